@@ -0,0 +1,36 @@
+// chipyard/generators/myaccelerators/src/main/scala
+package CONV
+
+import chisel3._
+import chisel3.util._
+import chisel3.experimental.FixedPoint
+
+// Balanced tree of 2-input adders, log2Ceil(n) levels deep, with `stages`
+// register levels spread evenly through it (0 = one combinational reduce).
+// The result appears `stages` cycles after the terms.
+//
+// Every partial sum is kept at `width` bits. Two's complement wrap-around
+// makes that the same as truncating the exact sum to `width` bits once at
+// the end, which is what `.reduce(_ + _)` into a 32-bit register did.
+object AdderTree {
+	def apply(terms: Seq[FixedPoint], stages: Int, width: Int = 32, bp: Int = 8): FixedPoint = {
+		val levels = log2Ceil(terms.length)
+		require(terms.nonEmpty, "AdderTree needs at least one term")
+		require(stages >= 0 && stages <= levels, s"AdderTree of ${terms.length} terms takes 0 to $levels stages")
+
+		var level = terms
+		for (l <- 0 until levels) {
+			val sums = level.grouped(2).map {
+				case Seq(x, y) =>
+					val s = Wire(FixedPoint(width.W, bp.BP))
+					s := x + y
+					s
+				case Seq(x) => x
+			}.toSeq
+			// register after this level if it crosses a stage boundary
+			val registered = (l + 1) * stages / levels > l * stages / levels
+			level = if (registered) sums.map(s => RegNext(s)) else sums
+		}
+		level.head
+	}
+}
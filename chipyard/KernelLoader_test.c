@@ -85,7 +85,7 @@ int main() {
 
     // Pack four 16-bit values into each 64-bit word
 
-    printf("Kernel address: 0x%lx\n", (uintptr_t)kernel_packed);
+    printf("Kernel address: 0x%llx\n", (unsigned long long)(uintptr_t)kernel_packed);
 
     for (int i = 0; i < PACKED_KERNEL_LEN; i++) {
         kernel_packed[i] = 0;
@@ -95,7 +95,7 @@ int main() {
         kernel_packed[i] |= (uint64_t)float_to_fixed88(kernel[4*i + 3]); // First 16 bits
     }
 
-    printf("Input address: 0x%lx\n", (uintptr_t)input_packed);
+    printf("Input address: 0x%llx\n", (unsigned long long)(uintptr_t)input_packed);
 
     for (int i = 0; i < PACKED_INPUT_LEN; i++) {
         input_packed[i] = 0;
@@ -112,13 +112,13 @@ int main() {
 
     for (int i = 0; i < PACKED_KERNEL_LEN; i++) {
         KernelLoad((uint64_t)&kernel_packed[i], (uint64_t)i); // 2 = 5x5 kernel
-        printf("Sending kernel %d, %d, %d, %d: 0x%0.16lx\n", 4*i,4*i+1,4*i+2,4*i+3, kernel_packed[i]);
+        printf("Sending kernel %d, %d, %d, %d: 0x%016llx\n", 4*i,4*i+1,4*i+2,4*i+3, (unsigned long long)kernel_packed[i]);
     }
     printf("Kernel Loaded!\n");
 
     for (int i = 0; i < PACKED_INPUT_LEN; i++) {
         InputLoad((uint64_t)&input_packed[i], (uint64_t)i); // 2 = 5x5 kernel
-        printf("Sending input %d, %d, %d, %d: 0x%0.16lx\n", 4*i,4*i+1,4*i+2,4*i+3, input_packed[i]);
+        printf("Sending input %d, %d, %d, %d: 0x%016llx\n", 4*i,4*i+1,4*i+2,4*i+3, (unsigned long long)input_packed[i]);
     }
     printf("Kernel Loaded!\n");
 
@@ -9,7 +9,12 @@ import freechips.rocketchip.diplomacy._
 import freechips.rocketchip.rocket._
 import chisel3.experimental.FixedPoint
 
-class OurCONV(opcodes: OpcodeSet, n: Int = 25)(implicit p: Parameters) extends LazyRoCC(opcodes) {
+// adderStages: register levels inside the 25-term adder tree (0 to 5), traded
+// against the clock the reduction can close at
+// kernelSlots: resident kernels, picked by the slot ID in rs2 bits 12 and up
+// of doLoadKernel and doCompute (at most 16, stride and dilation follow)
+class OurCONV(opcodes: OpcodeSet, n: Int = 25, val adderStages: Int = 2, val kernelSlots: Int = 4)(implicit p: Parameters) extends LazyRoCC(opcodes) {
+	require(kernelSlots >= 2 && kernelSlots <= 16 && isPow2(kernelSlots), "kernelSlots must be a power of 2 from 2 to 16")
 	val regCount = n
     override lazy val module = new OurCONVModuleImp(this)
 }
@@ -18,11 +23,18 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 	with HasCoreParameters {
 		
 		// FSM states
-		val sIdle :: sSetup :: sLoadFrame :: sAcc1 :: sAcc2 :: writeResult :: sWriteReq :: sWaitWriteResp :: sReadKernelReq :: sLoadKernelDone :: sReadInputReq :: sLoadInputDone :: sDone :: Nil = Enum(13)
+		val sIdle :: sSetup :: sCompute :: sDrain :: sWriteReq :: sWaitWriteResp :: sReadKernelReq :: sLoadKernelDone :: sReadInputReq :: sLoadInputDone :: sDone :: sRespond :: Nil = Enum(12)
 		val state = RegInit(sIdle)
 		val N = 8.U // Output size, 8 for 8x8 output
 
-		val kernel = Reg(Vec(25, FixedPoint(16.W, 8.BP)))
+		// Kernel slots, each with its own size code. kernelSize/reg_kernelDim
+		// are the active size: set by doLoadKernel and by doCompute from its
+		// slot, and used to lay out the input window.
+		val kernel = Reg(Vec(outer.kernelSlots, Vec(25, FixedPoint(16.W, 8.BP))))
+		val slotSize = RegInit(VecInit(Seq.fill(outer.kernelSlots)(2.U(2.W))))
+		val slotBits = log2Ceil(outer.kernelSlots)
+		val reg_kernelSlot = RegInit(0.U(slotBits.W)) // slot doLoadKernel fills
+		val reg_computeSlot = RegInit(0.U(slotBits.W)) // slot doCompute reads
 		val kernelSize = Reg(UInt(2.W)) // Size of the kernel, 0: 1x1, 1: 3x3, 2: 5x5
 
 		val reg_kernelBaseAddr = Reg(UInt(xLen.W))
@@ -43,6 +55,9 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 		val doLoadKernel = (funct === 2.U)
         val doLoadInput = funct === 1.U
         val doCompute = funct === 3.U
+        val doSlideInput = funct === 4.U // shift the input window right, load only the new columns
+        val doReadCounter = funct === 5.U // rd = performance counter rs2
+        val doResetCounters = funct === 6.U // clear every performance counter
         val memRespTag = io.mem.resp.bits.tag
 
 
@@ -53,6 +68,14 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
         val totalKernelReadReq = ((kernelNumElements + 3.U) >> 2).asUInt
 
 		val totalInputReadReq = ((inputNumElements + 3.U) >> 2).asUInt // total number of packed 64-bit words read requests for input
+
+		// doSlideInput: the new columns arrive as reg_inputDim rows of 8 values,
+		// of which the first reg_slideCols per row are used
+		val slideBlockCols = 8
+		val reg_slide = RegInit(false.B)
+		val reg_slideCols = RegInit(0.U(4.W))
+		val totalSlideReadReq = (reg_inputDim * slideBlockCols.U) >> 2
+		val totalInputReq = Mux(reg_slide, totalSlideReadReq, totalInputReadReq)
 		// *************************************
 
 		// *************************************
@@ -72,7 +95,8 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
         val reg_xd = Reg(Bool())
         val reg_baseAddr = Reg(UInt(xLen.W))
         val reg_dprv = Reg(UInt(2.W))
-        val reg_numElements = (((N * N) + 3.U) / 4.U)
+        // words to write back: the valid outputs of the tile, packed densely
+        val reg_numElements = RegInit((((N * N) + 3.U) / 4.U)(4, 0))
         val reg_inputTileType = Reg(UInt(10.W)) 
 		// *************************************
 
@@ -96,44 +120,70 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 		val inRow = RegInit(0.U(4.W))
 		val inCol = RegInit(0.U(4.W))
 
+		// Output step and tap spacing of the current doCompute
+		val reg_stride = RegInit(1.U(3.W))
+		val reg_dilation = RegInit(1.U(2.W))
+
 		val inRowStart = RegInit(0.U(4.W))
 		val inRowEnd = RegInit(0.U(4.W))
 		val inColStart = RegInit(0.U(4.W))
 		val inColEnd = RegInit(0.U(4.W))
 
-		val outIdx = RegInit(0.U(6.W))
-		// Output coordinates
-		val outRow = outIdx / N
-		val outCol = outIdx % N
+		val outIdx = RegInit(0.U(6.W)) // next output pixel to issue
 
 		val count = RegInit(0.U(32.W))
-		val acc_buffer = RegInit(0.F(32.W, 8.BP))
-		val acc = RegInit(VecInit(Seq.fill(5)(VecInit(Seq.fill(5)(0.F(32.W, 8.BP))))))
 		val result = RegInit(VecInit(Seq.fill(8)(VecInit(Seq.fill(8)(0.F(32.W, 8.BP))))))
 
+		// Compute pipeline, one output pixel enters per cycle:
+		//   issue (sCompute)  window fetch into a/b
+		//   stage 1           25 multiplies into prod
+		//   stage 2           adder tree (outer.adderStages register levels)
+		//                     into acc_buffer
+		//   stage 3           clamp, write result and overflowBits
+		// sValid(n)/sIdx(n) follow each pixel down the stages.
 		val a = RegInit(VecInit(Seq.fill(5)(VecInit(Seq.fill(5)(0.F(16.W, 8.BP))))))
 		val b = RegInit(VecInit(Seq.fill(5)(VecInit(Seq.fill(5)(0.F(16.W, 8.BP))))))
+		val prod = RegInit(VecInit(Seq.fill(5)(VecInit(Seq.fill(5)(0.F(32.W, 8.BP))))))
+		val acc_buffer = RegInit(0.F(32.W, 8.BP))
 
-		// Flags for pipeline state
-		val lastOutputPixel = (inRow === (N - 1.U)) && (inCol === (N - 1.U))
-		val finishedAll = RegInit(false.B)
+		val issue = state === sCompute
+		val s1Valid = RegNext(issue, false.B)
+		val s2Valid = RegNext(s1Valid, false.B)
+		val s1Idx = RegNext(outIdx)
+		val s2Idx = RegNext(s1Idx)
+		// s2 .. s3 spans the tree registers plus acc_buffer
+		val treeValid = Seq.iterate(s2Valid, outer.adderStages + 2)(v => RegNext(v, false.B))
+		val treeIdx = Seq.iterate(s2Idx, outer.adderStages + 2)(i => RegNext(i))
+		val s3Valid = treeValid.last
+		val s3Idx = treeIdx.last
 
 		count := count + 1.U
 
+		// Performance counters, in the order of enum ourconv_counter
+		// (ourconv_model.h): cycles, load / compute / write busy cycles,
+		// io.mem requests, cycles a request waited on io.mem.req.ready,
+		// io.mem responses, tiles completed. 64 bits, cleared by
+		// doResetCounters only.
+		val numCounters = 8
+		val perf = RegInit(VecInit(Seq.fill(numCounters)(0.U(64.W))))
+		val reg_respData = Reg(UInt(64.W)) // rd of sRespond
+
 		// State machine
 		when (cmd.fire && state === sIdle && doLoadKernel) {
 			reg_rd := cmd.bits.inst.rd 
 			reg_xd := cmd.bits.inst.xd 
 			reg_dprv := cmd.bits.status.dprv 
 			reg_kernelBaseAddr := cmd.bits.rs1 
-			when (cmd.bits.rs2 === 0.U) {
+			when (cmd.bits.rs2(1,0) === 0.U) {
 				reg_kernelDim := 1.U // 1x1 kernel
-			}.elsewhen (cmd.bits.rs2 === 1.U) {
+			}.elsewhen (cmd.bits.rs2(1,0) === 1.U) {
 				reg_kernelDim := 3.U // 3x3 kernel
 			}.otherwise {
 				reg_kernelDim := 5.U // 5x5 kernel
 			}
 			kernelSize := cmd.bits.rs2(1,0)
+			reg_kernelSlot := cmd.bits.rs2(12 + slotBits - 1, 12)
+			slotSize(cmd.bits.rs2(12 + slotBits - 1, 12)) := cmd.bits.rs2(1,0)
 			readReq := 0.U 
 			readResp := 0.U
 
@@ -172,7 +222,7 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 					val flatIdx = ((tag - 1.U) << 2) + i.U 
 					when(flatIdx < kernelNumElements) {
 						val v = data(15+16*i,0+16*i).asSInt.asFixedPoint(8.BP)
-						kernel(flatIdx) := v
+						kernel(reg_kernelSlot)(flatIdx) := v
 						//printf("[RoCC] Wrote kernel(%d) = 0x%x\n",flatIdx, kernel(flatIdx).asUInt)
 					}
 				}
@@ -202,16 +252,38 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 			reg_dprv := cmd.bits.status.dprv 
 			reg_inputBaseAddr := cmd.bits.rs1 
 			reg_inputTileType := cmd.bits.rs2 // Tile type for input
+			reg_slide := false.B
 			readReq := 0.U 
 			readResp := 0.U 
 
 			state := sReadInputReq
 			//printf("[RoCC] Read input command received\n")
 		}
+		when (cmd.fire && state === sIdle && doSlideInput) {
+			reg_rd := cmd.bits.inst.rd 
+			reg_xd := cmd.bits.inst.xd 
+			reg_dprv := cmd.bits.status.dprv 
+			reg_inputBaseAddr := cmd.bits.rs1 
+			val cols = Mux(cmd.bits.rs2(3,0) > slideBlockCols.U, slideBlockCols.U, cmd.bits.rs2(3,0))
+			reg_slide := true.B
+			reg_slideCols := cols
+			readReq := 0.U 
+			readResp := 0.U 
+
+			// Flat shift by cols: every row keeps its overlapping columns at the
+			// left; the vacated right-hand columns are refilled from memory
+			for (i <- 0 until 144) {
+				input(i) := MuxLookup(cols, input(i),
+					(1 to slideBlockCols).filter(c => i + c < 144).map(c => c.U -> input(i + c)))
+			}
+
+			state := sReadInputReq
+			//printf("[RoCC] Slide input command received\n")
+		}
 		when (state === sReadInputReq) {
 			// Issue request
-			val canIssue = readReq < totalInputReadReq
-			val canResp = readResp < totalInputReadReq
+			val canIssue = readReq < totalInputReq
+			val canResp = readResp < totalInputReq
 			io.mem.req.valid := canIssue 
 			io.mem.req.bits.addr := reg_inputBaseAddr + (readReq << 3)
 			io.mem.req.bits.tag := readReq + 1.U // must be non-zero 
@@ -238,8 +310,14 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 				// Unpack data into kernel vector
 				for (i <- 0 until 4) {
 					val flatIdx = ((tag - 1.U) << 2) + i.U 
-					when(flatIdx < inputNumElements) {
-						val v = data(15+16*i,0+16*i).asSInt.asFixedPoint(8.BP)
+					val v = data(15+16*i,0+16*i).asSInt.asFixedPoint(8.BP)
+					when(reg_slide) {
+						val row = flatIdx >> 3
+						val col = flatIdx(2,0)
+						when(col < reg_slideCols) {
+							input(row * reg_inputDim + reg_inputDim - reg_slideCols + col) := v
+						}
+					}.elsewhen(flatIdx < inputNumElements) {
 						input(flatIdx) := v
 						//printf("[RoCC] Wrote kernel(%d) = 0x%x\n",flatIdx, input(flatIdx).asUInt)
 					}
@@ -271,67 +349,101 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 			reg_dprv := cmd.bits.status.dprv
 			writeIdx := 0.U
 
-			tileType := rs2 // Set tile type based on rs2
-			when (rs2 === full) {
-                    inRowStart := 0.U
-                    inRowEnd := 7.U // for 8x8 output
-                    inColStart := 0.U
-                    inColEnd := 7.U // for 8x8 output
-                }.elsewhen (rs2 === center) {
-                    inRowStart := pad
-                    inRowEnd := (N+pad-1.U)
-                    inColStart := pad
-                    inColEnd := (N+pad-1.U)
-                }.elsewhen (rs2 === topLeft) {
-                    inRowStart := 0.U
-                    inRowEnd := 7.U // for 8x8 output
-                    inColStart := 0.U
-                    inColEnd := 7.U // for 8x8 output
-                }.elsewhen (rs2 === top) {
-                    inRowStart := 0.U
-                    inRowEnd := 7.U // for 8x8 output
-                    inColStart := pad
-                    inColEnd := (N+pad-1.U)
-                }.elsewhen (rs2 === topRight) {
-                    inRowStart := 0.U
-                    inRowEnd := 7.U // for 8x8 output
-                    inColStart := (2.U*pad)
-                    inColEnd := (N+2.U*pad-1.U)
-                }.elsewhen (rs2 === left) {
-                    inRowStart := pad
-                    inRowEnd := (N+pad-1.U)
-                    inColStart := 0.U
-                    inColEnd := 7.U // for 8x8 output
-                }.elsewhen (rs2 === right) {
-                    inRowStart := pad
-                    inRowEnd := (N+pad-1.U)
-                    inColStart := (2.U*pad)
-                    inColEnd := (N+2.U*pad-1.U)
-                }.elsewhen (rs2 === bottomLeft) {
-                    inRowStart := (2.U*pad)
-                    inRowEnd := (N+2.U*pad-1.U)
-                    inColStart := 0.U
-                    inColEnd := 7.U // for 8x8 output
-                }.elsewhen (rs2 === bottom) {
-                    inRowStart := (2.U*pad)
-                    inRowEnd := (N+2.U*pad-1.U)
-                    inColStart := pad
-                    inColEnd := (N+pad-1.U)
-                }.elsewhen (rs2 === bottomRight) {
-                    inRowStart := (2.U*pad)
-                    inRowEnd := (N+2.U*pad-1.U)
-                    inColStart := (2.U*pad)
-                    inColEnd := (N+2.U*pad-1.U)
+			// rs2: tile type in bits 3:0, valid output rows in 6:4 and
+			// columns in 10:8 for a ragged edge tile (0 = all 8), kernel slot
+			// from bit 12. The slot's size becomes the active one. Bits 17:16
+			// give the output stride (1, 2, 4), bit 18 the dilation (1, 2); a
+			// strided or dilated tile is scanned as a center tile.
+			val computeType = rs2(3,0)
+			val stride = MuxLookup(rs2(17,16), 4.U, Seq(0.U -> 1.U, 1.U -> 2.U))
+			val dilation = Mux(rs2(18), 2.U, 1.U)
+			val strided = rs2(18,16) =/= 0.U
+			reg_stride := stride
+			reg_dilation := dilation
+			val computeSlot = rs2(12 + slotBits - 1, 12)
+			val slotPad = slotSize(computeSlot)
+			reg_computeSlot := computeSlot
+			kernelSize := slotPad
+			reg_kernelDim := MuxLookup(slotPad, 5.U, Seq(0.U -> 1.U, 1.U -> 3.U))
+			val validRows = Mux(rs2(6,4) === 0.U, N, rs2(6,4))
+			val validCols = Mux(rs2(10,8) === 0.U, N, rs2(10,8))
+			val rowLo = WireDefault(inRowStart)
+			val rowHi = WireDefault(inRowEnd)
+			val colLo = WireDefault(inColStart)
+			val colHi = WireDefault(inColEnd)
+
+			tileType := Mux(strided, center, computeType) // Set tile type based on rs2
+			when (computeType === full) {
+                    rowLo := 0.U
+                    rowHi := 7.U // for 8x8 output
+                    colLo := 0.U
+                    colHi := 7.U // for 8x8 output
+                }.elsewhen (computeType === center) {
+                    rowLo := slotPad
+                    rowHi := (N+slotPad-1.U)
+                    colLo := slotPad
+                    colHi := (N+slotPad-1.U)
+                }.elsewhen (computeType === topLeft) {
+                    rowLo := 0.U
+                    rowHi := 7.U // for 8x8 output
+                    colLo := 0.U
+                    colHi := 7.U // for 8x8 output
+                }.elsewhen (computeType === top) {
+                    rowLo := 0.U
+                    rowHi := 7.U // for 8x8 output
+                    colLo := slotPad
+                    colHi := (N+slotPad-1.U)
+                }.elsewhen (computeType === topRight) {
+                    rowLo := 0.U
+                    rowHi := 7.U // for 8x8 output
+                    colLo := (2.U*slotPad)
+                    colHi := (N+2.U*slotPad-1.U)
+                }.elsewhen (computeType === left) {
+                    rowLo := slotPad
+                    rowHi := (N+slotPad-1.U)
+                    colLo := 0.U
+                    colHi := 7.U // for 8x8 output
+                }.elsewhen (computeType === right) {
+                    rowLo := slotPad
+                    rowHi := (N+slotPad-1.U)
+                    colLo := (2.U*slotPad)
+                    colHi := (N+2.U*slotPad-1.U)
+                }.elsewhen (computeType === bottomLeft) {
+                    rowLo := (2.U*slotPad)
+                    rowHi := (N+2.U*slotPad-1.U)
+                    colLo := 0.U
+                    colHi := 7.U // for 8x8 output
+                }.elsewhen (computeType === bottom) {
+                    rowLo := (2.U*slotPad)
+                    rowHi := (N+2.U*slotPad-1.U)
+                    colLo := slotPad
+                    colHi := (N+slotPad-1.U)
+                }.elsewhen (computeType === bottomRight) {
+                    rowLo := (2.U*slotPad)
+                    rowHi := (N+2.U*slotPad-1.U)
+                    colLo := (2.U*slotPad)
+                    colHi := (N+2.U*slotPad-1.U)
                 }
-			for (i <- 0 until 5) {
-				for (j <- 0 until 5) {
-					acc(i)(j) := 0.F(32.W, 8.BP)
-					a(i)(j) := 0.F(16.W, 8.BP)
-					b(i)(j) := 0.F(16.W, 8.BP)
-				}
+
+			// A ragged tile scans only its valid outputs, the ones next to the
+			// window edge the tile is flush with. A strided one starts at the
+			// first full window and steps by the stride.
+			when (strided) {
+				val first = slotPad * dilation
+				inRowStart := first
+				inRowEnd := first + (validRows - 1.U) * stride
+				inColStart := first
+				inColEnd := first + (validCols - 1.U) * stride
+			}.elsewhen (computeType <= full) {
+				val flushBottom = computeType === bottomLeft || computeType === bottom || computeType === bottomRight
+				val flushRight = computeType === topRight || computeType === right || computeType === bottomRight
+				inRowStart := Mux(flushBottom, rowHi - (validRows - 1.U), rowLo)
+				inRowEnd := Mux(flushBottom, rowHi, rowLo + validRows - 1.U)
+				inColStart := Mux(flushRight, colHi - (validCols - 1.U), colLo)
+				inColEnd := Mux(flushRight, colHi, colLo + validCols - 1.U)
 			}
+			reg_numElements := (validRows * validCols + 3.U) >> 2
 			outIdx := 0.U
-			finishedAll := false.B
 			state := sSetup
 			//printf(p"Starting convolution with tile type: ${rs2}\n")	
 		}
@@ -339,10 +451,11 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 		when (state === sSetup) {
 			inRow := inRowStart
 			inCol := inColStart
-			state := sLoadFrame 
+			state := sCompute 
 		}
 
-		when (state === sLoadFrame) {
+		when (state === sCompute) {
+			// Issue: fetch the window of (inRow, inCol)
 			for (i <- 0 until 5) {
                 for (j <- 0 until 5) {
                     val x = WireDefault(0.U)
@@ -355,8 +468,8 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 							x := inRow
 							y := inCol
 						}.otherwise {
-							x := (inRow +& j.U - pad)
-							y := (inCol +& i.U - pad)
+							x := (inRow +& j.U * reg_dilation - pad * reg_dilation)(4,0)
+							y := (inCol +& i.U * reg_dilation - pad * reg_dilation)(4,0)
 						}
 						
 						
@@ -383,7 +496,7 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 						}
 
 						when(valid) {
-							a(i)(j) := kernel(j.U * K + i.U)
+							a(i)(j) := kernel(reg_computeSlot)(j.U * K + i.U)
 							b(i)(j) := input(x * (N+2.U*pad) + y)
 						}.otherwise {
 							a(i)(j) := 0.F(16.W, 8.BP)
@@ -394,61 +507,46 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 					}
 				}
             }
-            state := sAcc1
+
+			outIdx := outIdx + 1.U
+            when(inCol === inColEnd) {
+                inCol := inColStart
+                when(inRow === inRowEnd) {
+                    // Last pixel issued: let the pipeline drain
+                    state := sDrain
+                }.otherwise  {
+                    inRow := inRow + reg_stride
+                }
+            }.otherwise {
+                inCol := inCol + reg_stride
+            }
 		}
 
-		when (state === sAcc1) {
+		// Stage 1: multiply
+		when (s1Valid) {
 			for (i <- 0 until 5) {
                 for (j <- 0 until 5) {
 					when (i.U < K && j.U < K) {
-                    	acc(i)(j) := acc(i)(j) + (a(i)(j) * b(i)(j))
+                    	prod(i)(j) := a(i)(j) * b(i)(j)
 					}
                 }
             }
-            state := sAcc2
-
-            //printf(p"Cycle: ${count}, state: ${state}, a = ${a.asUInt}, b = ${b.asUInt}\n")
 		}
 
-		when (state === sAcc2) {
-			val sum = (for (i <- 0 until 5; j <- 0 until 5) yield {
-				Mux(i.U < K && j.U < K, acc(i)(j), 0.F(32.W, 8.BP))
-				}).reduce(_ + _)
-				
-			acc_buffer := sum
-
-			for (i <- 0 until 5; j <- 0 until 5) {
-				when (i.U < K && j.U < K) {
-					acc(i)(j) := 0.F(32.W, 8.BP)
-					a(i)(j) := 0.F(16.W, 8.BP)
-					b(i)(j) := 0.F(16.W, 8.BP)
-				}
-			}
-            
-
-            // After full kernel scan, increment input pos
-            when(inCol === inColEnd) {
-                inCol := inColStart
-                when(inRow === inRowEnd) {
-                    // All pixels done: wait 1 cycle to commit final result
-                    finishedAll := true.B
-                }.otherwise  {
-                    inRow := inRow + 1.U
-                }
-            }.otherwise {
-                inCol := inCol + 1.U
-            }
-
-            //printf(p"Cycle: ${count}, state: ${state}, acc = ${acc.asUInt}\n")
-            
-            state := writeResult
+		// Stage 2: reduce. The tree registers advance every cycle; treeValid
+		// says which of their contents belong to a pixel.
+		val terms = for (i <- 0 until 5; j <- 0 until 5) yield {
+			Mux(i.U < K && j.U < K, prod(i)(j), 0.F(32.W, 8.BP))
 		}
+		acc_buffer := AdderTree(terms, outer.adderStages)
 
-		when (state === writeResult) {
-			
+		// Stage 3: clamp and write back
+		when (s3Valid) {
 			// *********************************************
 			// from convDoWrite.scala
-			val index = (outRow * N) + outCol // flatten 2D index 
+			val outRow = s3Idx / N
+			val outCol = s3Idx % N
+			val index = s3Idx // flatten 2D index 
                 when(acc_buffer > maxVal) {
                     result(outRow)(outCol) := maxVal // clamp to max.
                     overflowBits := overflowBits.bitSet(index, true.B)
@@ -461,16 +559,13 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
                 }  
 
 			// *********************************************
+		}
 
-            acc_buffer := 0.F(32.W, 8.BP)
-            outIdx := outIdx + 1.U
-            when(finishedAll) {
-                state := sWriteReq
-            }.otherwise {
-                state := sLoadFrame // Load the next frame
-            }
-            //printf(p"Cycle: ${count}, state: ${state}, inCol = ${inCol}, inRow = ${inRow}, outIdx: ${outIdx}, " + 
-            //p"acc_buffer: ${acc_buffer.asUInt}, lastOutputPixel = ${lastOutputPixel}, finishedAll = ${finishedAll}\n")
+		when (state === sDrain) {
+			// Stage 3 writes the last pixel this cycle
+			when (!s1Valid && !treeValid.init.reduce(_ || _)) {
+				state := sWriteReq
+			}
 		}
 
 		// ********************************************
@@ -543,6 +638,24 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
 
 		// ********************************************
 
+		when (cmd.fire && state === sIdle && doReadCounter) {
+			reg_rd := cmd.bits.inst.rd
+			reg_xd := cmd.bits.inst.xd
+			reg_respData := Mux(rs2 < numCounters.U, perf(rs2(log2Ceil(numCounters) - 1, 0)), 0.U)
+			state := sRespond
+		}
+
+		when (state === sRespond) {
+			when(reg_xd && io.resp.ready) {
+				io.resp.valid := true.B
+				io.resp.bits.rd := reg_rd
+				io.resp.bits.data := reg_respData
+				state := sIdle
+			}.elsewhen(!reg_xd) {
+				state := sIdle
+			}
+		}
+
 
 		// Computation end
 		//********************************************
@@ -559,7 +672,7 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
         cmd.ready := !stallLoad && !stallResp && state === sIdle
 
         // PROC RESPONSE INTERFACE
-        when(state =/= sDone && state =/= sLoadKernelDone && state =/= sLoadInputDone) {
+        when(state =/= sDone && state =/= sLoadKernelDone && state =/= sLoadInputDone && state =/= sRespond) {
             io.resp.valid := false.B 
             io.resp.bits := DontCare
         }
@@ -581,6 +694,27 @@ class OurCONVModuleImp(outer: OurCONV)(implicit p: Parameters) extends LazyRoCCM
             io.mem.req.bits.phys := false.B
             io.mem.req.bits.dprv := reg_dprv
 		}
+
+		// Performance counters, after the io.mem defaults so they see the
+		// final valid/ready
+		val loadBusy = state === sReadKernelReq || state === sLoadKernelDone || state === sReadInputReq || state === sLoadInputDone
+		val computeBusy = state === sSetup || state === sCompute || state === sDrain
+		val writeBusy = state === sWriteReq || state === sWaitWriteResp || state === sDone
+		val tileDone = state === sDone && (io.resp.fire || !reg_xd)
+		val perfEvents = Seq(true.B, loadBusy, computeBusy, writeBusy, io.mem.req.fire,
+			io.mem.req.valid && !io.mem.req.ready, io.mem.resp.valid, tileDone)
+		for ((event, i) <- perfEvents.zipWithIndex) {
+			when (event) {
+				perf(i) := perf(i) + 1.U
+			}
+		}
+		when (cmd.fire && state === sIdle && doResetCounters) {
+			perf.foreach(_ := 0.U)
+			reg_rd := cmd.bits.inst.rd
+			reg_xd := cmd.bits.inst.xd
+			reg_respData := 1.U
+			state := sRespond
+		}
 		
 
 	}
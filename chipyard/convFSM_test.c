@@ -1,7 +1,15 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "ourconv_pack.h"
+// Links with ourconv_pack.c and ../conv.c ../conv_simd.c (-I..).
+#ifdef OURCONV_MODEL
+// Host build against the software model instead of the RoCC hardware:
+// gcc -O2 -DOURCONV_MODEL -I.. -o convFSM_test convFSM_test.c ourconv_model.c ourconv_perf.c ourconv_pack.c ../conv.c ../conv_simd.c
+#include "ourconv_model.h"
+#else
 #include "rocc.h"
+#endif
 
 
 #define KERNEL_SIZE 5
@@ -40,12 +48,37 @@ enum TileType {
     BOTTOM_RIGHT = 8
 };
 
+#ifdef OURCONV_MODEL
+static ourconv_model model;
+
+// Cycle counter of the model, so the timings printed below are the
+// predictions of ourconv_perf.h rather than host time.
+static inline uint64_t rdcycle() {
+	return ourconv_model_cycles(&model);
+}
+
+#define ROCC_INSTRUCTION_DSS(X, rd, rs1, rs2, funct) \
+    ((rd) = ourconv_model_cmd(&model, (funct), (uint64_t)(rs1), (uint64_t)(rs2)))
+#else
 static inline uint64_t rdcycle() {
 
 	uint64_t cycles;
 	asm volatile ("rdcycle %0" : "=r" (cycles));
 	return cycles;
 }
+#endif
+
+// Build with -DOURCONV_TRACE and ourconv_trace.c for a per-phase breakdown
+// of the run (ourconv_trace.h), and under the model a Chrome trace in
+// convFSM_trace.json; without it the spans compile away.
+#ifdef OURCONV_TRACE
+#include "ourconv_trace.h"
+static ourconv_trace trace;
+static ourconv_trace_event trace_events[128];
+#define TRACE_SPAN(phase, t0) ourconv_trace_span(&trace, (phase), (t0), rdcycle())
+#else
+#define TRACE_SPAN(phase, t0) ((void)(t0))
+#endif
 
 
 
@@ -73,15 +106,6 @@ static inline uint64_t doCompute(uint64_t ptr, uint64_t tileType) {
     return result;
 }
 
-uint16_t float_to_fixed88(float value) {
-    int32_t fixed = (value * 256.0f);  // scale float to 8.8
-    if (fixed < -32768 || fixed > 32767) {
-        fprintf(stderr, "Error: value %.4f out of range for 8.8 fixed-point\n", value);
-        exit(1);
-    }
-    return (uint16_t)(fixed & 0xFFFF);  // two's complement, lower 16 bits
-}
-
 uint16_t fixed88_to_float(uint16_t fixed) {
     int32_t value = (int32_t)(fixed & 0xFFFF);  // two's complement, lower 16 bits
     return (uint16_t)(value / 256.0f);  // convert back to float
@@ -108,19 +132,18 @@ static float kernel_data[KERNEL_SIZE][KERNEL_SIZE] = {
     {1.0,  0.5, -1.0,  0.5,  1.0}
 };
 #else
+// The raw commands take 1x1, 3x3 or 5x5; ourconv_conv2d_q88() splits larger kernels
 #error "Unsupported KERNEL_SIZE. Must be 1, 3, or 5."
 #endif
 
 int main() {
 
     float input[INPUT_LEN];
-    float input_tile[INPUT_TILE_LEN];
     uint64_t input_tile_packed[PACKED_INPUT_TILE_LEN];
     
     float output[OUTPUT_LEN];
     float output_tile[OUTPUT_TILE_LEN];
     uint16_t output_f88[OUTPUT_LEN];
-    uint16_t output_tile_f88[OUTPUT_TILE_LEN];
     uint64_t output_tile_packed[PACKED_OUTPUT_TILE_LEN];
     int overflow[OUTPUT_LEN];
     
@@ -135,7 +158,6 @@ int main() {
     int outRowEnd = 0;
     int outColStart = 0;
     int outColEnd = 0;
-    int count = 0;
     uint64_t result;
 
 
@@ -148,23 +170,22 @@ int main() {
         overflow[i] = 0;
     }
 
+#ifdef OURCONV_MODEL
+    ourconv_model_init(&model);
+#endif
+
     // Start measurement of entire process - comment out other cycle counts if using
-    int start = rdcycle();
+    uint64_t start = rdcycle();
+#ifdef OURCONV_TRACE
+    ourconv_trace_init(&trace, trace_events, sizeof(trace_events) / sizeof(trace_events[0]));
+    ourconv_trace_frame_begin(&trace, start);
+#endif
     
-    // kernel processing
-    for (int w = 0; w < PACKED_KERNEL_LEN; w++) {
-        packed_kernel_data[w] = 0;
-    }
-
-    int idx = 0;
-    for (int r = 0; r < KERNEL_SIZE; r++) {
-        for (int c = 0; c < KERNEL_SIZE; c++) {
-            int word_idx = idx / 4;
-            int offset = (idx % 4) * 16;
-            packed_kernel_data[word_idx] |= ((uint64_t)float_to_fixed88(kernel_data[r][c]) << offset);
-            idx++;
-        }
-    }
+    // kernel processing: convert and pack in one pass
+    uint64_t tp = rdcycle();
+    int clamped = ourconv_pack_f32(&kernel_data[0][0], KERNEL_SIZE, KERNEL_SIZE, KERNEL_SIZE,
+                                   0, 0, KERNEL_SIZE, KERNEL_SIZE, packed_kernel_data);
+    TRACE_SPAN(OURCONV_TRACE_KERNEL_PACK, tp);
 
     int pad = 0;
     if (KERNEL_SIZE == 1) {
@@ -179,15 +200,26 @@ int main() {
     }
 
     
-    // Uncomment if counting cycles for just load kernel
-    //int aStart = rdcycle();
+    // Build with -DCONVFSM_PHASE_CYCLES to time each command on its own; the
+    // total below then includes the printf calls
+#ifdef CONVFSM_PHASE_CYCLES
+    uint64_t aStart = rdcycle();
+#endif
+    tp = rdcycle();
     uint64_t success = doLoadKernel((uint64_t)&packed_kernel_data[0], pad);
-    //int aEnd = rdcycle();
-    //printf("Kernel Load execution took %lu cycles\n",aEnd-aStart);
+    TRACE_SPAN(OURCONV_TRACE_KERNEL_LOAD, tp);
+#ifdef CONVFSM_PHASE_CYCLES
+    uint64_t aEnd = rdcycle();
+    printf("Kernel Load execution took %llu cycles\n", (unsigned long long)(aEnd - aStart));
+#endif
 
     
 
+#ifdef OURCONV_MODEL
+    __sync_synchronize();
+#else
     asm volatile("fence" ::: "memory");
+#endif
      
 
     for (int i = 0; i < INPUT_SIZE/OUTPUT_TILE_SIZE; i++) {
@@ -281,67 +313,63 @@ int main() {
                 outColStart = j * OUTPUT_TILE_SIZE;
             }
             
-            count = 0;
-            int tx = 0, ty = 0;
-            for (int x = rowStart; x <= rowEnd; x++) {
-                ty = 0;
-                for (int y = colStart; y <= colEnd; y++) {
-                    input_tile[tx * INPUT_TILE_SIZE + ty] = input[x * INPUT_SIZE + y];
-                    ty++;
-                }
-                tx++;
-            }
-
-            for (int w = 0; w < PACKED_INPUT_TILE_LEN; w++) {
-                input_tile_packed[w] = 0;
-            }
-            idx = 0;
-            for (int r = 0; r < INPUT_TILE_SIZE; r++) {
-                for (int c = 0; c < INPUT_TILE_SIZE; c++) {
-                    int word_idx = idx / 4;
-                    int offset = (idx % 4) * 16;
-                    input_tile_packed[word_idx] |= ((uint64_t)float_to_fixed88(input_tile[r*INPUT_TILE_SIZE+c]) << offset);
-                    idx++;
-                }
-            }
+            // Straight from the image into the packed tile buffer
+            tp = rdcycle();
+            clamped += ourconv_pack_f32(input, INPUT_SIZE, INPUT_SIZE, INPUT_SIZE,
+                                        rowStart, colStart, INPUT_TILE_SIZE, INPUT_TILE_SIZE, input_tile_packed);
+            TRACE_SPAN(OURCONV_TRACE_TILE_PACK, tp);
             
-            // Uncomment if counting cycles for just load input
-            //aStart = rdcycle();
+#ifdef CONVFSM_PHASE_CYCLES
+            aStart = rdcycle();
+#endif
+            tp = rdcycle();
             success = InputLoad((uint64_t)&input_tile_packed[0], 0); 
-            //aEnd = rdcycle();
-            //printf("Input Load execution took %lu cycles\n",aEnd-aStart);  
-
-            // Uncomment if counting cycles for just tile computation
-            //aStart = rdcycle();
+            TRACE_SPAN(OURCONV_TRACE_LOAD_INPUT, tp);
+#ifdef CONVFSM_PHASE_CYCLES
+            aEnd = rdcycle();
+            printf("Input Load execution took %llu cycles\n", (unsigned long long)(aEnd - aStart));
+            aStart = rdcycle();
+#endif
+            tp = rdcycle();
             result = doCompute((uint64_t)&output_tile_packed[0], tileType); 
-            //aEnd = rdcycle();
-            //printf("Tile compute execution took %lu cycles\n",aEnd-aStart);  
+            TRACE_SPAN(OURCONV_TRACE_COMPUTE, tp);
+#ifdef CONVFSM_PHASE_CYCLES
+            aEnd = rdcycle();
+            printf("Tile compute execution took %llu cycles\n", (unsigned long long)(aEnd - aStart));
+#endif
 
             
-            for (int i = 0; i < PACKED_OUTPUT_TILE_LEN; i++) {
-                uint16_t v0 = (output_tile_packed[i] >> 0) & 0xFFFF;
-                uint16_t v1 = (output_tile_packed[i] >> 16) & 0xFFFF;
-                uint16_t v2 = (output_tile_packed[i] >> 32) & 0xFFFF;
-                uint16_t v3 = (output_tile_packed[i] >> 48) & 0xFFFF;
-
-                output_tile_f88[i * 4 + 0] = v0;
-                output_tile_f88[i * 4 + 1] = v1;
-                output_tile_f88[i * 4 + 2] = v2;
-                output_tile_f88[i * 4 + 3] = v3;
-            }
+            tp = rdcycle();
+            ourconv_unpack_q88(output_tile_packed, OUTPUT_TILE_SIZE, OUTPUT_TILE_SIZE,
+                               (int16_t*)&output_f88[outRowStart * OUTPUT_SIZE + outColStart], OUTPUT_SIZE);
             for (int tx = 0; tx < OUTPUT_TILE_SIZE; tx++) {
                 for (int ty = 0; ty < OUTPUT_TILE_SIZE; ty++) {
-                    output_f88[(outRowStart + tx) * OUTPUT_SIZE + (outColStart + ty)] = output_tile_f88[tx * OUTPUT_TILE_SIZE + ty];
                     overflow[(outRowStart + tx) * OUTPUT_SIZE + (outColStart + ty)] = (result >> (tx * OUTPUT_TILE_SIZE + ty)) & 1;
                 }
             }  
+            TRACE_SPAN(OURCONV_TRACE_UNPACK, tp);
 
         }
     }
 
-    int end = rdcycle();
+    uint64_t end = rdcycle();
+#ifdef OURCONV_TRACE
+    ourconv_trace_frame_end(&trace, end);
+    ourconv_trace_report(&trace, stdout);
+#ifdef OURCONV_MODEL
+    FILE* trace_json = fopen("convFSM_trace.json", "w");
+    if (trace_json) {
+        ourconv_trace_write_chrome(&trace, trace_json, 1.0);
+        fclose(trace_json);
+    }
+#endif
+#endif
+    if (clamped) {
+        fprintf(stderr, "Error: %d values out of range for 8.8 fixed-point\n", clamped);
+        return 1;
+    }
     printf("Done\n");
-    printf("Convolution execution took %lu cycles\n",end-start);
+    printf("Convolution execution took %llu cycles\n", (unsigned long long)(end - start));
 
     printf("Output in Fixed Point 8.8 format:\n");
     for (int i = 0; i < OUTPUT_SIZE; i++) {
@@ -354,7 +382,7 @@ int main() {
     printf("\n");
     }
 
-    printf("Overflow bits: 0 = no overflow, 1 = overflow\n")
+    printf("Overflow bits: 0 = no overflow, 1 = overflow\n");
     for (int i = 0; i < OUTPUT_SIZE; i++) {
         for (int j = 0; j < OUTPUT_SIZE; j++) {
             printf("%d ", overflow[i*OUTPUT_SIZE+j]);
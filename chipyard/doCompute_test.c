@@ -19,7 +19,7 @@ int main() {
     static uint64_t matrix_data[1] = {0}; // 1 packet = 4 values
     uint16_t* unpacked_view = (uint16_t*)matrix_data;
 
-    printf("Matrix address: 0x%lx\n", (uintptr_t)&matrix_data[0]);
+    printf("Matrix address: 0x%llx\n", (unsigned long long)(uintptr_t)&matrix_data[0]);
 
     asm volatile("fence" ::: "memory");
 
@@ -28,7 +28,7 @@ int main() {
     __sync_synchronize();
     asm volatile("fence iorw, iorw" ::: "memory");
 
-    printf("Instruction sent. Accelerator returned: 0x%lx\n",overflow_result);
+    printf("Instruction sent. Accelerator returned: 0x%llx\n", (unsigned long long)overflow_result);
 
     printf("After:\n");
     for (int i = 0; i < 1; ++i) {
@@ -37,7 +37,8 @@ int main() {
         uint16_t v2 = (matrix_data[i] >> 32) & 0xFFFF;
         uint16_t v3 = (matrix_data[i] >> 48) & 0xFFFF;
 
-        printf("At addr 0x%lx, raw 16-bit values: 0x%04x 0x%04x 0x%04x 0x%04x\n", (uintptr_t)&matrix_data[i], v0, v1, v2, v3);
+        printf("At addr 0x%llx, raw 16-bit values: 0x%04x 0x%04x 0x%04x 0x%04x\n",
+               (unsigned long long)(uintptr_t)&matrix_data[i], v0, v1, v2, v3);
     }
 
     _exit(0);
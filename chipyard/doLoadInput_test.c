@@ -63,9 +63,9 @@ int main() {
         int max_elements = 64; // each 8x8 tile is 64 elements
         int max_words = (max_elements + 3) / 4;
         for (int i = 0; i < max_words; i++) {
-            printf("Word %2d at addr 0x%lx: 0x%016lx\n", i,
-                (uintptr_t)&packed_input_data[i],
-                packed_input_data[i]);
+            printf("Word %2d at addr 0x%llx: 0x%016llx\n", i,
+                (unsigned long long)(uintptr_t)&packed_input_data[i],
+                (unsigned long long)packed_input_data[i]);
         }
     }
 
@@ -73,7 +73,7 @@ int main() {
     
 
     uint64_t success = doLoadInput((uint64_t)&packed_input_data[0], TILE_NUM);
-    printf("RoCC instruction returned: %lu\n", success);
+    printf("RoCC instruction returned: %llu\n", (unsigned long long)success);
 
     return 0;
 }
\ No newline at end of file
@@ -61,11 +61,12 @@ int main() {
 
     printf("Packed kernel data:\n");
     for (int i = 0; i < num_words; i++) {
-        printf("Word%d at addr 0x%lx: 0x%016lx\n", i, (uintptr_t)&packed_kernel_data[i], packed_kernel_data[i]);
+        printf("Word%d at addr 0x%llx: 0x%016llx\n", i, (unsigned long long)(uintptr_t)&packed_kernel_data[i],
+               (unsigned long long)packed_kernel_data[i]);
     }
 
     uint64_t success = doLoadKernel((uint64_t)&packed_kernel_data[0], KERNEL_SIZE);
-    printf("RoCC instruction returned: %lu\n", success);
+    printf("RoCC instruction returned: %llu\n", (unsigned long long)success);
 
     return 0;
 }
\ No newline at end of file
@@ -22,7 +22,7 @@ int main() {
     static uint64_t matrix_data[4] = {0, 0, 0, 0}; // 4 packed words = 16 values max
     uint16_t* unpacked_view = (uint16_t*)matrix_data;
 
-    printf("Matrix address: 0x%lx\n", (uintptr_t)&matrix_data[0]);
+    printf("Matrix address: 0x%llx\n", (unsigned long long)(uintptr_t)&matrix_data[0]);
 
     asm volatile("fence" ::: "memory");
 
@@ -36,7 +36,7 @@ int main() {
     __sync_synchronize();
     asm volatile("fence iorw, iorw" ::: "memory");
 
-    printf("Instruction sent. Accelerator returned: 0x%lx\n", result);
+    printf("Instruction sent. Accelerator returned: 0x%llx\n", (unsigned long long)result);
 
     printf("After:\n");
     for (int i = 0; i < 4; ++i) {
@@ -45,7 +45,8 @@ int main() {
         uint16_t v2 = (matrix_data[i] >> 32) & 0xFFFF;
         uint16_t v3 = (matrix_data[i] >> 48) & 0xFFFF;
 
-        printf("At addr 0x%lx, raw 16-bit values: 0x%04x 0x%04x 0x%04x 0x%04x\n", (uintptr_t)&matrix_data[i], v0, v1, v2, v3);
+        printf("At addr 0x%llx, raw 16-bit values: 0x%04x 0x%04x 0x%04x 0x%04x\n",
+               (unsigned long long)(uintptr_t)&matrix_data[i], v0, v1, v2, v3);
     }
 
     if (result == 1) {
@@ -0,0 +1,190 @@
+// Build (host, software model):
+//   gcc -O2 -pthread -DOURCONV_MODEL -I.. -o ourconv_bench ourconv_bench.c ourconv_driver.c ourconv_pack.c ourconv_model.c ourconv_perf.c ../conv_bench.c ../conv_pool.c ../conv_tiles.c ../conv.c ../conv_simd.c
+// On the RoCC target drop -DOURCONV_MODEL and add -I../test for rocc.h.
+//
+// Usage: ourconv_bench [--json] [--runs N] [--quick]
+//
+// Benchmark sweep over image sizes, kernel sizes and tile sizes for every
+// convolution path:
+//   cpu-ref            conv2d() on the scalar code, the CPU reference
+//   cpu-<isa>          conv2d() on the best vector ISA
+//   cpu-q88-<isa>      conv2d_q88()
+//   cpu-tiled          conv2d_tiled() on a thread pool, per tile size
+//   ourconv-<mode>     ourconv_conv2d_q88() in serial, pipelined and sliding
+//                      mode (kernels above 5x5 split into passes)
+// Each case runs once untimed, then `runs` times. CPU cycles come from
+// conv_bench_cycles(); the accelerator's from ourconv_dev_cycles(), which
+// is rdcycle on the target and the model's virtual clock on the host
+// (clock "model"). bytes_per_pixel is input + output + kernel for the CPU
+// paths and the io.mem traffic (dev->traffic) for the accelerator.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "conv_bench.h"
+#include "conv_pool.h"
+#include "ourconv_driver.h"
+
+enum { PATH_REF, PATH_VEC, PATH_Q88, PATH_TILED, PATH_ACC };
+
+typedef struct {
+    int path;
+    const float* in;
+    const int16_t* in_q;
+    const float* k;
+    const int16_t* k_q;
+    float* out;
+    int16_t* out_q;
+    int h, w, ksize, tile, mode;
+    conv_pool* pool;
+    ourconv_dev* dev;
+} bench_job;
+
+// One run; returns the accelerator cycles for PATH_ACC, 0 otherwise
+static uint64_t run_once(const bench_job* j) {
+    switch (j->path) {
+    case PATH_REF:
+    case PATH_VEC:
+        conv2d(j->in, j->h, j->w, j->k, j->ksize, j->out);
+        return 0;
+    case PATH_Q88:
+        conv2d_q88(j->in_q, j->h, j->w, j->k_q, j->ksize, j->out_q, NULL);
+        return 0;
+    case PATH_TILED:
+        conv2d_tiled(j->in, j->h, j->w, j->k, j->ksize, j->out, j->tile, j->pool);
+        return 0;
+    default: {
+        ourconv_batch_stats stats;
+        ourconv_conv2d_q88(j->dev, j->in_q, j->h, j->w, j->k_q, j->ksize, j->out_q, j->mode, &stats);
+        return stats.cycles;
+    }
+    }
+}
+
+static void bench(conv_bench_out* out, const char* path, const bench_job* j, int runs) {
+    conv_bench_case c;
+    double pixels = (double)j->h * j->w, taps = (double)j->ksize * j->ksize;
+
+    memset(&c, 0, sizeof(c));
+    c.path = path;
+    c.h = j->h;
+    c.w = j->w;
+    c.ksize = j->ksize;
+    c.tile = j->path == PATH_TILED ? j->tile : j->path == PATH_ACC ? OURCONV_N : 0;
+    c.threads = j->path == PATH_TILED ? conv_pool_threads(j->pool) : 1;
+    c.macs = pixels * taps;
+    c.runs = runs;
+
+    ourconv_traffic before = j->dev->traffic;
+    run_once(j); // warm caches, kernel slots and the ISA choice
+    if (j->path == PATH_ACC) {
+        ourconv_traffic* t = &j->dev->traffic;
+        c.bytes = (double)(t->bytes_to_acc - before.bytes_to_acc + t->bytes_from_acc - before.bytes_from_acc);
+#ifdef OURCONV_MODEL
+        c.clock = "model";
+#else
+        c.clock = conv_bench_clock_name();
+#endif
+    } else {
+        int value = j->path == PATH_Q88 ? 2 : 4;
+        c.bytes = value * (2 * pixels + taps);
+        c.clock = conv_bench_clock_name();
+    }
+
+    for (int r = 0; r < runs; r++) {
+        uint64_t n0 = conv_bench_ns(), c0 = conv_bench_cycles();
+        uint64_t acc = run_once(j);
+        uint64_t c1 = conv_bench_cycles(), n1 = conv_bench_ns();
+        c.cycles[r] = j->path == PATH_ACC ? acc : c1 - c0;
+        c.ns[r] = n1 - n0;
+    }
+    conv_bench_row(out, &c);
+}
+
+int main(int argc, char** argv) {
+    static const int sizes[] = { 32, 256, 1024 };
+    static const int tiles[] = { 8, 32, 128 };
+    static const int modes[] = { OURCONV_SERIAL, OURCONV_PIPELINED, OURCONV_PIPELINED | OURCONV_SLIDE };
+    static const char* mode_path[] = { "ourconv-serial", "ourconv-pipelined", "ourconv-sliding" };
+    int format = CONV_BENCH_CSV, runs = 5, nsizes = 3;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) {
+            format = CONV_BENCH_JSON;
+        } else if (!strcmp(argv[i], "--runs") && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--quick")) {
+            nsizes = 2;
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--runs N] [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (runs < 1 || runs > CONV_BENCH_MAX_RUNS) {
+        fprintf(stderr, "--runs must be 1..%d\n", CONV_BENCH_MAX_RUNS);
+        return 2;
+    }
+
+    int max = sizes[nsizes - 1];
+    float* in = malloc(sizeof(float) * max * max);
+    float* out = malloc(sizeof(float) * max * max);
+    int16_t* in_q = malloc(sizeof(int16_t) * max * max);
+    int16_t* out_q = malloc(sizeof(int16_t) * max * max);
+    float k[49];
+    int16_t k_q[49];
+    conv_pool* pool = conv_pool_create(0);
+    ourconv_dev dev;
+    conv_bench_out report;
+    char vec_path[32], q88_path[32];
+
+    if (!in || !out || !in_q || !out_q) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < max * max; i++) {
+        in[i] = (float)((i * 7) % 23) * 0.25f;
+    }
+    for (int i = 0; i < 49; i++) {
+        k[i] = (float)(i % 11 - 5) / 64.0f;
+    }
+    conv_f32_to_q88(in, max * max, in_q);
+    conv_f32_to_q88(k, 49, k_q);
+    int isa = conv_isa();
+    snprintf(vec_path, sizeof(vec_path), "cpu-%s", conv_isa_name(isa));
+    snprintf(q88_path, sizeof(q88_path), "cpu-q88-%s", conv_isa_name(isa));
+    ourconv_dev_init(&dev);
+
+    conv_bench_begin(&report, stdout, format);
+    for (int s = 0; s < nsizes; s++) {
+        for (int ksize = 1; ksize <= 7; ksize += 2) {
+            bench_job j = { PATH_REF, in, in_q, k, k_q, out, out_q, sizes[s], sizes[s], ksize, 0, 0, pool, &dev };
+
+            conv_set_isa(CONV_ISA_SCALAR);
+            bench(&report, "cpu-ref", &j, runs);
+            conv_set_isa(isa);
+            j.path = PATH_VEC;
+            bench(&report, vec_path, &j, runs);
+            j.path = PATH_Q88;
+            bench(&report, q88_path, &j, runs);
+            j.path = PATH_TILED;
+            for (unsigned t = 0; t < sizeof(tiles) / sizeof(tiles[0]); t++) {
+                j.tile = tiles[t];
+                bench(&report, "cpu-tiled", &j, runs);
+            }
+            j.path = PATH_ACC;
+            for (int m = 0; m < 3; m++) {
+                j.mode = modes[m];
+                bench(&report, mode_path[m], &j, runs);
+            }
+        }
+    }
+    conv_bench_end(&report);
+
+    conv_pool_destroy(pool);
+    free(in);
+    free(out);
+    free(in_q);
+    free(out_q);
+    return 0;
+}
@@ -0,0 +1,220 @@
+#ifndef OURCONV_CMD_H
+#define OURCONV_CMD_H
+
+// OurCONV command helpers shared by the driver's executors. Private to the
+// chipyard/ourconv_*.c files: each acc_* issues one custom instruction, or
+// with -DOURCONV_MODEL runs it on the software model and the virtual clock.
+
+#include <stdint.h>
+#include <string.h>
+#include "ourconv_driver.h"
+#include "ourconv_model.h"
+#ifndef OURCONV_MODEL
+#include "rocc.h"
+#endif
+
+#define CUSTOM_OPCODE 0
+#define PACKED_KERNEL_LEN ((OURCONV_KERNEL_REGS + 3) / 4)
+#define PACKED_INPUT_LEN ((OURCONV_INPUT_REGS + 3) / 4)
+
+static inline void count_cmd(ourconv_dev* dev, int type, unsigned words_in, unsigned words_out) {
+    dev->traffic.commands[type]++;
+    dev->traffic.bytes_to_acc += (uint64_t)words_in * 8;
+    dev->traffic.bytes_from_acc += (uint64_t)words_out * 8;
+}
+
+// doCompute rs2 of a tile, with its valid rows/cols if it is ragged, on
+// the current kernel slot
+static inline uint64_t compute_rs2(const ourconv_dev* dev, const conv_tile* tile) {
+    return OURCONV_COMPUTE_RS2(tile->type, tile->out_rows, tile->out_cols) |
+           (uint64_t)dev->slot << OURCONV_SLOT_SHIFT;
+}
+
+// Input window edge for the kernel loaded last (5x5 after reset)
+static inline unsigned input_dim(const ourconv_dev* dev) {
+    return OURCONV_N + (dev->ksize ? dev->ksize : 5) - 1;
+}
+
+// Phase timing for ourconv_trace.h: t = trace_begin(dev); ...;
+// trace_end(dev, phase, t). Empty without -DOURCONV_TRACE.
+static inline uint64_t trace_begin(ourconv_dev* dev) {
+#ifdef OURCONV_TRACE
+    return dev->trace ? ourconv_dev_cycles(dev) : 0;
+#else
+    (void)dev;
+    return 0;
+#endif
+}
+
+static inline void trace_end(ourconv_dev* dev, int phase, uint64_t start) {
+#ifdef OURCONV_TRACE
+    if (dev->trace) {
+        ourconv_trace_span(dev->trace, phase, start, ourconv_dev_cycles(dev));
+    }
+#else
+    (void)dev;
+    (void)phase;
+    (void)start;
+#endif
+}
+
+// Accelerator commands. ready is when rd gets written (model only; on the
+// core the scoreboard tracks it).
+#ifdef OURCONV_MODEL
+static inline uint64_t acc_cmd(ourconv_dev* dev, unsigned funct7, uint64_t rs1, uint64_t rs2, uint64_t* ready) {
+    uint64_t before = ourconv_model_cycles(&dev->model) - dev->model.cycles[OURCONV_PHASE_COMMAND];
+    uint64_t rd = ourconv_model_cmd(&dev->model, funct7, rs1, rs2);
+    uint64_t fsm = ourconv_model_cycles(&dev->model) - dev->model.cycles[OURCONV_PHASE_COMMAND] - before;
+
+    // The round trip overlaps whatever the accelerator is still busy with
+    uint64_t start = dev->now + dev->model.timing.cmd_overhead;
+    if (start < dev->acc_free) {
+        start = dev->acc_free;
+    }
+    dev->acc_free = start + fsm;
+    *ready = dev->acc_free;
+#ifdef OURCONV_TRACE
+    if (dev->trace) {
+        ourconv_trace_span(dev->trace, OURCONV_TRACE_ACCELERATOR, start, dev->acc_free);
+    }
+#endif
+    dev->now++;
+    return rd;
+}
+#endif
+
+static inline uint64_t acc_load_kernel(ourconv_dev* dev, const uint64_t* p, uint64_t code, uint64_t* ready) {
+    dev->ksize = (code & 3) == 0 ? 1 : (code & 3) == 1 ? 3 : 5;
+    count_cmd(dev, OURCONV_CMD_LOAD_KERNEL, (unsigned)(dev->ksize * dev->ksize + 3) / 4, 0);
+#ifdef OURCONV_MODEL
+    return acc_cmd(dev, OURCONV_FUNCT7_LOADKERNEL, (uint64_t)(uintptr_t)p, code, ready);
+#else
+    uint64_t rd;
+    *ready = 0;
+    ROCC_INSTRUCTION_DSS(CUSTOM_OPCODE, rd, (uint64_t)(uintptr_t)p, code, OURCONV_FUNCT7_LOADKERNEL);
+    return rd;
+#endif
+}
+
+static inline uint64_t acc_load_input(ourconv_dev* dev, const uint64_t* p, uint64_t* ready) {
+    count_cmd(dev, OURCONV_CMD_LOAD_INPUT, (input_dim(dev) * input_dim(dev) + 3) / 4, 0);
+#ifdef OURCONV_MODEL
+    return acc_cmd(dev, OURCONV_FUNCT7_LOADINPUT, (uint64_t)(uintptr_t)p, 0, ready);
+#else
+    uint64_t rd;
+    *ready = 0;
+    ROCC_INSTRUCTION_DSS(CUSTOM_OPCODE, rd, (uint64_t)(uintptr_t)p, 0, OURCONV_FUNCT7_LOADINPUT);
+    return rd;
+#endif
+}
+
+static inline uint64_t acc_slide_input(ourconv_dev* dev, const uint64_t* p, uint64_t cols, uint64_t* ready) {
+    count_cmd(dev, OURCONV_CMD_SLIDE_INPUT, input_dim(dev) * OURCONV_SLIDE_COLS / 4, 0);
+#ifdef OURCONV_MODEL
+    return acc_cmd(dev, OURCONV_FUNCT7_SLIDEINPUT, (uint64_t)(uintptr_t)p, cols, ready);
+#else
+    uint64_t rd;
+    *ready = 0;
+    ROCC_INSTRUCTION_DSS(CUSTOM_OPCODE, rd, (uint64_t)(uintptr_t)p, cols, OURCONV_FUNCT7_SLIDEINPUT);
+    return rd;
+#endif
+}
+
+static inline uint64_t acc_compute(ourconv_dev* dev, uint64_t* p, uint64_t type, uint64_t* ready) {
+    count_cmd(dev, OURCONV_CMD_COMPUTE, 0, ourconv_compute_words(type));
+#ifdef OURCONV_MODEL
+    return acc_cmd(dev, OURCONV_FUNCT7_COMPUTE, (uint64_t)(uintptr_t)p, type, ready);
+#else
+    uint64_t rd;
+    *ready = 0;
+    ROCC_INSTRUCTION_DSS(CUSTOM_OPCODE, rd, (uint64_t)(uintptr_t)p, type, OURCONV_FUNCT7_COMPUTE);
+    return rd;
+#endif
+}
+
+static inline uint64_t acc_counter_cmd(ourconv_dev* dev, unsigned funct7, uint64_t index, uint64_t* ready) {
+    count_cmd(dev, OURCONV_CMD_COUNTERS, 0, 0);
+#ifdef OURCONV_MODEL
+    return acc_cmd(dev, funct7, 0, index, ready);
+#else
+    uint64_t rd;
+    *ready = 0;
+    if (funct7 == OURCONV_FUNCT7_READCOUNTER) {
+        ROCC_INSTRUCTION_DSS(CUSTOM_OPCODE, rd, 0, index, OURCONV_FUNCT7_READCOUNTER);
+    } else {
+        ROCC_INSTRUCTION_DSS(CUSTOM_OPCODE, rd, 0, index, OURCONV_FUNCT7_RESETCOUNTERS);
+    }
+    return rd;
+#endif
+}
+
+// Makes a packed kernel the one doCompute reads. A slot that holds it is
+// reused; otherwise the least recently used slot gets a doLoadKernel, and
+// 1 is returned with its rd/ready. Kernels of another size than the active
+// one are reloaded, as the input window layout follows the active size.
+static inline int acc_use_kernel(ourconv_dev* dev, const uint64_t* packed, int ksize,
+                                 uint64_t* rd, uint64_t* ready) {
+    size_t bytes = sizeof(uint64_t) * (size_t)((ksize * ksize + 3) / 4);
+    int victim = 0;
+
+    dev->lru_clock++;
+    for (int s = 0; s < (int)dev->kernel_slots; s++) {
+        ourconv_kernel_slot* slot = &dev->slots[s];
+        if (slot->ksize == ksize && memcmp(slot->packed, packed, bytes) == 0) {
+            if (ksize == dev->ksize) {
+                slot->used = dev->lru_clock;
+                dev->slot = s;
+                dev->kernel_hits++;
+                return 0;
+            }
+            victim = s;
+            break;
+        }
+        if (slot->used < dev->slots[victim].used) {
+            victim = s;
+        }
+    }
+    ourconv_kernel_slot* slot = &dev->slots[victim];
+    memcpy(slot->packed, packed, bytes);
+    slot->ksize = ksize;
+    slot->used = dev->lru_clock;
+    dev->slot = victim;
+    *rd = acc_load_kernel(dev, packed, (uint64_t)(ksize / 2) | (uint64_t)victim << OURCONV_SLOT_SHIFT, ready);
+    return 1;
+}
+
+// Block until a command's rd is written. On the core, reading rd stalls on
+// the scoreboard; the fence then orders the accelerator's memory writes
+// before our loads of its output buffer.
+static inline uint64_t acc_wait(ourconv_dev* dev, uint64_t rd, uint64_t ready) {
+#ifdef OURCONV_MODEL
+    if (dev->now < ready) {
+        dev->now = ready;
+    }
+#else
+    (void)dev;
+    (void)ready;
+    asm volatile("mv %0, %0\n\tfence" : "+r"(rd) :: "memory");
+#endif
+    return rd;
+}
+
+// Make packed buffers visible before handing them to the accelerator
+static inline void acc_fence(void) {
+#ifdef OURCONV_MODEL
+    __sync_synchronize();
+#else
+    asm volatile("fence" ::: "memory");
+#endif
+}
+
+static inline void host_work(ourconv_dev* dev, unsigned values) {
+#ifdef OURCONV_MODEL
+    dev->now += (uint64_t)values * dev->host_cycles_per_value;
+#else
+    (void)dev;
+    (void)values;
+#endif
+}
+
+#endif
@@ -0,0 +1,477 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ourconv_driver.h"
+#include "ourconv_cmd.h"
+#include "ourconv_model.h"
+#include "ourconv_pack.h"
+
+void ourconv_dev_init(ourconv_dev* dev) {
+    memset(dev, 0, sizeof(*dev));
+#ifdef OURCONV_MODEL
+    ourconv_model_init(&dev->model);
+    dev->host_cycles_per_value = OURCONV_HOST_CYCLES_PER_VALUE;
+#endif
+    dev->kernel_slots = OURCONV_KERNEL_SLOTS;
+}
+
+uint64_t ourconv_dev_cycles(ourconv_dev* dev) {
+#ifdef OURCONV_MODEL
+    return dev->now;
+#else
+    uint64_t cycles;
+    (void)dev;
+    asm volatile ("rdcycle %0" : "=r" (cycles));
+    return cycles;
+#endif
+}
+
+int ourconv_dev_load_kernel(ourconv_dev* dev, const int16_t* k, int ksize) {
+    uint64_t packed[PACKED_KERNEL_LEN];
+    uint64_t ready;
+
+    if (!dev || !k || (ksize != 1 && ksize != 3 && ksize != 5)) {
+        return CONV_EINVAL;
+    }
+    uint64_t t = trace_begin(dev);
+    ourconv_pack_q88(k, ksize, ksize, ksize, 0, 0, ksize, ksize, packed);
+    host_work(dev, (unsigned)(ksize * ksize));
+    trace_end(dev, OURCONV_TRACE_KERNEL_PACK, t);
+    acc_fence();
+    uint64_t rd;
+    t = trace_begin(dev);
+    if (acc_use_kernel(dev, packed, ksize, &rd, &ready)) {
+        acc_wait(dev, rd, ready);
+        trace_end(dev, OURCONV_TRACE_KERNEL_LOAD, t);
+    }
+    return CONV_OK;
+}
+
+int ourconv_dev_reset_counters(ourconv_dev* dev) {
+    uint64_t ready;
+
+    if (!dev) {
+        return CONV_EINVAL;
+    }
+    uint64_t rd = acc_counter_cmd(dev, OURCONV_FUNCT7_RESETCOUNTERS, 0, &ready);
+    acc_wait(dev, rd, ready);
+#ifdef OURCONV_MODEL
+    dev->counters_reset = dev->now;
+#endif
+    return CONV_OK;
+}
+
+int ourconv_dev_read_counters(ourconv_dev* dev, uint64_t* counters) {
+    uint64_t ready;
+
+    if (!dev || !counters) {
+        return CONV_EINVAL;
+    }
+#ifdef OURCONV_MODEL
+    uint64_t now = dev->now > dev->acc_free ? dev->now : dev->acc_free;
+#endif
+    for (int c = 0; c < OURCONV_COUNTERS; c++) {
+        uint64_t rd = acc_counter_cmd(dev, OURCONV_FUNCT7_READCOUNTER, (uint64_t)c, &ready);
+        counters[c] = acc_wait(dev, rd, ready);
+    }
+#ifdef OURCONV_MODEL
+    counters[OURCONV_CTR_CYCLES] = now - dev->counters_reset;
+#endif
+    return CONV_OK;
+}
+
+// Output tiles of a strided or dilated convolution: CENTER tiles of up to
+// per_tile x per_tile outputs whose windows start at out * stride - pad, so
+// the packer zero-fills the padding and no edge tile types are needed.
+typedef struct {
+    int oh, ow;
+    int per_tile;
+    int tiles_y, tiles_x;
+    int stride, pad;
+} strided_tiling;
+
+static void strided_tile_at(const strided_tiling* t, int idx, conv_tile* tile) {
+    int ty = idx / t->tiles_x;
+    int tx = idx % t->tiles_x;
+
+    tile->type = CONV_TILE_CENTER;
+    tile->out_row = ty * t->per_tile;
+    tile->out_col = tx * t->per_tile;
+    tile->out_rows = t->oh - tile->out_row < t->per_tile ? t->oh - tile->out_row : t->per_tile;
+    tile->out_cols = t->ow - tile->out_col < t->per_tile ? t->ow - tile->out_col : t->per_tile;
+    tile->in_row = tile->out_row * t->stride - t->pad;
+    tile->in_col = tile->out_col * t->stride - t->pad;
+}
+
+// Where tile inputs come from: a Q8.8 image packed per tile, or an
+// ourconv_image whose tile windows are already packed.
+typedef struct {
+    const int16_t* in;
+    const ourconv_image* img;
+    int base;              // tile index of descriptor 0 (img only)
+    int h, w, in_tile;
+    int slide;             // OURCONV_SLIDE requested
+    int out_w;             // output row pitch, w unless strided
+    uint64_t step;         // doCompute stride/dilation bits
+    const strided_tiling* strided; // tiles come from here instead
+} tile_source;
+
+// Columns tile i can slide by from tile i - 1, or 0 for a full load. Only
+// windows that share rows and move right by at most a slide block qualify;
+// with a 1x1 kernel there is no halo to keep.
+static inline int slide_cols(const tile_source* src, const conv_tile* tiles, int i) {
+    if (!src->slide || src->img || i == 0 || src->in_tile == OURCONV_N ||
+        tiles[i].in_row != tiles[i - 1].in_row) {
+        return 0;
+    }
+    int cols = tiles[i].in_col - tiles[i - 1].in_col;
+    return cols > 0 && cols <= OURCONV_SLIDE_COLS ? cols : 0;
+}
+
+// Packed input of tile i: packs into buf, or points into the image. With
+// cols > 0 only the new columns are packed, as a doSlideInput block.
+static inline const uint64_t* tile_input(ourconv_dev* dev, const tile_source* src, const conv_tile* tiles,
+                                         int i, int cols, uint64_t* buf) {
+    if (src->img) {
+        return ourconv_image_tile(src->img, src->base + i);
+    }
+    uint64_t t = trace_begin(dev);
+    if (cols) {
+        ourconv_pack_q88(src->in, src->h, src->w, src->w, tiles[i].in_row, tiles[i].in_col + src->in_tile - cols,
+                         src->in_tile, OURCONV_SLIDE_COLS, buf);
+        host_work(dev, (unsigned)(src->in_tile * OURCONV_SLIDE_COLS));
+    } else {
+        ourconv_pack_q88(src->in, src->h, src->w, src->w, tiles[i].in_row, tiles[i].in_col,
+                         src->in_tile, src->in_tile, buf);
+        host_work(dev, (unsigned)(src->in_tile * src->in_tile));
+    }
+    trace_end(dev, OURCONV_TRACE_TILE_PACK, t);
+    return buf;
+}
+
+static inline uint64_t acc_input(ourconv_dev* dev, const uint64_t* p, int cols, uint64_t* ready) {
+    if (cols) {
+        return acc_slide_input(dev, p, (uint64_t)cols, ready);
+    }
+    return acc_load_input(dev, p, ready);
+}
+
+static inline void unpack_tile(ourconv_dev* dev, const uint64_t* packed, int w, const conv_tile* tile,
+                               int16_t* out) {
+    uint64_t t = trace_begin(dev);
+    ourconv_unpack_q88(packed, tile->out_rows, tile->out_cols, out + tile->out_row * w + tile->out_col, w);
+    host_work(dev, (unsigned)(tile->out_rows * tile->out_cols));
+    trace_end(dev, OURCONV_TRACE_UNPACK, t);
+}
+
+static inline uint64_t tile_rs2(const ourconv_dev* dev, const tile_source* src, const conv_tile* tile) {
+    return compute_rs2(dev, tile) | src->step;
+}
+
+static void run_tiles(ourconv_dev* dev, const tile_source* src, const conv_tile* tiles, int count,
+                      int16_t* out, int mode, ourconv_batch_stats* stats) {
+    uint64_t packed_in[2][PACKED_INPUT_LEN];
+    uint64_t packed_out[2][OURCONV_OUTPUT_WORDS];
+    const uint64_t* input[2] = { NULL, NULL };
+    int cols[2] = { 0, 0 };
+    uint64_t overflow = 0;
+    uint64_t ready, load_rd = 0, load_ready = 0;
+    uint64_t compute_rd[2] = { 0, 0 }, compute_ready[2] = { 0, 0 };
+    int w = src->out_w;
+    uint64_t start = ourconv_dev_cycles(dev);
+
+    if (!(mode & OURCONV_PIPELINED)) {
+        for (int i = 0; i < count; i++) {
+            cols[0] = slide_cols(src, tiles, i);
+            input[0] = tile_input(dev, src, tiles, i, cols[0], packed_in[0]);
+            acc_fence();
+            uint64_t t = trace_begin(dev);
+            uint64_t rd = acc_input(dev, input[0], cols[0], &ready);
+            acc_wait(dev, rd, ready);
+            trace_end(dev, OURCONV_TRACE_LOAD_INPUT, t);
+            t = trace_begin(dev);
+            rd = acc_compute(dev, packed_out[0], tile_rs2(dev, src, &tiles[i]), &ready);
+            overflow |= acc_wait(dev, rd, ready);
+            trace_end(dev, OURCONV_TRACE_COMPUTE, t);
+            unpack_tile(dev, packed_out[0], w, &tiles[i], out);
+        }
+    } else if (count > 0) {
+        input[0] = tile_input(dev, src, tiles, 0, 0, packed_in[0]);
+
+        for (int i = 0; i < count; i++) {
+            int s = i & 1;
+
+            acc_fence();
+            uint64_t t = trace_begin(dev);
+            uint64_t rd = acc_input(dev, input[s], cols[s], &ready);
+            trace_end(dev, OURCONV_TRACE_LOAD_INPUT, t);
+            t = trace_begin(dev);
+            compute_rd[s] = acc_compute(dev, packed_out[s], tile_rs2(dev, src, &tiles[i]), &compute_ready[s]);
+            trace_end(dev, OURCONV_TRACE_COMPUTE, t);
+
+            // The other input buffer is free once the previous load is done
+            if (i + 1 < count) {
+                if (i > 0 && !src->img) {
+                    t = trace_begin(dev);
+                    acc_wait(dev, load_rd, load_ready);
+                    trace_end(dev, OURCONV_TRACE_LOAD_INPUT, t);
+                }
+                cols[s ^ 1] = slide_cols(src, tiles, i + 1);
+                input[s ^ 1] = tile_input(dev, src, tiles, i + 1, cols[s ^ 1], packed_in[s ^ 1]);
+            }
+            if (i > 0) {
+                t = trace_begin(dev);
+                overflow |= acc_wait(dev, compute_rd[s ^ 1], compute_ready[s ^ 1]);
+                trace_end(dev, OURCONV_TRACE_COMPUTE, t);
+                unpack_tile(dev, packed_out[s ^ 1], w, &tiles[i - 1], out);
+            }
+            load_rd = rd;
+            load_ready = ready;
+        }
+
+        int s = (count - 1) & 1;
+        uint64_t t = trace_begin(dev);
+        overflow |= acc_wait(dev, compute_rd[s], compute_ready[s]);
+        trace_end(dev, OURCONV_TRACE_COMPUTE, t);
+        unpack_tile(dev, packed_out[s], w, &tiles[count - 1], out);
+    }
+
+    if (stats) {
+        stats->cycles = ourconv_dev_cycles(dev) - start;
+        stats->tiles = (uint64_t)count;
+        stats->overflow = overflow;
+    }
+}
+
+int ourconv_run_tiles(ourconv_dev* dev, const int16_t* in, int h, int w,
+                      const conv_tile* tiles, int count, int16_t* out,
+                      int mode, ourconv_batch_stats* stats) {
+    if (!dev || !dev->ksize || !in || !out || !tiles || count < 0 || h <= 0 || w <= 0) {
+        return CONV_EINVAL;
+    }
+    tile_source src = { in, NULL, 0, h, w, OURCONV_N + dev->ksize - 1, mode & OURCONV_SLIDE, w, 0, NULL };
+    run_tiles(dev, &src, tiles, count, out, mode, stats);
+    return CONV_OK;
+}
+
+// Runs every tile of a tiling in chunks of descriptors, so the stack stays
+// small on the bare-metal target; the pipeline drains at each chunk boundary.
+static void run_all_tiles(ourconv_dev* dev, tile_source* src, const conv_tiling* t,
+                          int16_t* out, int mode, ourconv_batch_stats* stats) {
+    enum { TILE_CHUNK = 64 };
+    conv_tile tiles[TILE_CHUNK];
+    ourconv_batch_stats chunk;
+
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+    const strided_tiling* st = src->strided;
+    int total = st ? st->tiles_y * st->tiles_x : conv_tiling_count(t);
+    for (int base = 0; base < total; base += TILE_CHUNK) {
+        int n = total - base < TILE_CHUNK ? total - base : TILE_CHUNK;
+        for (int i = 0; i < n; i++) {
+            if (st) {
+                strided_tile_at(st, base + i, &tiles[i]);
+            } else {
+                conv_tile_at(t, base + i, &tiles[i]);
+            }
+        }
+        src->base = base;
+        run_tiles(dev, src, tiles, n, out, mode, &chunk);
+        if (stats) {
+            stats->cycles += chunk.cycles;
+            stats->tiles += chunk.tiles;
+            stats->overflow |= chunk.overflow;
+        }
+    }
+}
+
+int ourconv_conv2d_q88(ourconv_dev* dev, const int16_t* in, int h, int w,
+                       const int16_t* k, int ksize, int16_t* out,
+                       int mode, ourconv_batch_stats* stats) {
+    conv_tiling t;
+
+    if (ksize > 5) {
+        return ourconv_conv2d_large(dev, in, h, w, k, ksize, out, NULL, mode, stats);
+    }
+    if (!in || !out ||
+        conv_tiling_init(&t, h, w, ksize, OURCONV_N) != CONV_OK ||
+        ourconv_dev_load_kernel(dev, k, ksize) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+    tile_source src = { in, NULL, 0, h, w, OURCONV_N + ksize - 1, mode & OURCONV_SLIDE, w, 0, NULL };
+    run_all_tiles(dev, &src, &t, out, mode, stats);
+    return CONV_OK;
+}
+
+int ourconv_conv2d_q88_ex(ourconv_dev* dev, const int16_t* in, int h, int w,
+                          const int16_t* k, int ksize, const conv2d_params* params,
+                          int16_t* out, int mode, ourconv_batch_stats* stats) {
+    strided_tiling st;
+    int16_t k5[25];
+    int dil = params && params->dilation ? params->dilation : 1;
+
+    st.stride = params ? params->stride : 1;
+    st.pad = params ? params->pad : ksize / 2;
+    // A dilated 3x3 is a 5x5 with zero taps in between, which fits more
+    // outputs per tile than the dilated scan does; only a dilated 5x5 needs it
+    if (k && ksize == 3 && dil == 2) {
+        memset(k5, 0, sizeof(k5));
+        for (int i = 0; i < 9; i++) {
+            k5[i / 3 * 10 + i % 3 * 2] = k[i];
+        }
+        k = k5;
+        ksize = 5;
+        dil = 1;
+    }
+    if (ksize == 1) {
+        dil = 1;
+    }
+    if (st.stride == 1 && dil == 1 && st.pad == ksize / 2) {
+        return ourconv_conv2d_q88(dev, in, h, w, k, ksize, out, mode, stats);
+    }
+    if (!in || !out || (st.stride != 1 && st.stride != 2 && st.stride != 4) || (dil != 1 && dil != 2)) {
+        return CONV_EINVAL;
+    }
+    st.oh = conv2d_out_size(h, (ksize - 1) * dil + 1, st.stride, st.pad);
+    st.ow = conv2d_out_size(w, (ksize - 1) * dil + 1, st.stride, st.pad);
+    st.per_tile = (int)ourconv_strided_outputs(ksize, st.stride, dil);
+    if (st.oh <= 0 || st.ow <= 0 || ourconv_dev_load_kernel(dev, k, ksize) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+    st.tiles_y = (st.oh + st.per_tile - 1) / st.per_tile;
+    st.tiles_x = (st.ow + st.per_tile - 1) / st.per_tile;
+
+    tile_source src = { in, NULL, 0, h, w, OURCONV_N + ksize - 1, 0, st.ow,
+                        ourconv_compute_step(st.stride, dil), &st };
+    run_all_tiles(dev, &src, NULL, out, mode, stats);
+    return CONV_OK;
+}
+
+int ourconv_conv2d_image(ourconv_dev* dev, const ourconv_image* img,
+                         const int16_t* k, int16_t* out,
+                         int mode, ourconv_batch_stats* stats) {
+    if (!img || !img->words || !out ||
+        ourconv_dev_load_kernel(dev, k, img->ksize) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+    tile_source src = { NULL, img, 0, img->h, img->w, img->in_tile, 0, img->w, 0, NULL };
+    run_all_tiles(dev, &src, &img->tiling, out, mode, stats);
+    return CONV_OK;
+}
+
+// Smallest accelerator kernel size holding n taps
+static int subkernel_size(int n) {
+    return n <= 1 ? 1 : n <= 3 ? 3 : 5;
+}
+
+int ourconv_split_kernel(const int16_t* k, int ksize, ourconv_subkernel* sub) {
+    int count = 0, pad = ksize / 2;
+
+    if (!k || !sub || ksize < 1 || ksize % 2 == 0 || ksize > OURCONV_MAX_KSIZE) {
+        return CONV_EINVAL;
+    }
+    for (int r0 = 0; r0 < ksize; r0 += 5) {
+        for (int c0 = 0; c0 < ksize; c0 += 5) {
+            int rows = ksize - r0 < 5 ? ksize - r0 : 5;
+            int cols = ksize - c0 < 5 ? ksize - c0 : 5;
+            int s = subkernel_size(rows > cols ? rows : cols), nonzero = 0;
+            ourconv_subkernel* b = &sub[count];
+
+            memset(b->k, 0, sizeof(b->k));
+            for (int i = 0; i < rows; i++) {
+                for (int j = 0; j < cols; j++) {
+                    b->k[i * s + j] = k[(r0 + i) * ksize + c0 + j];
+                    nonzero |= b->k[i * s + j] != 0;
+                }
+            }
+            b->ksize = s;
+            b->dy = r0 + s / 2 - pad;
+            b->dx = c0 + s / 2 - pad;
+            count += nonzero;
+        }
+    }
+    return count;
+}
+
+int ourconv_conv2d_large(ourconv_dev* dev, const int16_t* in, int h, int w,
+                         const int16_t* k, int ksize, int16_t* out, uint8_t* overflow,
+                         int mode, ourconv_batch_stats* stats) {
+    ourconv_subkernel sub[OURCONV_MAX_SUBKERNELS];
+    ourconv_batch_stats total, pass;
+    size_t plane = (size_t)h * w;
+    int count = ourconv_split_kernel(k, ksize, sub);
+
+    if (!dev || !in || !out || h <= 0 || w <= 0 || count < 0) {
+        return CONV_EINVAL;
+    }
+    // The window of a sub-kernel is the input shifted by its offset, with
+    // the zero padding of the big kernel: (h + s - 1) x (w + s - 1)
+    int16_t* window = malloc(sizeof(int16_t) * (h + 4) * (w + 4));
+    int16_t* part = malloc(sizeof(int16_t) * plane);
+    int32_t* sum = calloc(plane, sizeof(int32_t));
+    if (!window || !part || !sum) {
+        free(window);
+        free(part);
+        free(sum);
+        return CONV_ENOMEM;
+    }
+    if (overflow) {
+        memset(overflow, 0, plane);
+    }
+
+    memset(&total, 0, sizeof(total));
+    int status = CONV_OK;
+    uint64_t start = ourconv_dev_cycles(dev);
+    for (int n = 0; n < count; n++) {
+        int s = sub[n].ksize, wh = h + s - 1, ww = w + s - 1;
+        int r0 = sub[n].dy - s / 2, c0 = sub[n].dx - s / 2;
+        conv2d_params valid = { 1, 0, 1 };
+        uint64_t t = trace_begin(dev);
+
+        for (int i = 0; i < wh; i++) {
+            for (int j = 0; j < ww; j++) {
+                int r = r0 + i, c = c0 + j;
+                window[i * ww + j] = r >= 0 && r < h && c >= 0 && c < w ? in[(size_t)r * w + c] : 0;
+            }
+        }
+        host_work(dev, (unsigned)(wh * ww));
+        trace_end(dev, OURCONV_TRACE_PARTIALS, t);
+        status = ourconv_conv2d_q88_ex(dev, window, wh, ww, sub[n].k, s, &valid, part, mode, &pass);
+        if (status != CONV_OK) {
+            break;
+        }
+        total.tiles += pass.tiles;
+        total.overflow |= pass.overflow;
+
+        t = trace_begin(dev);
+        for (size_t i = 0; i < plane; i++) {
+            sum[i] += part[i];
+            if (overflow && (part[i] == 32767 || part[i] == -32768)) {
+                overflow[i] = 1;
+            }
+        }
+        host_work(dev, (unsigned)plane);
+        trace_end(dev, OURCONV_TRACE_PARTIALS, t);
+    }
+    if (status == CONV_OK) {
+        uint64_t t = trace_begin(dev);
+        for (size_t i = 0; i < plane; i++) {
+            int32_t v = sum[i] > 32767 ? 32767 : sum[i] < -32768 ? -32768 : sum[i];
+            if (overflow && sum[i] != v) {
+                overflow[i] = 1;
+            }
+            out[i] = (int16_t)v;
+        }
+        host_work(dev, (unsigned)plane);
+        trace_end(dev, OURCONV_TRACE_PARTIALS, t);
+        total.cycles = ourconv_dev_cycles(dev) - start;
+        if (stats) {
+            *stats = total;
+        }
+    }
+
+    free(window);
+    free(part);
+    free(sum);
+    return status;
+}
@@ -0,0 +1,172 @@
+#ifndef OURCONV_DRIVER_H
+#define OURCONV_DRIVER_H
+
+// Image-level driver for the OurCONV accelerator.
+//
+// The accelerator takes one 8x8 output tile per doLoadInput + doCompute
+// pair; on ragged right/bottom edges the doCompute carries the tile's valid
+// rows and columns, so images of any size run without a padded copy.
+// OURCONV_SERIAL drives it like convFSM_test.c: pack a tile, send it, block
+// on each rd, unpack, repeat. OURCONV_PIPELINED keeps two packed input and
+// two packed output buffers: while the accelerator works on tile i the core
+// packs tile i + 1 and unpacks tile i - 1, and it only consumes the rd of a
+// doCompute once it needs that tile's output buffer again.
+//
+// Kernels go through an LRU over the accelerator's kernel slots: loading a
+// kernel that a slot still holds issues no command, so alternating filters
+// (Sobel X / Sobel Y, the filters of a layer) are fetched once.
+//
+// OURCONV_SLIDE can be OR-ed into either mode: consecutive tiles of a tile
+// row then go through doSlideInput, which keeps the halo columns already in
+// the accelerator and transfers only the new ones.
+//
+// Built with -DOURCONV_MODEL the commands go to the software model
+// (ourconv_model.h) instead, and the driver keeps a virtual clock in which
+// command round trips, the accelerator FSM (ourconv_perf.h) and host
+// packing overlap the same way they would on the core.
+//
+// Built with -DOURCONV_TRACE every phase of a run is timed into the
+// ourconv_trace attached to dev->trace (ourconv_trace.h).
+
+#include <stdint.h>
+#include "conv_tiles.h"
+#include "ourconv_image.h"
+#include "ourconv_model.h"
+#include "ourconv_trace.h"
+
+enum ourconv_mode {
+    OURCONV_SERIAL = 0,
+    OURCONV_PIPELINED = 1,
+    OURCONV_SLIDE = 2      // flag: reuse the previous tile's halo
+};
+
+// RoCC commands by type
+enum ourconv_cmd_type {
+    OURCONV_CMD_LOAD_KERNEL,
+    OURCONV_CMD_LOAD_INPUT,
+    OURCONV_CMD_SLIDE_INPUT,
+    OURCONV_CMD_COMPUTE,
+    OURCONV_CMD_COUNTERS,  // doReadCounter / doResetCounters
+    OURCONV_CMD_TYPES
+};
+
+// What crossed the core/accelerator boundary, counted by the driver as it
+// issues commands (on the core as well as under the model).
+typedef struct {
+    uint64_t commands[OURCONV_CMD_TYPES];
+    uint64_t bytes_to_acc;   // kernel and input words the accelerator reads
+    uint64_t bytes_from_acc; // result words it writes
+    uint64_t psum_bytes;     // partial sums the core reads and writes in memory
+} ourconv_traffic;
+
+// Host copy of what a kernel slot holds
+typedef struct {
+    uint64_t packed[(OURCONV_KERNEL_REGS + 3) / 4];
+    int ksize;     // 0 = empty
+    uint64_t used; // LRU stamp
+} ourconv_kernel_slot;
+
+typedef struct {
+#ifdef OURCONV_MODEL
+    ourconv_model model;
+    uint64_t now;      // host time
+    uint64_t acc_free; // accelerator idle from this time on
+    unsigned host_cycles_per_value; // packing/unpacking cost on the core
+#endif
+    int ksize;         // active kernel size (kernel loaded last), 0 if none
+    int slot;          // slot doCompute reads
+    unsigned kernel_slots; // slots the LRU may use, 1..OURCONV_KERNEL_SLOTS
+    ourconv_kernel_slot slots[OURCONV_KERNEL_SLOTS];
+    uint64_t lru_clock;
+    uint64_t kernel_hits; // kernel loads served from a slot
+#ifdef OURCONV_MODEL
+    uint64_t counters_reset; // host time of the last counter reset
+#endif
+    ourconv_traffic traffic;
+    // Declared with or without -DOURCONV_TRACE so the layout never depends
+    // on the flag; only the hooks in ourconv_cmd.h do
+    ourconv_trace* trace; // NULL: not traced
+} ourconv_dev;
+
+// Uncalibrated guess for pack/unpack on an in-order core: load, shift,
+// or, store per 16-bit value. Only used by the model's virtual clock.
+#define OURCONV_HOST_CYCLES_PER_VALUE 4
+
+typedef struct {
+    uint64_t cycles;   // rdcycle delta (model: virtual clock delta)
+    uint64_t tiles;
+    uint64_t overflow; // OR of the doCompute results
+} ourconv_batch_stats;
+
+void ourconv_dev_init(ourconv_dev* dev);
+uint64_t ourconv_dev_cycles(ourconv_dev* dev);
+
+// Q8.8 kernel, 1x1, 3x3 or 5x5, row-major. Issues a doLoadKernel only if
+// no slot holds it yet.
+int ourconv_dev_load_kernel(ourconv_dev* dev, const int16_t* k, int ksize);
+
+// Accelerator performance counters (enum ourconv_counter). Reset issues a
+// doResetCounters; read issues one doReadCounter per counter into
+// counters[OURCONV_COUNTERS]. Under the model the cycle counter is taken
+// from the virtual clock since the reset, so like the free-running RTL
+// counter it includes the time the accelerator sat idle.
+int ourconv_dev_reset_counters(ourconv_dev* dev);
+int ourconv_dev_read_counters(ourconv_dev* dev, uint64_t* counters);
+
+// Runs the listed tiles of an h x w Q8.8 image with the loaded kernel and
+// scatters each result into out. The descriptors come from conv_tiles.h
+// with tile_size 8.
+int ourconv_run_tiles(ourconv_dev* dev, const int16_t* in, int h, int w,
+                      const conv_tile* tiles, int count, int16_t* out,
+                      int mode, ourconv_batch_stats* stats);
+
+// Whole-image "same" convolution: loads k, then runs every tile. Kernels
+// above 5x5 (odd, up to OURCONV_MAX_KSIZE) go through ourconv_conv2d_large().
+int ourconv_conv2d_q88(ourconv_dev* dev, const int16_t* in, int h, int w,
+                       const int16_t* k, int ksize, int16_t* out,
+                       int mode, ourconv_batch_stats* stats);
+
+#define OURCONV_MAX_KSIZE 15
+#define OURCONV_MAX_SUBKERNELS 9 // 3 x 3 blocks of up to 5x5 taps
+
+typedef struct {
+    int ksize;       // 1, 3 or 5
+    int dy, dx;      // centre offset from the centre of the big kernel
+    int16_t k[25];
+} ourconv_subkernel;
+
+// Cuts an odd ksize x ksize Q8.8 kernel, up to OURCONV_MAX_KSIZE, into
+// blocks of at most 5x5 taps, each padded with zero taps to the smallest of
+// 1x1, 3x3 or 5x5 that holds it; all-zero blocks are dropped. 7x7 and 9x9
+// take 4 blocks, 11x11 to 15x15 take 9. Returns the count or CONV_EINVAL.
+int ourconv_split_kernel(const int16_t* k, int ksize, ourconv_subkernel* sub);
+
+// "Same" convolution with a kernel of any odd size up to OURCONV_MAX_KSIZE:
+// one pass per sub-kernel over the input window shifted by its offset, the
+// partial planes summed in 32 bits on the core and clamped once, like the
+// channels of ourconv_conv_layer_q88(). Products are floored and summed
+// exactly as conv2d_q88() does, so the result is identical unless a partial
+// saturates. overflow (may be NULL) gets 1 where a partial or the sum
+// reached the Q8.8 limits. stats sums every pass.
+int ourconv_conv2d_large(ourconv_dev* dev, const int16_t* in, int h, int w,
+                         const int16_t* k, int ksize, int16_t* out, uint8_t* overflow,
+                         int mode, ourconv_batch_stats* stats);
+
+// Convolution with stride 1, 2 or 4, dilation 1 or 2 and any padding, with
+// the conv2d_q88_ex() numerics; out is conv2d_out_size(h, ...) x
+// conv2d_out_size(w, ...). Tiles hold ourconv_strided_outputs() outputs per
+// axis and only those are computed and written back. Stride 1, dilation 1
+// and pad ksize / 2 runs ourconv_conv2d_q88(); otherwise OURCONV_SLIDE is
+// ignored.
+int ourconv_conv2d_q88_ex(ourconv_dev* dev, const int16_t* in, int h, int w,
+                          const int16_t* k, int ksize, const conv2d_params* params,
+                          int16_t* out, int mode, ourconv_batch_stats* stats);
+
+// ourconv_conv2d_q88() with a pre-quantized image: tile windows go to
+// doLoadInput by pointer, so the core only unpacks outputs. k must match
+// img->ksize. OURCONV_SLIDE is ignored, the stored windows are whole.
+int ourconv_conv2d_image(ourconv_dev* dev, const ourconv_image* img,
+                         const int16_t* k, int16_t* out,
+                         int mode, ourconv_batch_stats* stats);
+
+#endif
@@ -0,0 +1,442 @@
+// Build (host, software model):
+//   gcc -O2 -DOURCONV_MODEL -I.. -o ourconv_driver_test ourconv_driver_test.c ourconv_driver.c ourconv_pack.c ourconv_model.c ourconv_perf.c ../conv_tiles.c ../conv.c ../conv_simd.c
+// On the RoCC target drop -DOURCONV_MODEL and add -I../test for rocc.h.
+//
+// Checks that serial, pipelined and pipelined + sliding batches give the
+// conv2d_q88() result, also on ragged and tiny images, and compares their
+// throughput in cycles per tile and the input words each tile reads.
+// Strided and dilated runs are checked against conv2d_q88_ex() and their
+// accelerator cycles compared with a dense run, and 7x7 .. 15x15 kernels,
+// split into 5x5/3x3/1x1 passes, against conv2d_q88().
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "ourconv_driver.h"
+
+static const int modes[] = { OURCONV_SERIAL, OURCONV_PIPELINED, OURCONV_PIPELINED | OURCONV_SLIDE };
+static const char* mode_name[] = { "serial", "pipelined", "sliding" };
+#define MODES 3
+
+static int run(int h, int w, int ksize, int check, uint64_t* cycles, double* words) {
+    int16_t* in = malloc(sizeof(int16_t) * h * w);
+    int16_t* ref = malloc(sizeof(int16_t) * h * w);
+    int16_t* got = malloc(sizeof(int16_t) * h * w);
+    uint8_t* overflow = malloc((size_t)h * w);
+    int16_t k[25];
+    ourconv_batch_stats stats;
+    ourconv_dev dev;
+    int bad = 0;
+
+    for (int i = 0; i < h * w; i++) {
+        in[i] = (int16_t)(rand() % 2049 - 1024);
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (int16_t)(rand() % 513 - 256);
+    }
+    if (check) {
+        conv2d_q88(in, h, w, k, ksize, ref, overflow);
+    }
+
+    for (int mode = 0; mode < MODES; mode++) {
+        ourconv_dev_init(&dev);
+        memset(got, 0, sizeof(int16_t) * h * w);
+        if (ourconv_conv2d_q88(&dev, in, h, w, k, ksize, got, modes[mode], &stats) != CONV_OK) {
+            printf("  %dx%d k%d %s: failed\n", h, w, ksize, mode_name[mode]);
+            bad = 1;
+            continue;
+        }
+        if (check && memcmp(ref, got, sizeof(int16_t) * h * w) != 0) {
+            printf("  %dx%d k%d %s: MISMATCH\n", h, w, ksize, mode_name[mode]);
+            bad = 1;
+        }
+        cycles[mode] = stats.cycles / stats.tiles;
+        words[mode] = (double)(dev.model.mem_reads - (ksize * ksize + 3) / 4) / (double)stats.tiles;
+    }
+    free(in);
+    free(ref);
+    free(got);
+    free(overflow);
+    return bad;
+}
+
+// Compute and write-back cycles of a ragged frame against the multiple of
+// 8 it would have been padded to
+static void report_ragged(int h, int w, int ksize) {
+    int ph = (h + 7) / 8 * 8, pw = (w + 7) / 8 * 8;
+    int16_t* in = calloc((size_t)ph * pw, sizeof(int16_t));
+    int16_t* out = malloc(sizeof(int16_t) * ph * pw);
+    int16_t k[25] = { 0 };
+    uint64_t acc[2];
+    ourconv_dev dev;
+
+    for (int i = 0; i < 2; i++) {
+        ourconv_dev_init(&dev);
+        ourconv_conv2d_q88(&dev, in, i ? ph : h, i ? pw : w, k, ksize, out, OURCONV_PIPELINED, NULL);
+        acc[i] = dev.model.cycles[OURCONV_PHASE_COMPUTE] + dev.model.cycles[OURCONV_PHASE_WRITEBACK];
+    }
+    printf("%dx%d k%d: %llu compute + write-back cycles, %llu padded to %dx%d\n", h, w, ksize,
+           (unsigned long long)acc[0], (unsigned long long)acc[1], ph, pw);
+    free(in);
+    free(out);
+}
+
+// Strides 1/2/4 and dilations 1/2 against conv2d_q88_ex(), serial and
+// pipelined, with "same" and no padding
+static int check_strided(int h, int w) {
+    int16_t* in = malloc(sizeof(int16_t) * h * w);
+    int16_t* ref = malloc(sizeof(int16_t) * h * w);
+    int16_t* got = malloc(sizeof(int16_t) * h * w);
+    int16_t k[25];
+    ourconv_dev dev;
+    int bad = 0;
+
+    for (int i = 0; i < h * w; i++) {
+        in[i] = (int16_t)(rand() % 2049 - 1024);
+    }
+    for (int i = 0; i < 25; i++) {
+        k[i] = (int16_t)(rand() % 513 - 256);
+    }
+    for (int ksize = 1; ksize <= 5; ksize += 2) {
+        for (int stride = 1; stride <= 4; stride *= 2) {
+            for (int dil = 1; dil <= 2; dil++) {
+                int ext = (ksize - 1) * dil + 1;
+                for (int pad = ext / 2; pad >= 0; pad -= ext / 2 ? ext / 2 : 1) {
+                    conv2d_params params = { stride, pad, dil };
+                    int n = conv2d_out_size(h, ext, stride, pad) * conv2d_out_size(w, ext, stride, pad);
+                    conv2d_q88_ex(in, h, w, k, ksize, &params, ref, NULL);
+                    for (int mode = OURCONV_SERIAL; mode <= OURCONV_PIPELINED; mode++) {
+                        ourconv_dev_init(&dev);
+                        memset(got, 0, sizeof(int16_t) * h * w);
+                        if (ourconv_conv2d_q88_ex(&dev, in, h, w, k, ksize, &params, got, mode, NULL) != CONV_OK ||
+                            memcmp(ref, got, sizeof(int16_t) * n) != 0) {
+                            printf("  %dx%d k%d stride %d pad %d dilation %d %s: MISMATCH\n", h, w, ksize,
+                                   stride, pad, dil, mode_name[mode]);
+                            bad = 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    conv2d_params odd = { 3, 1, 1 };
+    if (ourconv_conv2d_q88_ex(&dev, in, h, w, k, 3, &odd, got, OURCONV_SERIAL, NULL) != CONV_EINVAL) {
+        printf("  stride 3 accepted\n");
+        bad = 1;
+    }
+    free(in);
+    free(ref);
+    free(got);
+    return bad;
+}
+
+// Kernels above 5x5: bit-exact while no partial saturates; with large
+// values every pixel conv2d_q88() clamps must be flagged, and unflagged
+// pixels must still match
+static int check_large(int h, int w) {
+    static const int passes[] = { 4, 4, 9, 9, 9 }; // 7, 9, 11, 13, 15
+    size_t plane = (size_t)h * w;
+    int16_t* in = malloc(sizeof(int16_t) * plane);
+    int16_t* ref = malloc(sizeof(int16_t) * plane);
+    int16_t* got = malloc(sizeof(int16_t) * plane);
+    uint8_t* ref_ovf = malloc(plane);
+    uint8_t* got_ovf = malloc(plane);
+    int16_t k[OURCONV_MAX_KSIZE * OURCONV_MAX_KSIZE];
+    ourconv_subkernel sub[OURCONV_MAX_SUBKERNELS];
+    ourconv_dev dev;
+    int bad = 0;
+
+    for (int big = 0; big <= 1; big++) {
+        int range = big ? 32767 : 256;
+        for (size_t i = 0; i < plane; i++) {
+            in[i] = (int16_t)(rand() % (2 * range + 1) - range);
+        }
+        for (int ksize = 7; ksize <= OURCONV_MAX_KSIZE; ksize += 2) {
+            for (int i = 0; i < ksize * ksize; i++) {
+                k[i] = (int16_t)(rand() % 129 - 64);
+            }
+            conv2d_q88(in, h, w, k, ksize, ref, ref_ovf);
+            for (unsigned m = 0; m < MODES; m++) {
+                ourconv_dev_init(&dev);
+                memset(got, 0, sizeof(int16_t) * plane);
+                int status = ourconv_conv2d_large(&dev, in, h, w, k, ksize, got, got_ovf, modes[m], NULL);
+                int mismatch = status != CONV_OK || ourconv_split_kernel(k, ksize, sub) != passes[ksize / 2 - 3];
+                long flagged = 0;
+                for (size_t i = 0; i < plane; i++) {
+                    mismatch |= (ref_ovf[i] && !got_ovf[i]) || (!got_ovf[i] && ref[i] != got[i]);
+                    flagged += got_ovf[i];
+                }
+                // small values never saturate; large ones must
+                mismatch |= big ? flagged == 0 : flagged != 0;
+                if (mismatch) {
+                    printf("  %dx%d k%d range %d %s: MISMATCH\n", h, w, ksize, range, mode_name[m]);
+                    bad = 1;
+                }
+            }
+        }
+    }
+    // A sum that lands exactly on the limit, from two partials well inside
+    // it, is not clamped and must not be flagged
+    memset(in, 0, sizeof(int16_t) * plane);
+    memset(k, 0, sizeof(int16_t) * 7 * 7);
+    k[0] = k[48] = 256; // corner taps, in different sub-kernels
+    in[(size_t)7 * w + 7] = 16383;
+    in[(size_t)13 * w + 13] = 16384;
+    ourconv_dev_init(&dev);
+    ourconv_conv2d_large(&dev, in, h, w, k, 7, got, got_ovf, OURCONV_PIPELINED, NULL);
+    for (size_t i = 0; i < plane; i++) {
+        if (got_ovf[i] || (i == (size_t)10 * w + 10 && got[i] != 32767)) {
+            printf("  exact limit: MISMATCH\n");
+            bad = 1;
+            break;
+        }
+    }
+    // the plain entry point takes them too
+    ourconv_dev_init(&dev);
+    if (ourconv_conv2d_q88(&dev, in, h, w, k, OURCONV_MAX_KSIZE, got, OURCONV_PIPELINED, NULL) != CONV_OK ||
+        ourconv_conv2d_q88(&dev, in, h, w, k, OURCONV_MAX_KSIZE + 2, got, OURCONV_PIPELINED, NULL) != CONV_EINVAL ||
+        ourconv_split_kernel(k, 8, sub) != CONV_EINVAL) {
+        printf("  large kernel sizes: MISMATCH\n");
+        bad = 1;
+    }
+    free(in);
+    free(ref);
+    free(got);
+    free(ref_ovf);
+    free(got_ovf);
+    return bad;
+}
+
+// Cycles of a split kernel against one 5x5 pass over the same image
+static void report_large(int size, int ksize) {
+    int16_t* in = malloc(sizeof(int16_t) * size * size);
+    int16_t* out = malloc(sizeof(int16_t) * size * size);
+    int16_t k[OURCONV_MAX_KSIZE * OURCONV_MAX_KSIZE];
+    ourconv_subkernel sub[OURCONV_MAX_SUBKERNELS];
+    ourconv_batch_stats large, dense;
+    ourconv_dev dev;
+
+    for (int i = 0; i < size * size; i++) {
+        in[i] = (int16_t)((i * 7) % 23 * 16);
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (int16_t)(i % 5 + 1);
+    }
+    ourconv_dev_init(&dev);
+    ourconv_conv2d_q88(&dev, in, size, size, k, 5, out, OURCONV_PIPELINED, &dense);
+    ourconv_dev_init(&dev);
+    ourconv_conv2d_large(&dev, in, size, size, k, ksize, out, NULL, OURCONV_PIPELINED, &large);
+    printf("%dx%d,%d,%d,%llu,%llu,%.2f\n", size, size, ksize, ourconv_split_kernel(k, ksize, sub),
+           (unsigned long long)large.cycles, (unsigned long long)dense.cycles,
+           (double)large.cycles / dense.cycles);
+    free(in);
+    free(out);
+}
+
+// Accelerator cycles and result words of a strided layer run natively
+// against a dense "same" run whose outputs the core would subsample
+static void report_strided(int size, int ksize, int stride) {
+    int16_t* in = calloc((size_t)size * size, sizeof(int16_t));
+    int16_t* out = malloc(sizeof(int16_t) * size * size);
+    int16_t k[25] = { 0 };
+    conv2d_params params = { stride, ksize / 2, 1 };
+    uint64_t acc[2], words[2];
+    ourconv_dev dev;
+
+    for (int i = 0; i < 2; i++) {
+        ourconv_dev_init(&dev);
+        if (i) {
+            ourconv_conv2d_q88(&dev, in, size, size, k, ksize, out, OURCONV_PIPELINED, NULL);
+        } else {
+            ourconv_conv2d_q88_ex(&dev, in, size, size, k, ksize, &params, out, OURCONV_PIPELINED, NULL);
+        }
+        acc[i] = ourconv_model_cycles(&dev.model);
+        words[i] = dev.traffic.bytes_from_acc / 8;
+    }
+    printf("%dx%d,%d,%d,%llu,%llu,%llu,%llu\n", size, size, ksize, stride,
+           (unsigned long long)acc[0], (unsigned long long)words[0],
+           (unsigned long long)acc[1], (unsigned long long)words[1]);
+    free(in);
+    free(out);
+}
+
+// Sobel X and Y in turn over a stream of frames, with one kernel slot (a
+// doLoadKernel at every switch) and with all of them
+static int report_kernel_slots(void) {
+    static const int16_t sobel[2][9] = {
+        { -256, 0, 256, -512, 0, 512, -256, 0, 256 },
+        { -256, -512, -256, 0, 0, 0, 256, 512, 256 },
+    };
+    enum { FRAMES = 16, SIZE = 64 };
+    int16_t* in = malloc(sizeof(int16_t) * SIZE * SIZE);
+    int16_t* ref = malloc(sizeof(int16_t) * SIZE * SIZE * 2);
+    int16_t* got = malloc(sizeof(int16_t) * SIZE * SIZE);
+    uint8_t* overflow = malloc(SIZE * SIZE);
+    unsigned slots[2] = { 1, OURCONV_KERNEL_SLOTS };
+    uint64_t loads[2], cycles[2];
+    ourconv_dev dev;
+    int bad = 0;
+
+    for (int i = 0; i < SIZE * SIZE; i++) {
+        in[i] = (int16_t)(rand() % 513 - 256);
+    }
+    conv2d_q88(in, SIZE, SIZE, sobel[0], 3, ref, overflow);
+    conv2d_q88(in, SIZE, SIZE, sobel[1], 3, ref + SIZE * SIZE, overflow);
+    for (int n = 0; n < 2; n++) {
+        ourconv_dev_init(&dev);
+        dev.kernel_slots = slots[n];
+        for (int f = 0; f < FRAMES; f++) {
+            ourconv_conv2d_q88(&dev, in, SIZE, SIZE, sobel[f & 1], 3, got, OURCONV_PIPELINED, NULL);
+            bad |= memcmp(got, ref + (f & 1) * SIZE * SIZE, sizeof(int16_t) * SIZE * SIZE) != 0;
+        }
+        loads[n] = dev.traffic.commands[OURCONV_CMD_LOAD_KERNEL];
+        cycles[n] = dev.model.cycles[OURCONV_PHASE_KERNEL] + loads[n] * dev.model.timing.cmd_overhead;
+    }
+    printf("Sobel X/Y over %d frames: %llu kernel loads, %llu cycles with 1 slot; "
+           "%llu loads, %llu cycles with %d (%llu saved)\n", FRAMES,
+           (unsigned long long)loads[0], (unsigned long long)cycles[0], (unsigned long long)loads[1],
+           (unsigned long long)cycles[1], OURCONV_KERNEL_SLOTS, (unsigned long long)(cycles[0] - cycles[1]));
+    if (bad || loads[1] != 2) {
+        printf("  kernel slots: MISMATCH\n");
+        bad = 1;
+    }
+    free(in);
+    free(ref);
+    free(got);
+    free(overflow);
+    return bad;
+}
+
+// The accelerator's own counters around one frame per mode: where its
+// time goes (load / compute / write-back busy, idle) as firmware would
+// read it, checked against the driver's tile and traffic counts
+static int report_counters(int size, int ksize) {
+    int16_t* in = malloc(sizeof(int16_t) * size * size);
+    int16_t* out = malloc(sizeof(int16_t) * size * size);
+    int16_t k[25];
+    uint64_t c[OURCONV_COUNTERS];
+    ourconv_batch_stats stats;
+    ourconv_dev dev;
+    int bad = 0;
+
+    for (int i = 0; i < size * size; i++) {
+        in[i] = (int16_t)(rand() % 513 - 256);
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (int16_t)(rand() % 129 - 64);
+    }
+    printf("mode,cycles,load_busy,compute_busy,write_busy,idle,mem_reqs,mem_stall_cycles,tiles\n");
+    for (int m = 0; m < MODES; m++) {
+        ourconv_dev_init(&dev);
+        ourconv_dev_reset_counters(&dev);
+        ourconv_traffic before = dev.traffic;
+        ourconv_conv2d_q88(&dev, in, size, size, k, ksize, out, modes[m], &stats);
+        ourconv_dev_read_counters(&dev, c);
+
+        double cycles = (double)c[OURCONV_CTR_CYCLES];
+        uint64_t busy = c[OURCONV_CTR_LOAD_BUSY] + c[OURCONV_CTR_COMPUTE_BUSY] + c[OURCONV_CTR_WRITE_BUSY];
+        uint64_t bytes = dev.traffic.bytes_to_acc - before.bytes_to_acc + dev.traffic.bytes_from_acc - before.bytes_from_acc;
+        printf("%s,%llu,%.1f%%,%.1f%%,%.1f%%,%.1f%%,%llu,%llu,%llu\n", mode_name[m],
+               (unsigned long long)c[OURCONV_CTR_CYCLES], 100.0 * c[OURCONV_CTR_LOAD_BUSY] / cycles,
+               100.0 * c[OURCONV_CTR_COMPUTE_BUSY] / cycles, 100.0 * c[OURCONV_CTR_WRITE_BUSY] / cycles,
+               100.0 * (cycles - busy) / cycles, (unsigned long long)c[OURCONV_CTR_MEM_REQS],
+               (unsigned long long)c[OURCONV_CTR_MEM_STALLS], (unsigned long long)c[OURCONV_CTR_TILES]);
+        if (c[OURCONV_CTR_TILES] != stats.tiles || c[OURCONV_CTR_MEM_REQS] * 8 != bytes ||
+            c[OURCONV_CTR_MEM_RESPS] != c[OURCONV_CTR_MEM_REQS] || busy > c[OURCONV_CTR_CYCLES] ||
+            c[OURCONV_CTR_CYCLES] < stats.cycles) {
+            printf("  counters, %s: MISMATCH\n", mode_name[m]);
+            bad = 1;
+        }
+    }
+    free(in);
+    free(out);
+    return bad;
+}
+
+int main() {
+    static const int ragged[][2] = { { 1, 1 }, { 5, 7 }, { 17, 20 }, { 37, 21 }, { 9, 300 }, { 123, 77 } };
+    static const int sizes[][2] = { { 32, 32 }, { 256, 256 }, { 1080, 1920 } };
+    uint64_t cycles[MODES];
+    double words[MODES];
+    int bad = 0;
+
+    printf("size,ksize,serial_cycles_per_tile,pipelined_cycles_per_tile,speedup,"
+           "sliding_cycles_per_tile,input_words_per_tile,sliding_input_words_per_tile\n");
+    for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (int ksize = 1; ksize <= 5; ksize += 2) {
+            // 1080p has ~2M pixels: check correctness on the smaller sizes only
+            bad |= run(sizes[s][0], sizes[s][1], ksize, sizes[s][0] <= 256, cycles, words);
+            printf("%dx%d,%d,%llu,%llu,%.2f,%llu,%.1f,%.1f\n", sizes[s][0], sizes[s][1], ksize,
+                   (unsigned long long)cycles[0], (unsigned long long)cycles[1],
+                   (double)cycles[0] / (double)cycles[1], (unsigned long long)cycles[2], words[1], words[2]);
+        }
+    }
+
+    for (unsigned s = 0; s < sizeof(ragged) / sizeof(ragged[0]); s++) {
+        for (int ksize = 1; ksize <= 5; ksize += 2) {
+            bad |= run(ragged[s][0], ragged[s][1], ksize, 1, cycles, words);
+        }
+    }
+    report_ragged(1077, 1917, 3);
+    bad |= report_kernel_slots();
+    bad |= report_counters(256, 3);
+
+    bad |= check_strided(37, 21);
+    bad |= check_strided(64, 64);
+    printf("size,ksize,stride,strided_acc_cycles,strided_result_words,"
+           "dense_acc_cycles,dense_result_words\n");
+    report_strided(256, 3, 2);
+    report_strided(256, 3, 4);
+    report_strided(256, 5, 2);
+
+    bad |= check_large(37, 21);
+    bad |= check_large(64, 64);
+    printf("size,ksize,passes,cycles,5x5_cycles,ratio\n");
+    report_large(256, 7);
+    report_large(256, 9);
+    report_large(256, 11);
+
+    // Small tile lists, including a single tile and an odd count
+    ourconv_dev dev;
+    ourconv_batch_stats stats;
+    int16_t in[16 * 16], out[MODES][16 * 16], k[9] = { 0, 0, 0, 0, 256, 0, 0, 0, 0 };
+    conv_tiling t;
+    conv_tile tiles[3];
+    for (int i = 0; i < 16 * 16; i++) {
+        in[i] = (int16_t)(i * 3);
+    }
+    conv_tiling_init(&t, 16, 16, 3, 8);
+    for (int i = 0; i < 3; i++) {
+        conv_tile_at(&t, i, &tiles[i]);
+    }
+    for (int count = 1; count <= 3; count += 2) {
+        for (int mode = 0; mode < MODES; mode++) {
+            ourconv_dev_init(&dev);
+            ourconv_dev_load_kernel(&dev, k, 3);
+            memset(out[mode], 0, sizeof(out[mode]));
+            ourconv_run_tiles(&dev, in, 16, 16, tiles, count, out[mode], modes[mode], &stats);
+        }
+        // identity kernel: covered pixels equal the input
+        int mismatch = memcmp(out[0], out[1], sizeof(out[0])) != 0 || memcmp(out[0], out[2], sizeof(out[0])) != 0;
+        for (int i = 0; i < count; i++) {
+            for (int r = 0; r < 8; r++) {
+                for (int c = 0; c < 8; c++) {
+                    int idx = (tiles[i].out_row + r) * 16 + tiles[i].out_col + c;
+                    mismatch |= out[1][idx] != in[idx];
+                }
+            }
+        }
+        if (mismatch) {
+            printf("  %d-tile list: MISMATCH\n", count);
+            bad = 1;
+        }
+    }
+    if (ourconv_run_tiles(&dev, in, 0, 16, tiles, 1, out[0], OURCONV_PIPELINED, &stats) != CONV_EINVAL) {
+        printf("  empty image accepted\n");
+        bad = 1;
+    }
+
+    printf("driver: %s\n", bad ? "MISMATCH" : "match");
+    return bad;
+}
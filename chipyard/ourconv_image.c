@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "ourconv_image.h"
+#include "ourconv_model.h"
+#include "ourconv_pack.h"
+
+int ourconv_image_init(ourconv_image* img, int h, int w, int ksize) {
+    memset(img, 0, sizeof(*img));
+    if ((ksize != 1 && ksize != 3 && ksize != 5) ||
+        conv_tiling_init(&img->tiling, h, w, ksize, OURCONV_N) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+    img->h = h;
+    img->w = w;
+    img->ksize = ksize;
+    img->in_tile = OURCONV_N + ksize - 1;
+    img->tile_words = OURCONV_PACKED_WORDS(img->in_tile, img->in_tile);
+    img->q88 = malloc(sizeof(int16_t) * h * w);
+    img->words = malloc(sizeof(uint64_t) * img->tile_words * conv_tiling_count(&img->tiling));
+    if (!img->q88 || !img->words) {
+        ourconv_image_free(img);
+        return CONV_ENOMEM;
+    }
+    return CONV_OK;
+}
+
+void ourconv_image_free(ourconv_image* img) {
+    free(img->q88);
+    free(img->words);
+    img->q88 = NULL;
+    img->words = NULL;
+}
+
+// Copy every tile window out of the quantized frame
+static void build_tiles(ourconv_image* img) {
+    conv_tile tile;
+
+    for (int idx = 0; idx < conv_tiling_count(&img->tiling); idx++) {
+        conv_tile_at(&img->tiling, idx, &tile);
+        ourconv_pack_q88(img->q88, img->h, img->w, img->w, tile.in_row, tile.in_col,
+                         img->in_tile, img->in_tile, img->words + (long)idx * img->tile_words);
+    }
+}
+
+static void note_error(ourconv_range_error* err, long count, int row, int col, float value) {
+    if (err->count == 0) {
+        err->row = row;
+        err->col = col;
+        err->value = value;
+    }
+    err->count += count;
+}
+
+int ourconv_image_from_f32(ourconv_image* img, const float* src, int stride, ourconv_range_error* err) {
+    ourconv_range_error e = { 0, 0, 0, 0.0f };
+
+    for (int r = 0; r < img->h; r++) {
+        const float* row = src + (long)r * stride;
+        int clamped = conv_f32_to_q88(row, img->w, img->q88 + (long)r * img->w);
+        if (clamped && e.count == 0) {
+            // Find the first culprit only on the rare failing row
+            for (int c = 0; c < img->w; c++) {
+                float x = row[c] * 256.0f;
+                if (!(x > -32769.0f && x < 32768.0f)) {
+                    note_error(&e, 0, r, c, row[c]);
+                    break;
+                }
+            }
+        }
+        e.count += clamped;
+    }
+    build_tiles(img);
+    if (err) {
+        *err = e;
+    }
+    return e.count ? CONV_ERANGE : CONV_OK;
+}
+
+void ourconv_image_from_q88(ourconv_image* img, const int16_t* src, int stride) {
+    for (int r = 0; r < img->h; r++) {
+        memcpy(img->q88 + (long)r * img->w, src + (long)r * stride, sizeof(int16_t) * img->w);
+    }
+    build_tiles(img);
+}
+
+int ourconv_image_from_u8(ourconv_image* img, const uint8_t* src, int stride, int shift, ourconv_range_error* err) {
+    ourconv_range_error e = { 0, 0, 0, 0.0f };
+
+    if (shift < 0 || shift > 8) {
+        return CONV_EINVAL;
+    }
+    for (int r = 0; r < img->h; r++) {
+        const uint8_t* row = src + (long)r * stride;
+        int16_t* dst = img->q88 + (long)r * img->w;
+        for (int c = 0; c < img->w; c++) {
+            int v = row[c] << shift;
+            if (v > 32767) {
+                note_error(&e, 1, r, c, (float)row[c]);
+                v = 32767;
+            }
+            dst[c] = (int16_t)v;
+        }
+    }
+    build_tiles(img);
+    if (err) {
+        *err = e;
+    }
+    return e.count ? CONV_ERANGE : CONV_OK;
+}
@@ -0,0 +1,54 @@
+#ifndef OURCONV_IMAGE_H
+#define OURCONV_IMAGE_H
+
+// Frame quantized to Q8.8 once, at ingest, and stored the way doLoadInput
+// reads it.
+//
+// The accelerator reads a tile's input window as one contiguous block of
+// (8 + k - 1)^2 values with row stride 8 + k - 1, so the frame is kept as
+// one packed block per 8x8 output tile, halo included, in conv_tiles.h tile
+// order. A tile is then handed to doLoadInput by pointer. Each source pixel
+// is converted exactly once; the halo overlap is copied, not re-converted.
+// The plain h x w Q8.8 frame is kept as well for CPU paths.
+
+#include <stdint.h>
+#include "conv_tiles.h"
+
+typedef struct {
+    int h, w, ksize;
+    conv_tiling tiling;  // 8x8 output tiles
+    int in_tile;         // window edge, 8 + ksize - 1
+    int tile_words;      // packed 64-bit words per tile window
+    int16_t* q88;        // h x w Q8.8 frame
+    uint64_t* words;     // tile_words per tile, in tile order
+} ourconv_image;
+
+// Values that did not fit Q8.8 at ingest. They are clamped, and the first
+// one is recorded so callers can report it like float_to_fixed88() did.
+typedef struct {
+    long count;
+    int row, col;        // first offending pixel
+    float value;         // its source value
+} ourconv_range_error;
+
+// Allocates an image for h x w frames and a 1x1, 3x3 or 5x5 kernel.
+// Returns CONV_EINVAL for bad sizes, CONV_ENOMEM if allocation fails.
+int ourconv_image_init(ourconv_image* img, int h, int w, int ksize);
+void ourconv_image_free(ourconv_image* img);
+
+// Ingest a frame with rows `stride` elements apart. Return CONV_OK, or
+// CONV_ERANGE if some values were clamped (the image is still complete;
+// err, if not NULL, says how many and which was first).
+int ourconv_image_from_f32(ourconv_image* img, const float* src, int stride, ourconv_range_error* err);
+// Frame already in Q8.8, e.g. one channel of a layer's activations.
+void ourconv_image_from_q88(ourconv_image* img, const int16_t* src, int stride);
+// uint8 pixels become v << shift in Q8.8: shift 0 maps 0..255 to [0, 1),
+// shift 8 keeps them as integers (values >= 128 are then out of range).
+int ourconv_image_from_u8(ourconv_image* img, const uint8_t* src, int stride, int shift, ourconv_range_error* err);
+
+// Packed input window of tile idx, ready for doLoadInput.
+static inline const uint64_t* ourconv_image_tile(const ourconv_image* img, int idx) {
+    return img->words + (long)idx * img->tile_words;
+}
+
+#endif
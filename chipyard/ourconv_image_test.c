@@ -0,0 +1,156 @@
+// Build (host, software model):
+//   gcc -O2 -DOURCONV_MODEL -I.. -o ourconv_image_test ourconv_image_test.c ourconv_image.c ourconv_driver.c ourconv_pack.c ourconv_model.c ourconv_perf.c ../conv_tiles.c ../conv.c ../conv_simd.c -lm
+//
+// Checks that the pre-quantized tile blocks equal the per-tile packing,
+// that out-of-range pixels are reported, and that running from the image
+// gives the conv2d_q88() result in fewer cycles per tile.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "ourconv_driver.h"
+#include "ourconv_image.h"
+#include "ourconv_pack.h"
+
+static int check_tiles(int h, int w, int ksize) {
+    float* src = malloc(sizeof(float) * h * w);
+    uint64_t packed[OURCONV_PACKED_WORDS(12, 12)];
+    ourconv_image img;
+    conv_tile tile;
+    int bad = 0;
+
+    for (int i = 0; i < h * w; i++) {
+        src[i] = (float)(rand() % 4001 - 2000) / 256.0f;
+    }
+    if (ourconv_image_init(&img, h, w, ksize) != CONV_OK ||
+        ourconv_image_from_f32(&img, src, w, NULL) != CONV_OK) {
+        printf("  %dx%d k%d: ingest failed\n", h, w, ksize);
+        free(src);
+        return 1;
+    }
+    for (int idx = 0; idx < conv_tiling_count(&img.tiling); idx++) {
+        conv_tile_at(&img.tiling, idx, &tile);
+        ourconv_pack_f32(src, h, w, w, tile.in_row, tile.in_col, img.in_tile, img.in_tile, packed);
+        if (memcmp(packed, ourconv_image_tile(&img, idx), sizeof(uint64_t) * img.tile_words) != 0) {
+            printf("  %dx%d k%d tile %d: MISMATCH\n", h, w, ksize, idx);
+            bad = 1;
+            break;
+        }
+    }
+    ourconv_image_free(&img);
+    free(src);
+    return bad;
+}
+
+static int check_range(void) {
+    float src[16 * 16];
+    uint8_t px[16 * 16];
+    ourconv_image img;
+    ourconv_range_error err;
+    int bad = 0;
+
+    for (int i = 0; i < 16 * 16; i++) {
+        src[i] = 0.5f;
+        px[i] = (uint8_t)i;
+    }
+    src[3 * 16 + 5] = 200.0f;
+    src[9 * 16 + 1] = -129.0f;
+    ourconv_image_init(&img, 16, 16, 3);
+    if (ourconv_image_from_f32(&img, src, 16, &err) != CONV_ERANGE ||
+        err.count != 2 || err.row != 3 || err.col != 5 || err.value != 200.0f ||
+        img.q88[3 * 16 + 5] != 32767 || img.q88[9 * 16 + 1] != -32768) {
+        printf("  f32 range: MISMATCH (count %ld at %d,%d)\n", err.count, err.row, err.col);
+        bad = 1;
+    }
+
+    // shift 0: pixel v is v/256; shift 8: integers, >= 128 clamp
+    if (ourconv_image_from_u8(&img, px, 16, 0, &err) != CONV_OK || err.count != 0 ||
+        img.q88[200] != 200) {
+        printf("  u8 shift 0: MISMATCH\n");
+        bad = 1;
+    }
+    if (ourconv_image_from_u8(&img, px, 16, 8, &err) != CONV_ERANGE ||
+        err.count != 128 || err.row != 8 || err.col != 0 ||
+        img.q88[100] != 100 * 256 || img.q88[255] != 32767) {
+        printf("  u8 shift 8: MISMATCH (count %ld)\n", err.count);
+        bad = 1;
+    }
+    if (ourconv_image_from_u8(&img, px, 16, 9, NULL) != CONV_EINVAL ||
+        ourconv_image_init(&img, 16, 16, 4) != CONV_EINVAL) {
+        printf("  bad arguments accepted\n");
+        bad = 1;
+    }
+    ourconv_image_free(&img);
+    return bad;
+}
+
+static int run(int h, int w, int ksize, uint64_t* packing, uint64_t* direct) {
+    float* src = malloc(sizeof(float) * h * w);
+    int16_t* in = malloc(sizeof(int16_t) * h * w);
+    int16_t* ref = malloc(sizeof(int16_t) * h * w);
+    int16_t* got = malloc(sizeof(int16_t) * h * w);
+    uint8_t* overflow = malloc((size_t)h * w);
+    int16_t k[25];
+    ourconv_batch_stats stats;
+    ourconv_image img;
+    ourconv_dev dev;
+    int bad = 0;
+
+    for (int i = 0; i < h * w; i++) {
+        src[i] = (float)(rand() % 2049 - 1024) / 256.0f;
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (int16_t)(rand() % 513 - 256);
+    }
+    conv_f32_to_q88(src, h * w, in);
+    conv2d_q88(in, h, w, k, ksize, ref, overflow);
+
+    ourconv_dev_init(&dev);
+    ourconv_conv2d_q88(&dev, in, h, w, k, ksize, got, OURCONV_PIPELINED, &stats);
+    *packing = stats.cycles / stats.tiles;
+
+    ourconv_image_init(&img, h, w, ksize);
+    ourconv_image_from_f32(&img, src, w, NULL);
+    for (int mode = OURCONV_SERIAL; mode <= OURCONV_PIPELINED; mode++) {
+        ourconv_dev_init(&dev);
+        memset(got, 0, sizeof(int16_t) * h * w);
+        if (ourconv_conv2d_image(&dev, &img, k, got, mode, &stats) != CONV_OK ||
+            memcmp(ref, got, sizeof(int16_t) * h * w) != 0) {
+            printf("  %dx%d k%d mode %d: MISMATCH\n", h, w, ksize, mode);
+            bad = 1;
+        }
+    }
+    *direct = stats.cycles / stats.tiles;
+
+    ourconv_image_free(&img);
+    free(src);
+    free(in);
+    free(ref);
+    free(got);
+    free(overflow);
+    return bad;
+}
+
+int main() {
+    uint64_t packing, direct;
+    int bad = 0;
+
+    for (int ksize = 1; ksize <= 5; ksize += 2) {
+        bad |= check_tiles(24, 40, ksize);
+    }
+    bad |= check_range();
+
+    printf("size,ksize,packing_cycles_per_tile,image_cycles_per_tile\n");
+    for (int ksize = 1; ksize <= 5; ksize += 2) {
+        bad |= run(256, 256, ksize, &packing, &direct);
+        printf("256x256,%d,%llu,%llu\n", ksize, (unsigned long long)packing, (unsigned long long)direct);
+        if (direct >= packing) {
+            printf("  k%d: image path not faster\n", ksize);
+            bad = 1;
+        }
+    }
+
+    printf("image: %s\n", bad ? "MISMATCH" : "match");
+    return bad;
+}
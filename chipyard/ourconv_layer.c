@@ -0,0 +1,304 @@
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "ourconv_layer.h"
+#include "ourconv_cmd.h"
+#include "ourconv_image.h"
+#include "ourconv_pack.h"
+#include "ourconv_perf.h"
+
+typedef struct {
+    int tile, ci, co;
+} layer_job;
+
+// Loop nest of each dataflow, outermost first
+enum { DIM_TILE, DIM_CI, DIM_CO, DIMS };
+static const int nest[][DIMS] = {
+    [OURCONV_OUTPUT_STATIONARY] = { DIM_TILE, DIM_CO, DIM_CI },
+    [OURCONV_INPUT_STATIONARY] = { DIM_TILE, DIM_CI, DIM_CO },
+    [OURCONV_WEIGHT_STATIONARY] = { DIM_CO, DIM_CI, DIM_TILE },
+};
+
+static int valid_layer(int c_in, int c_out, int h, int w, int ksize, int dataflow) {
+    return c_in > 0 && c_out > 0 && h > 0 && w > 0 &&
+           (ksize == 1 || ksize == 3 || ksize == 5) &&
+           dataflow >= OURCONV_DATAFLOW_AUTO && dataflow <= OURCONV_WEIGHT_STATIONARY;
+}
+
+// Loads of a register set that depends on the `uses` dimensions: it changes
+// whenever the innermost of them that has more than one value does, and
+// with it everything outside.
+static uint64_t reloads(int dataflow, const long* size, unsigned uses) {
+    uint64_t outer = 1, loads = 1;
+
+    for (int l = 0; l < DIMS; l++) {
+        int d = nest[dataflow][l];
+        outer *= (uint64_t)size[d];
+        if ((uses >> d & 1) && size[d] > 1) {
+            loads = outer;
+        }
+    }
+    return loads;
+}
+
+int ourconv_layer_traffic(int c_in, int c_out, int h, int w, int ksize, int dataflow, int kernel_slots,
+                          ourconv_traffic* traffic) {
+    if (!traffic || !valid_layer(c_in, c_out, h, w, ksize, dataflow) || dataflow == OURCONV_DATAFLOW_AUTO ||
+        kernel_slots < 1 || kernel_slots > OURCONV_KERNEL_SLOTS) {
+        return CONV_EINVAL;
+    }
+    conv_tiling t;
+    conv_tiling_init(&t, h, w, ksize, OURCONV_N);
+    long size[DIMS] = { [DIM_TILE] = conv_tiling_count(&t), [DIM_CI] = c_in, [DIM_CO] = c_out };
+    unsigned in_tile = OURCONV_N + ksize - 1;
+    uint64_t out_words = 0;
+    conv_tile tile;
+    // Every order cycles through the same c_in x c_out kernels: they stay
+    // in the slots if they all fit, and LRU misses on every switch if not
+    uint64_t kernel_loads = (long)c_in * c_out <= kernel_slots ? (uint64_t)c_in * c_out
+                                                               : reloads(dataflow, size, 1u << DIM_CI | 1u << DIM_CO);
+    uint64_t input_loads = reloads(dataflow, size, 1u << DIM_TILE | 1u << DIM_CI);
+    uint64_t computes = (uint64_t)size[DIM_TILE] * c_in * c_out;
+
+    memset(traffic, 0, sizeof(*traffic));
+    traffic->commands[OURCONV_CMD_LOAD_KERNEL] = kernel_loads;
+    traffic->commands[OURCONV_CMD_LOAD_INPUT] = input_loads;
+    traffic->commands[OURCONV_CMD_COMPUTE] = computes;
+    traffic->bytes_to_acc = 8 * (kernel_loads * ((unsigned)(ksize * ksize + 3) / 4) +
+                                 input_loads * ((in_tile * in_tile + 3) / 4));
+    for (int i = 0; i < conv_tiling_count(&t); i++) {
+        conv_tile_at(&t, i, &tile);
+        out_words += ourconv_compute_words(OURCONV_COMPUTE_RS2(tile.type, tile.out_rows, tile.out_cols));
+    }
+    traffic->bytes_from_acc = 8 * out_words * c_in * c_out;
+    // Plane sums: written for the first channel, read and written for every
+    // other one, read once more by the clamp
+    if (dataflow != OURCONV_OUTPUT_STATIONARY) {
+        traffic->psum_bytes = 8 * (uint64_t)c_in * c_out * h * w;
+    }
+    return CONV_OK;
+}
+
+static uint64_t traffic_cycles(const ourconv_traffic* tr) {
+    static const ourconv_timing t = OURCONV_TIMING_DEFAULT;
+    uint64_t loads = tr->commands[OURCONV_CMD_LOAD_KERNEL] + tr->commands[OURCONV_CMD_LOAD_INPUT] +
+                     tr->commands[OURCONV_CMD_SLIDE_INPUT];
+    uint64_t computes = tr->commands[OURCONV_CMD_COMPUTE];
+
+    return (loads + computes) * t.cmd_overhead +
+           loads * ourconv_cycles_load(&t, 0) +
+           computes * (ourconv_cycles_compute(&t, OURCONV_N * OURCONV_N) + ourconv_cycles_writeback(&t, 0)) +
+           (tr->bytes_to_acc + tr->bytes_from_acc) / 8 * t.req_interval +
+           tr->psum_bytes / 4;
+}
+
+int ourconv_layer_dataflow(int c_in, int c_out, int h, int w, int ksize, int kernel_slots) {
+    ourconv_traffic tr;
+    uint64_t best_cycles = UINT64_MAX;
+    int best = OURCONV_OUTPUT_STATIONARY;
+
+    for (int df = OURCONV_OUTPUT_STATIONARY; df <= OURCONV_WEIGHT_STATIONARY; df++) {
+        if (ourconv_layer_traffic(c_in, c_out, h, w, ksize, df, kernel_slots, &tr) == CONV_OK &&
+            traffic_cycles(&tr) < best_cycles) {
+            best_cycles = traffic_cycles(&tr);
+            best = df;
+        }
+    }
+    return best;
+}
+
+static layer_job job_at(int dataflow, long j, int tiles, int c_in, int c_out) {
+    const long size[DIMS] = { [DIM_TILE] = tiles, [DIM_CI] = c_in, [DIM_CO] = c_out };
+    long idx[DIMS];
+    layer_job job;
+
+    for (int l = DIMS - 1; l >= 0; l--) {
+        int d = nest[dataflow][l];
+        idx[d] = j % size[d];
+        j /= size[d];
+    }
+    job.tile = (int)idx[DIM_TILE];
+    job.ci = (int)idx[DIM_CI];
+    job.co = (int)idx[DIM_CO];
+    return job;
+}
+
+typedef struct {
+    const conv_tiling* t;
+    int c_in;
+    int32_t* sum;  // c_out planes, or NULL for output-stationary, which
+    int32_t tile[OURCONV_N * OURCONV_N]; // sums one tile here
+    int16_t* out;  // and stores it clamped
+    long clamped;
+} layer_acc;
+
+// Add one doCompute result to its filter's partial sum
+static void accumulate(ourconv_dev* dev, const uint64_t* packed, const layer_job* job, layer_acc* acc) {
+    const conv_tiling* t = acc->t;
+    int16_t vals[OURCONV_N * OURCONV_N];
+    conv_tile tile;
+
+    conv_tile_at(t, job->tile, &tile);
+    int rows = tile.out_rows, cols = tile.out_cols;
+    ourconv_unpack_q88(packed, rows, cols, vals, cols);
+    host_work(dev, (unsigned)(rows * cols));
+    long offset = (long)job->co * t->h * t->w + (long)tile.out_row * t->w + tile.out_col;
+
+    if (!acc->sum) {
+        for (int i = 0; i < rows * cols; i++) {
+            acc->tile[i] = job->ci == 0 ? vals[i] : acc->tile[i] + vals[i];
+        }
+        if (job->ci != acc->c_in - 1) {
+            return;
+        }
+        int16_t* dst = acc->out + offset;
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                int32_t v = acc->tile[r * cols + c];
+                if (v > 32767 || v < -32768) {
+                    v = v > 0 ? 32767 : -32768;
+                    acc->clamped++;
+                }
+                dst[(long)r * t->w + c] = (int16_t)v;
+            }
+        }
+        return;
+    }
+    int32_t* dst = acc->sum + offset;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int32_t v = vals[r * cols + c];
+            dst[(long)r * t->w + c] = job->ci == 0 ? v : dst[(long)r * t->w + c] + v;
+        }
+    }
+    dev->traffic.psum_bytes += (uint64_t)(job->ci == 0 ? 4 : 8) * rows * cols;
+}
+
+static void run_layer(ourconv_dev* dev, const ourconv_image* imgs, const uint64_t* kernels, int c_out,
+                      int dataflow, layer_acc* acc, ourconv_layer_stats* stats) {
+    const conv_tiling* t = acc->t;
+    int c_in = acc->c_in;
+    int tiles = conv_tiling_count(t);
+    long total = (long)tiles * c_in * c_out;
+    uint64_t packed_out[2][OURCONV_OUTPUT_WORDS];
+    uint64_t compute_rd[2] = { 0, 0 }, compute_ready[2] = { 0, 0 }, rd, ready;
+    layer_job pending[2];
+    long cur_kernel = -1, cur_input = -1;
+    conv_tile tile;
+
+    acc_fence();
+    for (long j = 0; j < total; j++) {
+        layer_job job = job_at(dataflow, j, tiles, c_in, c_out);
+        long kernel_id = (long)job.co * c_in + job.ci;
+        long input_id = (long)job.tile * c_in + job.ci;
+        int s = (int)(j & 1);
+
+        if (kernel_id != cur_kernel) {
+            acc_use_kernel(dev, kernels + kernel_id * PACKED_KERNEL_LEN, imgs[0].ksize, &rd, &ready);
+            cur_kernel = kernel_id;
+        }
+        if (input_id != cur_input) {
+            acc_load_input(dev, ourconv_image_tile(&imgs[job.ci], job.tile), &ready);
+            cur_input = input_id;
+        }
+        conv_tile_at(t, job.tile, &tile);
+        compute_rd[s] = acc_compute(dev, packed_out[s], compute_rs2(dev, &tile), &compute_ready[s]);
+        pending[s] = job;
+
+        if (j > 0) {
+            stats->overflow |= acc_wait(dev, compute_rd[s ^ 1], compute_ready[s ^ 1]);
+            accumulate(dev, packed_out[s ^ 1], &pending[s ^ 1], acc);
+        }
+    }
+    int s = (int)((total - 1) & 1);
+    stats->overflow |= acc_wait(dev, compute_rd[s], compute_ready[s]);
+    accumulate(dev, packed_out[s], &pending[s], acc);
+}
+
+static void free_layer(ourconv_image* imgs, int c_in, uint64_t* kernels, int32_t* sum) {
+    if (imgs) {
+        for (int ci = 0; ci < c_in; ci++) {
+            ourconv_image_free(&imgs[ci]);
+        }
+    }
+    free(imgs);
+    free(kernels);
+    free(sum);
+}
+
+int ourconv_conv_layer_q88(ourconv_dev* dev, const int16_t* in, int c_in, int h, int w,
+                           const int16_t* k, int c_out, int ksize, int16_t* out,
+                           int dataflow, ourconv_layer_stats* stats) {
+    ourconv_layer_stats st;
+    layer_acc acc;
+    long plane = (long)h * w;
+    long kk = (long)ksize * ksize;
+
+    if (!dev || !in || !k || !out || !valid_layer(c_in, c_out, h, w, ksize, dataflow)) {
+        return CONV_EINVAL;
+    }
+    memset(&st, 0, sizeof(st));
+    st.dataflow = dataflow == OURCONV_DATAFLOW_AUTO ? ourconv_layer_dataflow(c_in, c_out, h, w, ksize, (int)dev->kernel_slots)
+                                                     : dataflow;
+
+    ourconv_image* imgs = calloc((size_t)c_in, sizeof(ourconv_image));
+    uint64_t* kernels = malloc(sizeof(uint64_t) * PACKED_KERNEL_LEN * c_in * c_out);
+    int32_t* sum = NULL;
+    if (st.dataflow != OURCONV_OUTPUT_STATIONARY) {
+        sum = malloc(sizeof(int32_t) * c_out * plane);
+    }
+    if (!imgs || !kernels || (!sum && st.dataflow != OURCONV_OUTPUT_STATIONARY)) {
+        free_layer(imgs, c_in, kernels, sum);
+        return CONV_ENOMEM;
+    }
+
+    // Quantized inputs and packed kernels are prepared once for the layer
+    uint64_t start = ourconv_dev_cycles(dev);
+    ourconv_traffic before = dev->traffic;
+    for (int ci = 0; ci < c_in; ci++) {
+        if (ourconv_image_init(&imgs[ci], h, w, ksize) != CONV_OK) {
+            free_layer(imgs, c_in, kernels, sum);
+            return CONV_ENOMEM;
+        }
+        ourconv_image_from_q88(&imgs[ci], in + ci * plane, w);
+        host_work(dev, (unsigned)plane);
+    }
+    for (long i = 0; i < (long)c_in * c_out; i++) {
+        ourconv_pack_q88(k + i * kk, ksize, ksize, ksize, 0, 0, ksize, ksize, kernels + i * PACKED_KERNEL_LEN);
+    }
+    host_work(dev, (unsigned)(kk * c_in * c_out));
+
+    acc.t = &imgs[0].tiling;
+    acc.c_in = c_in;
+    acc.sum = sum;
+    acc.out = out;
+    acc.clamped = 0;
+    run_layer(dev, imgs, kernels, c_out, st.dataflow, &acc, &st);
+
+    if (sum) {
+        for (long i = 0; i < c_out * plane; i++) {
+            int32_t v = sum[i];
+            if (v > 32767 || v < -32768) {
+                v = v > 0 ? 32767 : -32768;
+                acc.clamped++;
+            }
+            out[i] = (int16_t)v;
+        }
+        host_work(dev, (unsigned)(c_out * plane));
+        dev->traffic.psum_bytes += 4 * (uint64_t)c_out * plane;
+    }
+    st.clamped = acc.clamped;
+    st.cycles = ourconv_dev_cycles(dev) - start;
+    for (int c = 0; c < OURCONV_CMD_TYPES; c++) {
+        st.traffic.commands[c] = dev->traffic.commands[c] - before.commands[c];
+    }
+    st.traffic.bytes_to_acc = dev->traffic.bytes_to_acc - before.bytes_to_acc;
+    st.traffic.bytes_from_acc = dev->traffic.bytes_from_acc - before.bytes_from_acc;
+    st.traffic.psum_bytes = dev->traffic.psum_bytes - before.psum_bytes;
+
+    free_layer(imgs, c_in, kernels, sum);
+    if (stats) {
+        *stats = st;
+    }
+    return CONV_OK;
+}
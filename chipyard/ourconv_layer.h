@@ -0,0 +1,66 @@
+#ifndef OURCONV_LAYER_H
+#define OURCONV_LAYER_H
+
+// Multi-channel convolution layer on OurCONV, through the plain
+// doLoadKernel / doLoadInput / doCompute commands.
+//
+// Layouts and numerics are those of conv_layer_q88() (conv_layer.h): the
+// accelerator produces one clamped Q8.8 plane per (filter, input channel),
+// the core accumulates them in 32 bits per output pixel and clamps once at
+// the end. The input channels are packed once into ourconv_images, so every
+// tile window goes to doLoadInput by pointer, and doCompute results are
+// double-buffered so the core accumulates one tile while the next computes.
+//
+// The accelerator holds one input tile and a few kernel slots, so the
+// dataflow (the loop order over tiles, filters and input channels) decides
+// what is reloaded and where the partial sums live:
+//   output-stationary  per tile, per filter: every channel's kernel and
+//                      input are loaded; the 8x8 sum stays on the core
+//                      and is clamped and stored once
+//   input-stationary   per (tile, channel): one doLoadInput, then every
+//                      filter's kernel is loaded and computed; partial sums
+//                      go through a 32-bit plane per filter in memory
+//   weight-stationary  per (filter, channel): one doLoadKernel, then every
+//                      tile is loaded and computed; 32-bit planes as above
+// Kernel loads go through the driver's slot LRU, so when all c_in x c_out
+// kernels fit in the slots each is loaded only once, whatever the order.
+//
+// Commands and bytes are counted in dev->traffic as they are issued, and
+// ourconv_layer_traffic() predicts the same counts from the layer shape.
+
+#include <stdint.h>
+#include "ourconv_driver.h"
+
+enum ourconv_dataflow {
+    OURCONV_DATAFLOW_AUTO = 0, // whichever ourconv_layer_dataflow() predicts is cheaper
+    OURCONV_OUTPUT_STATIONARY = 1,
+    OURCONV_INPUT_STATIONARY = 2,
+    OURCONV_WEIGHT_STATIONARY = 3
+};
+
+typedef struct {
+    uint64_t cycles;         // rdcycle delta (model: virtual clock delta)
+    ourconv_traffic traffic; // dev->traffic delta
+    uint64_t overflow;       // OR of the doCompute results
+    long clamped;            // output pixels saturated by the final clamp
+    int dataflow;            // dataflow actually used
+} ourconv_layer_stats;
+
+// Commands, accelerator bytes and partial-sum bytes a layer will take on a
+// device whose LRU uses kernel_slots slots, all empty, with c_in x c_out
+// distinct kernels. Returns CONV_EINVAL for shapes ourconv_conv_layer_q88()
+// rejects.
+int ourconv_layer_traffic(int c_in, int c_out, int h, int w, int ksize, int dataflow, int kernel_slots,
+                          ourconv_traffic* traffic);
+
+// Cheapest dataflow for a layer: predicted traffic priced with the
+// OURCONV_TIMING_DEFAULT command costs plus a cycle per partial-sum word.
+int ourconv_layer_dataflow(int c_in, int c_out, int h, int w, int ksize, int kernel_slots);
+
+// in: c_in planes of h x w; k: c_out x c_in kernels (1x1, 3x3 or 5x5);
+// out: c_out planes, any h x w. Returns CONV_EINVAL, CONV_ENOMEM or CONV_OK.
+int ourconv_conv_layer_q88(ourconv_dev* dev, const int16_t* in, int c_in, int h, int w,
+                           const int16_t* k, int c_out, int ksize, int16_t* out,
+                           int dataflow, ourconv_layer_stats* stats);
+
+#endif
@@ -0,0 +1,134 @@
+// Build (host, software model):
+//   gcc -O2 -pthread -DOURCONV_MODEL -I.. -o ourconv_layer_test ourconv_layer_test.c ourconv_layer.c ourconv_image.c ourconv_driver.c ourconv_pack.c ourconv_model.c ourconv_perf.c ../conv_layer.c ../conv_pool.c ../conv_tiles.c ../conv.c ../conv_simd.c
+// On the RoCC target drop -DOURCONV_MODEL and add -I../test for rocc.h.
+//
+// Usage: ourconv_layer_test [size channels]
+//
+// Checks every dataflow against conv_layer_q88() and the measured traffic
+// against ourconv_layer_traffic(), then prints the traffic and cycles of
+// each dataflow for a few layer shapes, ending with a 3x3, 64 -> 64 channel
+// layer at 56x56 (or the given size and channel count).
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "conv_layer.h"
+#include "ourconv_layer.h"
+
+static const char* dataflow_name[] = { "auto", "output-stationary", "input-stationary", "weight-stationary" };
+
+static void fill(int16_t* v, size_t n, int range) {
+    for (size_t i = 0; i < n; i++) {
+        v[i] = (int16_t)(rand() % (2 * range + 1) - range);
+    }
+}
+
+static int check(int c_in, int c_out, int h, int w, int ksize, int range) {
+    size_t plane = (size_t)h * w;
+    int16_t* in = malloc(sizeof(int16_t) * c_in * plane);
+    int16_t* k = malloc(sizeof(int16_t) * c_in * c_out * ksize * ksize);
+    int16_t* ref = malloc(sizeof(int16_t) * c_out * plane);
+    int16_t* got = malloc(sizeof(int16_t) * c_out * plane);
+    uint8_t* ovf = malloc(c_out * plane);
+    ourconv_layer_stats stats;
+    ourconv_traffic predicted;
+    ourconv_dev dev;
+    int bad = 0;
+
+    fill(in, c_in * plane, range);
+    fill(k, (size_t)c_in * c_out * ksize * ksize, 256);
+    // Distinct kernels: equal ones would share a slot and beat the prediction
+    for (int i = 0; i < c_in * c_out; i++) {
+        k[i * ksize * ksize] = (int16_t)(i * 7 - 300);
+    }
+    conv_layer_q88(in, c_in, h, w, k, c_out, ksize, ref, ovf, NULL);
+    long clamped = 0;
+    for (size_t i = 0; i < c_out * plane; i++) {
+        clamped += ref[i] == 32767 || ref[i] == -32768;
+    }
+
+    for (int slots = 1; slots <= OURCONV_KERNEL_SLOTS; slots += OURCONV_KERNEL_SLOTS - 1) {
+        for (int df = OURCONV_OUTPUT_STATIONARY; df <= OURCONV_WEIGHT_STATIONARY; df++) {
+            ourconv_dev_init(&dev);
+            dev.kernel_slots = (unsigned)slots;
+            memset(got, 0, sizeof(int16_t) * c_out * plane);
+            ourconv_layer_traffic(c_in, c_out, h, w, ksize, df, slots, &predicted);
+            if (ourconv_conv_layer_q88(&dev, in, c_in, h, w, k, c_out, ksize, got, df, &stats) != CONV_OK ||
+                memcmp(ref, got, sizeof(int16_t) * c_out * plane) != 0 || stats.clamped != clamped ||
+                memcmp(&predicted, &stats.traffic, sizeof(predicted)) != 0 ||
+                memcmp(&dev.traffic, &stats.traffic, sizeof(predicted)) != 0 || (range > 1024 && !clamped)) {
+                printf("  %d->%d %dx%d k%d %s, %d slots: MISMATCH\n", c_in, c_out, h, w, ksize,
+                       dataflow_name[df], slots);
+                bad = 1;
+            }
+        }
+    }
+    free(in);
+    free(k);
+    free(ref);
+    free(got);
+    free(ovf);
+    return bad;
+}
+
+static void bench(int c_in, int c_out, int size, int ksize) {
+    size_t plane = (size_t)size * size;
+    int16_t* in = malloc(sizeof(int16_t) * c_in * plane);
+    int16_t* k = malloc(sizeof(int16_t) * c_in * c_out * ksize * ksize);
+    int16_t* out = malloc(sizeof(int16_t) * c_out * plane);
+    double macs = (double)c_in * c_out * ksize * ksize * plane;
+    int pick = ourconv_layer_dataflow(c_in, c_out, size, size, ksize, OURCONV_KERNEL_SLOTS);
+    ourconv_layer_stats stats;
+    ourconv_dev dev;
+
+    fill(in, c_in * plane, 512);
+    fill(k, (size_t)c_in * c_out * ksize * ksize, 16);
+    for (int df = OURCONV_OUTPUT_STATIONARY; df <= OURCONV_WEIGHT_STATIONARY; df++) {
+        ourconv_dev_init(&dev);
+        ourconv_conv_layer_q88(&dev, in, c_in, size, size, k, c_out, ksize, out, df, &stats);
+        const ourconv_traffic* tr = &stats.traffic;
+        uint64_t commands = 0;
+        for (int c = 0; c < OURCONV_CMD_TYPES; c++) {
+            commands += tr->commands[c];
+        }
+        printf("%dx%d,%d,%d,%d,%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.2f%s\n", size, size, ksize, c_in, c_out,
+               dataflow_name[df], (unsigned long long)commands,
+               (unsigned long long)tr->commands[OURCONV_CMD_LOAD_KERNEL],
+               (unsigned long long)tr->commands[OURCONV_CMD_LOAD_INPUT],
+               (unsigned long long)tr->bytes_to_acc, (unsigned long long)tr->bytes_from_acc,
+               (unsigned long long)tr->psum_bytes, (unsigned long long)stats.cycles,
+               macs / (double)stats.cycles, df == pick ? ",auto" : ",");
+    }
+    free(in);
+    free(k);
+    free(out);
+}
+
+int main(int argc, char** argv) {
+    int bad = 0;
+
+    for (int ksize = 1; ksize <= 5; ksize += 2) {
+        bad |= check(3, 4, 24, 16, ksize, 1024);
+        bad |= check(1, 2, 8, 8, ksize, 1024);
+        bad |= check(2, 3, 13, 21, ksize, 1024);
+    }
+    // Partial sums that saturate only once accumulated across channels
+    bad |= check(8, 3, 16, 16, 3, 4096);
+    // Few enough filters to stay in the kernel slots
+    bad |= check(1, 4, 24, 24, 3, 1024);
+    bad |= check(2, 2, 16, 24, 5, 1024);
+    printf("layer: %s\n", bad ? "MISMATCH" : "match");
+
+    printf("size,ksize,c_in,c_out,dataflow,commands,kernel_loads,input_loads,bytes_to_acc,bytes_from_acc,"
+           "psum_bytes,cycles,macs_per_cycle,picked\n");
+    bench(1, 1, 256, 3);
+    bench(1, 4, 64, 3);
+    bench(2, 2, 64, 5);
+    bench(3, 32, 64, 3);
+    bench(32, 32, 32, 5);
+    bench(64, 8, 32, 1);
+    int channels = argc >= 3 ? atoi(argv[2]) : 64;
+    bench(channels, channels, argc >= 3 ? atoi(argv[1]) : 56, 3);
+    return bad;
+}
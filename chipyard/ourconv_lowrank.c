@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "ourconv_lowrank.h"
+#include "ourconv_cmd.h"
+
+static void add_stats(ourconv_batch_stats* total, const ourconv_batch_stats* pass) {
+    total->tiles += pass->tiles;
+    total->overflow |= pass->overflow;
+}
+
+int ourconv_conv2d_lowrank(ourconv_dev* dev, const int16_t* in, int h, int w,
+                           const conv_lowrank* lr, int16_t* out,
+                           int mode, ourconv_batch_stats* stats) {
+    ourconv_batch_stats total, pass;
+    size_t plane = (size_t)h * w;
+
+    if (!dev || !in || !lr || !out || h <= 0 || w <= 0 ||
+        (lr->ksize != 1 && lr->ksize != 3 && lr->ksize != 5)) {
+        return CONV_EINVAL;
+    }
+    int16_t* t = malloc(sizeof(int16_t) * plane);
+    int16_t* part = malloc(sizeof(int16_t) * plane);
+    int32_t* sum = calloc(plane, sizeof(int32_t));
+    if (!t || !part || !sum) {
+        free(t);
+        free(part);
+        free(sum);
+        return CONV_ENOMEM;
+    }
+
+    memset(&total, 0, sizeof(total));
+    int status = CONV_OK;
+    uint64_t start = ourconv_dev_cycles(dev);
+    int K = lr->ksize, pad = K / 2;
+    for (int r = 0; r < lr->rank; r++) {
+        // 1 x K and K x 1 jobs as K x K kernels with a single non-zero line
+        int16_t krow[25] = { 0 }, kcol[25] = { 0 };
+        for (int n = 0; n < K; n++) {
+            krow[pad * K + n] = lr->row_q[r][n];
+            kcol[n * K + pad] = lr->col_q[r][n];
+        }
+        status = ourconv_conv2d_q88(dev, in, h, w, krow, K, t, mode, &pass);
+        if (status != CONV_OK) {
+            break;
+        }
+        add_stats(&total, &pass);
+        status = ourconv_conv2d_q88(dev, t, h, w, kcol, K, part, mode, &pass);
+        if (status != CONV_OK) {
+            break;
+        }
+        add_stats(&total, &pass);
+        for (size_t i = 0; i < plane; i++) {
+            sum[i] += part[i];
+        }
+        host_work(dev, (unsigned)plane);
+    }
+    if (status == CONV_OK) {
+        for (size_t i = 0; i < plane; i++) {
+            int32_t v = sum[i];
+            out[i] = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+        }
+        host_work(dev, (unsigned)plane);
+        total.cycles = ourconv_dev_cycles(dev) - start;
+        if (stats) {
+            *stats = total;
+        }
+    }
+
+    free(t);
+    free(part);
+    free(sum);
+    return status;
+}
@@ -0,0 +1,28 @@
+#ifndef OURCONV_LOWRANK_H
+#define OURCONV_LOWRANK_H
+
+// Separable and low-rank kernels (conv_lowrank.h) on OurCONV.
+//
+// Each term runs as a 1 x K job across the rows, then a K x 1 job down the
+// result. doLoadKernel only takes 1x1, 3x3 and 5x5 kernels, so a 1 x K job
+// is a K x K kernel holding the row factor in its middle row (K x 1: the
+// column factor in its middle column). Both passes clamp like any doCompute,
+// and the core sums the terms in 32 bits and clamps once, so the result is
+// bit-identical to conv2d_lowrank_q88().
+//
+// The MAC array produces one output pixel per cycle whatever the taps, so
+// unlike the CPU a rank-r kernel costs 2r image passes against one for the
+// direct kernel. This exists for kernels the CPU already keeps factored and
+// to measure that cost; it saves no accelerator cycles.
+
+#include <stdint.h>
+#include "ourconv_driver.h"
+#include "conv_lowrank.h"
+
+// lr->ksize must be 1, 3 or 5; out is h x w. stats sums the cycles and
+// tiles of every pass. Returns CONV_EINVAL, CONV_ENOMEM or CONV_OK.
+int ourconv_conv2d_lowrank(ourconv_dev* dev, const int16_t* in, int h, int w,
+                           const conv_lowrank* lr, int16_t* out,
+                           int mode, ourconv_batch_stats* stats);
+
+#endif
@@ -0,0 +1,104 @@
+// Build (host, software model):
+//   gcc -O2 -pthread -DOURCONV_MODEL -I.. -o ourconv_lowrank_test ourconv_lowrank_test.c ourconv_lowrank.c ourconv_driver.c ourconv_pack.c ourconv_model.c ourconv_perf.c ../conv_lowrank.c ../conv_tiles.c ../conv.c ../conv_simd.c -lm
+// On the RoCC target drop -DOURCONV_MODEL and add -I../test for rocc.h.
+//
+// Checks ourconv_conv2d_lowrank() against conv2d_lowrank_q88() bit for bit,
+// then prints the cycles of the 1-D passes against the direct kernel.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "conv_lowrank.h"
+#include "ourconv_lowrank.h"
+
+static int check(const char* name, const float* k, int ksize, int max_rank, int h, int w, int mode) {
+    size_t plane = (size_t)h * w;
+    int16_t* in = malloc(sizeof(int16_t) * plane);
+    int16_t* ref = malloc(sizeof(int16_t) * plane);
+    int16_t* got = malloc(sizeof(int16_t) * plane);
+    conv_lowrank lr;
+    ourconv_dev dev;
+    int bad = 0;
+
+    for (size_t i = 0; i < plane; i++) {
+        in[i] = (int16_t)(rand() % 8193 - 4096);
+    }
+    conv_lowrank_decompose(k, ksize, max_rank, 1e-5f, &lr);
+    conv2d_lowrank_q88(in, h, w, &lr, ref, NULL);
+    ourconv_dev_init(&dev);
+    if (ourconv_conv2d_lowrank(&dev, in, h, w, &lr, got, mode, NULL) != CONV_OK ||
+        memcmp(ref, got, sizeof(int16_t) * plane) != 0) {
+        printf("MISMATCH %s %dx%d, mode %d\n", name, h, w, mode);
+        bad = 1;
+    } else {
+        printf("%s, rank %d, %dx%d, mode %d: match\n", name, lr.rank, h, w, mode);
+    }
+    free(in);
+    free(ref);
+    free(got);
+    return bad;
+}
+
+static void bench(const char* name, const float* k, int ksize, int size) {
+    size_t plane = (size_t)size * size;
+    int16_t* in = malloc(sizeof(int16_t) * plane);
+    int16_t* out = malloc(sizeof(int16_t) * plane);
+    int16_t k_q[25];
+    ourconv_batch_stats direct, lowrank;
+    conv_lowrank lr;
+    ourconv_dev dev;
+
+    for (size_t i = 0; i < plane; i++) {
+        in[i] = (int16_t)((i * 7) % 23 * 64);
+    }
+    conv_f32_to_q88(k, ksize * ksize, k_q);
+    conv_lowrank_decompose(k, ksize, ksize, 1e-5f, &lr);
+    ourconv_dev_init(&dev);
+    ourconv_conv2d_q88(&dev, in, size, size, k_q, ksize, out, OURCONV_PIPELINED | OURCONV_SLIDE, &direct);
+    ourconv_dev_init(&dev);
+    ourconv_conv2d_lowrank(&dev, in, size, size, &lr, out, OURCONV_PIPELINED | OURCONV_SLIDE, &lowrank);
+    printf("%dx%d %s (rank %d): direct %llu cycles, 1-D passes %llu cycles (%.2fx)\n",
+           size, size, name, lr.rank, (unsigned long long)direct.cycles,
+           (unsigned long long)lowrank.cycles, (double)lowrank.cycles / direct.cycles);
+    free(in);
+    free(out);
+}
+
+int main() {
+    static const float sobel_x[9] = { -1, 0, 1, -2, 0, 2, -1, 0, 1 };
+    static const float binomial[5] = { 1, 4, 6, 4, 1 };
+    float gauss5[25], sobel_xy[9], random5[25];
+    int bad = 0;
+
+    for (int i = 0; i < 25; i++) {
+        gauss5[i] = binomial[i / 5] * binomial[i % 5] / 256.0f;
+        random5[i] = (float)(rand() % 513 - 256) / 256.0f;
+    }
+    for (int i = 0; i < 9; i++) {
+        sobel_xy[i] = sobel_x[i] + sobel_x[i % 3 * 3 + i / 3];
+    }
+
+    for (int mode = OURCONV_SERIAL; mode <= (OURCONV_PIPELINED | OURCONV_SLIDE); mode++) {
+        bad |= check("sobel x", sobel_x, 3, 1, 37, 21, mode);
+        bad |= check("binomial 5x5", gauss5, 5, 1, 29, 40, mode);
+    }
+    bad |= check("sobel x + y", sobel_xy, 3, 3, 64, 64, OURCONV_PIPELINED);
+    bad |= check("random 5x5", random5, 5, 5, 33, 17, OURCONV_PIPELINED);
+
+    conv_lowrank lr;
+    ourconv_dev dev;
+    int16_t px = 0;
+    conv_lowrank_decompose(random5, 5, 5, 0.0f, &lr);
+    lr.ksize = 7;
+    ourconv_dev_init(&dev);
+    if (ourconv_conv2d_lowrank(&dev, &px, 1, 1, &lr, &px, OURCONV_SERIAL, NULL) != CONV_EINVAL) {
+        printf("MISMATCH 7x7 accepted\n");
+        bad = 1;
+    }
+    printf("ourconv lowrank: %s\n", bad ? "MISMATCH" : "match");
+
+    bench("binomial 5x5", gauss5, 5, 256);
+    bench("sobel x", sobel_x, 3, 256);
+    return bad;
+}
@@ -0,0 +1,337 @@
+#include <stddef.h>
+#include <string.h>
+#include "ourconv_model.h"
+
+// Tile types, in the order of the Chisel Enum
+enum {
+    TT_TOP_LEFT, TT_TOP, TT_TOP_RIGHT, TT_LEFT, TT_CENTER, TT_RIGHT,
+    TT_BOTTOM_LEFT, TT_BOTTOM, TT_BOTTOM_RIGHT, TT_FULL
+};
+
+// saturation bounds (maxVal / minVal)
+#define Q88_MAX 32767
+#define Q88_MIN -32768
+
+void ourconv_model_init(ourconv_model* m) {
+    static const ourconv_timing timing = OURCONV_TIMING_DEFAULT;
+
+    memset(m, 0, sizeof(*m));
+    m->kernel_dim = 5;
+    for (int s = 0; s < OURCONV_KERNEL_SLOTS; s++) {
+        m->slot_size[s] = 2;
+    }
+    m->tile_type = TT_FULL;
+    m->stride = 1;
+    m->dilation = 1;
+    m->timing = timing;
+}
+
+uint64_t ourconv_model_cycles(const ourconv_model* m) {
+    uint64_t total = 0;
+
+    for (int p = 0; p < OURCONV_PHASES; p++) {
+        total += m->cycles[p];
+    }
+    return total;
+}
+
+// FSM cycles of a phase, also seen by the performance counters
+static void count_cycles(ourconv_model* m, int phase, uint64_t cycles) {
+    static const signed char busy[OURCONV_PHASES] = {
+        OURCONV_CTR_LOAD_BUSY, OURCONV_CTR_LOAD_BUSY, OURCONV_CTR_COMPUTE_BUSY, OURCONV_CTR_WRITE_BUSY, -1
+    };
+
+    m->cycles[phase] += cycles;
+    m->counters[OURCONV_CTR_CYCLES] += cycles;
+    if (busy[phase] >= 0) {
+        m->counters[busy[phase]] += cycles;
+    }
+}
+
+// io.mem traffic of one command: a request every req_interval cycles, so
+// each waits req_interval - 1 cycles on ready, and one response per word
+static void count_mem(ourconv_model* m, unsigned words) {
+    m->counters[OURCONV_CTR_MEM_REQS] += words;
+    m->counters[OURCONV_CTR_MEM_STALLS] += (uint64_t)words * (m->timing.req_interval - 1);
+    m->counters[OURCONV_CTR_MEM_RESPS] += words;
+}
+
+// Unpack one memory response into a register file, as in sReadKernelReq /
+// sReadInputReq: value i of word `tag` goes to element tag * 4 + i.
+static void unpack_word(int16_t* regs, unsigned num_elements, unsigned tag, uint64_t data) {
+    for (unsigned i = 0; i < 4; i++) {
+        unsigned flat = tag * 4 + i;
+        if (flat < num_elements) {
+            regs[flat] = (int16_t)(uint16_t)(data >> (16 * i));
+        }
+    }
+}
+
+static unsigned rs2_slot(uint64_t rs2) {
+    return (unsigned)(rs2 >> OURCONV_SLOT_SHIFT) & (OURCONV_KERNEL_SLOTS - 1);
+}
+
+uint64_t ourconv_load_kernel(ourconv_model* m, const uint64_t* packed, uint64_t kernel_code) {
+    unsigned code = (unsigned)(kernel_code & 3);
+    unsigned slot = rs2_slot(kernel_code);
+
+    m->kernel_dim = code == 0 ? 1 : code == 1 ? 3 : 5;
+    m->kernel_size = code;
+    m->slot_size[slot] = code;
+
+    unsigned elements = m->kernel_dim * m->kernel_dim;
+    unsigned words = (elements + 3) >> 2;
+    for (unsigned w = 0; w < words; w++) {
+        unpack_word(m->kernel[slot], elements, w, packed[w]);
+    }
+    m->mem_reads += words;
+    count_mem(m, words);
+    count_cycles(m, OURCONV_PHASE_KERNEL, ourconv_cycles_load(&m->timing, words));
+    count_cycles(m, OURCONV_PHASE_COMMAND, m->timing.cmd_overhead);
+    return 1;
+}
+
+static void count_input_load(ourconv_model* m, unsigned words) {
+    m->mem_reads += words;
+    count_mem(m, words);
+    count_cycles(m, OURCONV_PHASE_INPUT, ourconv_cycles_load(&m->timing, words));
+    if (m->input_loads++ == 0) {
+        count_cycles(m, OURCONV_PHASE_INPUT, m->timing.cold_penalty);
+    }
+    count_cycles(m, OURCONV_PHASE_COMMAND, m->timing.cmd_overhead);
+}
+
+uint64_t ourconv_load_input(ourconv_model* m, const uint64_t* packed) {
+    unsigned dim = OURCONV_N + m->kernel_dim - 1; // reg_inputDim
+    unsigned elements = dim * dim;
+    unsigned words = (elements + 3) >> 2;
+
+    for (unsigned w = 0; w < words; w++) {
+        unpack_word(m->input, elements, w, packed[w]);
+    }
+    count_input_load(m, words);
+    return 1;
+}
+
+uint64_t ourconv_slide_input(ourconv_model* m, const uint64_t* packed, uint64_t cols) {
+    unsigned dim = OURCONV_N + m->kernel_dim - 1;
+    unsigned shift = (unsigned)(cols & 0xF);
+    unsigned words = (dim * OURCONV_SLIDE_COLS) >> 2;
+
+    if (shift > OURCONV_SLIDE_COLS) {
+        shift = OURCONV_SLIDE_COLS;
+    }
+    // Flat shift on accept: row r keeps columns shift.. as 0.., and the
+    // vacated right-hand columns (filled with the next row's head) get the
+    // new data below
+    for (unsigned i = 0; i + shift < OURCONV_INPUT_REGS; i++) {
+        m->input[i] = m->input[i + shift];
+    }
+    for (unsigned w = 0; w < words; w++) {
+        for (unsigned i = 0; i < 4; i++) {
+            unsigned flat = w * 4 + i;
+            unsigned row = flat / OURCONV_SLIDE_COLS;
+            unsigned col = flat % OURCONV_SLIDE_COLS;
+            if (col < shift) {
+                m->input[row * dim + dim - shift + col] = (int16_t)(uint16_t)(packed[w] >> (16 * i));
+            }
+        }
+    }
+    count_input_load(m, words);
+    return 1;
+}
+
+// Input window scan range per tile type, set when doCompute is accepted.
+// Tile types outside the enum leave the previous range in place, as the RTL
+// when/elsewhen chain does. A ragged tile scans only its valid outputs, the
+// ones next to the window edge the tile is flush with. A strided or dilated
+// tile starts at the first full window and steps by the stride.
+static void set_scan_range(ourconv_model* m, uint64_t rs2) {
+    unsigned n = OURCONV_N;
+    unsigned pad = m->kernel_size;
+    unsigned type = (unsigned)(rs2 & 0xF);
+    unsigned rows = ourconv_compute_rows(rs2);
+    unsigned cols = ourconv_compute_cols(rs2);
+
+    if (m->stride > 1 || m->dilation > 1) {
+        unsigned first = pad * m->dilation;
+        m->in_row_start = first & 0xF;
+        m->in_row_end = (first + (rows - 1) * m->stride) & 0xF;
+        m->in_col_start = first & 0xF;
+        m->in_col_end = (first + (cols - 1) * m->stride) & 0xF;
+        return;
+    }
+    unsigned lo[3] = { 0, pad, 2 * pad };
+    unsigned hi[3] = { n - 1, n + pad - 1, n + 2 * pad - 1 };
+    // 0: flush with the top/left edge, 1: centred, 2: flush with bottom/right
+    static const unsigned char row_pos[10] = { 0, 0, 0, 1, 1, 1, 2, 2, 2, 0 };
+    static const unsigned char col_pos[10] = { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 };
+
+    if (type > TT_FULL) {
+        return;
+    }
+    unsigned rp = row_pos[type], cp = col_pos[type];
+    m->in_row_start = (rp == 2 ? hi[rp] - (rows - 1) : lo[rp]) & 0xF;
+    m->in_row_end = (rp == 2 ? hi[rp] : lo[rp] + rows - 1) & 0xF;
+    m->in_col_start = (cp == 2 ? hi[cp] - (cols - 1) : lo[cp]) & 0xF;
+    m->in_col_end = (cp == 2 ? hi[cp] : lo[cp] + cols - 1) & 0xF;
+}
+
+// Valid-tap check of the window fetch in sCompute. x and y are the 5-bit wrapped window
+// coordinates, so taps left of / above the tile look like large values.
+static int tap_valid(unsigned tile_type, unsigned pad, unsigned x, unsigned y) {
+    unsigned n = OURCONV_N;
+    unsigned last = n + 2 * pad - 1;
+
+    switch (tile_type) {
+    case TT_FULL:
+        return x < n && y < n;
+    case TT_CENTER:
+        return 1;
+    case TT_TOP_LEFT:
+        return x < n + pad && y < n + pad;
+    case TT_TOP:
+        return x < n + pad && y <= last;
+    case TT_LEFT:
+    case TT_BOTTOM_LEFT:
+        return x <= last && y < n + pad;
+    case TT_TOP_RIGHT:
+    case TT_RIGHT:
+    case TT_BOTTOM:
+    case TT_BOTTOM_RIGHT:
+        return x <= last && y <= last;
+    default:
+        return 0; // 4-bit values 10..15 match no branch
+    }
+}
+
+uint64_t ourconv_compute(ourconv_model* m, uint64_t* packed_out, uint64_t tile_type) {
+    // The slot's size is active from the accept on
+    m->compute_slot = rs2_slot(tile_type);
+    m->kernel_size = m->slot_size[m->compute_slot];
+    m->kernel_dim = m->kernel_size == 0 ? 1 : m->kernel_size == 1 ? 3 : 5;
+    m->stride = ourconv_compute_stride(tile_type);
+    m->dilation = ourconv_compute_dilation(tile_type);
+    m->tile_type = m->stride > 1 || m->dilation > 1 ? TT_CENTER : (unsigned)(tile_type & 0xF);
+    set_scan_range(m, tile_type);
+
+    unsigned pad = m->kernel_size;
+    unsigned k = 2 * pad + 1;
+    unsigned dil = m->dilation;
+    unsigned stride = (OURCONV_N + 2 * pad) & 0xF; // input row stride
+    unsigned out_idx = 0;
+    unsigned in_row = m->in_row_start;
+    unsigned in_col = m->in_col_start;
+    int finished = 0;
+
+    while (!finished) {
+        // Issue + stage 1: one truncated product per tap. Taps the RTL
+        // would read past the register files (pad 3 only) read as zero.
+        int64_t sum = 0;
+        for (unsigned i = 0; i < 5; i++) {
+            for (unsigned j = 0; j < 5; j++) {
+                if (i >= k || j >= k) {
+                    continue;
+                }
+                unsigned x = pad == 0 ? in_row : (in_row + (j - pad) * dil) & 0x1F;
+                unsigned y = pad == 0 ? in_col : (in_col + (i - pad) * dil) & 0x1F;
+                if (!tap_valid(m->tile_type, pad, x, y)) {
+                    continue;
+                }
+                unsigned kidx = j * k + i;
+                unsigned iidx = x * stride + y;
+                int32_t a = kidx < OURCONV_KERNEL_REGS ? m->kernel[m->compute_slot][kidx] : 0;
+                int32_t b = iidx < OURCONV_INPUT_REGS ? m->input[iidx] : 0;
+                // 16.8 x 16.8 -> 32.16, stored into a 32.8 accumulator
+                sum += (a * b) >> 8;
+            }
+        }
+        // Stage 2: adder tree into the 32-bit acc_buffer
+        int32_t acc_buffer = (int32_t)(uint32_t)(uint64_t)sum;
+
+        if (in_col == m->in_col_end) {
+            in_col = m->in_col_start;
+            if (in_row == m->in_row_end) {
+                finished = 1;
+            } else {
+                in_row = (in_row + m->stride) & 0xF;
+            }
+        } else {
+            in_col = (in_col + m->stride) & 0xF;
+        }
+
+        // Stage 3: clamp
+        unsigned index = out_idx & 0x3F;
+        if (acc_buffer > Q88_MAX) {
+            m->result[index] = Q88_MAX;
+            m->overflow_bits |= 1ULL << index;
+        } else if (acc_buffer < Q88_MIN) {
+            m->result[index] = Q88_MIN;
+            m->overflow_bits |= 1ULL << index;
+        } else {
+            m->result[index] = (int16_t)acc_buffer;
+        }
+        out_idx++;
+    }
+
+    // sWriteReq: four results per 64-bit word, val0 in the low bits, as many
+    // words as the valid outputs fill
+    unsigned words = ourconv_compute_words(tile_type);
+    for (unsigned w = 0; w < words; w++) {
+        uint64_t data = 0;
+        for (unsigned i = 0; i < 4; i++) {
+            data |= (uint64_t)(uint16_t)m->result[w * 4 + i] << (16 * i);
+        }
+        packed_out[w] = data;
+    }
+    m->mem_writes += words;
+    count_mem(m, words);
+    count_cycles(m, OURCONV_PHASE_COMPUTE, ourconv_cycles_compute(&m->timing, out_idx));
+    count_cycles(m, OURCONV_PHASE_WRITEBACK, ourconv_cycles_writeback(&m->timing, words));
+    count_cycles(m, OURCONV_PHASE_COMMAND, m->timing.cmd_overhead);
+    m->counters[OURCONV_CTR_TILES]++;
+    return m->overflow_bits;
+}
+
+// Both answer from sRespond right after the accept; the round trip is
+// all the time they take
+uint64_t ourconv_read_counter(ourconv_model* m, uint64_t index) {
+    uint64_t value = index < OURCONV_COUNTERS ? m->counters[index] : 0;
+
+    count_cycles(m, OURCONV_PHASE_COMMAND, m->timing.cmd_overhead);
+    return value;
+}
+
+uint64_t ourconv_reset_counters(ourconv_model* m) {
+    count_cycles(m, OURCONV_PHASE_COMMAND, m->timing.cmd_overhead);
+    memset(m->counters, 0, sizeof(m->counters));
+    return 1;
+}
+
+const char* ourconv_counter_name(int counter) {
+    static const char* names[OURCONV_COUNTERS] = {
+        "cycles", "load_busy", "compute_busy", "write_busy",
+        "mem_reqs", "mem_stalls", "mem_resps", "tiles"
+    };
+    return counter >= 0 && counter < OURCONV_COUNTERS ? names[counter] : "?";
+}
+
+uint64_t ourconv_model_cmd(ourconv_model* m, unsigned funct7, uint64_t rs1, uint64_t rs2) {
+    switch (funct7) {
+    case OURCONV_FUNCT7_LOADKERNEL:
+        return ourconv_load_kernel(m, (const uint64_t*)(uintptr_t)rs1, rs2);
+    case OURCONV_FUNCT7_LOADINPUT:
+        return ourconv_load_input(m, (const uint64_t*)(uintptr_t)rs1);
+    case OURCONV_FUNCT7_COMPUTE:
+        return ourconv_compute(m, (uint64_t*)(uintptr_t)rs1, rs2);
+    case OURCONV_FUNCT7_SLIDEINPUT:
+        return ourconv_slide_input(m, (const uint64_t*)(uintptr_t)rs1, rs2);
+    case OURCONV_FUNCT7_READCOUNTER:
+        return ourconv_read_counter(m, rs2);
+    case OURCONV_FUNCT7_RESETCOUNTERS:
+        return ourconv_reset_counters(m);
+    default:
+        m->bad_commands++;
+        return 0;
+    }
+}
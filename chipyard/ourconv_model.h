@@ -0,0 +1,166 @@
+#ifndef OURCONV_MODEL_H
+#define OURCONV_MODEL_H
+
+// Bit-accurate software model of the OurCONV RoCC accelerator (OurCONV.scala).
+//
+// It executes the same custom instructions on the host: doLoadKernel and
+// doLoadInput read packed Q8.8 words (val0 in bits 15:0 ... val3 in 63:48)
+// from the address in rs1, and doCompute runs one 8x8 output tile with the
+// RTL's tile-type edge handling, MAC truncation and output clamp, writes
+// 16 packed words to rs1 and returns overflowBits. A ragged edge tile gives
+// its valid rows and columns in rs2 (OURCONV_COMPUTE_RS2): only those
+// outputs are computed, and they are written row-major without gaps.
+//
+// doCompute rs2 also carries an output stride (1, 2 or 4) and a kernel
+// dilation (1 or 2). With either one above 1 the tile is scanned like a
+// center tile whatever its type: the driver zero-fills the padding into the
+// window. Outputs are then stride pixels apart and taps dilation pixels apart,
+// and only the valid rows x cols outputs on that grid are computed, which is
+// at most ourconv_strided_outputs() per axis to stay inside the window.
+//
+// doSlideInput moves the input window right along a tile row: it shifts the
+// register file left by rs2 columns (1..8, larger values act as 8), keeping
+// the overlapping halo, and reads only the new columns from rs1 as a block of
+// input-dim rows of 8 values, of which the first rs2 per row are used.
+//
+// The accelerator keeps OURCONV_KERNEL_SLOTS kernels resident. doLoadKernel
+// fills the slot given in rs2 bits 12 and up, doCompute reads the one given
+// there. Each slot remembers its size; a doCompute makes its slot's size the
+// active one, which doLoadInput and doSlideInput lay the input window out
+// by, as does every doLoadKernel.
+//
+// Like the RTL, overflowBits is never cleared: every doCompute returns the
+// OR of the overflow bits of all tiles computed since reset.
+//
+// Each command also advances the cycle counters of ourconv_perf.h, so a
+// driver run against the model reports where the accelerator time goes.
+//
+// doReadCounter returns performance counter rs2 (enum ourconv_counter, 0
+// past the last one) and doResetCounters clears them all and returns 1.
+// The RTL counts state cycles and io.mem handshakes; the model derives the
+// same counts from its timing, so its cycle counter only sees accelerator
+// commands, not the idle time between them. A query's own round trip is
+// not in the value it returns.
+
+#include <stdint.h>
+#include "ourconv_perf.h"
+
+#define OURCONV_FUNCT7_LOADINPUT 0x01
+#define OURCONV_FUNCT7_LOADKERNEL 0x02
+#define OURCONV_FUNCT7_COMPUTE 0x03
+#define OURCONV_FUNCT7_SLIDEINPUT 0x04
+#define OURCONV_FUNCT7_READCOUNTER 0x05
+#define OURCONV_FUNCT7_RESETCOUNTERS 0x06
+
+// Performance counters, the rs2 of doReadCounter
+enum ourconv_counter {
+    OURCONV_CTR_CYCLES,       // every cycle since the last reset
+    OURCONV_CTR_LOAD_BUSY,    // sReadKernelReq .. sLoadInputDone
+    OURCONV_CTR_COMPUTE_BUSY, // sSetup, sCompute, sDrain
+    OURCONV_CTR_WRITE_BUSY,   // sWriteReq, sWaitWriteResp, sDone
+    OURCONV_CTR_MEM_REQS,     // io.mem requests issued, reads and writes
+    OURCONV_CTR_MEM_STALLS,   // cycles a request waited on io.mem.req.ready
+    OURCONV_CTR_MEM_RESPS,    // io.mem responses received
+    OURCONV_CTR_TILES,        // doComputes completed
+    OURCONV_COUNTERS
+};
+
+#define OURCONV_N 8 // output tile edge
+#define OURCONV_KERNEL_REGS 25
+#define OURCONV_INPUT_REGS 144
+#define OURCONV_OUTPUT_WORDS ((OURCONV_N * OURCONV_N + 3) / 4)
+#define OURCONV_SLIDE_COLS 8 // row length of a doSlideInput block
+#define OURCONV_KERNEL_SLOTS 4 // OurCONV kernelSlots
+#define OURCONV_SLOT_SHIFT 12  // slot ID position in doLoadKernel/doCompute rs2
+
+// doCompute rs2: tile type in bits 3:0, valid output rows in bits 6:4 and
+// columns in bits 10:8, 0 meaning all 8.
+#define OURCONV_COMPUTE_RS2(type, rows, cols) \
+    ((uint64_t)(type) | (uint64_t)((rows) & 7) << 4 | (uint64_t)((cols) & 7) << 8)
+
+// doCompute rs2 bits 17:16: output stride 1, 2, 4 (code 3 acts as 4);
+// bit 18: dilation 1, 2
+#define OURCONV_STRIDE_SHIFT 16
+#define OURCONV_DILATION_SHIFT 18
+
+static inline uint64_t ourconv_compute_step(int stride, int dilation) {
+    uint64_t code = stride >= 4 ? 2 : stride == 2 ? 1 : 0;
+    return code << OURCONV_STRIDE_SHIFT | (uint64_t)(dilation == 2) << OURCONV_DILATION_SHIFT;
+}
+
+static inline unsigned ourconv_compute_stride(uint64_t rs2) {
+    unsigned code = (unsigned)(rs2 >> OURCONV_STRIDE_SHIFT) & 3;
+    return code == 0 ? 1 : code == 1 ? 2 : 4;
+}
+
+static inline unsigned ourconv_compute_dilation(uint64_t rs2) {
+    return 1 + ((unsigned)(rs2 >> OURCONV_DILATION_SHIFT) & 1);
+}
+
+// Outputs per axis a window of the given kernel size holds at this stride
+// and dilation: 8 when dense, 4 at stride 2, 2 for a 5x5 at stride 4, ...
+static inline unsigned ourconv_strided_outputs(int ksize, int stride, int dilation) {
+    int span = OURCONV_N - 1 - (ksize - 1) * (dilation - 1);
+    return span < 0 ? 0 : (unsigned)(span / stride + 1);
+}
+
+static inline unsigned ourconv_compute_rows(uint64_t rs2) {
+    return (rs2 >> 4 & 7) ? (unsigned)(rs2 >> 4 & 7) : OURCONV_N;
+}
+
+static inline unsigned ourconv_compute_cols(uint64_t rs2) {
+    return (rs2 >> 8 & 7) ? (unsigned)(rs2 >> 8 & 7) : OURCONV_N;
+}
+
+// Words a doCompute writes back
+static inline unsigned ourconv_compute_words(uint64_t rs2) {
+    return (ourconv_compute_rows(rs2) * ourconv_compute_cols(rs2) + 3) / 4;
+}
+
+typedef struct {
+    // Architectural registers of OurCONVModuleImp
+    int16_t kernel[OURCONV_KERNEL_SLOTS][OURCONV_KERNEL_REGS];
+    unsigned slot_size[OURCONV_KERNEL_SLOTS]; // slotSize: size code per slot
+    unsigned compute_slot; // reg_computeSlot
+    int16_t input[OURCONV_INPUT_REGS];
+    int16_t result[OURCONV_N * OURCONV_N];
+    unsigned kernel_dim;  // reg_kernelDim: 1, 3 or 5
+    unsigned kernel_size; // kernelSize: the padding, 0..2
+    unsigned stride, dilation; // reg_stride / reg_dilation of the last doCompute
+    unsigned tile_type;   // 4-bit tileType register
+    unsigned in_row_start, in_row_end, in_col_start, in_col_end;
+    uint64_t overflow_bits;
+    uint64_t counters[OURCONV_COUNTERS]; // perf
+
+    // Bookkeeping, not part of the RTL state
+    uint64_t mem_reads;   // 64-bit words read over io.mem
+    uint64_t mem_writes;  // 64-bit words written over io.mem
+    uint64_t bad_commands; // funct7 values the RTL ignores (it would never respond)
+    ourconv_timing timing;
+    uint64_t cycles[OURCONV_PHASES];
+    uint64_t input_loads;
+} ourconv_model;
+
+// Reset state: kernel dimension 5 in every slot, tile type full, everything
+// else zero, OURCONV_TIMING_DEFAULT timing.
+void ourconv_model_init(ourconv_model* m);
+
+// Cycles of all commands since reset, summed over the phases.
+uint64_t ourconv_model_cycles(const ourconv_model* m);
+
+// One RoCC command. rs1 is a host pointer cast to uint64_t, as in the tests.
+// Returns the value the accelerator writes to rd.
+uint64_t ourconv_model_cmd(ourconv_model* m, unsigned funct7, uint64_t rs1, uint64_t rs2);
+
+// The instructions by name. kernel_code: 0 = 1x1, 1 = 3x3, 2 = 5x5, plus
+// the slot ID << OURCONV_SLOT_SHIFT.
+uint64_t ourconv_load_kernel(ourconv_model* m, const uint64_t* packed, uint64_t kernel_code);
+uint64_t ourconv_load_input(ourconv_model* m, const uint64_t* packed);
+uint64_t ourconv_slide_input(ourconv_model* m, const uint64_t* packed, uint64_t cols);
+uint64_t ourconv_compute(ourconv_model* m, uint64_t* packed_out, uint64_t tile_type);
+uint64_t ourconv_read_counter(ourconv_model* m, uint64_t index);
+uint64_t ourconv_reset_counters(ourconv_model* m);
+
+const char* ourconv_counter_name(int counter);
+
+#endif
@@ -0,0 +1,342 @@
+// Build: gcc -O2 -I.. -o ourconv_model_test ourconv_model_test.c ourconv_model.c ourconv_perf.c ../conv_tiles.c ../conv.c ../conv_simd.c
+//
+// Checks the OurCONV software model against conv2d_q88() and against the
+// tile-by-tile RTL simulation log in "Results Logs".
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "conv_tiles.h"
+#include "ourconv_model.h"
+
+#define RTL_LOG "../Results Logs/3x3Kernel_tilebytileOutput.txt"
+
+static void pack_q88(const int16_t* vals, int n, uint64_t* packed) {
+    memset(packed, 0, sizeof(uint64_t) * ((n + 3) / 4));
+    for (int i = 0; i < n; i++) {
+        packed[i / 4] |= (uint64_t)(uint16_t)vals[i] << (16 * (i % 4));
+    }
+}
+
+// Drive the model over a whole image exactly like convFSM_test.c: one
+// doLoadInput + doCompute per 8x8 tile. Returns the OR of all overflow bits.
+static uint64_t model_conv(ourconv_model* m, const int16_t* in, int h, int w,
+                           const int16_t* k, int ksize, int16_t* out) {
+    uint64_t packed_kernel[(OURCONV_KERNEL_REGS + 3) / 4];
+    uint64_t packed_input[(OURCONV_INPUT_REGS + 3) / 4];
+    uint64_t packed_out[OURCONV_OUTPUT_WORDS];
+    int16_t tile_in[OURCONV_INPUT_REGS];
+    int in_tile = OURCONV_N + ksize - 1;
+    uint64_t overflow = 0;
+    conv_tiling t;
+    conv_tile tile;
+
+    conv_tiling_init(&t, h, w, ksize, OURCONV_N);
+    pack_q88(k, ksize * ksize, packed_kernel);
+    ourconv_model_cmd(m, OURCONV_FUNCT7_LOADKERNEL, (uint64_t)(uintptr_t)packed_kernel, ksize / 2);
+
+    for (int idx = 0; idx < conv_tiling_count(&t); idx++) {
+        conv_tile_at(&t, idx, &tile);
+        // Zero where the window overhangs an image smaller than itself
+        for (int r = 0; r < in_tile; r++) {
+            for (int c = 0; c < in_tile; c++) {
+                int y = tile.in_row + r, x = tile.in_col + c;
+                tile_in[r * in_tile + c] = y < h && x < w ? in[y * w + x] : 0;
+            }
+        }
+        pack_q88(tile_in, in_tile * in_tile, packed_input);
+        ourconv_model_cmd(m, OURCONV_FUNCT7_LOADINPUT, (uint64_t)(uintptr_t)packed_input, 0);
+        overflow |= ourconv_model_cmd(m, OURCONV_FUNCT7_COMPUTE, (uint64_t)(uintptr_t)packed_out, tile.type);
+
+        for (int r = 0; r < OURCONV_N; r++) {
+            for (int c = 0; c < OURCONV_N; c++) {
+                int i = r * OURCONV_N + c;
+                out[(tile.out_row + r) * w + tile.out_col + c] = (int16_t)(packed_out[i / 4] >> (16 * (i % 4)));
+            }
+        }
+    }
+    return overflow;
+}
+
+// Model vs conv2d_q88() on random data. Large inputs make some pixels
+// saturate, so the clamp and the overflow bits get exercised too.
+static int check_reference(int h, int w, int ksize, int scale) {
+    int16_t* in = malloc(sizeof(int16_t) * h * w);
+    int16_t* ref = malloc(sizeof(int16_t) * h * w);
+    int16_t* got = malloc(sizeof(int16_t) * h * w);
+    uint8_t* overflow = malloc((size_t)h * w);
+    int16_t k[25];
+    ourconv_model m;
+    int bad = 0;
+
+    for (int i = 0; i < h * w; i++) {
+        in[i] = (int16_t)(rand() % (2 * scale + 1) - scale);
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (int16_t)(rand() % 1025 - 512);
+    }
+    conv2d_q88(in, h, w, k, ksize, ref, overflow);
+
+    ourconv_model_init(&m);
+    uint64_t bits = model_conv(&m, in, h, w, k, ksize, got);
+
+    // Bit b of the model result is set iff pixel b of some tile overflowed
+    uint64_t expect = 0;
+    conv_tiling t;
+    conv_tile tile;
+    conv_tiling_init(&t, h, w, ksize, OURCONV_N);
+    for (int idx = 0; idx < conv_tiling_count(&t); idx++) {
+        conv_tile_at(&t, idx, &tile);
+        for (int r = 0; r < OURCONV_N; r++) {
+            for (int c = 0; c < OURCONV_N; c++) {
+                if (overflow[(tile.out_row + r) * w + tile.out_col + c]) {
+                    expect |= 1ULL << (r * OURCONV_N + c);
+                }
+            }
+        }
+    }
+
+    if (memcmp(ref, got, sizeof(int16_t) * h * w) != 0 || bits != expect) {
+        printf("  %dx%d k%d scale %d: MISMATCH (overflow %016llx, expected %016llx)\n", h, w, ksize, scale,
+               (unsigned long long)bits, (unsigned long long)expect);
+        bad = 1;
+    }
+    free(in);
+    free(ref);
+    free(got);
+    free(overflow);
+    return bad;
+}
+
+// Replays the 32x32 3x3 run logged from the RTL simulation (input i % 4,
+// kernel from convFSM_test.c) and compares every tile word for word.
+static int check_rtl_log(void) {
+    static const float kernel[9] = { 1.0, 5.0, -1.0, 2.0, 0.5, -2.0, 3.0, 0.5, -3.0 };
+    int16_t in[32 * 32], k[9], out[32 * 32];
+    char line[512];
+    int tile = -1, row = 0, bad = 0, tiles = 0;
+    ourconv_model m;
+    conv_tiling t;
+    conv_tile desc;
+
+    FILE* f = fopen(RTL_LOG, "r");
+    if (!f) {
+        printf("RTL log: %s not found, skipped\n", RTL_LOG);
+        return 0;
+    }
+    for (int i = 0; i < 32 * 32; i++) {
+        in[i] = (int16_t)((i % 4) * 256);
+    }
+    for (int i = 0; i < 9; i++) {
+        k[i] = (int16_t)(kernel[i] * 256.0f);
+    }
+    ourconv_model_init(&m);
+    model_conv(&m, in, 32, 32, k, 3, out);
+    conv_tiling_init(&t, 32, 32, 3, OURCONV_N);
+
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "Tile type:", 10) == 0) {
+            tile++;
+            tiles++;
+            row = 0;
+            conv_tile_at(&t, tile, &desc);
+            continue;
+        }
+        if (strncmp(line, "0x", 2) != 0 || tile < 0 || row >= OURCONV_N) {
+            continue;
+        }
+        char* p = line;
+        for (int c = 0; c < OURCONV_N; c++) {
+            unsigned v = (unsigned)strtoul(p, &p, 16);
+            uint16_t mine = (uint16_t)out[(desc.out_row + row) * 32 + desc.out_col + c];
+            if (v != mine) {
+                if (bad++ < 4) {
+                    printf("  tile %d (%d,%d): RTL %04x, model %04x\n", tile, row, c, v, mine);
+                }
+            }
+        }
+        row++;
+    }
+    fclose(f);
+    printf("RTL log: %d tiles, %s\n", tiles, bad ? "MISMATCH" : "match");
+    return bad != 0;
+}
+
+// doLoadInput of window (0, c0), then doSlideInput by `shift` columns, must
+// leave the registers of a plain doLoadInput of window (0, c0 + shift).
+static int check_slide(void) {
+    uint64_t packed_kernel[(OURCONV_KERNEL_REGS + 3) / 4] = { 0 };
+    uint64_t packed[(OURCONV_INPUT_REGS + 3) / 4];
+    int16_t img[12 * 32], win[OURCONV_INPUT_REGS], ref[OURCONV_INPUT_REGS];
+    ourconv_model m;
+    int bad = 0;
+
+    for (int i = 0; i < 12 * 32; i++) {
+        img[i] = (int16_t)(i * 7 - 1000);
+    }
+    for (int ksize = 1; ksize <= 5; ksize += 2) {
+        int dim = OURCONV_N + ksize - 1;
+        for (int shift = 1; shift <= 9; shift++) {
+            int moved = shift > OURCONV_SLIDE_COLS ? OURCONV_SLIDE_COLS : shift;
+            ourconv_model_init(&m);
+            ourconv_load_kernel(&m, packed_kernel, (uint64_t)(ksize / 2));
+            for (int r = 0; r < dim; r++) {
+                memcpy(win + r * dim, img + r * 32 + 3, sizeof(int16_t) * dim);
+            }
+            pack_q88(win, dim * dim, packed);
+            ourconv_load_input(&m, packed);
+
+            // New columns as dim rows of 8, only the first `moved` used
+            for (int r = 0; r < dim; r++) {
+                memcpy(win + r * OURCONV_SLIDE_COLS, img + r * 32 + 3 + dim, sizeof(int16_t) * OURCONV_SLIDE_COLS);
+            }
+            pack_q88(win, dim * OURCONV_SLIDE_COLS, packed);
+            uint64_t reads = m.mem_reads;
+            ourconv_slide_input(&m, packed, (uint64_t)shift);
+
+            for (int r = 0; r < dim; r++) {
+                memcpy(ref + r * dim, img + r * 32 + 3 + moved, sizeof(int16_t) * dim);
+            }
+            if (memcmp(m.input, ref, sizeof(int16_t) * dim * dim) != 0 ||
+                m.mem_reads - reads != (uint64_t)dim * OURCONV_SLIDE_COLS / 4) {
+                printf("slide k%d by %d: MISMATCH\n", ksize, shift);
+                bad = 1;
+            }
+        }
+    }
+    printf("slide input: %s\n", bad ? "MISMATCH" : "match");
+    return bad;
+}
+
+// One input window computed against every kernel slot must equal loading
+// that kernel alone. Slot 3 holds a 5x5 among 3x3s: computing on it makes
+// 5x5 the active size, so the window is reloaded at that size first.
+static int check_slots(void) {
+    uint64_t kernels[OURCONV_KERNEL_SLOTS][(OURCONV_KERNEL_REGS + 3) / 4];
+    uint64_t packed_input[(OURCONV_INPUT_REGS + 3) / 4];
+    uint64_t got[OURCONV_OUTPUT_WORDS], want[OURCONV_OUTPUT_WORDS];
+    int16_t vals[OURCONV_INPUT_REGS];
+    ourconv_model m, ref;
+    int bad = 0;
+
+    for (int i = 0; i < OURCONV_INPUT_REGS; i++) {
+        vals[i] = (int16_t)(rand() % 2049 - 1024);
+    }
+    pack_q88(vals, OURCONV_INPUT_REGS, packed_input);
+    ourconv_model_init(&m);
+    for (int s = 0; s < OURCONV_KERNEL_SLOTS; s++) {
+        int ksize = s == 3 ? 5 : 3;
+        for (int i = 0; i < ksize * ksize; i++) {
+            vals[i] = (int16_t)(rand() % 513 - 256);
+        }
+        pack_q88(vals, ksize * ksize, kernels[s]);
+        ourconv_load_kernel(&m, kernels[s], (uint64_t)(ksize / 2) | (uint64_t)s << OURCONV_SLOT_SHIFT);
+    }
+    // 5x5 in slot 3 was loaded last: reload the input at 3x3 via slot 0
+    ourconv_compute(&m, got, CONV_TILE_CENTER);
+    for (int s = 0; s < OURCONV_KERNEL_SLOTS; s++) {
+        int ksize = s == 3 ? 5 : 3;
+        uint64_t rs2 = CONV_TILE_CENTER | (uint64_t)s << OURCONV_SLOT_SHIFT;
+        if (s == 3) {
+            ourconv_compute(&m, got, rs2); // make 5x5 active
+        }
+        ourconv_load_input(&m, packed_input);
+        ourconv_compute(&m, got, rs2);
+
+        ourconv_model_init(&ref);
+        ourconv_load_kernel(&ref, kernels[s], (uint64_t)(ksize / 2));
+        ourconv_load_input(&ref, packed_input);
+        ourconv_compute(&ref, want, CONV_TILE_CENTER);
+        if (memcmp(got, want, sizeof(got)) != 0) {
+            printf("  kernel slot %d: MISMATCH\n", s);
+            bad = 1;
+        }
+    }
+    printf("kernel slots: %s\n", bad ? "MISMATCH" : "match");
+    return bad;
+}
+
+// The performance counters follow the commands: busy cycles per class add
+// up to the phase cycles, requests and responses to the words moved, and
+// doResetCounters clears them all
+static int check_counters(void) {
+    uint64_t packed_kernel[(OURCONV_KERNEL_REGS + 3) / 4] = { 0 };
+    uint64_t packed_input[(OURCONV_INPUT_REGS + 3) / 4] = { 0 };
+    uint64_t packed_out[OURCONV_OUTPUT_WORDS];
+    uint64_t c[OURCONV_COUNTERS];
+    ourconv_model m;
+    int bad = 0;
+
+    ourconv_model_init(&m);
+    m.timing.req_interval = 2;
+    ourconv_model_cmd(&m, OURCONV_FUNCT7_LOADKERNEL, (uint64_t)(uintptr_t)packed_kernel, 1);
+    for (int t = 0; t < 3; t++) {
+        ourconv_load_input(&m, packed_input);
+        ourconv_compute(&m, packed_out, CONV_TILE_CENTER);
+    }
+    for (int i = 0; i < OURCONV_COUNTERS; i++) {
+        c[i] = ourconv_model_cmd(&m, OURCONV_FUNCT7_READCOUNTER, 0, (uint64_t)i);
+    }
+    uint64_t words = m.mem_reads + m.mem_writes;
+    if (c[OURCONV_CTR_LOAD_BUSY] != m.cycles[OURCONV_PHASE_KERNEL] + m.cycles[OURCONV_PHASE_INPUT] ||
+        c[OURCONV_CTR_COMPUTE_BUSY] != m.cycles[OURCONV_PHASE_COMPUTE] ||
+        c[OURCONV_CTR_WRITE_BUSY] != m.cycles[OURCONV_PHASE_WRITEBACK] ||
+        c[OURCONV_CTR_CYCLES] != 7 * m.timing.cmd_overhead + c[OURCONV_CTR_LOAD_BUSY] +
+                                 c[OURCONV_CTR_COMPUTE_BUSY] + c[OURCONV_CTR_WRITE_BUSY] ||
+        c[OURCONV_CTR_MEM_REQS] != words || c[OURCONV_CTR_MEM_RESPS] != words ||
+        c[OURCONV_CTR_MEM_STALLS] != words || c[OURCONV_CTR_TILES] != 3) {
+        bad = 1;
+    }
+    if (ourconv_model_cmd(&m, OURCONV_FUNCT7_READCOUNTER, 0, OURCONV_COUNTERS) != 0 ||
+        ourconv_model_cmd(&m, OURCONV_FUNCT7_RESETCOUNTERS, 0, 0) != 1 || m.bad_commands != 0) {
+        bad = 1;
+    }
+    for (int i = 0; i < OURCONV_COUNTERS; i++) {
+        bad |= ourconv_read_counter(&m, (uint64_t)i) != (i == OURCONV_CTR_CYCLES ? i * m.timing.cmd_overhead : 0);
+    }
+    printf("performance counters: %s\n", bad ? "MISMATCH" : "match");
+    return bad;
+}
+
+int main() {
+    static const int shapes[][2] = { { 8, 8 }, { 32, 32 }, { 40, 24 }, { 64, 96 } };
+    static const int scales[] = { 256, 8192 };
+    int bad = 0;
+
+    for (unsigned s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        for (int ksize = 1; ksize <= 5; ksize += 2) {
+            for (unsigned sc = 0; sc < sizeof(scales) / sizeof(scales[0]); sc++) {
+                bad |= check_reference(shapes[s][0], shapes[s][1], ksize, scales[sc]);
+            }
+        }
+    }
+    printf("model vs conv2d_q88: %s\n", bad ? "MISMATCH" : "match");
+
+    // Sticky overflow: a clean tile after a saturating one still reports it
+    ourconv_model m;
+    uint64_t packed_kernel[1] = { 0x7fff };
+    uint64_t packed_input[(OURCONV_INPUT_REGS + 3) / 4];
+    uint64_t packed_out[OURCONV_OUTPUT_WORDS];
+    ourconv_model_init(&m);
+    ourconv_load_kernel(&m, packed_kernel, 0);
+    memset(packed_input, 0x7f, sizeof(packed_input));
+    uint64_t first = ourconv_load_input(&m, packed_input) ? ourconv_compute(&m, packed_out, CONV_TILE_FULL) : 0;
+    memset(packed_input, 0, sizeof(packed_input));
+    ourconv_load_input(&m, packed_input);
+    uint64_t second = ourconv_compute(&m, packed_out, CONV_TILE_FULL);
+    if (first != ~0ULL || second != first || packed_out[0] != 0) {
+        printf("sticky overflow: MISMATCH\n");
+        bad = 1;
+    }
+    if (ourconv_model_cmd(&m, 0x7f, 0, 0) != 0 || m.bad_commands != 1) {
+        printf("unknown funct7: MISMATCH\n");
+        bad = 1;
+    }
+
+    bad |= check_slide();
+    bad |= check_slots();
+    bad |= check_counters();
+    bad |= check_rtl_log();
+    return bad;
+}
@@ -0,0 +1,85 @@
+#include <string.h>
+#include "conv.h"
+#include "ourconv_pack.h"
+
+// On a little-endian core value i of a packed buffer is simply the i-th
+// int16 in memory, so packing is a conversion into a contiguous int16 run.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "ourconv_pack: the packed layout assumes a little-endian host"
+#endif
+
+typedef int16_t __attribute__((may_alias)) q88_lane;
+
+// Part [c0, c1) of window columns [0, cols) that lies inside the image
+static void window_cols(int col, int cols, int w, int* c0, int* c1) {
+    *c0 = col < 0 ? -col : 0;
+    *c1 = col + cols > w ? w - col : cols;
+    if (*c1 < *c0) {
+        *c1 = *c0;
+    }
+}
+
+static void zero_tail(uint64_t* packed, int n) {
+    q88_lane* lanes = (q88_lane*)packed;
+
+    for (int i = n; i & 3; i++) {
+        lanes[i] = 0;
+    }
+}
+
+int ourconv_pack_f32(const float* img, int h, int w, int stride,
+                     int row, int col, int rows, int cols, uint64_t* packed) {
+    q88_lane* lanes = (q88_lane*)packed;
+    int c0, c1, clamped = 0;
+
+    window_cols(col, cols, w, &c0, &c1);
+    for (int r = 0; r < rows; r++) {
+        q88_lane* dst = lanes + r * cols;
+        int y = row + r;
+        if (y < 0 || y >= h || c0 == c1) {
+            memset(dst, 0, sizeof(int16_t) * cols);
+            continue;
+        }
+        memset(dst, 0, sizeof(int16_t) * c0);
+        clamped += conv_f32_to_q88(img + (long)y * stride + col + c0, c1 - c0, (int16_t*)dst + c0);
+        memset(dst + c1, 0, sizeof(int16_t) * (cols - c1));
+    }
+    zero_tail(packed, rows * cols);
+    return clamped;
+}
+
+void ourconv_pack_q88(const int16_t* img, int h, int w, int stride,
+                      int row, int col, int rows, int cols, uint64_t* packed) {
+    q88_lane* lanes = (q88_lane*)packed;
+    int c0, c1;
+
+    window_cols(col, cols, w, &c0, &c1);
+    for (int r = 0; r < rows; r++) {
+        q88_lane* dst = lanes + r * cols;
+        int y = row + r;
+        if (y < 0 || y >= h || c0 == c1) {
+            memset(dst, 0, sizeof(int16_t) * cols);
+            continue;
+        }
+        memset(dst, 0, sizeof(int16_t) * c0);
+        memcpy(dst + c0, img + (long)y * stride + col + c0, sizeof(int16_t) * (c1 - c0));
+        memset(dst + c1, 0, sizeof(int16_t) * (cols - c1));
+    }
+    zero_tail(packed, rows * cols);
+}
+
+void ourconv_unpack_f32(const uint64_t* packed, int rows, int cols, float* dst, int stride) {
+    const q88_lane* lanes = (const q88_lane*)packed;
+
+    for (int r = 0; r < rows; r++) {
+        conv_q88_to_f32((const int16_t*)lanes + r * cols, cols, dst + (long)r * stride);
+    }
+}
+
+void ourconv_unpack_q88(const uint64_t* packed, int rows, int cols, int16_t* dst, int stride) {
+    const q88_lane* lanes = (const q88_lane*)packed;
+
+    for (int r = 0; r < rows; r++) {
+        memcpy(dst + (long)r * stride, lanes + r * cols, sizeof(int16_t) * cols);
+    }
+}
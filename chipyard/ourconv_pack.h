@@ -0,0 +1,33 @@
+#ifndef OURCONV_PACK_H
+#define OURCONV_PACK_H
+
+// Packing between strided images and OurCONV's packed Q8.8 buffers.
+//
+// A packed buffer holds a rows x cols window row-major, four values per
+// 64-bit word (value i in bits 16 * (i % 4) of word i / 4), with the last
+// word zero-filled. That is the layout doLoadKernel/doLoadInput read and
+// doCompute writes. Each call is a single pass: source pixels are converted
+// straight into the packed words (vectorised through conv_f32_to_q88()), and
+// unpacking writes straight into the strided destination image.
+
+#include <stdint.h>
+
+// Words needed for a rows x cols window.
+#define OURCONV_PACKED_WORDS(rows, cols) (((rows) * (cols) + 3) / 4)
+
+// Pack the window with top-left pixel (row, col) of an h x w image whose
+// rows are `stride` elements apart. Window pixels outside the image are 0,
+// so row/col may be negative for centred halo windows. The float version
+// converts like float_to_fixed88() and returns how many values were out of
+// Q8.8 range (clamped); the Q8.8 version just packs.
+int ourconv_pack_f32(const float* img, int h, int w, int stride,
+                     int row, int col, int rows, int cols, uint64_t* packed);
+void ourconv_pack_q88(const int16_t* img, int h, int w, int stride,
+                      int row, int col, int rows, int cols, uint64_t* packed);
+
+// Scatter a packed rows x cols window into an image at dst (its top-left
+// pixel), rows `stride` elements apart.
+void ourconv_unpack_f32(const uint64_t* packed, int rows, int cols, float* dst, int stride);
+void ourconv_unpack_q88(const uint64_t* packed, int rows, int cols, int16_t* dst, int stride);
+
+#endif
@@ -0,0 +1,187 @@
+// Build: gcc -O2 -I.. -o ourconv_pack_test ourconv_pack_test.c ourconv_pack.c ../conv.c ../conv_simd.c
+//
+// Checks one-pass packing against the copy / zero / convert-and-OR passes
+// convFSM_test.c used to do per tile, on every ISA the CPU supports, and
+// times both over the tiles of a 1080p frame.
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "conv.h"
+#include "ourconv_pack.h"
+
+#define TILE 8
+#define MAX_WINDOW (TILE + 4)
+#define BENCH_H 1080
+#define BENCH_W 1920
+
+static inline uint64_t read_cycles(void) {
+#if defined(__riscv)
+    uint64_t cycles;
+    asm volatile ("rdcycle %0" : "=r" (cycles));
+    return cycles;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+#error "read_cycles: no cycle counter for this target"
+#endif
+}
+
+// float_to_fixed88() with clamping instead of exit(1)
+static uint16_t ref_fixed88(float value, int* clamped) {
+    float x = value * 256.0f;
+    if (!(x > -32769.0f)) {
+        (*clamped)++;
+        return 0x8000;
+    }
+    if (x >= 32768.0f) {
+        (*clamped)++;
+        return 0x7fff;
+    }
+    return (uint16_t)((int32_t)x & 0xFFFF);
+}
+
+// The three passes convFSM_test.c did: copy, zero, convert and OR
+static int ref_pack(const float* img, int h, int w, int row, int col, int rows, int cols, uint64_t* packed) {
+    float tile[MAX_WINDOW * MAX_WINDOW];
+    int clamped = 0;
+
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int y = row + r, x = col + c;
+            tile[r * cols + c] = y >= 0 && y < h && x >= 0 && x < w ? img[y * w + x] : 0.0f;
+        }
+    }
+    for (int i = 0; i < (rows * cols + 3) / 4; i++) {
+        packed[i] = 0;
+    }
+    for (int i = 0; i < rows * cols; i++) {
+        packed[i / 4] |= (uint64_t)ref_fixed88(tile[i], &clamped) << (16 * (i % 4));
+    }
+    return clamped;
+}
+
+static int check_isa(int isa) {
+    static const float special[] = { 127.99f, 128.0f, -128.0f, -128.004f, -128.01f, 1e9f, -1e9f,
+                                     INFINITY, -INFINITY, NAN, 0.00390625f, -0.00390625f, -0.001f };
+    float img[37 * 29];
+    float back[MAX_WINDOW * MAX_WINDOW];
+    uint64_t got[OURCONV_PACKED_WORDS(MAX_WINDOW, MAX_WINDOW)], ref[OURCONV_PACKED_WORDS(MAX_WINDOW, MAX_WINDOW)];
+    int16_t q[37 * 29], qback[MAX_WINDOW * MAX_WINDOW];
+    int bad = 0;
+
+    conv_set_isa(isa);
+    for (int i = 0; i < 37 * 29; i++) {
+        img[i] = (float)(rand() % 80000 - 40000) / 256.0f;
+        q[i] = (int16_t)(rand() % 65536 - 32768);
+    }
+    for (unsigned i = 0; i < sizeof(special) / sizeof(special[0]); i++) {
+        img[i * 31] = special[i];
+    }
+
+    for (int trial = 0; trial < 2000; trial++) {
+        int rows = 1 + rand() % MAX_WINDOW;
+        int cols = 1 + rand() % MAX_WINDOW;
+        int row = rand() % (37 + 2 * MAX_WINDOW) - MAX_WINDOW;
+        int col = rand() % (29 + 2 * MAX_WINDOW) - MAX_WINDOW;
+        int words = OURCONV_PACKED_WORDS(rows, cols);
+
+        memset(got, 0xAB, sizeof(got));
+        int c_got = ourconv_pack_f32(img, 37, 29, 29, row, col, rows, cols, got);
+        int c_ref = ref_pack(img, 37, 29, row, col, rows, cols, ref);
+        if (c_got != c_ref || memcmp(got, ref, sizeof(uint64_t) * words) != 0) {
+            if (bad++ < 3) {
+                printf("  %s f32 window %dx%d at (%d,%d): MISMATCH\n", conv_isa_name(isa), rows, cols, row, col);
+            }
+        }
+
+        // Q8.8 packing is the same without the conversion
+        float qf[37 * 29];
+        for (int i = 0; i < 37 * 29; i++) {
+            qf[i] = (float)q[i] / 256.0f;
+        }
+        ourconv_pack_q88(q, 37, 29, 29, row, col, rows, cols, got);
+        ref_pack(qf, 37, 29, row, col, rows, cols, ref);
+        if (memcmp(got, ref, sizeof(uint64_t) * words) != 0) {
+            if (bad++ < 3) {
+                printf("  %s q88 window %dx%d at (%d,%d): MISMATCH\n", conv_isa_name(isa), rows, cols, row, col);
+            }
+        }
+
+        // Unpack into a strided buffer and compare with the packed values
+        ourconv_unpack_f32(got, rows, cols, back, MAX_WINDOW);
+        ourconv_unpack_q88(got, rows, cols, qback, MAX_WINDOW);
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                int i = r * cols + c;
+                int16_t v = (int16_t)(got[i / 4] >> (16 * (i % 4)));
+                if (qback[r * MAX_WINDOW + c] != v || back[r * MAX_WINDOW + c] != (float)v / 256.0f) {
+                    if (bad++ < 3) {
+                        printf("  %s unpack %dx%d: MISMATCH at (%d,%d)\n", conv_isa_name(isa), rows, cols, r, c);
+                    }
+                }
+            }
+        }
+    }
+    return bad != 0;
+}
+
+static void bench(void) {
+    float* img = malloc(sizeof(float) * BENCH_H * BENCH_W);
+    uint64_t packed[OURCONV_PACKED_WORDS(MAX_WINDOW, MAX_WINDOW)];
+    uint64_t sink = 0;
+
+    for (int i = 0; i < BENCH_H * BENCH_W; i++) {
+        img[i] = (float)(i % 16);
+    }
+    printf("ksize,tiles,three_pass_cycles_per_tile,one_pass_cycles_per_tile,speedup\n");
+    for (int ksize = 1; ksize <= 5; ksize += 2) {
+        int in_tile = TILE + ksize - 1;
+        int tiles = (BENCH_H / TILE) * (BENCH_W / TILE);
+        uint64_t t[3];
+
+        t[0] = read_cycles();
+        for (int i = 0; i < BENCH_H; i += TILE) {
+            for (int j = 0; j < BENCH_W; j += TILE) {
+                ref_pack(img, BENCH_H, BENCH_W, i - ksize / 2, j - ksize / 2, in_tile, in_tile, packed);
+                sink += packed[0];
+            }
+        }
+        t[1] = read_cycles();
+        for (int i = 0; i < BENCH_H; i += TILE) {
+            for (int j = 0; j < BENCH_W; j += TILE) {
+                ourconv_pack_f32(img, BENCH_H, BENCH_W, BENCH_W, i - ksize / 2, j - ksize / 2, in_tile, in_tile, packed);
+                sink += packed[0];
+            }
+        }
+        t[2] = read_cycles();
+        printf("%d,%d,%llu,%llu,%.2f\n", ksize, tiles, (unsigned long long)((t[1] - t[0]) / tiles),
+               (unsigned long long)((t[2] - t[1]) / tiles), (double)(t[1] - t[0]) / (double)(t[2] - t[1]));
+    }
+    if (sink == 42) {
+        printf("\n");
+    }
+    free(img);
+}
+
+int main() {
+    int bad = 0;
+
+    for (int isa = CONV_ISA_SCALAR; isa <= CONV_ISA_RVV; isa++) {
+        if (conv_set_isa(isa) == isa) {
+            int b = check_isa(isa);
+            printf("pack/unpack %s: %s\n", conv_isa_name(isa), b ? "MISMATCH" : "match");
+            bad |= b;
+        }
+    }
+    // Benchmark on the best ISA again
+    for (int isa = CONV_ISA_RVV; isa > CONV_ISA_SCALAR && conv_set_isa(isa) != isa; isa--) {
+    }
+    printf("benchmark ISA: %s\n", conv_isa_name(conv_isa()));
+    bench();
+    return bad;
+}
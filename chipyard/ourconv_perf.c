@@ -0,0 +1,69 @@
+#include <string.h>
+#include "ourconv_perf.h"
+#include "ourconv_model.h"
+
+uint64_t ourconv_cycles_load(const ourconv_timing* t, unsigned words) {
+    // accept, sReadXReq until the last response, sLoadXDone
+    return 1 + (uint64_t)words * t->req_interval + t->mem_latency + 1;
+}
+
+uint64_t ourconv_cycles_compute(const ourconv_timing* t, unsigned pixels) {
+    // accept, sSetup, issue every pixel, drain the pipeline
+    return 2 + (uint64_t)pixels * t->cycles_per_pixel + t->pipeline_depth;
+}
+
+uint64_t ourconv_cycles_writeback(const ourconv_timing* t, unsigned words) {
+    // sWriteReq, sWaitWriteResp for the last tag, sDone
+    return (uint64_t)words * t->req_interval + t->mem_latency + 1;
+}
+
+// doCompute write-back words over all tiles: ragged edge tiles write only
+// their valid outputs
+static uint64_t output_words(int h, int w) {
+    uint64_t count_y[2] = { (uint64_t)(h / OURCONV_N), h % OURCONV_N != 0 };
+    uint64_t count_x[2] = { (uint64_t)(w / OURCONV_N), w % OURCONV_N != 0 };
+    unsigned rows[2] = { OURCONV_N, (unsigned)(h % OURCONV_N) };
+    unsigned cols[2] = { OURCONV_N, (unsigned)(w % OURCONV_N) };
+    uint64_t words = 0;
+
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            words += count_y[i] * count_x[j] * ((rows[i] * cols[j] + 3) / 4);
+        }
+    }
+    return words;
+}
+
+int ourconv_perf_estimate(const ourconv_timing* t, int h, int w, int ksize, ourconv_perf* perf) {
+    if (h < 1 || w < 1 || (ksize != 1 && ksize != 3 && ksize != 5)) {
+        return -1;
+    }
+    memset(perf, 0, sizeof(*perf));
+
+    unsigned kernel_words = (unsigned)(ksize * ksize + 3) / 4;
+    unsigned in_tile = OURCONV_N + ksize - 1;
+    unsigned input_words = (in_tile * in_tile + 3) / 4;
+    uint64_t tiles = (uint64_t)((h + OURCONV_N - 1) / OURCONV_N) * ((w + OURCONV_N - 1) / OURCONV_N);
+    uint64_t out_words = output_words(h, w);
+
+    perf->tiles = tiles;
+    perf->commands = 1 + 2 * tiles;
+    perf->cycles[OURCONV_PHASE_KERNEL] = ourconv_cycles_load(t, kernel_words);
+    perf->cycles[OURCONV_PHASE_INPUT] = tiles * ourconv_cycles_load(t, input_words) + t->cold_penalty;
+    // Both are linear in their pixel/word count
+    perf->cycles[OURCONV_PHASE_COMPUTE] = tiles * ourconv_cycles_compute(t, 0) +
+                                          (uint64_t)h * w * t->cycles_per_pixel;
+    perf->cycles[OURCONV_PHASE_WRITEBACK] = tiles * ourconv_cycles_writeback(t, 0) + out_words * t->req_interval;
+    perf->cycles[OURCONV_PHASE_COMMAND] = perf->commands * t->cmd_overhead;
+    perf->mem_words = kernel_words + tiles * input_words + out_words;
+
+    for (int p = 0; p < OURCONV_PHASES; p++) {
+        perf->total += perf->cycles[p];
+    }
+    return 0;
+}
+
+const char* ourconv_phase_name(int phase) {
+    static const char* names[OURCONV_PHASES] = { "kernel load", "input load", "compute", "write-back", "command" };
+    return phase >= 0 && phase < OURCONV_PHASES ? names[phase] : "?";
+}
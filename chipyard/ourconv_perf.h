@@ -0,0 +1,70 @@
+#ifndef OURCONV_PERF_H
+#define OURCONV_PERF_H
+
+// Cycle-approximate timing of the OurCONV FSM (OurCONV.scala).
+//
+// Every command costs a fixed RoCC round trip (issue, command queue, rd
+// write-back, as seen by the rdcycle pair around it) plus the cycles the FSM
+// spends in its own states:
+//
+//   load (kernel/input)  accept + one io.mem request per 64-bit word
+//                        (4 values) + response latency + sLoad*Done
+//   compute              accept + sSetup + one output pixel issued per
+//                        cycle in sCompute + draining the multiply,
+//                        adder tree (adderStages registers), acc_buffer
+//                        and clamp stages
+//   write-back           one io.mem write per word in sWriteReq + waiting
+//                        for the last response + sDone
+//
+// The defaults are calibrated against the rdcycle numbers of
+// convFSM_test.c in "Results Logs/3x3Kernel_tilebytileOutput.txt": a 3x3
+// input tile (100 values, 25 words) takes 107 cycles, 139 for the first
+// one after reset.
+
+#include <stdint.h>
+
+enum ourconv_phase {
+    OURCONV_PHASE_KERNEL,    // kernel load FSM states
+    OURCONV_PHASE_INPUT,     // input load FSM states
+    OURCONV_PHASE_COMPUTE,   // sSetup .. sDrain
+    OURCONV_PHASE_WRITEBACK, // sWriteReq .. sDone
+    OURCONV_PHASE_COMMAND,   // RoCC round trip of every command
+    OURCONV_PHASES
+};
+
+typedef struct {
+    unsigned cmd_overhead;  // cycles per command outside the accelerator FSM
+    unsigned req_interval;  // cycles between io.mem requests (1 = every cycle)
+    unsigned mem_latency;   // io.mem request to response, L1 hit
+    unsigned cycles_per_pixel;
+    unsigned cold_penalty;  // extra cycles on the first input load after reset
+    unsigned pipeline_depth; // compute stages after issue, 3 + adderStages
+} ourconv_timing;
+
+#define OURCONV_TIMING_DEFAULT { 78, 1, 2, 1, 32, 5 }
+// The earlier FSM that walked sLoadFrame, sAcc1, sAcc2 and writeResult for
+// every pixel, for comparison
+#define OURCONV_TIMING_SEQUENTIAL { 78, 1, 2, 4, 32, 0 }
+
+// FSM cycles of one command, without cmd_overhead.
+uint64_t ourconv_cycles_load(const ourconv_timing* t, unsigned words);
+uint64_t ourconv_cycles_compute(const ourconv_timing* t, unsigned pixels);
+uint64_t ourconv_cycles_writeback(const ourconv_timing* t, unsigned words);
+
+typedef struct {
+    uint64_t cycles[OURCONV_PHASES];
+    uint64_t total;
+    uint64_t commands;
+    uint64_t tiles;
+    uint64_t mem_words; // 64-bit words read + written by the accelerator
+} ourconv_perf;
+
+// Predicted cycles for an h x w "same" convolution with a 1x1, 3x3 or 5x5
+// kernel, driven like convFSM_test.c: one kernel load, then doLoadInput +
+// doCompute per 8x8 output tile, ragged ones computing only their valid
+// outputs. Returns -1 for unsupported sizes.
+int ourconv_perf_estimate(const ourconv_timing* t, int h, int w, int ksize, ourconv_perf* perf);
+
+const char* ourconv_phase_name(int phase);
+
+#endif
@@ -0,0 +1,124 @@
+// Build: gcc -O2 -I.. -o ourconv_perf_test ourconv_perf_test.c ourconv_perf.c ourconv_model.c ../conv_tiles.c ../conv.c ../conv_simd.c
+//
+// Usage: ourconv_perf_test [height width ksize [clock_mhz]]
+//
+// Checks the timing model against the logged rdcycle numbers and against
+// the cycle counters of the software model, then prints a per-phase cycle
+// breakdown for 32x32 and 1080p frames (or the given size).
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv_tiles.h"
+#include "ourconv_model.h"
+#include "ourconv_perf.h"
+
+#define DEFAULT_CLOCK_MHZ 1000
+
+static uint64_t command_cycles(const ourconv_model* m, int phase, const uint64_t* before) {
+    return m->cycles[phase] - before[phase] + m->cycles[OURCONV_PHASE_COMMAND] - before[OURCONV_PHASE_COMMAND];
+}
+
+// "Results Logs/3x3Kernel_tilebytileOutput.txt": rdcycle around each 3x3
+// doLoadInput reads 139 cycles for the first tile and 107 afterwards.
+static int check_calibration(void) {
+    uint64_t kernel[3] = { 0 }, input[25] = { 0 }, before[OURCONV_PHASES];
+    ourconv_model m;
+    int bad = 0;
+
+    ourconv_model_init(&m);
+    ourconv_load_kernel(&m, kernel, 1);
+    for (int i = 0; i < 2; i++) {
+        uint64_t expect = i == 0 ? 139 : 107;
+        memcpy(before, m.cycles, sizeof(before));
+        ourconv_load_input(&m, input);
+        uint64_t got = command_cycles(&m, OURCONV_PHASE_INPUT, before);
+        if (got != expect) {
+            printf("  input load %d: %llu cycles, log says %llu\n", i, (unsigned long long)got,
+                   (unsigned long long)expect);
+            bad = 1;
+        }
+    }
+    printf("calibration vs RTL log: %s\n", bad ? "MISMATCH" : "match");
+    return bad;
+}
+
+// The closed-form estimate must agree with the model driven tile by tile.
+static int check_model(int h, int w, int ksize) {
+    static uint64_t kernel[7], input[36], out[OURCONV_OUTPUT_WORDS];
+    ourconv_model m;
+    ourconv_perf perf;
+    conv_tiling t;
+    conv_tile tile;
+
+    ourconv_model_init(&m);
+    ourconv_perf_estimate(&m.timing, h, w, ksize, &perf);
+    conv_tiling_init(&t, h, w, ksize, OURCONV_N);
+    ourconv_load_kernel(&m, kernel, ksize / 2);
+    for (int idx = 0; idx < conv_tiling_count(&t); idx++) {
+        conv_tile_at(&t, idx, &tile);
+        ourconv_load_input(&m, input);
+        ourconv_compute(&m, out, OURCONV_COMPUTE_RS2(tile.type, tile.out_rows, tile.out_cols));
+    }
+
+    int bad = memcmp(m.cycles, perf.cycles, sizeof(perf.cycles)) != 0 ||
+              m.mem_reads + m.mem_writes != perf.mem_words;
+    if (bad) {
+        printf("  %dx%d k%d: model %llu cycles, estimate %llu\n", h, w, ksize,
+               (unsigned long long)ourconv_model_cycles(&m), (unsigned long long)perf.total);
+    }
+    return bad;
+}
+
+static void report(int h, int w, int ksize, double mhz) {
+    static const ourconv_timing timing = OURCONV_TIMING_DEFAULT;
+    ourconv_perf perf;
+
+    if (ourconv_perf_estimate(&timing, h, w, ksize, &perf) != 0) {
+        printf("%dx%d k%d: unsupported\n", h, w, ksize);
+        return;
+    }
+    printf("%dx%d %dx%d kernel: %llu tiles, %llu commands, %llu cycles (%.1f cycles/pixel, %.2f fps at %.0f MHz)\n",
+           h, w, ksize, ksize, (unsigned long long)perf.tiles, (unsigned long long)perf.commands,
+           (unsigned long long)perf.total, (double)perf.total / ((double)h * w),
+           mhz * 1e6 / (double)perf.total, mhz);
+    for (int p = 0; p < OURCONV_PHASES; p++) {
+        printf("  %-12s %12llu cycles %5.1f%%\n", ourconv_phase_name(p), (unsigned long long)perf.cycles[p],
+               100.0 * (double)perf.cycles[p] / (double)perf.total);
+    }
+}
+
+// Pipelined datapath vs the one-pixel-per-four-cycles FSM it replaced
+static void report_pipeline(void) {
+    static const ourconv_timing piped = OURCONV_TIMING_DEFAULT;
+    static const ourconv_timing sequential = OURCONV_TIMING_SEQUENTIAL;
+    uint64_t p = ourconv_cycles_compute(&piped, OURCONV_N * OURCONV_N);
+    uint64_t s = ourconv_cycles_compute(&sequential, OURCONV_N * OURCONV_N);
+
+    printf("compute per 8x8 tile: %llu cycles pipelined, %llu sequential (%.2fx)\n",
+           (unsigned long long)p, (unsigned long long)s, (double)s / (double)p);
+}
+
+int main(int argc, char** argv) {
+    int bad = check_calibration();
+
+    int model_bad = 0;
+    for (int ksize = 1; ksize <= 5; ksize += 2) {
+        model_bad |= check_model(32, 32, ksize);
+        model_bad |= check_model(40, 24, ksize);
+        model_bad |= check_model(37, 21, ksize);
+    }
+    printf("estimate vs model counters: %s\n", model_bad ? "MISMATCH" : "match");
+    bad |= model_bad;
+    report_pipeline();
+
+    if (argc >= 4) {
+        report(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]), argc >= 5 ? atof(argv[4]) : DEFAULT_CLOCK_MHZ);
+    } else {
+        report(32, 32, 3, DEFAULT_CLOCK_MHZ);
+        for (int ksize = 1; ksize <= 5; ksize += 2) {
+            report(1080, 1920, ksize, DEFAULT_CLOCK_MHZ);
+        }
+    }
+    return bad;
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ourconv_stream.h"
+#include "ourconv_cmd.h"
+
+static int16_t* ring_row(const ourconv_stream* s, int slot) {
+    return s->ring + (size_t)slot * s->pitch;
+}
+
+int ourconv_stream_init(ourconv_stream* s, ourconv_dev* dev, int w, const int16_t* k, int ksize, int mode) {
+    memset(s, 0, sizeof(*s));
+    if (!dev || !k || w <= 0 || (ksize != 1 && ksize != 3 && ksize != 5)) {
+        return CONV_EINVAL;
+    }
+    s->dev = dev;
+    s->w = w;
+    s->ksize = ksize;
+    s->mode = mode;
+    s->ring_rows = OURCONV_N + ksize - 1;
+    s->pitch = (size_t)w + ksize - 1;
+    memcpy(s->k, k, sizeof(int16_t) * ksize * ksize);
+    s->ring = malloc(sizeof(int16_t) * 2 * s->ring_rows * s->pitch);
+    if (!s->ring) {
+        return CONV_ENOMEM;
+    }
+    ourconv_stream_reset(s);
+    return CONV_OK;
+}
+
+void ourconv_stream_free(ourconv_stream* s) {
+    free(s->ring);
+    s->ring = NULL;
+}
+
+void ourconv_stream_reset(ourconv_stream* s) {
+    memset(s->ring, 0, sizeof(int16_t) * 2 * s->ring_rows * s->pitch);
+    memset(&s->stats, 0, sizeof(s->stats));
+    s->rows_in = 0;
+    s->rows_out = 0;
+    s->filled = s->ksize / 2;
+    s->flushing = 0;
+}
+
+// Appends a row (NULL: a zero row) to both of its ring slots
+static void ring_push(ourconv_stream* s, const int16_t* row) {
+    int slot = s->filled % s->ring_rows;
+
+    for (int copy = 0; copy < 2; copy++) {
+        int16_t* dst = ring_row(s, slot + copy * s->ring_rows) + s->ksize / 2;
+        if (row) {
+            memcpy(dst, row, sizeof(int16_t) * s->w);
+        } else {
+            memset(dst, 0, sizeof(int16_t) * s->w);
+        }
+    }
+    host_work(s->dev, (unsigned)s->w);
+    s->filled++;
+}
+
+// The next n output rows: one tile row over the n + ksize - 1 ring rows
+// that start with the first one's window
+static int run_strip(ourconv_stream* s, int n, int16_t* out) {
+    conv2d_params valid = { 1, 0, 1 };
+    ourconv_batch_stats pass;
+    int first = s->rows_out % s->ring_rows;
+
+    if (ourconv_conv2d_q88_ex(s->dev, ring_row(s, first), n + s->ksize - 1, (int)s->pitch, s->k, s->ksize,
+                              &valid, out, s->mode, &pass) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+    s->stats.cycles += pass.cycles;
+    s->stats.tiles += pass.tiles;
+    s->stats.overflow |= pass.overflow;
+    s->rows_out += n;
+    return n;
+}
+
+int ourconv_stream_push(ourconv_stream* s, const int16_t* row, int16_t* out) {
+    if (!s || !row || !out || s->flushing) {
+        return CONV_EINVAL;
+    }
+    s->rows_in++;
+    ring_push(s, row);
+    if (s->filled - s->rows_out < s->ring_rows) {
+        return 0;
+    }
+    return run_strip(s, OURCONV_N, out);
+}
+
+int ourconv_stream_flush(ourconv_stream* s, int16_t* out) {
+    if (!s || !out) {
+        return CONV_EINVAL;
+    }
+    s->flushing = 1;
+    int n = s->rows_in - s->rows_out;
+    if (n <= 0) {
+        return 0;
+    }
+    n = n < OURCONV_N ? n : OURCONV_N;
+    // Zero rows below the frame until the strip's window is complete
+    while (s->filled < s->rows_out + n + s->ksize - 1) {
+        ring_push(s, NULL);
+    }
+    return run_strip(s, n, out);
+}
@@ -0,0 +1,49 @@
+#ifndef OURCONV_STREAM_H
+#define OURCONV_STREAM_H
+
+// Row-strip streaming on OurCONV, the accelerator side of conv_stream.h.
+//
+// The accelerator computes 8x8 output tiles, so rows are buffered until a
+// strip of OURCONV_N output rows has its OURCONV_N + ksize - 1 input rows.
+// The strip then runs as one tile row: a convolution without padding over
+// that window of the ring (ourconv_conv2d_q88_ex()), whose rows carry
+// ksize / 2 zero columns on either side as in conv_stream.c. Output row r
+// comes out with its strip, at most OURCONV_N - 1 + ksize / 2 rows after
+// input row r, and the stream holds 2 * (OURCONV_N + ksize - 1)
+// rows of w + ksize - 1 values. The result is bit-identical to
+// ourconv_conv2d_q88() on the whole frame. The windows are zero-filled by
+// the packer and OURCONV_SLIDE is ignored, as for strided convolutions.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ourconv_driver.h"
+
+typedef struct {
+    ourconv_dev* dev;
+    int w, ksize, mode;
+    int rows_in;    // frame rows pushed
+    int rows_out;   // output rows emitted
+    int filled;     // ring rows written, the top zero rows included
+    int flushing;
+    int ring_rows;  // OURCONV_N + ksize - 1
+    size_t pitch;   // w + ksize - 1
+    int16_t* ring;  // 2 * ring_rows rows
+    int16_t k[25];
+    ourconv_batch_stats stats; // every strip of the frame
+} ourconv_stream;
+
+// ksize 1, 3 or 5. Returns CONV_OK, CONV_EINVAL or CONV_ENOMEM.
+int ourconv_stream_init(ourconv_stream* s, ourconv_dev* dev, int w, const int16_t* k, int ksize, int mode);
+void ourconv_stream_free(ourconv_stream* s);
+void ourconv_stream_reset(ourconv_stream* s);
+
+// Pushes one input row. When that completes a strip its OURCONV_N rows go
+// to out (room for OURCONV_N rows of w) and the count is returned; 0
+// otherwise, or CONV_EINVAL.
+int ourconv_stream_push(ourconv_stream* s, const int16_t* row, int16_t* out);
+
+// Ends the frame: each call writes the next strip of the remaining rows to
+// out and returns its row count, then 0.
+int ourconv_stream_flush(ourconv_stream* s, int16_t* out);
+
+#endif
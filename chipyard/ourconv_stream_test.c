@@ -0,0 +1,144 @@
+// Build (host, software model):
+//   gcc -O2 -DOURCONV_MODEL -I.. -o ourconv_stream_test ourconv_stream_test.c ourconv_stream.c ourconv_driver.c ourconv_pack.c ourconv_model.c ourconv_perf.c ../conv_tiles.c ../conv.c ../conv_simd.c
+// On the RoCC target drop -DOURCONV_MODEL and add -I../test for rocc.h.
+//
+// Streams random frames row by row through OurCONV and compares them with
+// conv2d_q88() bit for bit, also for frames shorter than a strip, and
+// checks when each strip comes out and that a reset stream starts clean.
+// Then prints the ring size and cycles against ourconv_conv2d_q88() on the
+// whole frame.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "ourconv_stream.h"
+
+// One frame through s, every strip into out in order. Returns the push
+// that produced the first strip (1-based, 0 if only the flush did), or -1.
+static int stream_frame(ourconv_stream* s, const int16_t* in, int h, int16_t* out) {
+    int first = 0, r;
+
+    for (int i = 0; i < h; i++) {
+        r = ourconv_stream_push(s, in + (size_t)i * s->w, out + (size_t)s->rows_out * s->w);
+        if (r < 0) {
+            return -1;
+        }
+        if (r && !first) {
+            first = i + 1;
+        }
+    }
+    do {
+        r = ourconv_stream_flush(s, out + (size_t)s->rows_out * s->w);
+    } while (r > 0);
+    return r < 0 || s->rows_out != h ? -1 : first;
+}
+
+static int check(int h, int w, int ksize, int mode) {
+    size_t plane = (size_t)h * w;
+    int16_t* in = malloc(sizeof(int16_t) * plane);
+    int16_t* ref = malloc(sizeof(int16_t) * plane);
+    // Room for a whole strip past the last row
+    int16_t* got = malloc(sizeof(int16_t) * (plane + OURCONV_N * (size_t)w));
+    uint8_t* overflow = malloc(plane);
+    int16_t k[25];
+    ourconv_stream s;
+    ourconv_dev dev;
+    int pad = ksize / 2, bad = 0;
+
+    for (size_t i = 0; i < plane; i++) {
+        in[i] = (int16_t)(rand() % 2049 - 1024);
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (int16_t)(rand() % 513 - 256);
+    }
+    conv2d_q88(in, h, w, k, ksize, ref, overflow);
+
+    ourconv_dev_init(&dev);
+    if (ourconv_stream_init(&s, &dev, w, k, ksize, mode) != CONV_OK) {
+        printf("MISMATCH init %dx%d, %dx%d\n", h, w, ksize, ksize);
+        return 1;
+    }
+    for (int frame = 0; frame < 2; frame++) {
+        memset(got, 0, sizeof(int16_t) * plane);
+        int first = stream_frame(&s, in, h, got);
+        int expect = h >= OURCONV_N + pad ? OURCONV_N + pad : 0;
+        if (first != expect || memcmp(ref, got, sizeof(int16_t) * plane) != 0) {
+            printf("MISMATCH %dx%d, %dx%d, mode %d, frame %d\n", h, w, ksize, ksize, mode, frame);
+            bad = 1;
+        }
+        ourconv_stream_reset(&s);
+    }
+    if (ourconv_stream_flush(&s, got) != 0 || ourconv_stream_push(&s, in, got) != CONV_EINVAL) {
+        bad = 1;
+    }
+    if (!bad) {
+        printf("%dx%d, %dx%d, mode %d: match\n", h, w, ksize, ksize, mode);
+    }
+    ourconv_stream_free(&s);
+    free(in);
+    free(ref);
+    free(got);
+    free(overflow);
+    return bad;
+}
+
+// Ring size and cycles of a streamed frame against the whole-frame path
+static void report(int h, int w, int ksize) {
+    int16_t* in = malloc(sizeof(int16_t) * h * w);
+    int16_t* out = malloc(sizeof(int16_t) * (h + OURCONV_N) * w);
+    int16_t k[25];
+    uint64_t frame, stream;
+    ourconv_stream s;
+    ourconv_dev dev;
+
+    for (int i = 0; i < h * w; i++) {
+        in[i] = (int16_t)(i % 251 - 125);
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (int16_t)(256 / (ksize * ksize));
+    }
+    ourconv_dev_init(&dev);
+    ourconv_conv2d_q88(&dev, in, h, w, k, ksize, out, OURCONV_PIPELINED, NULL);
+    frame = ourconv_dev_cycles(&dev);
+    // Ring copies included
+    ourconv_dev_init(&dev);
+    ourconv_stream_init(&s, &dev, w, k, ksize, OURCONV_PIPELINED);
+    stream_frame(&s, in, h, out);
+    stream = ourconv_dev_cycles(&dev);
+    printf("%dx%d, %dx%d: frame %.1f KB, %llu cycles; stream %.1f KB, %llu cycles, latency %d rows\n",
+           h, w, ksize, ksize, 4.0 * h * w / 1e3, (unsigned long long)frame,
+           (2.0 * s.ring_rows * s.pitch + OURCONV_N * w) * sizeof(int16_t) / 1e3,
+           (unsigned long long)stream, OURCONV_N + ksize / 2 - 1);
+    ourconv_stream_free(&s);
+    free(in);
+    free(out);
+}
+
+int main() {
+    static const int shapes[][2] = { { 1, 1 }, { 3, 9 }, { 8, 8 }, { 10, 17 }, { 37, 33 }, { 64, 61 } };
+    static const int modes[] = { OURCONV_SERIAL, OURCONV_PIPELINED };
+    int failures = 0;
+
+    for (unsigned i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        for (int ksize = 1; ksize <= 5; ksize += 2) {
+            for (int m = 0; m < 2; m++) {
+                failures += check(shapes[i][0], shapes[i][1], ksize, modes[m]);
+            }
+        }
+    }
+
+    ourconv_stream bad;
+    ourconv_dev dev;
+    int16_t k[49] = { 0 };
+    ourconv_dev_init(&dev);
+    if (ourconv_stream_init(&bad, &dev, 16, k, 7, OURCONV_PIPELINED) != CONV_EINVAL ||
+        ourconv_stream_init(&bad, &dev, 0, k, 3, OURCONV_PIPELINED) != CONV_EINVAL) {
+        printf("MISMATCH argument checks\n");
+        failures++;
+    }
+
+    report(256, 256, 3);
+    report(256, 256, 5);
+    return failures ? 1 : 0;
+}
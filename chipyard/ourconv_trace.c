@@ -0,0 +1,122 @@
+#include <string.h>
+#include "ourconv_trace.h"
+
+static const char* phase_names[OURCONV_TRACE_PHASES] = {
+    "convert", "kernel_pack", "kernel_load", "tile_pack", "load_input",
+    "compute", "unpack", "partials", "accelerator"
+};
+
+const char* ourconv_trace_phase_name(int phase) {
+    return phase >= 0 && phase < OURCONV_TRACE_PHASES ? phase_names[phase] : "?";
+}
+
+static void clear_stats(ourconv_trace_stats* s, int n) {
+    memset(s, 0, sizeof(*s) * (size_t)n);
+    for (int i = 0; i < n; i++) {
+        s[i].min = UINT64_MAX;
+    }
+}
+
+void ourconv_trace_init(ourconv_trace* t, ourconv_trace_event* events, uint32_t capacity) {
+    memset(t, 0, sizeof(*t));
+    clear_stats(t->frame, OURCONV_TRACE_PHASES);
+    clear_stats(t->total, OURCONV_TRACE_PHASES);
+    t->events = events;
+    t->capacity = events ? capacity : 0;
+}
+
+void ourconv_trace_frame_begin(ourconv_trace* t, uint64_t now) {
+    clear_stats(t->frame, OURCONV_TRACE_PHASES);
+    t->frame_start = now;
+}
+
+void ourconv_trace_frame_end(ourconv_trace* t, uint64_t now) {
+    t->frame_cycles = now - t->frame_start;
+    t->total_cycles += t->frame_cycles;
+    t->frames++;
+    for (int p = 0; p < OURCONV_TRACE_PHASES; p++) {
+        const ourconv_trace_stats* f = &t->frame[p];
+        ourconv_trace_stats* s = &t->total[p];
+
+        s->calls += f->calls;
+        s->cycles += f->cycles;
+        s->min = f->min < s->min ? f->min : s->min;
+        s->max = f->max > s->max ? f->max : s->max;
+        for (int b = 0; b < OURCONV_TRACE_BUCKETS; b++) {
+            s->hist[b] += f->hist[b];
+        }
+    }
+}
+
+static int bucket(uint64_t cycles) {
+    int b = cycles ? 64 - __builtin_clzll(cycles) : 0;
+    return b < OURCONV_TRACE_BUCKETS ? b : OURCONV_TRACE_BUCKETS - 1;
+}
+
+void ourconv_trace_span(ourconv_trace* t, int phase, uint64_t start, uint64_t end) {
+    uint64_t cycles = end > start ? end - start : 0;
+    ourconv_trace_stats* s = &t->frame[phase];
+
+    s->calls++;
+    s->cycles += cycles;
+    s->min = cycles < s->min ? cycles : s->min;
+    s->max = cycles > s->max ? cycles : s->max;
+    s->hist[bucket(cycles)]++;
+
+    if (t->count < t->capacity) {
+        ourconv_trace_event* e = &t->events[t->count++];
+        e->start = start;
+        e->cycles = cycles;
+        e->frame = t->frames;
+        e->phase = (uint32_t)phase;
+    } else {
+        t->dropped++;
+    }
+}
+
+void ourconv_trace_report(const ourconv_trace* t, FILE* f) {
+    double frame = t->frame_cycles ? (double)t->frame_cycles : 1.0;
+
+    fprintf(f, "frame %u: %llu cycles\n", (unsigned)(t->frames ? t->frames - 1 : 0),
+            (unsigned long long)t->frame_cycles);
+    fprintf(f, "%-12s %8s %12s %7s %10s %10s %10s  histogram\n",
+            "phase", "calls", "cycles", "share", "mean", "min", "max");
+    for (int p = 0; p < OURCONV_TRACE_PHASES; p++) {
+        const ourconv_trace_stats* s = &t->frame[p];
+
+        if (!s->calls) {
+            continue;
+        }
+        fprintf(f, "%-12s %8llu %12llu %6.1f%% %10llu %10llu %10llu ", phase_names[p],
+                (unsigned long long)s->calls, (unsigned long long)s->cycles, 100.0 * (double)s->cycles / frame,
+                (unsigned long long)(s->cycles / s->calls), (unsigned long long)s->min,
+                (unsigned long long)s->max);
+        for (int b = 0; b < OURCONV_TRACE_BUCKETS; b++) {
+            if (s->hist[b]) {
+                fprintf(f, " %llu:%llu", b ? 1ull << (b - 1) : 0ull, (unsigned long long)s->hist[b]);
+            }
+        }
+        fprintf(f, "\n");
+    }
+    if (t->dropped) {
+        fprintf(f, "%llu spans not logged, event buffer full\n", (unsigned long long)t->dropped);
+    }
+}
+
+int ourconv_trace_write_chrome(const ourconv_trace* t, FILE* f, double cycles_per_us) {
+    double scale = cycles_per_us > 0.0 ? 1.0 / cycles_per_us : 1.0;
+
+    fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    fprintf(f, "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"core\"}},\n");
+    fprintf(f, "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": {\"name\": \"OurCONV\"}}");
+    for (uint32_t i = 0; i < t->count; i++) {
+        const ourconv_trace_event* e = &t->events[i];
+
+        fprintf(f, ",\n  {\"name\": \"%s\", \"cat\": \"ourconv\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                   "\"pid\": 1, \"tid\": %d, \"args\": {\"frame\": %u}}",
+                phase_names[e->phase], (double)e->start * scale, (double)e->cycles * scale,
+                e->phase == OURCONV_TRACE_ACCELERATOR ? 2 : 1, (unsigned)e->frame);
+    }
+    fprintf(f, "\n]}\n");
+    return ferror(f) ? -1 : 0;
+}
@@ -0,0 +1,96 @@
+#ifndef OURCONV_TRACE_H
+#define OURCONV_TRACE_H
+
+// Per-phase instrumentation of the accelerator hot path.
+//
+// Built with -DOURCONV_TRACE, the driver times every phase of a frame with
+// ourconv_dev_cycles() (rdcycle on the core, the virtual clock under
+// -DOURCONV_MODEL) and hands the spans to the ourconv_trace attached to
+// dev->trace. Without the flag the hooks compile to nothing, so release
+// builds pay nothing, and dev->trace is ignored; with it and no trace
+// attached each hook is one branch. The field itself is always there, so
+// objects built with and without the flag agree on ourconv_dev.
+//
+// A trace aggregates the spans of the current frame per phase: calls,
+// cycles, min/max and a log2 histogram of span lengths, and the same over
+// all frames. ourconv_trace_report() prints the breakdown of the last
+// frame. If the caller gives it an event buffer every span is also logged,
+// and ourconv_trace_write_chrome() exports them as Chrome trace-event JSON
+// (chrome://tracing, Perfetto): the core on one track, and under the model
+// the accelerator's busy time on a second one, so the overlap of the
+// pipelined mode is visible. Spans past the buffer are counted, not logged.
+//
+// In the pipelined mode load_input and compute only cover issuing the
+// command and blocking on its rd, the accelerator work itself overlaps the
+// packing and unpacking; phase shares then sum to less than 100%, and the
+// accelerator track can push them above it.
+
+#include <stdint.h>
+#include <stdio.h>
+
+enum ourconv_trace_phase {
+    OURCONV_TRACE_CONVERT,     // float to Q8.8, recorded by the caller
+    OURCONV_TRACE_KERNEL_PACK, // kernel quantization and packing
+    OURCONV_TRACE_KERNEL_LOAD, // doLoadKernel round trip
+    OURCONV_TRACE_TILE_PACK,   // tile window extraction and packing
+    OURCONV_TRACE_LOAD_INPUT,  // doLoadInput / doSlideInput issue and waits
+    OURCONV_TRACE_COMPUTE,     // doCompute issue and waits
+    OURCONV_TRACE_UNPACK,      // output unpack and overflow scatter
+    OURCONV_TRACE_PARTIALS,    // large kernels: shifted windows and partial sums
+    OURCONV_TRACE_ACCELERATOR, // accelerator FSM busy (model only)
+    OURCONV_TRACE_PHASES
+};
+
+// Bucket 0 counts empty spans, bucket b spans of 2^(b-1) .. 2^b - 1
+// cycles; the last one everything longer.
+#define OURCONV_TRACE_BUCKETS 32
+
+typedef struct {
+    uint64_t calls;
+    uint64_t cycles;
+    uint64_t min, max;
+    uint64_t hist[OURCONV_TRACE_BUCKETS];
+} ourconv_trace_stats;
+
+typedef struct {
+    uint64_t start;
+    uint64_t cycles;
+    uint32_t frame;
+    uint32_t phase;
+} ourconv_trace_event;
+
+typedef struct {
+    ourconv_trace_stats frame[OURCONV_TRACE_PHASES]; // current or last frame
+    ourconv_trace_stats total[OURCONV_TRACE_PHASES]; // every finished frame
+    uint64_t frame_start;
+    uint64_t frame_cycles; // length of the last finished frame
+    uint64_t total_cycles;
+    uint32_t frames;       // finished frames
+    ourconv_trace_event* events; // may be NULL
+    uint32_t capacity;
+    uint32_t count;
+    uint64_t dropped;      // spans that did not fit in events
+} ourconv_trace;
+
+// events (capacity entries) may be NULL for counters and histograms only.
+void ourconv_trace_init(ourconv_trace* t, ourconv_trace_event* events, uint32_t capacity);
+
+// Frame boundaries, in the clock the spans use. Begin clears the frame
+// counters, end adds them to the totals.
+void ourconv_trace_frame_begin(ourconv_trace* t, uint64_t now);
+void ourconv_trace_frame_end(ourconv_trace* t, uint64_t now);
+
+void ourconv_trace_span(ourconv_trace* t, int phase, uint64_t start, uint64_t end);
+
+// Table of the last frame: per phase calls, cycles, share of the frame,
+// mean, min, max and the non-empty histogram buckets as "shortest:count".
+void ourconv_trace_report(const ourconv_trace* t, FILE* f);
+
+// Logged events as a Chrome trace-event JSON object. Timestamps are in
+// microseconds: cycles / cycles_per_us (1 shows cycles as microseconds).
+// Returns 0, or -1 if the stream reports an error.
+int ourconv_trace_write_chrome(const ourconv_trace* t, FILE* f, double cycles_per_us);
+
+const char* ourconv_trace_phase_name(int phase);
+
+#endif
@@ -0,0 +1,168 @@
+// Build (host, software model):
+//   gcc -O2 -DOURCONV_MODEL -DOURCONV_TRACE -I.. -o ourconv_trace_test ourconv_trace_test.c ourconv_trace.c ourconv_driver.c ourconv_pack.c ourconv_model.c ourconv_perf.c ../conv_tiles.c ../conv.c ../conv_simd.c
+// On the RoCC target drop -DOURCONV_MODEL and add -I../test for rocc.h.
+//
+// Checks that tracing leaves outputs and the virtual clock unchanged, that
+// the per-phase call counts follow the tiles and commands of a frame, that
+// in serial mode the core phases add up to the frame, and that the Chrome
+// export holds every logged span. Then prints the breakdown of a pipelined
+// 256x256 frame and writes its timeline to ourconv_trace.json.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "ourconv_driver.h"
+#include "ourconv_trace.h"
+
+#define MAX_EVENTS 8192
+
+static ourconv_trace_event events[MAX_EVENTS];
+
+// Runs one traced frame
+static int frame(ourconv_dev* dev, ourconv_trace* t, const int16_t* in, int size, const int16_t* k,
+                 int ksize, int16_t* out, int mode, ourconv_batch_stats* stats) {
+    dev->trace = t;
+    ourconv_trace_frame_begin(t, ourconv_dev_cycles(dev));
+    int err = ourconv_conv2d_q88(dev, in, size, size, k, ksize, out, mode, stats);
+    ourconv_trace_frame_end(t, ourconv_dev_cycles(dev));
+    dev->trace = NULL;
+    return err;
+}
+
+static uint64_t hist_sum(const ourconv_trace_stats* s) {
+    uint64_t n = 0;
+    for (int b = 0; b < OURCONV_TRACE_BUCKETS; b++) {
+        n += s->hist[b];
+    }
+    return n;
+}
+
+static int check(int size, int ksize, int mode) {
+    size_t plane = (size_t)size * size;
+    int16_t* in = malloc(sizeof(int16_t) * plane);
+    int16_t* ref = malloc(sizeof(int16_t) * plane);
+    int16_t* got = malloc(sizeof(int16_t) * plane);
+    int16_t k[25];
+    ourconv_dev plain, traced;
+    ourconv_batch_stats ref_stats, stats;
+    ourconv_trace t;
+    int bad = 0;
+
+    for (size_t i = 0; i < plane; i++) {
+        in[i] = (int16_t)(rand() % 8193 - 4096);
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (int16_t)(rand() % 257 - 128);
+    }
+    ourconv_dev_init(&plain);
+    ourconv_dev_init(&traced);
+    ourconv_trace_init(&t, events, MAX_EVENTS);
+
+    ourconv_conv2d_q88(&plain, in, size, size, k, ksize, ref, mode, &ref_stats);
+    frame(&traced, &t, in, size, k, ksize, got, mode, &stats);
+    if (memcmp(ref, got, sizeof(int16_t) * plane) != 0 || stats.cycles != ref_stats.cycles) {
+        printf("MISMATCH traced output or cycles, %dx%d, %dx%d, mode %d\n", size, size, ksize, ksize, mode);
+        bad = 1;
+    }
+
+    const ourconv_trace_stats* f = t.frame;
+    uint64_t tiles = stats.tiles, commands = 0, core = 0;
+    for (int c = 0; c < OURCONV_CMD_TYPES; c++) {
+        commands += traced.traffic.commands[c];
+    }
+    for (int p = 0; p < OURCONV_TRACE_PHASES; p++) {
+        if (hist_sum(&f[p]) != f[p].calls) {
+            printf("MISMATCH %s histogram\n", ourconv_trace_phase_name(p));
+            bad = 1;
+        }
+        core += p == OURCONV_TRACE_ACCELERATOR ? 0 : f[p].cycles;
+    }
+    if (f[OURCONV_TRACE_KERNEL_PACK].calls != 1 || f[OURCONV_TRACE_KERNEL_LOAD].calls != 1 ||
+        f[OURCONV_TRACE_TILE_PACK].calls != tiles || f[OURCONV_TRACE_UNPACK].calls != tiles ||
+        f[OURCONV_TRACE_ACCELERATOR].calls != commands ||
+        (!(mode & OURCONV_PIPELINED) && (f[OURCONV_TRACE_LOAD_INPUT].calls != tiles ||
+                                         f[OURCONV_TRACE_COMPUTE].calls != tiles || core != t.frame_cycles))) {
+        printf("MISMATCH phase counts, %dx%d, %dx%d, mode %d\n", size, size, ksize, ksize, mode);
+        bad = 1;
+    }
+
+    // A second frame finds the kernel in its slot
+    frame(&traced, &t, in, size, k, ksize, got, mode, &stats);
+    uint64_t spans_total = 0;
+    for (int p = 0; p < OURCONV_TRACE_PHASES; p++) {
+        spans_total += t.total[p].calls;
+    }
+    if (t.frames != 2 || t.frame[OURCONV_TRACE_KERNEL_LOAD].calls != 0 ||
+        t.total[OURCONV_TRACE_TILE_PACK].calls != 2 * tiles || t.count + t.dropped != spans_total) {
+        printf("MISMATCH second frame, %dx%d, %dx%d, mode %d\n", size, size, ksize, ksize, mode);
+        bad = 1;
+    }
+
+    // Every logged span is one complete event, plus the two track names
+    FILE* json = tmpfile();
+    char line[256];
+    uint32_t spans = 0;
+    ourconv_trace_write_chrome(&t, json, 1.0);
+    rewind(json);
+    while (fgets(line, sizeof(line), json)) {
+        spans += strstr(line, "\"ph\": \"X\"") != NULL;
+    }
+    fclose(json);
+    if (spans != t.count) {
+        printf("MISMATCH chrome events %u of %u\n", (unsigned)spans, (unsigned)t.count);
+        bad = 1;
+    }
+    if (!bad) {
+        printf("%dx%d, %dx%d, mode %d: match (%u spans, %llu dropped)\n", size, size, ksize, ksize, mode,
+               (unsigned)t.count, (unsigned long long)t.dropped);
+    }
+    free(in);
+    free(ref);
+    free(got);
+    return bad;
+}
+
+static void report(void) {
+    enum { SIZE = 256 };
+    int16_t* in = malloc(sizeof(int16_t) * SIZE * SIZE);
+    int16_t* out = malloc(sizeof(int16_t) * SIZE * SIZE);
+    int16_t k[25];
+    ourconv_dev dev;
+    ourconv_trace t;
+
+    for (int i = 0; i < SIZE * SIZE; i++) {
+        in[i] = (int16_t)((i * 7) % 23 * 64);
+    }
+    for (int i = 0; i < 25; i++) {
+        k[i] = (int16_t)(i % 11 - 5);
+    }
+    ourconv_dev_init(&dev);
+    ourconv_trace_init(&t, events, MAX_EVENTS);
+    frame(&dev, &t, in, SIZE, k, 5, out, OURCONV_PIPELINED | OURCONV_SLIDE, NULL);
+    printf("\npipelined + sliding, %dx%d, 5x5:\n", SIZE, SIZE);
+    ourconv_trace_report(&t, stdout);
+
+    FILE* json = fopen("ourconv_trace.json", "w");
+    if (json) {
+        ourconv_trace_write_chrome(&t, json, 1.0);
+        fclose(json);
+        printf("timeline: ourconv_trace.json\n");
+    }
+    free(in);
+    free(out);
+}
+
+int main(void) {
+    static const int modes[] = { OURCONV_SERIAL, OURCONV_SERIAL | OURCONV_SLIDE,
+                                 OURCONV_PIPELINED, OURCONV_PIPELINED | OURCONV_SLIDE };
+    int failures = 0;
+
+    for (int m = 0; m < 4; m++) {
+        failures += check(37, 3, modes[m]);
+        failures += check(64, 5, modes[m]);
+    }
+    failures += check(300, 1, OURCONV_PIPELINED); // more spans than the buffer
+    report();
+    return failures ? 1 : 0;
+}
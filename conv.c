@@ -1,285 +1,422 @@
-#include <stdio.h>
-
-#define N3 3
-#define N5 5
-#define N8 8
-#define N10 10
-#define N12 12
-
-
-#define K5 5
-#define K3 3
-
-void conv33(float input[N3][N3], float kernel[K3][K3], float output[N3][N3]) {
-    int pad = K3 / 2;
-
-    for (int i = 0; i < N3; i++) {
-        for (int j = 0; j < N3; j++) {
-            float sum = 0.0;
-            for (int m = 0; m < K3; m++) {
-                for (int n = 0; n < K3; n++) {
-                    int x = i + m - pad;
-                    int y = j + n - pad;
-                    if (x >= 0 && x < N3 && y >= 0 && y < N3) {
-                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
-                        sum += kernel[m][n] * input[x][y];
-                    }
-                }
-            }
-            output[i][j] = sum;
-            //printf("Sum = %f\n", sum);
+#include <stddef.h>
+#include "conv.h"
+#include "conv_simd.h"
+
+// Output pixels computed together by the interior fast paths. The compiler
+// turns each block into vector multiply/adds; every pixel still sums its taps
+// in the same (m, n) order as the scalar loop, so results do not change.
+#define CONV_BLOCK 8
+
+// Forces the kernel-size specialisations below to be compiled separately with
+// a constant K so their tap loops fully unroll.
+#define CONV_INLINE static inline __attribute__((always_inline))
+
+// OurCONV MAC: 16x16-bit product, floored to 8 fractional bits (arithmetic
+// shift, as gcc implements >> on negative values)
+#define Q88_MAC(kv, x) (((int32_t)(kv) * (int32_t)(x)) >> 8)
+
+static int selected_isa = -1;
+
+int conv_isa(void) {
+    if (selected_isa < 0) {
+        unsigned isas = conv_simd_supported();
+        if (isas & (1u << CONV_ISA_AVX2)) {
+            selected_isa = CONV_ISA_AVX2;
+        } else if (isas & (1u << CONV_ISA_SSE)) {
+            selected_isa = CONV_ISA_SSE;
+        } else if (isas & (1u << CONV_ISA_RVV)) {
+            selected_isa = CONV_ISA_RVV;
+        } else {
+            selected_isa = CONV_ISA_SCALAR;
         }
     }
+    return selected_isa;
 }
 
-void conv83(float input[N8][N8], float kernel[K3][K3], float output[N8][N8]) {
-    int pad = K3 / 2;
-
-    for (int i = 0; i < N8; i++) {
-        for (int j = 0; j < N8; j++) {
-            float sum = 0.0;
-            for (int m = 0; m < K3; m++) {
-                for (int n = 0; n < K3; n++) {
-                    int x = i + m - pad;
-                    int y = j + n - pad;
-                    if (x >= 0 && x < N8 && y >= 0 && y < N8) {
-                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
-                        sum += kernel[m][n] * input[x][y];
-                    }
-                }
-            }
-            output[i][j] = sum;
-            //printf("Sum = %f\n", sum);
+int conv_set_isa(int isa) {
+    if (isa < 0 || isa > CONV_ISA_RVV || !(conv_simd_supported() & (1u << isa))) {
+        isa = CONV_ISA_SCALAR;
+    }
+    selected_isa = isa;
+    return isa;
+}
+
+const char* conv_isa_name(int isa) {
+    switch (isa) {
+    case CONV_ISA_SSE:
+        return "sse4.1";
+    case CONV_ISA_AVX2:
+        return "avx2";
+    case CONV_ISA_RVV:
+        return "rvv";
+    default:
+        return "scalar";
+    }
+}
+
+int conv2d_out_size(int n, int ksize, int stride, int pad) {
+    if (n <= 0 || ksize <= 0 || stride <= 0 || pad < 0) {
+        return 0;
+    }
+    int span = n + 2 * pad - ksize;
+    if (span < 0) {
+        return 0;
+    }
+    return span / stride + 1;
+}
+
+// Geometry of a call: dilation 0 means 1, as in a params struct written
+// before the field existed; ext is the dilated kernel extent.
+typedef struct {
+    int stride, pad, dil, ext, oh, ow;
+} conv2d_geom;
+
+static int conv2d_geometry(int h, int w, int ksize, const conv2d_params* params, conv2d_geom* g) {
+    g->stride = params ? params->stride : 1;
+    g->pad = params ? params->pad : ksize / 2;
+    g->dil = params && params->dilation ? params->dilation : 1;
+    if (ksize <= 0 || g->dil < 0) {
+        return CONV_EINVAL;
+    }
+    g->ext = (ksize - 1) * g->dil + 1;
+    g->oh = conv2d_out_size(h, g->ext, g->stride, g->pad);
+    g->ow = conv2d_out_size(w, g->ext, g->stride, g->pad);
+    return g->oh > 0 && g->ow > 0 ? CONV_OK : CONV_EINVAL;
+}
+
+// First and one-past-last tap m along one axis with r + m * dil inside [0, n)
+static inline void conv2d_taps(int n, int ksize, int dil, int r, int* m0, int* m1) {
+    *m0 = r < 0 ? (-r + dil - 1) / dil : 0;
+    *m1 = r + (ksize - 1) * dil >= n ? (n - r + dil - 1) / dil : ksize;
+}
+
+// One output pixel near the border; (r, c) is the input position of the
+// top-left tap and may lie in the padding. The in-image tap range is clipped
+// once up front instead of testing every tap.
+static float conv2d_pixel(const float* in, int h, int w, const float* k, int ksize, int dil, int r, int c) {
+    int m0, m1, n0, n1;
+    float sum = 0.0f;
+
+    conv2d_taps(h, ksize, dil, r, &m0, &m1);
+    conv2d_taps(w, ksize, dil, c, &n0, &n1);
+    for (int m = m0; m < m1; m++) {
+        const float* row = in + (size_t)(r + m * dil) * w + c;
+        for (int n = n0; n < n1; n++) {
+            sum += k[m * ksize + n] * row[n * dil];
         }
     }
+    return sum;
 }
 
-void conv103(float input[N10][N10], float kernel[K3][K3], float output[N10][N10]) {
-    int pad = K3 / 2;
-
-    for (int i = 0; i < N10; i++) {
-        for (int j = 0; j < N10; j++) {
-            float sum = 0.0;
-            for (int m = 0; m < K3; m++) {
-                for (int n = 0; n < K3; n++) {
-                    int x = i + m - pad;
-                    int y = j + n - pad;
-                    if (x >= 0 && x < N10 && y >= 0 && y < N10) {
-                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
-                        sum += kernel[m][n] * input[x][y];
+// Range [*lo, *hi] of output indices along one axis whose whole window lies
+// inside the input. Empty when *lo > *hi. ext is the dilated kernel extent.
+static void conv2d_interior(int n, int on, int ext, int stride, int pad, int* lo, int* hi) {
+    int last = n - ext + pad; // largest i * stride with the window still inside
+
+    *lo = (pad + stride - 1) / stride;
+    *hi = last < 0 ? -1 : last / stride;
+    if (*hi > on - 1) {
+        *hi = on - 1;
+    }
+}
+
+// Interior rows i0..i1, cols j0..j1: no bounds checks needed. Taps are dil
+// pixels apart; only outputs on the stride grid are visited.
+CONV_INLINE void conv2d_rows_k(const float* in, int w, const float* k, const int K,
+                               int stride, int pad, int dil, float* out, int ow,
+                               int i0, int i1, int j0, int j1) {
+    for (int i = i0; i <= i1; i++) {
+        const float* base = in + (size_t)(i * stride - pad) * w - pad;
+        float* o = out + (size_t)i * ow;
+        int j = j0;
+
+        if (stride == 1) {
+            for (; j + CONV_BLOCK - 1 <= j1; j += CONV_BLOCK) {
+                float acc[CONV_BLOCK] = {0};
+                for (int m = 0; m < K; m++) {
+                    const float* row = base + (size_t)m * dil * w + j;
+                    for (int n = 0; n < K; n++) {
+                        float kv = k[m * K + n];
+                        for (int t = 0; t < CONV_BLOCK; t++) {
+                            acc[t] += kv * row[n * dil + t];
+                        }
                     }
                 }
+                for (int t = 0; t < CONV_BLOCK; t++) {
+                    o[j + t] = acc[t];
+                }
             }
-            output[i][j] = sum;
-            //printf("Sum = %f\n", sum);
         }
-    }
-}
 
-void conv55(float input[N5][N5], float kernel[K5][K5], float output[N5][N5]) {
-    int pad = K5 / 2;
-
-    for (int i = 0; i < N5; i++) {
-        for (int j = 0; j < N5; j++) {
-            float sum = 0.0;
-            for (int m = 0; m < K5; m++) {
-                for (int n = 0; n < K5; n++) {
-                    int x = i + m - pad;
-                    int y = j + n - pad;
-                    if (x >= 0 && x < N5 && y >= 0 && y < N5) {
-                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
-                        sum += kernel[m][n] * input[x][y];
-                    }
+        for (; j <= j1; j++) {
+            const float* win = base + (size_t)j * stride;
+            float sum = 0.0f;
+            for (int m = 0; m < K; m++) {
+                for (int n = 0; n < K; n++) {
+                    sum += k[m * K + n] * win[(size_t)m * dil * w + n * dil];
                 }
             }
-            output[i][j] = sum;
-            //printf("Sum = %f\n", sum);
+            o[j] = sum;
         }
     }
 }
 
-void conv85(float input[N8][N8], float kernel[K5][K5], float output[N8][N8]) {
-    int pad = K5 / 2;
-
-    for (int i = 0; i < N8; i++) {
-        for (int j = 0; j < N8; j++) {
-            float sum = 0.0;
-            for (int m = 0; m < K5; m++) {
-                for (int n = 0; n < K5; n++) {
-                    int x = i + m - pad;
-                    int y = j + n - pad;
-                    if (x >= 0 && x < N8 && y >= 0 && y < N8) {
-                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
-                        sum += kernel[m][n] * input[x][y];
-                    }
-                }
+static void conv2d_rows_k1(const float* in, int w, const float* k, int stride, int pad,
+                           float* out, int ow, int i0, int i1, int j0, int j1) {
+    conv2d_rows_k(in, w, k, 1, stride, pad, 1, out, ow, i0, i1, j0, j1);
+}
+
+static void conv2d_rows_k3(const float* in, int w, const float* k, int stride, int pad,
+                           float* out, int ow, int i0, int i1, int j0, int j1) {
+    conv2d_rows_k(in, w, k, 3, stride, pad, 1, out, ow, i0, i1, j0, j1);
+}
+
+static void conv2d_rows_k5(const float* in, int w, const float* k, int stride, int pad,
+                           float* out, int ow, int i0, int i1, int j0, int j1) {
+    conv2d_rows_k(in, w, k, 5, stride, pad, 1, out, ow, i0, i1, j0, j1);
+}
+
+int conv2d_region(const float* in, int h, int w, const float* k, int ksize,
+                  const conv2d_params* params, float* out,
+                  int r0, int r1, int c0, int c1) {
+    conv2d_geom g;
+
+    if (!in || !k || !out || conv2d_geometry(h, w, ksize, params, &g) != CONV_OK ||
+        r0 < 0 || r1 > g.oh || r0 > r1 || c0 < 0 || c1 > g.ow || c0 > c1) {
+        return CONV_EINVAL;
+    }
+    int stride = g.stride, pad = g.pad, dil = g.dil, ow = g.ow;
+
+    // Interior rectangle clipped to the requested region
+    int i_lo, i_hi, j_lo, j_hi;
+    conv2d_interior(h, g.oh, g.ext, stride, pad, &i_lo, &i_hi);
+    conv2d_interior(w, ow, g.ext, stride, pad, &j_lo, &j_hi);
+    i_lo = i_lo > r0 ? i_lo : r0;
+    i_hi = i_hi < r1 - 1 ? i_hi : r1 - 1;
+    j_lo = j_lo > c0 ? j_lo : c0;
+    j_hi = j_hi < c1 - 1 ? j_hi : c1 - 1;
+
+    // Border: everything outside the interior rectangle. Like the edge tile
+    // types of the accelerator, only these pixels need zero-padding logic.
+    for (int i = r0; i < r1; i++) {
+        int inner_row = (i >= i_lo && i <= i_hi && j_lo <= j_hi);
+        for (int j = c0; j < c1; j++) {
+            if (inner_row && j == j_lo) {
+                j = j_hi; // skip the interior span of this row
+                continue;
             }
-            output[i][j] = sum;
-            //printf("Sum = %f\n", sum);
+            out[(size_t)i * ow + j] = conv2d_pixel(in, h, w, k, ksize, dil, i * stride - pad, j * stride - pad);
         }
     }
-}
 
-void conv125(float input[N12][N12], float kernel[K5][K5], float output[N12][N12]) {
-    int pad = K5 / 2;
-
-    for (int i = 0; i < N12; i++) {
-        for (int j = 0; j < N12; j++) {
-            float sum = 0.0;
-            for (int m = 0; m < K5; m++) {
-                for (int n = 0; n < K5; n++) {
-                    int x = i + m - pad;
-                    int y = j + n - pad;
-                    if (x >= 0 && x < N12 && y >= 0 && y < N12) {
-                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
-                        sum += kernel[m][n] * input[x][y];
-                    }
-                }
+    if (i_lo > i_hi || j_lo > j_hi) {
+        return CONV_OK;
+    }
+
+    // Vector path first; the scalar code finishes whatever columns are left
+    if (stride == 1 && dil == 1) {
+        conv_rows_f32_fn vec = conv_simd_rows_f32(conv_isa(), ksize);
+        if (vec) {
+            j_lo += vec(in, w, k, pad, out, ow, i_lo, i_hi, j_lo, j_hi);
+            if (j_lo > j_hi) {
+                return CONV_OK;
             }
-            output[i][j] = sum;
-            //printf("Sum = %f\n", sum);
         }
     }
+
+    switch (dil == 1 ? ksize : 0) {
+    case 1:
+        conv2d_rows_k1(in, w, k, stride, pad, out, ow, i_lo, i_hi, j_lo, j_hi);
+        break;
+    case 3:
+        conv2d_rows_k3(in, w, k, stride, pad, out, ow, i_lo, i_hi, j_lo, j_hi);
+        break;
+    case 5:
+        conv2d_rows_k5(in, w, k, stride, pad, out, ow, i_lo, i_hi, j_lo, j_hi);
+        break;
+    default:
+        conv2d_rows_k(in, w, k, ksize, stride, pad, dil, out, ow, i_lo, i_hi, j_lo, j_hi);
+        break;
+    }
+    return CONV_OK;
 }
 
-int main() {
-    // Input 3x3 matrix
-    float input3[N3][N3] = {
-        {1, 2, 3},
-        {4, 5, 6},
-        {7, 8, 9}
-    };
-
-    float input5[N5][N5] = {
-        {1, 2, 3, 4, 5},
-        {1, 2, 3, 4, 5},
-        {1, 2, 3, 4, 5},
-        {1, 2, 3, 4, 5},
-        {1, 2, 3, 4, 5}
-    };
-
-    float input8[N8][N8] = {
-        {1, 2, 3, 4, 5, 6, 7, 8},
-        {1, 2, 3, 4, 5, 6, 7, 8},
-        {1, 2, 3, 4, 5, 6, 7, 8},
-        {1, 2, 3, 4, 5, 6, 7, 8},
-        {1, 2, 3, 4, 5, 6, 7, 8},
-        {1, 2, 3, 4, 5, 6, 7, 8},
-        {1, 2, 3, 4, 5, 6, 7, 8},
-        {1, 2, 3, 4, 5, 6, 7, 8}
-    };
-
-    float input10[N10][N10] = {
-        {0,0,0,0,0,0,0,0,0,0},
-        {0,0,0,0,0,0,0,0,0,0},
-        {0,0,1,2,3,4,5,6,7,8},
-        {0,0,1,2,3,4,5,6,7,8},
-        {0,0,1,2,3,4,5,6,7,8},
-        {0,0,1,2,3,4,5,6,7,8},
-        {0,0,1,2,3,4,5,6,7,8},
-        {0,0,1,2,3,4,5,6,7,8},
-        {0,0,1,2,3,4,5,6,7,8},
-        {0,0,1,2,3,4,5,6,7,8}
-    };
-
-    float input12[N12][N12] = {
-        {0,0,0,0,0,0,0,0,0,0,0,0},
-        {0,0,0,0,0,0,0,0,0,0,0,0},
-        {0,0,0,0,0,0,0,0,0,0,0,0},
-        {0,0,0,0,0,0,0,0,0,0,0,0},
-        {0,0,0,0,1,2,3,4,5,6,7,8},
-        {0,0,0,0,1,2,3,4,5,6,7,8},
-        {0,0,0,0,1,2,3,4,5,6,7,8},
-        {0,0,0,0,1,2,3,4,5,6,7,8},
-        {0,0,0,0,1,2,3,4,5,6,7,8},
-        {0,0,0,0,1,2,3,4,5,6,7,8},
-        {0,0,0,0,1,2,3,4,5,6,7,8},
-        {0,0,0,0,1,2,3,4,5,6,7,8}
-    };
-    
-    // 3x3 kernel (e.g., simple edge detection kernel)
-    float kernel3[K3][K3] = {
-        {1, 2, 3},
-        {4, 5, 6},
-        {7, 8, 9}
-    };
-    
-    
-    float kernel5[K5][K5] = {
-        {1, 2, 3, 4, 5},
-        {6, 7, 8, 9, 10},
-        {11, 12, 13, 14, 15},
-        {16, 17, 18, 19, 20},
-        {21, 22, 23, 24, 25}
-    };
-    
-    
-
-    // Output 3x3 matrix
-    float output33[N3][N3];
-    float output83[N8][N8];
-    float output103[N10][N10];
-    float output55[N5][N5];
-    float output85[N8][N8];
-    float output125[N12][N12];
-
-    // Perform 2D convolution
-    conv33(input3, kernel3, output33);
-    conv83(input8, kernel3, output83);
-    conv103(input10, kernel3, output103);
-    conv55(input5, kernel5, output55);
-    conv85(input8, kernel5, output85);
-    conv125(input12, kernel5, output125);
-
-    // Print output matrix
-    printf("Output 33:\n");
-    for (int i = 0; i < N3; i++) {
-        for (int j = 0; j < N3; j++) {
-            printf("%6.0f ", output33[i][j]);
-        }
-        printf("\n");
+int conv2d_ex(const float* in, int h, int w, const float* k, int ksize,
+              const conv2d_params* params, float* out) {
+    conv2d_geom g;
+
+    if (conv2d_geometry(h, w, ksize, params, &g) != CONV_OK) {
+        return CONV_EINVAL;
     }
+    return conv2d_region(in, h, w, k, ksize, params, out, 0, g.oh, 0, g.ow);
+}
 
-    printf("Output 83:\n");
-    for (int i = 0; i < N8; i++) {
-        for (int j = 0; j < N8; j++) {
-            printf("%6.0f ", output83[i][j]);
-        }
-        printf("\n");
+int conv2d(const float* in, int h, int w, const float* k, int ksize, float* out) {
+    conv2d_params params = { 1, ksize / 2, 1 };
+
+    if (ksize % 2 == 0) {
+        return CONV_EINVAL;
     }
+    return conv2d_ex(in, h, w, k, ksize, &params, out);
+}
+
+// Clamp a 32-bit sum to Q8.8 like the OurCONV clamp stage, flagging saturation.
+static inline int16_t q88_clamp(int32_t acc, uint8_t* overflow, size_t idx) {
+    int16_t v = (int16_t)acc;
+    uint8_t ovf = 0;
 
-    printf("Output 103:\n");
-    for (int i = 0; i < N10; i++) {
-        for (int j = 0; j < N10; j++) {
-            printf("%6.0f ", output103[i][j]);
+    if (acc > 32767) {
+        v = 32767;
+        ovf = 1;
+    } else if (acc < -32768) {
+        v = -32768;
+        ovf = 1;
+    }
+    if (overflow) {
+        overflow[idx] = ovf;
+    }
+    return v;
+}
+
+static int32_t conv2d_q88_pixel(const int16_t* in, int h, int w, const int16_t* k, int ksize, int dil,
+                                int r, int c) {
+    int m0, m1, n0, n1;
+    int32_t acc = 0;
+
+    conv2d_taps(h, ksize, dil, r, &m0, &m1);
+    conv2d_taps(w, ksize, dil, c, &n0, &n1);
+    for (int m = m0; m < m1; m++) {
+        const int16_t* row = in + (size_t)(r + m * dil) * w + c;
+        for (int n = n0; n < n1; n++) {
+            acc += Q88_MAC(k[m * ksize + n], row[n * dil]);
         }
-        printf("\n");
     }
+    return acc;
+}
 
-    printf("Output 55:\n");
-    for (int i = 0; i < N5; i++) {
-        for (int j = 0; j < N5; j++) {
-            printf("%6.0f ", output55[i][j]);
+CONV_INLINE void conv2d_q88_rows_k(const int16_t* in, int w, const int16_t* k, const int K,
+                                   int stride, int pad, int dil, int16_t* out, uint8_t* overflow, int ow,
+                                   int i0, int i1, int j0, int j1) {
+    for (int i = i0; i <= i1; i++) {
+        const int16_t* base = in + (size_t)(i * stride - pad) * w - pad;
+        for (int j = j0; j <= j1; j++) {
+            const int16_t* win = base + (size_t)j * stride;
+            int32_t acc = 0;
+            for (int m = 0; m < K; m++) {
+                for (int n = 0; n < K; n++) {
+                    acc += Q88_MAC(k[m * K + n], win[(size_t)m * dil * w + n * dil]);
+                }
+            }
+            out[(size_t)i * ow + j] = q88_clamp(acc, overflow, (size_t)i * ow + j);
         }
-        printf("\n");
     }
+}
+
+static void conv2d_q88_rows_k3(const int16_t* in, int w, const int16_t* k, int stride, int pad,
+                               int16_t* out, uint8_t* overflow, int ow, int i0, int i1, int j0, int j1) {
+    conv2d_q88_rows_k(in, w, k, 3, stride, pad, 1, out, overflow, ow, i0, i1, j0, j1);
+}
+
+static void conv2d_q88_rows_k5(const int16_t* in, int w, const int16_t* k, int stride, int pad,
+                               int16_t* out, uint8_t* overflow, int ow, int i0, int i1, int j0, int j1) {
+    conv2d_q88_rows_k(in, w, k, 5, stride, pad, 1, out, overflow, ow, i0, i1, j0, j1);
+}
+
+int conv2d_q88_ex(const int16_t* in, int h, int w, const int16_t* k, int ksize,
+                  const conv2d_params* params, int16_t* out, uint8_t* overflow) {
+    conv2d_geom g;
+
+    if (!in || !k || !out || conv2d_geometry(h, w, ksize, params, &g) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+    int stride = g.stride, pad = g.pad, dil = g.dil, ow = g.ow;
+    int i_lo, i_hi, j_lo, j_hi;
+    conv2d_interior(h, g.oh, g.ext, stride, pad, &i_lo, &i_hi);
+    conv2d_interior(w, ow, g.ext, stride, pad, &j_lo, &j_hi);
 
-    printf("Output 85:\n");
-    for (int i = 0; i < N8; i++) {
-        for (int j = 0; j < N8; j++) {
-            printf("%6.0f ", output85[i][j]);
+    for (int i = 0; i < g.oh; i++) {
+        int inner_row = (i >= i_lo && i <= i_hi && j_lo <= j_hi);
+        for (int j = 0; j < ow; j++) {
+            if (inner_row && j == j_lo) {
+                j = j_hi;
+                continue;
+            }
+            int32_t acc = conv2d_q88_pixel(in, h, w, k, ksize, dil, i * stride - pad, j * stride - pad);
+            out[(size_t)i * ow + j] = q88_clamp(acc, overflow, (size_t)i * ow + j);
         }
-        printf("\n");
     }
 
-    printf("Output 125:\n");
-    for (int i = 0; i < N12; i++) {
-        for (int j = 0; j < N12; j++) {
-            printf("%6.0f ", output125[i][j]);
+    if (i_lo > i_hi || j_lo > j_hi) {
+        return CONV_OK;
+    }
+
+    if (stride == 1 && dil == 1) {
+        conv_rows_q88_fn vec = conv_simd_rows_q88(conv_isa(), ksize);
+        if (vec) {
+            j_lo += vec(in, w, k, pad, out, overflow, ow, i_lo, i_hi, j_lo, j_hi);
+            if (j_lo > j_hi) {
+                return CONV_OK;
+            }
         }
-        printf("\n");
     }
 
+    switch (dil == 1 ? ksize : 0) {
+    case 3:
+        conv2d_q88_rows_k3(in, w, k, stride, pad, out, overflow, ow, i_lo, i_hi, j_lo, j_hi);
+        break;
+    case 5:
+        conv2d_q88_rows_k5(in, w, k, stride, pad, out, overflow, ow, i_lo, i_hi, j_lo, j_hi);
+        break;
+    default:
+        conv2d_q88_rows_k(in, w, k, ksize, stride, pad, dil, out, overflow, ow, i_lo, i_hi, j_lo, j_hi);
+        break;
+    }
+    return CONV_OK;
+}
+
+int conv2d_q88(const int16_t* in, int h, int w, const int16_t* k, int ksize,
+               int16_t* out, uint8_t* overflow) {
+    conv2d_params params = { 1, ksize / 2, 1 };
+
+    if (ksize % 2 == 0) {
+        return CONV_EINVAL;
+    }
+    return conv2d_q88_ex(in, h, w, k, ksize, &params, out, overflow);
+}
 
-    return 0;
-}
\ No newline at end of file
+// float_to_fixed88(): (int32_t)(value * 256.0f), in range iff the scaled
+// value lies in (-32769, 32768). NaN fails both compares and clamps low,
+// the same as the vector paths' max/min.
+static inline int16_t q88_from_f32(float v, int* clamped) {
+    float x = v * 256.0f;
+
+    if (!(x > -32769.0f)) {
+        (*clamped)++;
+        return -32768;
+    }
+    if (x >= 32768.0f) {
+        (*clamped)++;
+        return 32767;
+    }
+    return (int16_t)(int32_t)x;
+}
+
+int conv_f32_to_q88(const float* src, int n, int16_t* dst) {
+    conv_cvt_f32_q88_fn vec = conv_simd_cvt_f32_q88(conv_isa());
+    int clamped = 0;
+    int i = vec ? vec(src, n, dst, &clamped) : 0;
+
+    for (; i < n; i++) {
+        dst[i] = q88_from_f32(src[i], &clamped);
+    }
+    return clamped;
+}
+
+void conv_q88_to_f32(const int16_t* src, int n, float* dst) {
+    conv_cvt_q88_f32_fn vec = conv_simd_cvt_q88_f32(conv_isa());
+    int i = vec ? vec(src, n, dst) : 0;
+
+    for (; i < n; i++) {
+        dst[i] = (float)src[i] / 256.0f;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef CONV_H
+#define CONV_H
+
+// Host-side reference convolution library.
+//
+// Images and kernels are row-major float (or Q8.8 int16) arrays. The kernel is applied as a
+// correlation (no flip), the same way the conv* reference functions and the
+// OurCONV accelerator do it, and out-of-image taps read as zero.
+
+#include <stdint.h>
+
+#define CONV_OK 0
+#define CONV_EINVAL -1 // bad dimensions, stride or padding
+#define CONV_ERANGE -2 // values outside the Q8.8 range were clamped
+#define CONV_ENOMEM -3
+#define CONV_EIO -4 // a file could not be opened, created or mapped (conv_file.h)
+
+typedef struct {
+    int stride; // output step in both directions, >= 1
+    int pad;    // zero padding on every side, >= 0
+    int dilation; // tap spacing, >= 1; 0 also means 1
+} conv2d_params;
+
+// Number of output rows/cols for an input dimension n. For a dilated kernel
+// pass its extent, (ksize - 1) * dilation + 1.
+int conv2d_out_size(int n, int ksize, int stride, int pad);
+
+// "Same" convolution: stride 1, pad ksize / 2, out is h x w. ksize must be
+// odd; an even one returns CONV_EINVAL.
+// Bit-identical to the old fixed-size conv33/conv83/.../conv325 functions.
+int conv2d(const float* in, int h, int w, const float* k, int ksize, float* out);
+
+// Convolution with explicit stride, padding and dilation. Only the outputs
+// on the stride grid are computed. out must hold
+// conv2d_out_size(h, ...) x conv2d_out_size(w, ...) floats.
+int conv2d_ex(const float* in, int h, int w, const float* k, int ksize,
+              const conv2d_params* params, float* out);
+
+// Same as conv2d_ex but only computes output rows [r0, r1) and columns
+// [c0, c1). out is still the whole output image; other pixels are untouched.
+// params may be NULL for the conv2d() defaults.
+int conv2d_region(const float* in, int h, int w, const float* k, int ksize,
+                  const conv2d_params* params, float* out,
+                  int r0, int r1, int c0, int c1);
+
+// Q8.8 fixed-point "same" convolution with the OurCONV datapath numerics:
+// each 16x16-bit product is truncated (floored) to 8 fractional bits, the
+// taps are summed in 32 bits and the sum is clamped to the int16 range like
+// the accelerator's clamp stage. overflow (may be NULL) gets 1 for every clamped pixel.
+int conv2d_q88(const int16_t* in, int h, int w, const int16_t* k, int ksize,
+               int16_t* out, uint8_t* overflow);
+
+// Q8.8 with explicit stride, padding and dilation; out and overflow are
+// conv2d_out_size(h, ...) x conv2d_out_size(w, ...), as for conv2d_ex.
+int conv2d_q88_ex(const int16_t* in, int h, int w, const int16_t* k, int ksize,
+                  const conv2d_params* params, int16_t* out, uint8_t* overflow);
+
+// Float <-> Q8.8 conversion. Truncates toward zero like float_to_fixed88()
+// in the OurCONV tests; values outside [-128, 128) (and NaN) are clamped to
+// the int16 range instead of aborting, and the number of clamped values is
+// returned.
+int conv_f32_to_q88(const float* src, int n, int16_t* dst);
+void conv_q88_to_f32(const int16_t* src, int n, float* dst);
+
+// Instruction set used by the fast paths. The best one the CPU
+// supports is picked on first use; conv_set_isa() can force a lower one.
+#define CONV_ISA_SCALAR 0
+#define CONV_ISA_SSE 1 // SSE4.1
+#define CONV_ISA_AVX2 2
+#define CONV_ISA_RVV 3
+
+int conv_isa(void);
+// Returns the ISA actually selected, which is `isa` if the CPU supports it
+// and CONV_ISA_SCALAR otherwise.
+int conv_set_isa(int isa);
+const char* conv_isa_name(int isa);
+
+#endif
@@ -1,4 +1,8 @@
-class ConvolutionFSM(val N: Int, val K: Int) extends Module {
+import CONV.AdderTree
+
+// adderStages: register levels in the K*K-term reduction of sAcc2, which then
+// waits that many cycles for the sum
+class ConvolutionFSM(val N: Int, val K: Int, val adderStages: Int = 2) extends Module {
     import chisel3.experimental.FixedPoint
 
     val pad = (K - 1) / 2
@@ -47,6 +51,11 @@ class ConvolutionFSM(val N: Int, val K: Int) extends Module {
     val lastOutputPixel = (inRow === (N - 1).U) && (inCol === (N - 1).U)
     val finishedAll = RegInit(false.B)
 
+    // Registered reduction of acc; acc holds still while sAcc2 waits for it
+    val treeStages = adderStages min log2Ceil(K * K)
+    val treeSum = AdderTree(acc.flatten, treeStages)
+    val treeWait = RegInit(0.U((log2Ceil(treeStages + 1) max 1).W))
+
     count := count + 1.U
 
     switch(state) {
@@ -190,6 +199,7 @@ class ConvolutionFSM(val N: Int, val K: Int) extends Module {
                     acc(i)(j) := acc(i)(j) + (a(i)(j) * b(i)(j))
                 }
             }
+            treeWait := 0.U
             state := sAcc2
 
             //printf(p"Cycle: $count, state: $state, a = $a, b = $b\n")
@@ -197,33 +207,35 @@ class ConvolutionFSM(val N: Int, val K: Int) extends Module {
 
         is(sAcc2) {
 
-            var sum = 0.F(32.W, 8.BP)
-            for (i <- 0 until K) {
-                for (j <- 0 until K) {
-                    sum = sum + acc(i)(j)
-                    acc(i)(j) := 0.F(32.W, 8.BP)
-                    a(i)(j) := 0.F(16.W, 8.BP)
-                    b(i)(j) := 0.F(16.W, 8.BP)
+            when(treeWait =/= treeStages.U) {
+                treeWait := treeWait + 1.U
+            }.otherwise {
+                for (i <- 0 until K) {
+                    for (j <- 0 until K) {
+                        acc(i)(j) := 0.F(32.W, 8.BP)
+                        a(i)(j) := 0.F(16.W, 8.BP)
+                        b(i)(j) := 0.F(16.W, 8.BP)
+                    }
                 }
-            }
-            acc_buffer := sum
-
-            // After full kernel scan, increment input pos
-            when(inCol === inColEnd) {
-                inCol := inColStart
-                when(inRow === inRowEnd) {
-                    // All pixels done: wait 1 cycle to commit final result
-                    finishedAll := true.B
-                }.otherwise  {
-                    inRow := inRow + 1.U
+                acc_buffer := treeSum
+
+                // After full kernel scan, increment input pos
+                when(inCol === inColEnd) {
+                    inCol := inColStart
+                    when(inRow === inRowEnd) {
+                        // All pixels done: wait 1 cycle to commit final result
+                        finishedAll := true.B
+                    }.otherwise  {
+                        inRow := inRow + 1.U
+                    }
+                }.otherwise {
+                    inCol := inCol + 1.U
                 }
-            }.otherwise {
-                inCol := inCol + 1.U
-            }
 
-            //printf(p"Cycle: $count, state: $state, acc = $acc\n")
+                //printf(p"Cycle: $count, state: $state, acc = $acc\n")
             
-            state := writeResult
+                state := writeResult
+            }
         }
 
         is(writeResult) {
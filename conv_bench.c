@@ -0,0 +1,103 @@
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "conv_bench.h"
+
+uint64_t conv_bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t conv_bench_cycles(void) {
+#if defined(__riscv)
+    uint64_t cycles;
+    asm volatile("rdcycle %0" : "=r"(cycles));
+    return cycles;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return conv_bench_ns();
+#endif
+}
+
+const char* conv_bench_clock_name(void) {
+#if defined(__riscv)
+    return "rdcycle";
+#elif defined(__x86_64__) || defined(__i386__)
+    return "rdtsc";
+#else
+    return "ns";
+#endif
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t rank(const uint64_t* sorted, int n, int pct) {
+    int idx = (pct * n + 99) / 100 - 1; // ceil(pct / 100 * n) - 1
+    return sorted[idx < 0 ? 0 : idx];
+}
+
+void conv_bench_stats_of(uint64_t* samples, int n, conv_bench_stats* st) {
+    qsort(samples, (size_t)n, sizeof(uint64_t), cmp_u64);
+    st->min = samples[0];
+    st->p10 = rank(samples, n, 10);
+    st->median = rank(samples, n, 50);
+    st->p90 = rank(samples, n, 90);
+    st->p99 = rank(samples, n, 99);
+    st->max = samples[n - 1];
+}
+
+void conv_bench_begin(conv_bench_out* out, FILE* f, int format) {
+    out->f = f;
+    out->format = format;
+    out->rows = 0;
+    if (format == CONV_BENCH_JSON) {
+        fprintf(f, "[\n");
+    } else {
+        fprintf(f, "path,clock,h,w,ksize,tile,threads,runs,median_cycles,p10_cycles,p90_cycles,p99_cycles,"
+                   "min_cycles,max_cycles,median_ns,macs_per_cycle,gmacs_per_s,bytes_per_pixel\n");
+    }
+}
+
+void conv_bench_row(conv_bench_out* out, conv_bench_case* c) {
+    conv_bench_stats cy, ns;
+    int runs = c->runs < 1 ? 1 : c->runs > CONV_BENCH_MAX_RUNS ? CONV_BENCH_MAX_RUNS : c->runs;
+
+    conv_bench_stats_of(c->cycles, runs, &cy);
+    conv_bench_stats_of(c->ns, runs, &ns);
+    double macs_per_cycle = cy.median ? c->macs / (double)cy.median : 0.0;
+    double gmacs = ns.median ? c->macs / (double)ns.median : 0.0;
+    double bytes_per_pixel = c->bytes / ((double)c->h * c->w);
+
+    if (out->format == CONV_BENCH_JSON) {
+        fprintf(out->f,
+                "%s  {\"path\": \"%s\", \"clock\": \"%s\", \"h\": %d, \"w\": %d, \"ksize\": %d, \"tile\": %d, "
+                "\"threads\": %d, \"runs\": %d, \"median_cycles\": %llu, \"p10_cycles\": %llu, "
+                "\"p90_cycles\": %llu, \"p99_cycles\": %llu, \"min_cycles\": %llu, \"max_cycles\": %llu, "
+                "\"median_ns\": %llu, \"macs_per_cycle\": %.4f, \"gmacs_per_s\": %.4f, \"bytes_per_pixel\": %.3f}",
+                out->rows ? ",\n" : "", c->path, c->clock, c->h, c->w, c->ksize, c->tile, c->threads, runs,
+                (unsigned long long)cy.median, (unsigned long long)cy.p10, (unsigned long long)cy.p90,
+                (unsigned long long)cy.p99, (unsigned long long)cy.min, (unsigned long long)cy.max,
+                (unsigned long long)ns.median, macs_per_cycle, gmacs, bytes_per_pixel);
+    } else {
+        fprintf(out->f, "%s,%s,%d,%d,%d,%d,%d,%d,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.4f,%.4f,%.3f\n",
+                c->path, c->clock, c->h, c->w, c->ksize, c->tile, c->threads, runs,
+                (unsigned long long)cy.median, (unsigned long long)cy.p10, (unsigned long long)cy.p90,
+                (unsigned long long)cy.p99, (unsigned long long)cy.min, (unsigned long long)cy.max,
+                (unsigned long long)ns.median, macs_per_cycle, gmacs, bytes_per_pixel);
+    }
+    out->rows++;
+    fflush(out->f);
+}
+
+void conv_bench_end(conv_bench_out* out) {
+    if (out->format == CONV_BENCH_JSON) {
+        fprintf(out->f, "%s]\n", out->rows ? "\n" : "");
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef CONV_BENCH_H
+#define CONV_BENCH_H
+
+// Counters, statistics and CSV/JSON rows for the convolution benchmarks.
+//
+// conv_bench_cycles() reads the cheapest counter the target has: rdcycle on
+// RISC-V, the TSC on x86 (constant-rate ticks, not core clocks), and
+// clock_gettime() nanoseconds elsewhere; conv_bench_clock_name() says which.
+// A case is timed `runs` times and reported as the median and percentiles
+// of its samples, MACs per cycle at the median and bytes moved per output
+// pixel, one CSV row or JSON object per case, so runs from different
+// releases can be diffed.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define CONV_BENCH_MAX_RUNS 64
+
+enum conv_bench_format {
+    CONV_BENCH_CSV = 0,
+    CONV_BENCH_JSON = 1
+};
+
+uint64_t conv_bench_cycles(void);
+uint64_t conv_bench_ns(void); // CLOCK_MONOTONIC
+const char* conv_bench_clock_name(void); // "rdcycle", "rdtsc" or "ns"
+
+typedef struct {
+    uint64_t min, p10, median, p90, p99, max;
+} conv_bench_stats;
+
+// Nearest-rank percentiles of n samples (n >= 1); samples is left sorted.
+void conv_bench_stats_of(uint64_t* samples, int n, conv_bench_stats* st);
+
+typedef struct {
+    const char* path;    // e.g. "cpu-ref", "cpu-avx2", "ourconv-pipelined"
+    const char* clock;   // what cycles[] counts: conv_bench_clock_name() or "model"
+    int h, w, ksize;
+    int tile;            // output tile edge, 0 if the path does not tile
+    int threads;
+    double macs;         // per run, nominally h * w * ksize^2
+    double bytes;        // moved per run, input + output + kernel at least
+    int runs;
+    uint64_t cycles[CONV_BENCH_MAX_RUNS];
+    uint64_t ns[CONV_BENCH_MAX_RUNS];
+} conv_bench_case;
+
+typedef struct {
+    FILE* f;
+    int format;
+    int rows;
+} conv_bench_out;
+
+void conv_bench_begin(conv_bench_out* out, FILE* f, int format);
+void conv_bench_row(conv_bench_out* out, conv_bench_case* c);
+void conv_bench_end(conv_bench_out* out);
+
+#endif
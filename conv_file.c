@@ -0,0 +1,663 @@
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "conv_file.h"
+#include "conv_stream.h"
+
+static int host_little(void) {
+    const uint16_t one = 1;
+    return *(const uint8_t*)&one;
+}
+
+static size_t sample_size(int sample) {
+    static const size_t size[] = { 1, 2, 2, 4 };
+    return size[sample];
+}
+
+// n-byte unsigned integer in the given byte order
+static uint64_t get_uint(const unsigned char* p, int n, int le) {
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++) {
+        v |= (uint64_t)p[le ? i : n - 1 - i] << (8 * i);
+    }
+    return v;
+}
+
+static void put_uint(unsigned char* p, int n, uint64_t v, int le) {
+    for (int i = 0; i < n; i++) {
+        p[le ? i : n - 1 - i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint16_t load16(const unsigned char* p, int swap) {
+    uint16_t v;
+    memcpy(&v, p, 2);
+    return swap ? (uint16_t)(v << 8 | v >> 8) : v;
+}
+
+static void store16(unsigned char* p, uint16_t v, int swap) {
+    v = swap ? (uint16_t)(v << 8 | v >> 8) : v;
+    memcpy(p, &v, 2);
+}
+
+static float load_f32(const unsigned char* p, int swap) {
+    uint32_t v;
+    float f;
+    memcpy(&v, p, 4);
+    v = swap ? __builtin_bswap32(v) : v;
+    memcpy(&f, &v, 4);
+    return f;
+}
+
+static void store_f32(unsigned char* p, float f, int swap) {
+    uint32_t v;
+    memcpy(&v, &f, 4);
+    v = swap ? __builtin_bswap32(v) : v;
+    memcpy(p, &v, 4);
+}
+
+// Sets up a layout of strips of rows_per_strip rows and checks that they
+// lie in the file
+static int set_strips(conv_file* f, int rows_per_strip, int strips) {
+    const conv_file_info* in = &f->info;
+
+    f->row_bytes = (size_t)in->w * sample_size(in->sample);
+    f->rows_per_strip = rows_per_strip;
+    f->strips = strips;
+    for (int i = 0; i < strips; i++) {
+        int rows = in->h - i * rows_per_strip < rows_per_strip ? in->h - i * rows_per_strip : rows_per_strip;
+        if (f->strip[i] > f->map_len || (f->map_len - f->strip[i]) / f->row_bytes < (uint64_t)rows) {
+            return CONV_EINVAL;
+        }
+    }
+    return CONV_OK;
+}
+
+static int valid_info(const conv_file_info* in) {
+    return in->h > 0 && in->w > 0 && in->sample >= CONV_SAMPLE_U8 && in->sample <= CONV_SAMPLE_F32 &&
+           (size_t)in->w <= SIZE_MAX / 4 / (size_t)in->h;
+}
+
+static int one_strip(conv_file* f, uint64_t offset) {
+    f->strip = malloc(sizeof(uint64_t));
+    if (!f->strip) {
+        return CONV_ENOMEM;
+    }
+    f->strip[0] = offset;
+    return set_strips(f, f->info.h, 1);
+}
+
+static int parse_raw(conv_file* f, const conv_file_info* raw) {
+    if (!valid_info(raw)) {
+        return CONV_EINVAL;
+    }
+    f->info = *raw;
+    f->info.format = CONV_FILE_RAW;
+    return one_strip(f, 0);
+}
+
+// Next decimal header field, skipping whitespace and comments
+static int pgm_number(const conv_file* f, size_t* pos, long* v) {
+    const unsigned char* p = f->map;
+
+    for (;;) {
+        while (*pos < f->map_len && isspace(p[*pos])) {
+            (*pos)++;
+        }
+        if (*pos >= f->map_len || p[*pos] != '#') {
+            break;
+        }
+        while (*pos < f->map_len && p[*pos] != '\n') {
+            (*pos)++;
+        }
+    }
+    if (*pos >= f->map_len || !isdigit(p[*pos])) {
+        return CONV_EINVAL;
+    }
+    for (*v = 0; *pos < f->map_len && isdigit(p[*pos]); (*pos)++) {
+        *v = *v * 10 + (p[*pos] - '0');
+        if (*v > INT_MAX) {
+            return CONV_EINVAL;
+        }
+    }
+    return CONV_OK;
+}
+
+static int parse_pgm(conv_file* f) {
+    size_t pos = 2;
+    long w, h, maxval;
+
+    if (f->map[1] != '5' || pgm_number(f, &pos, &w) != CONV_OK || pgm_number(f, &pos, &h) != CONV_OK ||
+        pgm_number(f, &pos, &maxval) != CONV_OK || maxval < 1 || maxval > 65535) {
+        return CONV_EINVAL;
+    }
+    // One whitespace character ends the header
+    if (pos >= f->map_len || !isspace(f->map[pos])) {
+        return CONV_EINVAL;
+    }
+    f->info.format = CONV_FILE_PGM;
+    f->info.sample = maxval < 256 ? CONV_SAMPLE_U8 : CONV_SAMPLE_U16;
+    f->info.h = (int)h;
+    f->info.w = (int)w;
+    f->swap = f->info.sample == CONV_SAMPLE_U16 && host_little();
+    return valid_info(&f->info) ? one_strip(f, pos + 1) : CONV_EINVAL;
+}
+
+typedef struct {
+    const unsigned char* p;
+    size_t n;
+    int le, big;
+} tiff_reader;
+
+typedef struct {
+    int tag, type;
+    uint64_t count;
+    const unsigned char* value; // the entry's value field
+} tiff_entry;
+
+// Element i of an entry's SHORT, LONG or LONG8 array
+static int tiff_value(const tiff_reader* t, const tiff_entry* e, uint64_t i, uint64_t* v) {
+    int size = e->type == 3 ? 2 : e->type == 4 ? 4 : e->type == 16 ? 8 : 0;
+    size_t inline_size = t->big ? 8 : 4;
+    const unsigned char* data = e->value;
+
+    if (!size || i >= e->count) {
+        return CONV_EINVAL;
+    }
+    if (e->count > inline_size / size) {
+        uint64_t offset = get_uint(e->value, (int)inline_size, t->le);
+        if (offset > t->n || (t->n - offset) / size < e->count) {
+            return CONV_EINVAL;
+        }
+        data = t->p + offset;
+    }
+    *v = get_uint(data + i * size, size, t->le);
+    return CONV_OK;
+}
+
+static int parse_tiff(conv_file* f) {
+    tiff_reader t = { f->map, f->map_len, f->map[0] == 'I', 0 };
+    tiff_entry strip_offsets = { 0, 0, 0, NULL };
+    uint64_t w = 0, h = 0, bits = 1, format = 1, compression = 1, samples = 1, rows_per_strip = UINT32_MAX;
+    uint64_t ifd;
+    int version = (int)get_uint(t.p + 2, 2, t.le);
+
+    if (version == 43) {
+        t.big = 1;
+        if (t.n < 16 || get_uint(t.p + 4, 2, t.le) != 8) {
+            return CONV_EINVAL;
+        }
+        ifd = get_uint(t.p + 8, 8, t.le);
+    } else if (version == 42) {
+        ifd = get_uint(t.p + 4, 4, t.le);
+    } else {
+        return CONV_EINVAL;
+    }
+
+    size_t count_size = t.big ? 8 : 2, entry_size = t.big ? 20 : 12;
+    if (ifd > t.n - count_size) {
+        return CONV_EINVAL;
+    }
+    uint64_t entries = get_uint(t.p + ifd, (int)count_size, t.le);
+    if (entries > (t.n - ifd - count_size) / entry_size) {
+        return CONV_EINVAL;
+    }
+    for (uint64_t i = 0; i < entries; i++) {
+        const unsigned char* p = t.p + ifd + count_size + i * entry_size;
+        tiff_entry e = { (int)get_uint(p, 2, t.le), (int)get_uint(p + 2, 2, t.le),
+                         get_uint(p + 4, t.big ? 8 : 4, t.le), p + (t.big ? 12 : 8) };
+        uint64_t* field = NULL;
+
+        switch (e.tag) {
+        case 256: field = &w; break;
+        case 257: field = &h; break;
+        case 258: field = &bits; break;
+        case 259: field = &compression; break;
+        case 273: strip_offsets = e; break;
+        case 277: field = &samples; break;
+        case 278: field = &rows_per_strip; break;
+        case 339: field = &format; break;
+        case 322: // TileWidth .. TileByteCounts
+        case 323:
+        case 324:
+        case 325:
+            return CONV_EINVAL;
+        }
+        if (field && tiff_value(&t, &e, 0, field) != CONV_OK) {
+            return CONV_EINVAL;
+        }
+    }
+
+    if (compression != 1 || samples != 1 || w == 0 || h == 0 || w > INT_MAX || h > INT_MAX ||
+        rows_per_strip == 0 || !strip_offsets.value) {
+        return CONV_EINVAL;
+    }
+    if (bits == 8 && format == 1) {
+        f->info.sample = CONV_SAMPLE_U8;
+    } else if (bits == 16 && format == 1) {
+        f->info.sample = CONV_SAMPLE_U16;
+    } else if (bits == 16 && format == 2) {
+        f->info.sample = CONV_SAMPLE_Q88;
+    } else if (bits == 32 && format == 3) {
+        f->info.sample = CONV_SAMPLE_F32;
+    } else {
+        return CONV_EINVAL;
+    }
+    f->info.format = CONV_FILE_TIFF;
+    f->info.h = (int)h;
+    f->info.w = (int)w;
+    f->swap = t.le != host_little();
+    if (!valid_info(&f->info)) {
+        return CONV_EINVAL;
+    }
+
+    int rows = rows_per_strip < h ? (int)rows_per_strip : (int)h;
+    int strips = (int)((h + rows - 1) / rows);
+    if (strip_offsets.count < (uint64_t)strips) {
+        return CONV_EINVAL;
+    }
+    f->strip = malloc(sizeof(uint64_t) * strips);
+    if (!f->strip) {
+        return CONV_ENOMEM;
+    }
+    for (int i = 0; i < strips; i++) {
+        if (tiff_value(&t, &strip_offsets, i, &f->strip[i]) != CONV_OK) {
+            return CONV_EINVAL;
+        }
+    }
+    return set_strips(f, rows, strips);
+}
+
+static int map_file(conv_file* f, int writable) {
+    f->map = mmap(NULL, f->map_len, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, f->fd, 0);
+    if (f->map == MAP_FAILED) {
+        f->map = NULL;
+        return CONV_EIO;
+    }
+    f->writable = writable;
+    return CONV_OK;
+}
+
+int conv_file_open(conv_file* f, const char* path, const conv_file_info* raw, int writable) {
+    struct stat st;
+    int r;
+
+    memset(f, 0, sizeof(*f));
+    f->fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (f->fd < 0 || fstat(f->fd, &st) != 0) {
+        conv_file_close(f);
+        return CONV_EIO;
+    }
+    // An empty file holds no image (and cannot be mapped)
+    if (st.st_size == 0) {
+        conv_file_close(f);
+        return CONV_EINVAL;
+    }
+    f->map_len = (size_t)st.st_size;
+    r = map_file(f, writable);
+    if (r == CONV_OK) {
+        if (raw) {
+            r = parse_raw(f, raw);
+        } else if (f->map_len >= 2 && f->map[0] == 'P') {
+            r = parse_pgm(f);
+        } else if (f->map_len >= 8 && ((f->map[0] == 'I' && f->map[1] == 'I') || (f->map[0] == 'M' && f->map[1] == 'M'))) {
+            r = parse_tiff(f);
+        } else {
+            r = CONV_EINVAL;
+        }
+    }
+    if (r != CONV_OK) {
+        conv_file_close(f);
+    }
+    return r;
+}
+
+// Classic TIFF or BigTIFF header and IFD for one strip of data_bytes at
+// the returned offset
+static size_t tiff_header(unsigned char* hdr, const conv_file_info* info, uint64_t data_bytes) {
+    static const int bits[] = { 8, 16, 16, 32 };
+    static const int format[] = { 1, 1, 2, 3 };
+    int le = host_little(), big = data_bytes > UINT32_MAX - 256;
+    size_t ifd = big ? 16 : 8, count_size = big ? 8 : 2, entry_size = big ? 20 : 12;
+    int offset_type = big ? 16 : 4, offset_size = big ? 8 : 4;
+    enum { ENTRIES = 10 };
+    size_t data = (ifd + count_size + ENTRIES * entry_size + offset_size + 15) / 16 * 16;
+    const struct {
+        int tag, type;
+        uint64_t value;
+    } entry[ENTRIES] = {
+        { 256, 4, (uint64_t)info->w },          // ImageWidth
+        { 257, 4, (uint64_t)info->h },          // ImageLength
+        { 258, 3, (uint64_t)bits[info->sample] }, // BitsPerSample
+        { 259, 3, 1 },                          // Compression: none
+        { 262, 3, 1 },                          // PhotometricInterpretation: BlackIsZero
+        { 273, offset_type, data },             // StripOffsets
+        { 277, 3, 1 },                          // SamplesPerPixel
+        { 278, 4, (uint64_t)info->h },          // RowsPerStrip
+        { 279, offset_type, data_bytes },       // StripByteCounts
+        { 339, 3, (uint64_t)format[info->sample] }, // SampleFormat
+    };
+
+    memset(hdr, 0, data);
+    hdr[0] = hdr[1] = le ? 'I' : 'M';
+    if (big) {
+        put_uint(hdr + 2, 2, 43, le);
+        put_uint(hdr + 4, 2, 8, le);
+        put_uint(hdr + 8, 8, ifd, le);
+    } else {
+        put_uint(hdr + 2, 2, 42, le);
+        put_uint(hdr + 4, 4, ifd, le);
+    }
+    put_uint(hdr + ifd, (int)count_size, ENTRIES, le);
+    for (int i = 0; i < ENTRIES; i++) {
+        unsigned char* p = hdr + ifd + count_size + i * entry_size;
+        int size = entry[i].type == 3 ? 2 : entry[i].type == 4 ? 4 : 8;
+        put_uint(p, 2, (uint64_t)entry[i].tag, le);
+        put_uint(p + 2, 2, (uint64_t)entry[i].type, le);
+        put_uint(p + 4, big ? 8 : 4, 1, le);
+        // Values are left-justified in the value field
+        put_uint(p + (big ? 12 : 8), size, entry[i].value, le);
+    }
+    return data;
+}
+
+int conv_file_create(conv_file* f, const char* path, const conv_file_info* info) {
+    unsigned char hdr[256];
+    size_t hdr_len = 0;
+    int r;
+
+    memset(f, 0, sizeof(*f));
+    f->fd = -1;
+    if (!valid_info(info) || info->format < CONV_FILE_RAW || info->format > CONV_FILE_TIFF ||
+        (info->format == CONV_FILE_PGM && info->sample > CONV_SAMPLE_U16)) {
+        return CONV_EINVAL;
+    }
+    f->info = *info;
+    uint64_t data_bytes = (uint64_t)info->h * info->w * sample_size(info->sample);
+    if (info->format == CONV_FILE_PGM) {
+        hdr_len = (size_t)snprintf((char*)hdr, sizeof(hdr), "P5\n%d %d\n%d\n", info->w, info->h,
+                                   info->sample == CONV_SAMPLE_U8 ? 255 : 65535);
+        f->swap = info->sample == CONV_SAMPLE_U16 && host_little();
+    } else if (info->format == CONV_FILE_TIFF) {
+        hdr_len = tiff_header(hdr, info, data_bytes);
+    }
+
+    f->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    f->map_len = hdr_len + data_bytes;
+    if (f->fd < 0 || ftruncate(f->fd, (off_t)f->map_len) != 0 || map_file(f, 1) != CONV_OK) {
+        conv_file_close(f);
+        return CONV_EIO;
+    }
+    memcpy(f->map, hdr, hdr_len);
+    r = one_strip(f, hdr_len);
+    if (r != CONV_OK) {
+        conv_file_close(f);
+    }
+    return r;
+}
+
+int conv_file_close(conv_file* f) {
+    int r = CONV_OK;
+
+    if (f->map) {
+        if (f->writable && msync(f->map, f->map_len, MS_SYNC) != 0) {
+            r = CONV_EIO;
+        }
+        munmap(f->map, f->map_len);
+    }
+    if (f->fd >= 0 && close(f->fd) != 0) {
+        r = CONV_EIO;
+    }
+    free(f->strip);
+    f->map = NULL;
+    f->strip = NULL;
+    f->fd = -1;
+    return r;
+}
+
+void* conv_file_row(const conv_file* f, int y) {
+    return f->map + f->strip[y / f->rows_per_strip] + (size_t)(y % f->rows_per_strip) * f->row_bytes;
+}
+
+void conv_file_read_row(const conv_file* f, int y, float* dst) {
+    const unsigned char* p = conv_file_row(f, y);
+    int w = f->info.w;
+
+    switch (f->info.sample) {
+    case CONV_SAMPLE_U8:
+        for (int x = 0; x < w; x++) {
+            dst[x] = p[x];
+        }
+        break;
+    case CONV_SAMPLE_U16:
+        for (int x = 0; x < w; x++) {
+            dst[x] = load16(p + 2 * x, f->swap);
+        }
+        break;
+    case CONV_SAMPLE_Q88:
+        for (int x = 0; x < w; x++) {
+            dst[x] = (float)(int16_t)load16(p + 2 * x, f->swap) / 256.0f;
+        }
+        break;
+    default:
+        for (int x = 0; x < w; x++) {
+            dst[x] = load_f32(p + 4 * x, f->swap);
+        }
+    }
+}
+
+// Round to nearest, clamp to [0, max]; NaN goes to 0
+static uint16_t to_uint(float v, float max, int* clamped) {
+    float r = floorf(v + 0.5f);
+
+    if (!(r >= 0.0f)) {
+        (*clamped)++;
+        return 0;
+    }
+    if (r > max) {
+        (*clamped)++;
+        return (uint16_t)max;
+    }
+    return (uint16_t)r;
+}
+
+int conv_file_write_row(conv_file* f, int y, const float* src) {
+    unsigned char* p = conv_file_row(f, y);
+    int w = f->info.w, clamped = 0;
+
+    switch (f->info.sample) {
+    case CONV_SAMPLE_U8:
+        for (int x = 0; x < w; x++) {
+            p[x] = (unsigned char)to_uint(src[x], 255.0f, &clamped);
+        }
+        break;
+    case CONV_SAMPLE_U16:
+        for (int x = 0; x < w; x++) {
+            store16(p + 2 * x, to_uint(src[x], 65535.0f, &clamped), f->swap);
+        }
+        break;
+    case CONV_SAMPLE_Q88:
+        for (int x = 0; x < w; x += 256) {
+            int16_t q[256];
+            int n = w - x < 256 ? w - x : 256;
+            clamped += conv_f32_to_q88(src + x, n, q);
+            for (int i = 0; i < n; i++) {
+                store16(p + 2 * (x + i), (uint16_t)q[i], f->swap);
+            }
+        }
+        break;
+    default:
+        for (int x = 0; x < w; x++) {
+            store_f32(p + 4 * x, src[x], f->swap);
+        }
+    }
+    return clamped;
+}
+
+// Applies advice to rows [y0, y1), strip by strip. WILLNEED covers every
+// page the rows touch, DONTNEED only pages wholly inside them, after
+// starting writeback of a writable file's.
+static void advise_rows(const conv_file* f, int y0, int y1, int advice) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+
+    y0 = y0 < 0 ? 0 : y0;
+    y1 = y1 > f->info.h ? f->info.h : y1;
+    while (y0 < y1) {
+        int end = (y0 / f->rows_per_strip + 1) * f->rows_per_strip;
+        end = end < y1 ? end : y1;
+        uintptr_t a = (uintptr_t)conv_file_row(f, y0);
+        uintptr_t b = (uintptr_t)conv_file_row(f, end - 1) + f->row_bytes;
+        if (advice == MADV_WILLNEED) {
+            a &= ~(page - 1);
+            b = (b + page - 1) & ~(page - 1);
+        } else {
+            a = (a + page - 1) & ~(page - 1);
+            b &= ~(page - 1);
+        }
+        if (a < b) {
+            if (advice == MADV_DONTNEED && f->writable) {
+                msync((void*)a, b - a, MS_ASYNC);
+            }
+            madvise((void*)a, b - a, advice);
+        }
+        y0 = end;
+    }
+}
+
+// Whether the stream can use row y of f in place: stored as its own type
+static int native_row(const conv_file* f, int y, int q88) {
+    int sample = q88 ? CONV_SAMPLE_Q88 : CONV_SAMPLE_F32;
+    return f->info.sample == sample && !f->swap && (uintptr_t)conv_file_row(f, y) % sample_size(sample) == 0;
+}
+
+static const void* stream_src(const conv_file* f, int y, int q88, void* buf) {
+    if (native_row(f, y, q88)) {
+        return conv_file_row(f, y);
+    }
+    if (!q88) {
+        conv_file_read_row(f, y, buf);
+    } else {
+        const unsigned char* p = conv_file_row(f, y);
+        for (int x = 0; x < f->info.w; x++) {
+            ((int16_t*)buf)[x] = (int16_t)load16(p + 2 * x, f->swap);
+        }
+    }
+    return buf;
+}
+
+static void* stream_dst(const conv_file* f, int y, int q88, void* buf) {
+    return native_row(f, y, q88) ? conv_file_row(f, y) : buf;
+}
+
+// Writes back an output row that went to buf. Returns the clamped count.
+static int stream_store(conv_file* f, int y, int q88, const void* buf, const void* dst, const uint8_t* overflow) {
+    int clamped = 0;
+
+    if (q88) {
+        for (int x = 0; x < f->info.w; x++) {
+            clamped += overflow[x];
+        }
+    }
+    if (dst != buf) {
+        return clamped;
+    }
+    if (!q88) {
+        return conv_file_write_row(f, y, buf);
+    }
+    unsigned char* p = conv_file_row(f, y);
+    for (int x = 0; x < f->info.w; x++) {
+        store16(p + 2 * x, (uint16_t)((const int16_t*)buf)[x], f->swap);
+    }
+    return clamped;
+}
+
+// Streams in through s into out, one band of rows at a time
+static int file_conv(conv_file* in, conv_file* out, conv_stream* s, int band_rows) {
+    int h = in->info.h, band = band_rows > 0 ? band_rows : CONV_FILE_BAND_ROWS;
+    int q88 = s->q88, in_done = 0, out_done = 0, r = CONV_OK;
+    long clamped = 0;
+    void* in_buf = malloc(sizeof(float) * in->info.w);
+    void* out_buf = malloc(sizeof(float) * in->info.w);
+    uint8_t* overflow = malloc((size_t)in->info.w);
+
+    if (!in_buf || !out_buf || !overflow) {
+        r = CONV_ENOMEM;
+        goto done;
+    }
+    advise_rows(in, 0, band, MADV_WILLNEED);
+    for (int y = 0; y < h || s->rows_out < h; y++) {
+        if (y % band == 0) {
+            advise_rows(in, y + band, y + 2 * band, MADV_WILLNEED);
+            // Rows before y are in the ring; in place they may still be
+            // waiting for their output
+            int in_end = in == out ? s->rows_out : y;
+            advise_rows(in, in_done, in_end, MADV_DONTNEED);
+            advise_rows(out, out_done, s->rows_out, MADV_DONTNEED);
+            in_done = in_end;
+            out_done = s->rows_out;
+        }
+        void* dst = stream_dst(out, s->rows_out, q88, out_buf);
+        int got;
+        if (y < h) {
+            const void* src = stream_src(in, y, q88, in_buf);
+            got = q88 ? conv_stream_push_q88(s, src, dst, overflow) : conv_stream_push(s, src, dst);
+        } else {
+            got = q88 ? conv_stream_flush_q88(s, dst, overflow) : conv_stream_flush(s, dst);
+        }
+        if (got < 0) {
+            r = got;
+            goto done;
+        }
+        if (got) {
+            clamped += stream_store(out, s->rows_out - 1, q88, out_buf, dst, overflow);
+        }
+    }
+    advise_rows(in, in_done, h, MADV_DONTNEED);
+    advise_rows(out, out_done, h, MADV_DONTNEED);
+    r = clamped ? CONV_ERANGE : CONV_OK;
+done:
+    free(in_buf);
+    free(out_buf);
+    free(overflow);
+    return r;
+}
+
+static int same_size(const conv_file* in, const conv_file* out) {
+    return in && out && in->map && out->map && out->writable && in->info.h == out->info.h &&
+           in->info.w == out->info.w;
+}
+
+int conv_file_conv2d(conv_file* in, conv_file* out, const float* k, int ksize, int band_rows) {
+    conv_stream s;
+
+    if (!same_size(in, out)) {
+        return CONV_EINVAL;
+    }
+    int r = conv_stream_init(&s, in->info.w, k, ksize);
+    if (r == CONV_OK) {
+        r = file_conv(in, out, &s, band_rows);
+        conv_stream_free(&s);
+    }
+    return r;
+}
+
+int conv_file_conv2d_q88(conv_file* in, conv_file* out, const int16_t* k, int ksize, int band_rows) {
+    conv_stream s;
+
+    if (!same_size(in, out) || in->info.sample != CONV_SAMPLE_Q88 || out->info.sample != CONV_SAMPLE_Q88) {
+        return CONV_EINVAL;
+    }
+    int r = conv_stream_init_q88(&s, in->info.w, k, ksize);
+    if (r == CONV_OK) {
+        r = file_conv(in, out, &s, band_rows);
+        conv_stream_free(&s);
+    }
+    return r;
+}
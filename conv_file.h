@@ -0,0 +1,97 @@
+#ifndef CONV_FILE_H
+#define CONV_FILE_H
+
+// File-backed images for planes larger than memory.
+//
+// A conv_file maps a whole single-channel image file with mmap (MAP_SHARED)
+// and hands out pointers to its rows, so nothing is read or written through
+// a staging copy of the image. Supported files:
+//   raw   no header, row-major samples in host byte order; the caller gives
+//         the size and sample type
+//   PGM   binary P5, maxval < 256 (U8) or up to 65535 (U16, big-endian)
+//   TIFF  classic or BigTIFF, either byte order, uncompressed, one sample
+//         per pixel, in strips (tiled TIFFs are refused): 8-bit and 16-bit
+//         unsigned, 16-bit signed (read as Q8.8) and 32-bit float samples
+// Created TIFFs hold the image in one strip, BigTIFF when it passes 4 GB.
+//
+// conv_file_conv2d() runs the plane through a conv_stream (conv_stream.h)
+// in row order, which for these row-major layouts is file order: while one
+// band of rows is consumed the next is prefetched with MADV_WILLNEED, and
+// bands behind the stream are dropped from the mapping with MADV_DONTNEED
+// (written output after an msync(MS_ASYNC)). The resident set is then the
+// ring plus about two bands of each file, whatever the image size. Mapping
+// the whole file needs the address space for it, i.e. a 64-bit target for
+// files of several GB.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "conv.h"
+
+#define CONV_FILE_RAW 0
+#define CONV_FILE_PGM 1
+#define CONV_FILE_TIFF 2
+
+#define CONV_SAMPLE_U8 0
+#define CONV_SAMPLE_U16 1
+#define CONV_SAMPLE_Q88 2 // int16 Q8.8
+#define CONV_SAMPLE_F32 3
+
+#define CONV_FILE_BAND_ROWS 64 // default prefetch/release band
+
+typedef struct {
+    int format, sample;
+    int h, w;
+} conv_file_info;
+
+typedef struct {
+    conv_file_info info;
+    int fd;
+    int writable;
+    int swap;            // samples are in the other byte order
+    unsigned char* map;
+    size_t map_len;
+    size_t row_bytes;
+    int rows_per_strip;
+    int strips;
+    uint64_t* strip;     // file offset of each strip
+} conv_file;
+
+// Opens and maps an image file. raw != NULL opens a raw file of that size
+// and sample type (raw->format is ignored); otherwise the format is taken
+// from the PGM or TIFF header. writable maps it read-write, e.g. for
+// in-place convolution. Returns CONV_OK, CONV_EINVAL (bad or unsupported
+// header, or a file shorter than its image), CONV_EIO or CONV_ENOMEM.
+int conv_file_open(conv_file* f, const char* path, const conv_file_info* raw, int writable);
+
+// Creates (or truncates) an image file of info's format, size and sample
+// type and maps it read-write; the samples start out zero. PGM takes U8 or
+// U16 only.
+int conv_file_create(conv_file* f, const char* path, const conv_file_info* info);
+
+// Flushes a writable file with msync(MS_SYNC) and unmaps it. Returns
+// CONV_OK or CONV_EIO.
+int conv_file_close(conv_file* f);
+
+// Row y as stored, i.e. info.sample values in the file byte order.
+void* conv_file_row(const conv_file* f, int y);
+
+// Row y converted to float (U8/U16 as their integer value, Q8.8 scaled by
+// 1/256), and back: rounded to nearest and clamped for U8/U16, truncated
+// as by conv_f32_to_q88() for Q8.8. write returns the count of clamped
+// values.
+void conv_file_read_row(const conv_file* f, int y, float* dst);
+int conv_file_write_row(conv_file* f, int y, const float* src);
+
+// "Same" convolution of in into out, which must have in's size and be
+// writable; it may be in itself. Float arithmetic as conv2d() (exact away
+// from the border, see conv_stream.h), in and out of any sample type.
+// band_rows <= 0 takes CONV_FILE_BAND_ROWS. Returns CONV_OK, CONV_ERANGE
+// if output values were clamped (the file is still complete), CONV_EINVAL
+// or CONV_ENOMEM.
+int conv_file_conv2d(conv_file* in, conv_file* out, const float* k, int ksize, int band_rows);
+
+// Q8.8 convolution of a Q8.8 file into a Q8.8 file, bit-identical to
+// conv2d_q88(); CONV_ERANGE when a pixel was clamped.
+int conv_file_conv2d_q88(conv_file* in, conv_file* out, const int16_t* k, int ksize, int band_rows);
+
+#endif
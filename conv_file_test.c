@@ -0,0 +1,340 @@
+// Build: gcc -O2 -o conv_file_test conv_file_test.c conv_file.c conv_stream.c conv_bench.c conv.c conv_simd.c -lm
+//
+// Writes and reopens raw, PGM and TIFF files of every sample type, reads a
+// big-endian multi-strip TIFF, and checks file-to-file convolution (float,
+// Q8.8, in place, small bands) against conv2d() / conv2d_q88(). Then runs
+// an 8192 x 8192 float plane (256 MB per file) with the default bands and
+// with one band, which never releases anything, and prints the peak
+// resident set of each (the first run's time includes a cold page cache,
+// whatever its band). Files go to a fresh directory under /tmp, or
+// under argv[1].
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "conv.h"
+#include "conv_bench.h"
+#include "conv_file.h"
+
+static char dir[256];
+
+static const char* path(const char* name) {
+    static char buf[2][300];
+    static int next;
+    char* p = buf[next++ & 1];
+    snprintf(p, sizeof(buf[0]), "%s/%s", dir, name);
+    return p;
+}
+
+static long peak_rss_kb(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+// Value of a sample type for pixel i, exactly representable in it
+static float sample_value(int sample, size_t i) {
+    switch (sample) {
+    case CONV_SAMPLE_U8:
+        return (float)(i * 37 % 256);
+    case CONV_SAMPLE_U16:
+        return (float)(i * 7919 % 65536);
+    case CONV_SAMPLE_Q88:
+        return (float)((int)(i * 7919 % 65536) - 32768) / 256.0f;
+    default:
+        return (float)((int)(i * 7919 % 20001) - 10000) / 64.0f;
+    }
+}
+
+static int round_trip(int format, int sample) {
+    static const char* format_name[] = { "raw", "pgm", "tiff" };
+    conv_file_info info = { format, sample, 13, 29 };
+    conv_file f;
+    float row[29];
+    int bad = 0;
+
+    if (conv_file_create(&f, path("rt"), &info) != CONV_OK) {
+        printf("MISMATCH create %s sample %d\n", format_name[format], sample);
+        return 1;
+    }
+    for (int y = 0; y < info.h; y++) {
+        for (int x = 0; x < info.w; x++) {
+            row[x] = sample_value(sample, (size_t)y * info.w + x);
+        }
+        bad |= conv_file_write_row(&f, y, row) != 0;
+    }
+    bad |= conv_file_close(&f) != CONV_OK;
+    if (conv_file_open(&f, path("rt"), format == CONV_FILE_RAW ? &info : NULL, 0) != CONV_OK) {
+        printf("MISMATCH open %s sample %d\n", format_name[format], sample);
+        return 1;
+    }
+    bad |= f.info.format != format || f.info.sample != sample || f.info.h != info.h || f.info.w != info.w;
+    for (int y = 0; y < info.h && !bad; y++) {
+        conv_file_read_row(&f, y, row);
+        for (int x = 0; x < info.w; x++) {
+            bad |= row[x] != sample_value(sample, (size_t)y * info.w + x);
+        }
+    }
+    conv_file_close(&f);
+    if (!bad) {
+        printf("%s sample %d round trip: match\n", format_name[format], sample);
+    } else {
+        printf("MISMATCH %s sample %d round trip\n", format_name[format], sample);
+    }
+    return bad;
+}
+
+static void put_be(unsigned char* p, int n, uint32_t v) {
+    for (int i = 0; i < n; i++) {
+        p[i] = (unsigned char)(v >> (8 * (n - 1 - i)));
+    }
+}
+
+// Big-endian classic TIFF of 16-bit unsigned samples in strips of 3 rows,
+// stored last strip first
+static int multi_strip(void) {
+    enum { H = 10, W = 7, RPS = 3, STRIPS = 4, ENTRIES = 8 };
+    static const int tags[ENTRIES][3] = { { 256, 4, W }, { 257, 4, H }, { 258, 3, 16 }, { 259, 3, 1 },
+                                          { 273, 4, 0 }, { 277, 3, 1 }, { 278, 4, RPS }, { 339, 3, 1 } };
+    unsigned char file[1024] = { 'M', 'M' };
+    size_t offsets = 8 + 2 + ENTRIES * 12 + 4, data = offsets + 4 * STRIPS;
+    conv_file f;
+    float row[W];
+    int bad = 0;
+
+    put_be(file + 2, 2, 42);
+    put_be(file + 4, 4, 8);
+    put_be(file + 8, 2, ENTRIES);
+    for (int i = 0; i < ENTRIES; i++) {
+        unsigned char* e = file + 10 + 12 * i;
+        put_be(e, 2, (uint32_t)tags[i][0]);
+        put_be(e + 2, 2, (uint32_t)tags[i][1]);
+        put_be(e + 4, 4, tags[i][0] == 273 ? STRIPS : 1);
+        put_be(e + 8, tags[i][1] == 3 ? 2 : 4, tags[i][0] == 273 ? (uint32_t)offsets : (uint32_t)tags[i][2]);
+    }
+    for (int s = 0; s < STRIPS; s++) {
+        size_t at = data + (size_t)(STRIPS - 1 - s) * RPS * W * 2;
+        put_be(file + offsets + 4 * s, 4, (uint32_t)at);
+        for (int y = s * RPS; y < H && y < (s + 1) * RPS; y++) {
+            for (int x = 0; x < W; x++) {
+                put_be(file + at + ((size_t)(y - s * RPS) * W + x) * 2, 2, (uint32_t)(y * 1000 + x));
+            }
+        }
+    }
+    FILE* fp = fopen(path("strips.tif"), "wb");
+    fwrite(file, 1, data + STRIPS * RPS * W * 2, fp);
+    fclose(fp);
+
+    if (conv_file_open(&f, path("strips.tif"), NULL, 0) != CONV_OK) {
+        printf("MISMATCH open big-endian strips\n");
+        return 1;
+    }
+    bad |= f.strips != STRIPS || f.info.sample != CONV_SAMPLE_U16;
+    for (int y = 0; y < H && !bad; y++) {
+        conv_file_read_row(&f, y, row);
+        for (int x = 0; x < W; x++) {
+            bad |= row[x] != (float)(y * 1000 + x);
+        }
+    }
+    conv_file_close(&f);
+
+    // Truncated: the last strip is cut short
+    fp = fopen(path("short.tif"), "wb");
+    fwrite(file, 1, data + STRIPS * RPS * W * 2 - 2 * RPS * W * 2 - 1, fp);
+    fclose(fp);
+    bad |= conv_file_open(&f, path("short.tif"), NULL, 0) != CONV_EINVAL;
+
+    printf(bad ? "MISMATCH big-endian strips\n" : "big-endian strips: match\n");
+    return bad;
+}
+
+// Float convolution from a file of in_sample into one of out_sample
+static int check_f32(int format, int in_sample, int out_sample, int h, int w, int ksize, int band) {
+    size_t plane = (size_t)h * w;
+    float* img = malloc(sizeof(float) * plane);
+    float* ref = malloc(sizeof(float) * plane);
+    float* row = malloc(sizeof(float) * w);
+    float k[25];
+    conv_file_info in_info = { format, in_sample, h, w }, out_info = { format, out_sample, h, w };
+    conv_file in, out;
+    int pad = ksize / 2, bad = 0;
+
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (float)(rand() % 101) / 512.0f;
+    }
+    conv_file_create(&in, path("in"), &in_info);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            img[(size_t)y * w + x] = sample_value(in_sample, (size_t)rand());
+        }
+        conv_file_write_row(&in, y, img + (size_t)y * w);
+    }
+    conv2d(img, h, w, k, ksize, ref);
+    conv_file_create(&out, path("out"), &out_info);
+    int r = conv_file_conv2d(&in, &out, k, ksize, band);
+    bad |= r != CONV_OK && r != CONV_ERANGE;
+    bad |= conv_file_close(&out) != CONV_OK;
+    conv_file_close(&in);
+
+    // Compare with the reference stored in the output's sample type
+    conv_file_open(&out, path("out"), format == CONV_FILE_RAW ? &out_info : NULL, 0);
+    conv_file_create(&in, path("ref"), &out_info);
+    for (int y = 0; y < h && !bad; y++) {
+        conv_file_write_row(&in, y, ref + (size_t)y * w);
+        conv_file_read_row(&in, y, ref + (size_t)y * w);
+        conv_file_read_row(&out, y, row);
+        for (int x = 0; x < w; x++) {
+            float a = ref[(size_t)y * w + x], b = row[x];
+            int inside = y >= pad && y < h - pad && x >= pad && x < w - pad;
+            // On the border float rounding may move a value by one step
+            float step = out_sample == CONV_SAMPLE_F32 ? 1e-4f * (1.0f + fabsf(a))
+                       : out_sample == CONV_SAMPLE_Q88 ? 1.0f / 256.0f : 1.0f;
+            bad |= inside ? a != b : fabsf(a - b) > step;
+        }
+    }
+    conv_file_close(&in);
+    conv_file_close(&out);
+    if (!bad) {
+        printf("f32 %dx%d, %dx%d, samples %d -> %d, band %d: match\n", h, w, ksize, ksize, in_sample, out_sample,
+               band);
+    } else {
+        printf("MISMATCH f32 %dx%d, %dx%d, samples %d -> %d, band %d\n", h, w, ksize, ksize, in_sample,
+               out_sample, band);
+    }
+    free(img);
+    free(ref);
+    free(row);
+    return bad;
+}
+
+// Q8.8 TIFF into a raw file, then the raw file in place
+static int check_q88(int h, int w, int ksize, int band) {
+    size_t plane = (size_t)h * w;
+    int16_t* img = malloc(sizeof(int16_t) * plane);
+    int16_t* ref = malloc(sizeof(int16_t) * plane);
+    int16_t* twice = malloc(sizeof(int16_t) * plane);
+    uint8_t* overflow = malloc(plane);
+    int16_t k[25];
+    conv_file_info tiff = { CONV_FILE_TIFF, CONV_SAMPLE_Q88, h, w }, raw = { CONV_FILE_RAW, CONV_SAMPLE_Q88, h, w };
+    conv_file in, out;
+    int bad = 0, clamped = 0;
+
+    for (size_t i = 0; i < plane; i++) {
+        img[i] = (int16_t)(rand() % 8193 - 4096);
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (int16_t)(rand() % 513 - 256);
+    }
+    conv2d_q88(img, h, w, k, ksize, ref, overflow);
+    conv2d_q88(ref, h, w, k, ksize, twice, overflow);
+    for (size_t i = 0; i < plane; i++) {
+        clamped |= overflow[i];
+    }
+
+    conv_file_create(&in, path("q.tif"), &tiff);
+    for (int y = 0; y < h; y++) {
+        memcpy(conv_file_row(&in, y), img + (size_t)y * w, sizeof(int16_t) * w);
+    }
+    conv_file_create(&out, path("q.raw"), &raw);
+    bad |= conv_file_conv2d_q88(&in, &out, k, ksize, band) < CONV_ERANGE;
+    bad |= conv_file_conv2d_q88(&out, &out, k, ksize, band) != (clamped ? CONV_ERANGE : CONV_OK);
+    for (int y = 0; y < h; y++) {
+        bad |= memcmp(conv_file_row(&out, y), twice + (size_t)y * w, sizeof(int16_t) * w) != 0;
+    }
+    // Q8.8 needs Q8.8 files
+    bad |= conv_file_conv2d_q88(&out, &in, k, 4, band) != CONV_EINVAL;
+    conv_file_close(&in);
+    conv_file_close(&out);
+    if (!bad) {
+        printf("q88 %dx%d, %dx%d, band %d (in place): match\n", h, w, ksize, ksize, band);
+    } else {
+        printf("MISMATCH q88 %dx%d, %dx%d, band %d\n", h, w, ksize, ksize, band);
+    }
+    free(img);
+    free(ref);
+    free(twice);
+    free(overflow);
+    return bad;
+}
+
+// An n x n float plane, written with write() a row at a time, through
+// conv_file_conv2d() with the given band
+static void bench(int n, int band) {
+    conv_file_info info = { CONV_FILE_RAW, CONV_SAMPLE_F32, n, n };
+    float* row = malloc(sizeof(float) * n);
+    float k[9] = { 1 / 9.0f, 1 / 9.0f, 1 / 9.0f, 1 / 9.0f, 1 / 9.0f, 1 / 9.0f, 1 / 9.0f, 1 / 9.0f, 1 / 9.0f };
+    conv_file in, out;
+
+    FILE* fp = fopen(path("big.in"), "wb");
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            row[x] = (float)((x + y) % 251);
+        }
+        fwrite(row, sizeof(float), n, fp);
+    }
+    fclose(fp);
+    free(row);
+
+    long rss0 = peak_rss_kb();
+    uint64_t t0 = conv_bench_ns();
+    conv_file_open(&in, path("big.in"), &info, 0);
+    conv_file_create(&out, path("big.out"), &info);
+    conv_file_conv2d(&in, &out, k, 3, band);
+    conv_file_close(&in);
+    conv_file_close(&out);
+    uint64_t t1 = conv_bench_ns();
+    printf("%dx%d float 3x3, band %d: files 2 x %.0f MB, peak RSS %ld KB (was %ld KB), %.0f ms\n", n, n,
+           band ? band : CONV_FILE_BAND_ROWS, 4.0 * n * n / 1e6, peak_rss_kb(), rss0, (t1 - t0) / 1e6);
+    unlink(path("big.in"));
+    unlink(path("big.out"));
+}
+
+int main(int argc, char** argv) {
+    static const char* names[] = { "rt", "strips.tif", "short.tif", "in", "out", "ref", "q.tif", "q.raw" };
+    int failures = 0;
+
+    snprintf(dir, sizeof(dir), "%s/conv_file_XXXXXX", argc > 1 ? argv[1] : "/tmp");
+    if (!mkdtemp(dir)) {
+        printf("cannot create %s\n", dir);
+        return 1;
+    }
+
+    for (int format = CONV_FILE_RAW; format <= CONV_FILE_TIFF; format++) {
+        for (int sample = CONV_SAMPLE_U8; sample <= CONV_SAMPLE_F32; sample++) {
+            if (format != CONV_FILE_PGM || sample <= CONV_SAMPLE_U16) {
+                failures += round_trip(format, sample);
+            }
+        }
+    }
+    conv_file_info bad_pgm = { CONV_FILE_PGM, CONV_SAMPLE_F32, 4, 4 };
+    conv_file f;
+    if (conv_file_create(&f, path("rt"), &bad_pgm) != CONV_EINVAL ||
+        conv_file_open(&f, path("missing"), NULL, 0) != CONV_EIO) {
+        printf("MISMATCH argument checks\n");
+        failures++;
+    }
+    failures += multi_strip();
+
+    failures += check_f32(CONV_FILE_RAW, CONV_SAMPLE_F32, CONV_SAMPLE_F32, 37, 41, 3, 0);
+    failures += check_f32(CONV_FILE_RAW, CONV_SAMPLE_F32, CONV_SAMPLE_F32, 200, 300, 5, 7);
+    failures += check_f32(CONV_FILE_PGM, CONV_SAMPLE_U8, CONV_SAMPLE_U8, 64, 50, 3, 5);
+    failures += check_f32(CONV_FILE_PGM, CONV_SAMPLE_U16, CONV_SAMPLE_U16, 33, 17, 5, 0);
+    failures += check_f32(CONV_FILE_TIFF, CONV_SAMPLE_U8, CONV_SAMPLE_F32, 20, 20, 1, 3);
+    failures += check_f32(CONV_FILE_TIFF, CONV_SAMPLE_F32, CONV_SAMPLE_Q88, 50, 70, 3, 16);
+    failures += check_q88(1, 1, 3, 0);
+    failures += check_q88(45, 67, 3, 4);
+    failures += check_q88(128, 100, 5, 0);
+
+    for (unsigned i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        unlink(path(names[i]));
+    }
+    if (!failures) {
+        bench(8192, 0);
+        bench(8192, 8192);
+    }
+    rmdir(dir);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv_layer.h"
+
+typedef struct {
+    const void* in;
+    const void* k;
+    void* out;
+    uint8_t* overflow;
+    int c_in, h, w, ksize;
+    _Atomic int failed;
+} conv_layer_job;
+
+static int layer_args_ok(const void* in, int c_in, int h, int w, const void* k, int c_out, int ksize, const void* out) {
+    return in && k && out && c_in > 0 && c_out > 0 && h > 0 && w > 0 && ksize > 0 && ksize % 2 == 1;
+}
+
+static void layer_f32_run(void* arg, int co) {
+    conv_layer_job* job = arg;
+    size_t plane = (size_t)job->h * job->w;
+    size_t kk = (size_t)job->ksize * job->ksize;
+    const float* in = job->in;
+    const float* k = (const float*)job->k + (size_t)co * job->c_in * kk;
+    float* out = (float*)job->out + (size_t)co * plane;
+    float* part = malloc(sizeof(float) * plane);
+
+    if (!part) {
+        job->failed = 1;
+        return;
+    }
+    conv2d(in, job->h, job->w, k, job->ksize, out);
+    for (int ci = 1; ci < job->c_in; ci++) {
+        conv2d(in + ci * plane, job->h, job->w, k + ci * kk, job->ksize, part);
+        for (size_t i = 0; i < plane; i++) {
+            out[i] += part[i];
+        }
+    }
+    free(part);
+}
+
+static void layer_q88_run(void* arg, int co) {
+    conv_layer_job* job = arg;
+    size_t plane = (size_t)job->h * job->w;
+    size_t kk = (size_t)job->ksize * job->ksize;
+    const int16_t* in = job->in;
+    const int16_t* k = (const int16_t*)job->k + (size_t)co * job->c_in * kk;
+    int16_t* out = (int16_t*)job->out + (size_t)co * plane;
+    uint8_t* overflow = job->overflow ? job->overflow + (size_t)co * plane : NULL;
+    int32_t* sum = calloc(plane, sizeof(int32_t));
+    int16_t* part = malloc(sizeof(int16_t) * plane);
+    uint8_t* part_ovf = overflow ? malloc(plane) : NULL;
+
+    if (!sum || !part || (overflow && !part_ovf)) {
+        job->failed = 1;
+        free(sum);
+        free(part);
+        free(part_ovf);
+        return;
+    }
+    if (overflow) {
+        memset(overflow, 0, plane);
+    }
+    for (int ci = 0; ci < job->c_in; ci++) {
+        conv2d_q88(in + ci * plane, job->h, job->w, k + ci * kk, job->ksize, part, part_ovf);
+        for (size_t i = 0; i < plane; i++) {
+            sum[i] += part[i];
+        }
+        if (overflow) {
+            for (size_t i = 0; i < plane; i++) {
+                overflow[i] |= part_ovf[i];
+            }
+        }
+    }
+    for (size_t i = 0; i < plane; i++) {
+        int32_t v = sum[i];
+        int16_t q = v > 32767 ? 32767 : v < -32768 ? -32768 : (int16_t)v;
+        if (overflow && q != v) {
+            overflow[i] = 1;
+        }
+        out[i] = q;
+    }
+    free(sum);
+    free(part);
+    free(part_ovf);
+}
+
+static int layer_run(conv_layer_job* job, int c_out, conv_task_fn fn, conv_pool* pool) {
+    conv_isa(); // pick the vector path once, before the workers look it up
+    if (pool) {
+        conv_pool_run(pool, c_out, fn, job);
+    } else {
+        for (int co = 0; co < c_out; co++) {
+            fn(job, co);
+        }
+    }
+    return job->failed ? CONV_ENOMEM : CONV_OK;
+}
+
+int conv_layer_f32(const float* in, int c_in, int h, int w,
+                   const float* k, int c_out, int ksize, float* out, conv_pool* pool) {
+    conv_layer_job job = { in, k, out, NULL, c_in, h, w, ksize, 0 };
+
+    if (!layer_args_ok(in, c_in, h, w, k, c_out, ksize, out)) {
+        return CONV_EINVAL;
+    }
+    return layer_run(&job, c_out, layer_f32_run, pool);
+}
+
+int conv_layer_q88(const int16_t* in, int c_in, int h, int w,
+                   const int16_t* k, int c_out, int ksize, int16_t* out,
+                   uint8_t* overflow, conv_pool* pool) {
+    conv_layer_job job = { in, k, out, overflow, c_in, h, w, ksize, 0 };
+
+    if (!layer_args_ok(in, c_in, h, w, k, c_out, ksize, out)) {
+        return CONV_EINVAL;
+    }
+    return layer_run(&job, c_out, layer_q88_run, pool);
+}
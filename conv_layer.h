@@ -0,0 +1,30 @@
+#ifndef CONV_LAYER_H
+#define CONV_LAYER_H
+
+// Multi-channel convolution layer on top of the single-plane conv2d paths.
+//
+// in holds c_in planes of h x w, k holds c_out x c_in kernels of
+// ksize x ksize (filter-major: k + (co * c_in + ci) * ksize * ksize), and out
+// gets c_out planes of h x w. Every output plane is the sum over input
+// channels of the "same" convolution of that channel with its kernel; there
+// is no bias or activation.
+
+#include <stdint.h>
+#include "conv.h"
+#include "conv_pool.h"
+
+// Output channels are spread over pool (may be NULL). Channel partial sums
+// are added in ci order, so the result does not depend on the thread count.
+int conv_layer_f32(const float* in, int c_in, int h, int w,
+                   const float* k, int c_out, int ksize, float* out, conv_pool* pool);
+
+// Q8.8 layer with the numerics of a layer run on OurCONV one channel at a
+// time: each channel's plane comes out of conv2d_q88() (clamped like the
+// accelerator), the planes are summed in 32 bits and the sum is clamped
+// once more. overflow (may be NULL, c_out x h x w) gets 1 for every output
+// pixel that saturated at either step.
+int conv_layer_q88(const int16_t* in, int c_in, int h, int w,
+                   const int16_t* k, int c_out, int ksize, int16_t* out,
+                   uint8_t* overflow, conv_pool* pool);
+
+#endif
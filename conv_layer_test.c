@@ -0,0 +1,169 @@
+// Build: gcc -O2 -pthread -o conv_layer_test conv_layer_test.c conv_bench.c conv_layer.c conv_pool.c conv_tiles.c conv.c conv_simd.c
+//
+// Checks the multi-channel layer paths against per-channel loops and times
+// a 3x3, 64 -> 64 channel layer at 56x56.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "conv_bench.h"
+#include "conv_layer.h"
+#include "conv_pool.h"
+
+#define BENCH_SIZE 56
+#define BENCH_CHANNELS 64
+#define BENCH_RUNS 3
+
+// Channel-by-channel reference: float sums in ci order, Q8.8 planes
+// clamped per channel and once more after the 32-bit sum.
+static void layer_ref(const float* in, const int16_t* in_q, int c_in, int h, int w,
+                      const float* k, const int16_t* k_q, int c_out, int ksize,
+                      float* out, int16_t* out_q, uint8_t* ovf) {
+    size_t plane = (size_t)h * w, kk = (size_t)ksize * ksize;
+    float* part = malloc(sizeof(float) * plane);
+    int16_t* part_q = malloc(sizeof(int16_t) * plane);
+    uint8_t* part_ovf = malloc(plane);
+    int32_t* sum = malloc(sizeof(int32_t) * plane);
+
+    for (int co = 0; co < c_out; co++) {
+        float* o = out + co * plane;
+        memset(sum, 0, sizeof(int32_t) * plane);
+        memset(ovf + co * plane, 0, plane);
+        for (int ci = 0; ci < c_in; ci++) {
+            conv2d(in + ci * plane, h, w, k + (co * c_in + ci) * kk, ksize, part);
+            conv2d_q88(in_q + ci * plane, h, w, k_q + (co * c_in + ci) * kk, ksize, part_q, part_ovf);
+            for (size_t i = 0; i < plane; i++) {
+                o[i] = ci == 0 ? part[i] : o[i] + part[i];
+                sum[i] += part_q[i];
+                ovf[co * plane + i] |= part_ovf[i];
+            }
+        }
+        for (size_t i = 0; i < plane; i++) {
+            int32_t v = sum[i] > 32767 ? 32767 : sum[i] < -32768 ? -32768 : sum[i];
+            out_q[co * plane + i] = (int16_t)v;
+            ovf[co * plane + i] |= v != sum[i];
+        }
+    }
+    free(part);
+    free(part_q);
+    free(part_ovf);
+    free(sum);
+}
+
+static int check(int c_in, int c_out, int h, int w, int ksize, conv_pool* pool) {
+    size_t plane = (size_t)h * w, kk = (size_t)ksize * ksize;
+    size_t n_in = c_in * plane, n_out = c_out * plane, n_k = (size_t)c_out * c_in * kk;
+    float* in = malloc(sizeof(float) * n_in);
+    float* k = malloc(sizeof(float) * n_k);
+    int16_t* in_q = malloc(sizeof(int16_t) * n_in);
+    int16_t* k_q = malloc(sizeof(int16_t) * n_k);
+    float* ref = malloc(sizeof(float) * n_out);
+    float* got = malloc(sizeof(float) * n_out);
+    int16_t* ref_q = malloc(sizeof(int16_t) * n_out);
+    int16_t* got_q = malloc(sizeof(int16_t) * n_out);
+    uint8_t* ref_ovf = malloc(n_out);
+    uint8_t* got_ovf = malloc(n_out);
+    int bad = 0;
+
+    for (size_t i = 0; i < n_in; i++) {
+        in[i] = (float)(rand() % 4001 - 2000) / 256.0f;
+    }
+    for (size_t i = 0; i < n_k; i++) {
+        k[i] = (float)(rand() % 513 - 256) / 256.0f;
+    }
+    conv_f32_to_q88(in, (int)n_in, in_q);
+    conv_f32_to_q88(k, (int)n_k, k_q);
+    layer_ref(in, in_q, c_in, h, w, k, k_q, c_out, ksize, ref, ref_q, ref_ovf);
+
+    if (conv_layer_f32(in, c_in, h, w, k, c_out, ksize, got, pool) != CONV_OK ||
+        memcmp(ref, got, sizeof(float) * n_out) != 0) {
+        printf("MISMATCH layer_f32 %d->%d %dx%d k%d\n", c_in, c_out, h, w, ksize);
+        bad = 1;
+    }
+    if (conv_layer_q88(in_q, c_in, h, w, k_q, c_out, ksize, got_q, got_ovf, pool) != CONV_OK ||
+        memcmp(ref_q, got_q, sizeof(int16_t) * n_out) != 0 || memcmp(ref_ovf, got_ovf, n_out) != 0) {
+        printf("MISMATCH layer_q88 %d->%d %dx%d k%d\n", c_in, c_out, h, w, ksize);
+        bad = 1;
+    }
+
+    free(in);
+    free(k);
+    free(in_q);
+    free(k_q);
+    free(ref);
+    free(got);
+    free(ref_q);
+    free(got_q);
+    free(ref_ovf);
+    free(got_ovf);
+    return bad;
+}
+
+static void bench(conv_pool* pool) {
+    size_t plane = BENCH_SIZE * BENCH_SIZE;
+    size_t n_in = BENCH_CHANNELS * plane, n_k = (size_t)BENCH_CHANNELS * BENCH_CHANNELS * 9;
+    float* in = malloc(sizeof(float) * n_in);
+    float* k = malloc(sizeof(float) * n_k);
+    float* out = malloc(sizeof(float) * n_in);
+    int16_t* in_q = malloc(sizeof(int16_t) * n_in);
+    int16_t* k_q = malloc(sizeof(int16_t) * n_k);
+    int16_t* out_q = malloc(sizeof(int16_t) * n_in);
+    uint64_t best[3] = { UINT64_MAX, UINT64_MAX, UINT64_MAX };
+    double macs = (double)n_k * plane;
+
+    for (size_t i = 0; i < n_in; i++) {
+        in[i] = (float)((i * 7) % 23) * 0.25f;
+    }
+    for (size_t i = 0; i < n_k; i++) {
+        k[i] = (float)((int)(i % 11) - 5) / 64.0f;
+    }
+    conv_f32_to_q88(in, (int)n_in, in_q);
+    conv_f32_to_q88(k, (int)n_k, k_q);
+
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        uint64_t t0 = conv_bench_ns();
+        conv_layer_f32(in, BENCH_CHANNELS, BENCH_SIZE, BENCH_SIZE, k, BENCH_CHANNELS, 3, out, NULL);
+        uint64_t t1 = conv_bench_ns();
+        conv_layer_f32(in, BENCH_CHANNELS, BENCH_SIZE, BENCH_SIZE, k, BENCH_CHANNELS, 3, out, pool);
+        uint64_t t2 = conv_bench_ns();
+        conv_layer_q88(in_q, BENCH_CHANNELS, BENCH_SIZE, BENCH_SIZE, k_q, BENCH_CHANNELS, 3, out_q, NULL, pool);
+        uint64_t t3 = conv_bench_ns();
+        if (t1 - t0 < best[0]) best[0] = t1 - t0;
+        if (t2 - t1 < best[1]) best[1] = t2 - t1;
+        if (t3 - t2 < best[2]) best[2] = t3 - t2;
+    }
+    printf("%dx%d, 3x3, %d->%d layer: f32 %.2f ms (%.2f GMAC/s), f32 x%d threads %.2f ms (%.2f GMAC/s), "
+           "q88 x%d threads %.2f ms (%.2f GMAC/s)\n",
+           BENCH_SIZE, BENCH_SIZE, BENCH_CHANNELS, BENCH_CHANNELS,
+           best[0] / 1e6, macs / best[0], conv_pool_threads(pool), best[1] / 1e6, macs / best[1],
+           conv_pool_threads(pool), best[2] / 1e6, macs / best[2]);
+
+    free(in);
+    free(k);
+    free(out);
+    free(in_q);
+    free(k_q);
+    free(out_q);
+}
+
+int main() {
+    conv_pool* pool = conv_pool_create(0);
+    int bad = 0;
+
+    for (int ksize = 1; ksize <= 5; ksize += 2) {
+        bad |= check(3, 4, 24, 16, ksize, NULL);
+        bad |= check(5, 2, 9, 13, ksize, pool);
+    }
+    // Wide sums: 16 channels of large values saturate after accumulation
+    bad |= check(16, 3, 16, 16, 3, pool);
+    if (conv_layer_f32(NULL, 1, 8, 8, NULL, 1, 3, NULL, NULL) != CONV_EINVAL) {
+        printf("MISMATCH bad arguments accepted\n");
+        bad = 1;
+    }
+    printf("layer: %s\n", bad ? "MISMATCH" : "match");
+
+    bench(pool);
+    conv_pool_destroy(pool);
+    return bad;
+}
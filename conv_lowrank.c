@@ -0,0 +1,402 @@
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv_lowrank.h"
+#include "conv_simd.h"
+
+#define KMAX CONV_LOWRANK_MAX_K
+
+// Power iterations per singular pair. Kernels are at most 11x11, so this is
+// cheap, and a pair that has not converged after it is still a valid term:
+// the residual it leaves is measured, not assumed.
+#define LOWRANK_ITERATIONS 300
+
+// OurCONV MAC, as in conv.c
+#define Q88_MAC(kv, x) (((int32_t)(kv) * (int32_t)(x)) >> 8)
+
+static int16_t q88_round(double v) {
+    double x = v * 256.0;
+    x = x < 0 ? x - 0.5 : x + 0.5;
+    if (x >= 32767.0) {
+        return 32767;
+    }
+    if (x <= -32768.0) {
+        return -32768;
+    }
+    return (int16_t)(int32_t)x;
+}
+
+// Scale col up and row down (or the reverse) by powers of two until their
+// largest entries are within a factor of 2: exact in float and keeps both
+// factors clear of the Q8.8 range limits.
+static void balance(double* col, double* row, int K) {
+    double ca = 0.0, ra = 0.0;
+
+    for (int i = 0; i < K; i++) {
+        ca = fabs(col[i]) > ca ? fabs(col[i]) : ca;
+        ra = fabs(row[i]) > ra ? fabs(row[i]) : ra;
+    }
+    if (ca == 0.0 || ra == 0.0) {
+        return;
+    }
+    while (ra > 2.0 * ca || ca > 2.0 * ra) {
+        double s = ra > ca ? 2.0 : 0.5;
+        for (int i = 0; i < K; i++) {
+            col[i] *= s;
+            row[i] /= s;
+        }
+        ca *= s;
+        ra /= s;
+    }
+}
+
+// Appends col x row as the next term and subtracts it from the residual
+static void add_term(conv_lowrank* lr, double* col, double* row, double* res) {
+    int K = lr->ksize, r = lr->rank++;
+
+    balance(col, row, K);
+    for (int i = 0; i < K; i++) {
+        lr->col[r][i] = (float)col[i];
+        lr->row[r][i] = (float)row[i];
+        lr->col_q[r][i] = q88_round(col[i]);
+        lr->row_q[r][i] = q88_round(row[i]);
+    }
+    for (int m = 0; m < K; m++) {
+        for (int n = 0; n < K; n++) {
+            res[m * K + n] -= (double)lr->col[r][m] * lr->row[r][n];
+        }
+    }
+}
+
+// Leading singular pair of the K x K residual, by power iteration on
+// res^T res. col gets sigma * u, row gets v. Returns 0 for a zero residual.
+static int singular_pair(const double* res, int K, double* col, double* row) {
+    double v[KMAX], best = 0.0;
+
+    // Start from the largest row, which cannot be orthogonal to v1 unless
+    // every row is
+    for (int m = 0; m < K; m++) {
+        double norm = 0.0;
+        for (int n = 0; n < K; n++) {
+            norm += res[m * K + n] * res[m * K + n];
+        }
+        if (norm > best) {
+            best = norm;
+            memcpy(v, res + m * K, sizeof(double) * K);
+        }
+    }
+    if (best == 0.0) {
+        return 0;
+    }
+    for (int it = 0; it < LOWRANK_ITERATIONS; it++) {
+        double u[KMAX], norm = 0.0;
+        for (int m = 0; m < K; m++) {
+            u[m] = 0.0;
+            for (int n = 0; n < K; n++) {
+                u[m] += res[m * K + n] * v[n];
+            }
+        }
+        for (int n = 0; n < K; n++) {
+            v[n] = 0.0;
+            for (int m = 0; m < K; m++) {
+                v[n] += res[m * K + n] * u[m];
+            }
+            norm += v[n] * v[n];
+        }
+        if (norm == 0.0) {
+            return 0;
+        }
+        norm = sqrt(norm);
+        for (int n = 0; n < K; n++) {
+            v[n] /= norm;
+        }
+    }
+    for (int m = 0; m < K; m++) {
+        col[m] = 0.0;
+        for (int n = 0; n < K; n++) {
+            col[m] += res[m * K + n] * v[n];
+        }
+    }
+    memcpy(row, v, sizeof(double) * K);
+    return 1;
+}
+
+static void measure(const float* k, conv_lowrank* lr) {
+    int K = lr->ksize;
+    int16_t k_q[KMAX * KMAX];
+
+    conv_f32_to_q88(k, K * K, k_q);
+    lr->residual_l1 = 0.0;
+    lr->residual_q88 = 0.0;
+    lr->factor_l1 = 0.0;
+    lr->kernel_l1 = 0.0;
+    for (int m = 0; m < K; m++) {
+        for (int n = 0; n < K; n++) {
+            double sum = 0.0, sum_q = 0.0;
+            for (int r = 0; r < lr->rank; r++) {
+                sum += (double)lr->col[r][m] * lr->row[r][n];
+                sum_q += (double)lr->col_q[r][m] * lr->row_q[r][n] / 256.0;
+            }
+            lr->residual_l1 += fabs(k[m * K + n] - sum);
+            lr->residual_q88 += fabs(k_q[m * K + n] - sum_q);
+            lr->kernel_l1 += fabs(k[m * K + n]);
+        }
+    }
+    for (int r = 0; r < lr->rank; r++) {
+        double c = 0.0, w = 0.0;
+        for (int i = 0; i < K; i++) {
+            c += fabs(lr->col[r][i]);
+            w += fabs(lr->row[r][i]);
+        }
+        lr->factor_l1 += c * w;
+    }
+}
+
+// Exact rank-1 factoring through the largest tap (p, q): col is column q
+// over k[p][q], row is row p. Leaves lr at rank 1.
+static void factor_pivot(const float* k, conv_lowrank* lr, double* res) {
+    int K = lr->ksize, p = 0, q = 0;
+    double col[KMAX], row[KMAX];
+
+    for (int i = 0; i < K * K; i++) {
+        if (fabsf(k[i]) > fabsf(k[p * K + q])) {
+            p = i / K;
+            q = i % K;
+        }
+    }
+    for (int i = 0; i < K; i++) {
+        col[i] = (double)k[i * K + q] / k[p * K + q];
+        row[i] = k[p * K + i];
+    }
+    add_term(lr, col, row, res);
+}
+
+int conv_lowrank_decompose(const float* k, int ksize, int max_rank, float tol, conv_lowrank* lr) {
+    double res[KMAX * KMAX];
+
+    if (!k || !lr || ksize <= 0 || ksize % 2 == 0 || ksize > KMAX || max_rank < 1 || tol < 0.0f) {
+        return CONV_EINVAL;
+    }
+    memset(lr, 0, sizeof(*lr));
+    lr->ksize = ksize;
+    if (max_rank > ksize) {
+        max_rank = ksize;
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        res[i] = k[i];
+    }
+
+    // Separable kernels: one exact term
+    double l1 = 0.0;
+    for (int i = 0; i < ksize * ksize; i++) {
+        l1 += fabs(res[i]);
+    }
+    if (l1 == 0.0) {
+        measure(k, lr);
+        return CONV_OK;
+    }
+    factor_pivot(k, lr, res);
+    measure(k, lr);
+    if (lr->residual_l1 <= tol) {
+        return CONV_OK;
+    }
+
+    // Otherwise the leading singular terms until the residual is small enough
+    lr->rank = 0;
+    for (int i = 0; i < ksize * ksize; i++) {
+        res[i] = k[i];
+    }
+    while (lr->rank < max_rank) {
+        double col[KMAX], row[KMAX];
+        if (!singular_pair(res, ksize, col, row)) {
+            break;
+        }
+        add_term(lr, col, row, res);
+        measure(k, lr);
+        if (lr->residual_l1 <= tol) {
+            return CONV_OK;
+        }
+    }
+    return lr->residual_l1 <= tol ? CONV_OK : CONV_ERANGE;
+}
+
+// Output rows per strip: the row-pass results of a strip (plus the K - 1
+// halo rows) stay in cache for the column pass
+#define LOWRANK_STRIP 32
+
+// dst[j] (+)= sum of k[t] * src[t * step + j]: the vector path, then the rest
+static void taps(conv_taps_f32_fn vec, const float* src, ptrdiff_t step, const float* k, int K,
+                 float* dst, int n, int add) {
+    int j = vec ? vec(src, step, k, K, dst, n, add) : 0;
+
+    for (; j < n; j++) {
+        float sum = 0.0f;
+        for (int t = 0; t < K; t++) {
+            sum += k[t] * src[t * step + j];
+        }
+        dst[j] = add ? dst[j] + sum : sum;
+    }
+}
+
+// One image row correlated with the 1 x K row, zero padded
+static void row_pass(conv_taps_f32_fn vec, const float* src, int w, const float* row, int K, float* dst) {
+    int pad = K / 2;
+    int lo = pad < w ? pad : w;
+    int hi = w - pad > lo ? w - pad : lo;
+
+    for (int j = 0; j < w; j++) {
+        if (j == lo) {
+            j = hi; // interior below
+            if (j >= w) {
+                break;
+            }
+        }
+        int n0 = pad - j > 0 ? pad - j : 0;
+        int n1 = w + pad - j < K ? w + pad - j : K;
+        float sum = 0.0f;
+        for (int n = n0; n < n1; n++) {
+            sum += row[n] * src[j + n - pad];
+        }
+        dst[j] = sum;
+    }
+    taps(vec, src, 1, row, K, dst + lo, hi - lo, 0);
+}
+
+int conv2d_lowrank(const float* in, int h, int w, const conv_lowrank* lr, float* out) {
+    if (!in || !lr || !out || h <= 0 || w <= 0) {
+        return CONV_EINVAL;
+    }
+    int K = lr->ksize, pad = K / 2;
+    float* t = malloc(sizeof(float) * (LOWRANK_STRIP + K - 1) * w);
+    if (!t) {
+        return CONV_ENOMEM;
+    }
+    conv_taps_f32_fn vec = conv_simd_taps_f32(conv_isa());
+
+    if (lr->rank == 0) {
+        memset(out, 0, sizeof(float) * h * w);
+    }
+    for (int i0 = 0; i0 < h; i0 += LOWRANK_STRIP) {
+        int i1 = i0 + LOWRANK_STRIP < h ? i0 + LOWRANK_STRIP : h;
+        int x0 = i0 - pad > 0 ? i0 - pad : 0;
+        int x1 = i1 + pad < h ? i1 + pad : h;
+        for (int r = 0; r < lr->rank; r++) {
+            for (int x = x0; x < x1; x++) {
+                row_pass(vec, in + (size_t)x * w, w, lr->row[r], K, t + (size_t)(x - x0) * w);
+            }
+            // Column pass over the in-image taps of each output row
+            for (int i = i0; i < i1; i++) {
+                int m0 = pad - i > 0 ? pad - i : 0;
+                int m1 = h + pad - i < K ? h + pad - i : K;
+                taps(vec, t + (size_t)(i - pad + m0 - x0) * w, w, lr->col[r] + m0, m1 - m0,
+                     out + (size_t)i * w, w, r > 0);
+            }
+        }
+    }
+    free(t);
+    return CONV_OK;
+}
+
+static inline int16_t q88_clamp(int32_t acc, uint8_t* ovf) {
+    if (acc > 32767) {
+        *ovf = 1;
+        return 32767;
+    }
+    if (acc < -32768) {
+        *ovf = 1;
+        return -32768;
+    }
+    return (int16_t)acc;
+}
+
+int conv2d_lowrank_q88(const int16_t* in, int h, int w, const conv_lowrank* lr,
+                       int16_t* out, uint8_t* overflow) {
+    size_t plane = (size_t)h * w;
+
+    if (!in || !lr || !out || h <= 0 || w <= 0) {
+        return CONV_EINVAL;
+    }
+    int16_t* t = malloc(sizeof(int16_t) * plane);
+    int32_t* sum = calloc(plane, sizeof(int32_t));
+    uint8_t* ovf = calloc(plane, 1);
+    uint8_t* t_ovf = malloc(plane); // row-pass saturation of t
+    if (!t || !sum || !ovf || !t_ovf) {
+        free(t);
+        free(sum);
+        free(ovf);
+        free(t_ovf);
+        return CONV_ENOMEM;
+    }
+
+    int K = lr->ksize, pad = K / 2;
+    for (int r = 0; r < lr->rank; r++) {
+        const int16_t* row = lr->row_q[r];
+        const int16_t* col = lr->col_q[r];
+        memset(t_ovf, 0, plane);
+        for (int i = 0; i < h; i++) {
+            for (int j = 0; j < w; j++) {
+                int32_t acc = 0;
+                for (int n = 0; n < K; n++) {
+                    int y = j + n - pad;
+                    if (y >= 0 && y < w) {
+                        acc += Q88_MAC(row[n], in[(size_t)i * w + y]);
+                    }
+                }
+                t[(size_t)i * w + j] = q88_clamp(acc, &t_ovf[(size_t)i * w + j]);
+            }
+        }
+        for (int i = 0; i < h; i++) {
+            for (int j = 0; j < w; j++) {
+                int32_t acc = 0;
+                // A clamped t pixel taints every output its column taps reach
+                uint8_t tainted = 0;
+                for (int m = 0; m < K; m++) {
+                    int x = i + m - pad;
+                    if (x >= 0 && x < h) {
+                        acc += Q88_MAC(col[m], t[(size_t)x * w + j]);
+                        tainted |= t_ovf[(size_t)x * w + j];
+                    }
+                }
+                ovf[(size_t)i * w + j] |= tainted;
+                sum[(size_t)i * w + j] += q88_clamp(acc, &ovf[(size_t)i * w + j]);
+            }
+        }
+    }
+    for (size_t i = 0; i < plane; i++) {
+        out[i] = q88_clamp(sum[i], &ovf[i]);
+        if (overflow) {
+            overflow[i] = ovf[i];
+        }
+    }
+    free(t);
+    free(sum);
+    free(ovf);
+    free(t_ovf);
+    return CONV_OK;
+}
+
+double conv_lowrank_bound(const conv_lowrank* lr, double max_abs) {
+    int K = lr->ksize;
+    // float sums of at most K * K (direct) or K + K + rank (low-rank) terms
+    double rounding = 2.0 * (K * K + 2 * K + lr->rank) * FLT_EPSILON * (lr->kernel_l1 + lr->factor_l1);
+
+    return (lr->residual_l1 + rounding) * max_abs;
+}
+
+double conv_lowrank_q88_bound(const conv_lowrank* lr, int max_abs) {
+    int K = lr->ksize;
+    // Each floored product loses less than an LSB: K * K of them in the
+    // direct sum; per term K in the column pass, plus the K lost in each
+    // row-pass value scaled by the column taps
+    double bound = lr->residual_q88 * max_abs / 256.0 + K * K;
+
+    for (int r = 0; r < lr->rank; r++) {
+        double c = 0.0;
+        for (int i = 0; i < K; i++) {
+            c += abs(lr->col_q[r][i]);
+        }
+        bound += K + K * c / 256.0;
+    }
+    return bound;
+}
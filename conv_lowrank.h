@@ -0,0 +1,64 @@
+#ifndef CONV_LOWRANK_H
+#define CONV_LOWRANK_H
+
+// Separable and low-rank kernels.
+//
+// A ksize x ksize kernel of rank r is a sum of r outer products col x row,
+// so its "same" convolution is r pairs of 1-D passes: row (1 x ksize) across
+// every image row, then col (ksize x 1) down the result. That is 2 * ksize
+// MACs per pixel and term instead of ksize * ksize. Box, binomial Gaussian
+// and Sobel kernels are rank 1; others can be approximated by their leading
+// singular terms.
+//
+// Error bound: the decomposition reports residual_l1, the sum of
+// |k - sum of col x row| over the taps. For any image with |pixel| <= m
+//   |conv2d_lowrank() - conv2d()| <= conv_lowrank_bound(lr, m)
+// which is residual_l1 * m plus a float rounding allowance. The Q8.8 path
+// has the same kind of bound in LSBs against conv2d_q88() with the kernel
+// converted by conv_f32_to_q88(), from residual_q88 plus the truncation of
+// every product (see conv_lowrank_q88_bound()).
+
+#include <stdint.h>
+#include "conv.h"
+
+#define CONV_LOWRANK_MAX_K 11
+
+typedef struct {
+    int ksize;
+    int rank;                    // terms in use, 0 for an all-zero kernel
+    float col[CONV_LOWRANK_MAX_K][CONV_LOWRANK_MAX_K]; // col[r]: vertical factor of term r
+    float row[CONV_LOWRANK_MAX_K][CONV_LOWRANK_MAX_K]; // row[r]: horizontal factor
+    int16_t col_q[CONV_LOWRANK_MAX_K][CONV_LOWRANK_MAX_K]; // the factors in Q8.8
+    int16_t row_q[CONV_LOWRANK_MAX_K][CONV_LOWRANK_MAX_K];
+    double residual_l1;          // sum |k - reconstruction| of the float factors
+    double residual_q88;         // same for the Q8.8 factors, in Q8.8 units
+    double factor_l1;            // sum over terms of |col|_1 * |row|_1
+    double kernel_l1;            // sum |k|
+} conv_lowrank;
+
+// Decomposes an odd ksize x ksize kernel (up to CONV_LOWRANK_MAX_K) into
+// the fewest terms, at most max_rank, whose residual_l1 is <= tol. A rank-1
+// kernel is factored exactly through its largest tap; otherwise terms are
+// the leading singular pairs. Factors are balanced by powers of two so the
+// Q8.8 copies keep as many bits as the kernel allows. Returns CONV_OK, or
+// CONV_ERANGE with the max_rank approximation in lr when tol was not met.
+int conv_lowrank_decompose(const float* k, int ksize, int max_rank, float tol, conv_lowrank* lr);
+
+// "Same" convolution with the decomposed kernel, out is h x w.
+int conv2d_lowrank(const float* in, int h, int w, const conv_lowrank* lr, float* out);
+
+// Q8.8 with the OurCONV numerics of running each pass as its own
+// convolution: products floored, 32-bit sums clamped after every pass, the
+// terms summed in 32 bits and clamped once more. overflow (may be NULL) gets
+// 1 for every output pixel that saturated at any step.
+int conv2d_lowrank_q88(const int16_t* in, int h, int w, const conv_lowrank* lr,
+                       int16_t* out, uint8_t* overflow);
+
+// Largest |conv2d_lowrank() - conv2d()| over images with |pixel| <= max_abs.
+double conv_lowrank_bound(const conv_lowrank* lr, double max_abs);
+
+// Largest |conv2d_lowrank_q88() - conv2d_q88()| in LSBs over Q8.8 images with
+// |pixel| <= max_abs (in LSBs), provided nothing saturates.
+double conv_lowrank_q88_bound(const conv_lowrank* lr, int max_abs);
+
+#endif
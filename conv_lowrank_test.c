@@ -0,0 +1,178 @@
+// Build: gcc -O2 -o conv_lowrank_test conv_lowrank_test.c conv_bench.c conv_lowrank.c conv.c conv_simd.c -lm
+//
+// Checks that separable kernels are found at rank 1, that other kernels get
+// the rank their tolerance needs, and that the float and Q8.8 results stay
+// within the bounds of conv_lowrank.h, and that Q8.8 overflow flags reach
+// every output a saturated row pass feeds; then times separable 5x5 and 3x3
+// kernels against conv2d() at 1024x1024.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "conv_bench.h"
+#include "conv_lowrank.h"
+
+#define SIZE 61
+#define BENCH_SIZE 1024
+#define BENCH_RUNS 5
+
+// Decomposes k, expects `rank` terms, and compares both paths with the
+// direct convolution of a random image against the error bounds.
+static int check(const char* name, const float* k, int ksize, int max_rank, float tol,
+                 int expect_status, int expect_rank) {
+    static float in[SIZE * SIZE], ref[SIZE * SIZE], got[SIZE * SIZE];
+    static int16_t in_q[SIZE * SIZE], ref_q[SIZE * SIZE], got_q[SIZE * SIZE];
+    int16_t k_q[CONV_LOWRANK_MAX_K * CONV_LOWRANK_MAX_K];
+    conv_lowrank lr;
+    int bad = 0;
+
+    for (int i = 0; i < SIZE * SIZE; i++) {
+        in[i] = (float)(rand() % 2049 - 1024) / 256.0f;
+    }
+    conv_f32_to_q88(in, SIZE * SIZE, in_q);
+    conv_f32_to_q88(k, ksize * ksize, k_q);
+
+    int status = conv_lowrank_decompose(k, ksize, max_rank, tol, &lr);
+    if (status != expect_status || lr.rank != expect_rank) {
+        printf("MISMATCH %s: status %d rank %d, expected %d rank %d\n", name, status, lr.rank,
+               expect_status, expect_rank);
+        return 1;
+    }
+
+    // 2049 values in [-4, 4]: |pixel| <= 4, or 1024 LSBs
+    double bound = conv_lowrank_bound(&lr, 4.0), worst = 0.0;
+    conv2d(in, SIZE, SIZE, k, ksize, ref);
+    conv2d_lowrank(in, SIZE, SIZE, &lr, got);
+    for (int i = 0; i < SIZE * SIZE; i++) {
+        double d = ref[i] > got[i] ? ref[i] - got[i] : got[i] - ref[i];
+        worst = d > worst ? d : worst;
+    }
+    if (worst > bound) {
+        printf("MISMATCH %s: float error %g over bound %g\n", name, worst, bound);
+        bad = 1;
+    }
+
+    double bound_q = conv_lowrank_q88_bound(&lr, 1024), worst_q = 0.0;
+    conv2d_q88(in_q, SIZE, SIZE, k_q, ksize, ref_q, NULL);
+    conv2d_lowrank_q88(in_q, SIZE, SIZE, &lr, got_q, NULL);
+    for (int i = 0; i < SIZE * SIZE; i++) {
+        int d = abs(ref_q[i] - got_q[i]);
+        worst_q = d > worst_q ? d : worst_q;
+    }
+    if (worst_q > bound_q) {
+        printf("MISMATCH %s: Q8.8 error %g LSB over bound %g\n", name, worst_q, bound_q);
+        bad = 1;
+    }
+    if (!bad) {
+        printf("%s: rank %d, residual %.3g, error %.3g (bound %.3g), Q8.8 %g LSB (bound %.1f): match\n",
+               name, lr.rank, lr.residual_l1, worst, bound, worst_q, bound_q);
+    }
+    return bad;
+}
+
+// A row pass that saturates on one image row: every output whose column
+// taps read a clamped t pixel must be flagged, and nothing else.
+static int check_overflow(void) {
+    static int16_t in[SIZE * SIZE], out[SIZE * SIZE];
+    static uint8_t overflow[SIZE * SIZE];
+    conv_lowrank lr;
+    int bad = 0;
+
+    memset(&lr, 0, sizeof(lr));
+    lr.ksize = 3;
+    lr.rank = 1;
+    for (int n = 0; n < 3; n++) {
+        lr.row_q[0][n] = 256; // 1.0: three 62.5 pixels sum past the Q8.8 range
+        lr.col_q[0][n] = 64;  // 0.25: the column pass and the sum stay in range
+    }
+    for (int j = 0; j < SIZE; j++) {
+        in[20 * SIZE + j] = 16000;
+    }
+    conv2d_lowrank_q88(in, SIZE, SIZE, &lr, out, overflow);
+    for (int i = 0; i < SIZE; i++) {
+        for (int j = 0; j < SIZE; j++) {
+            // Edge columns only sum two pixels and do not clamp
+            int expect = i >= 19 && i <= 21 && j > 0 && j < SIZE - 1;
+            bad |= overflow[i * SIZE + j] != expect;
+        }
+    }
+    printf(bad ? "MISMATCH row-pass overflow flags\n" : "row-pass overflow flags: match\n");
+    return bad;
+}
+
+static void bench(const float* k, int ksize) {
+    float* in = malloc(sizeof(float) * BENCH_SIZE * BENCH_SIZE);
+    float* out = malloc(sizeof(float) * BENCH_SIZE * BENCH_SIZE);
+    uint64_t best_direct = UINT64_MAX, best_lowrank = UINT64_MAX;
+    conv_lowrank lr;
+
+    for (int i = 0; i < BENCH_SIZE * BENCH_SIZE; i++) {
+        in[i] = (float)((i * 7) % 23) * 0.25f;
+    }
+    conv_lowrank_decompose(k, ksize, 1, 1e-6f, &lr);
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        uint64_t t0 = conv_bench_ns();
+        conv2d(in, BENCH_SIZE, BENCH_SIZE, k, ksize, out);
+        uint64_t t1 = conv_bench_ns();
+        conv2d_lowrank(in, BENCH_SIZE, BENCH_SIZE, &lr, out);
+        uint64_t t2 = conv_bench_ns();
+        if (t1 - t0 < best_direct) best_direct = t1 - t0;
+        if (t2 - t1 < best_lowrank) best_lowrank = t2 - t1;
+    }
+    printf("%dx%d, separable %dx%d (%s): conv2d %.2f ms, two 1-D passes %.2f ms (%.2fx)\n",
+           BENCH_SIZE, BENCH_SIZE, ksize, ksize, conv_isa_name(conv_isa()),
+           best_direct / 1e6, best_lowrank / 1e6, (double)best_direct / best_lowrank);
+    free(in);
+    free(out);
+}
+
+int main() {
+    static const float sobel_x[9] = { -1, 0, 1, -2, 0, 2, -1, 0, 1 };
+    static const float box[9] = { 1 / 9.0f, 1 / 9.0f, 1 / 9.0f, 1 / 9.0f, 1 / 9.0f,
+                                  1 / 9.0f, 1 / 9.0f, 1 / 9.0f, 1 / 9.0f };
+    static const float binomial[5] = { 1, 4, 6, 4, 1 };
+    float gauss5[25], gauss7[49], sobel_xy[9], random5[25], zero[9] = { 0 };
+    int bad = 0;
+
+    for (int m = 0; m < 5; m++) {
+        for (int n = 0; n < 5; n++) {
+            gauss5[m * 5 + n] = binomial[m] * binomial[n] / 256.0f;
+        }
+    }
+    for (int m = 0; m < 7; m++) {
+        for (int n = 0; n < 7; n++) {
+            int dm = m - 3, dn = n - 3;
+            gauss7[m * 7 + n] = 1.0f / (1.0f + 0.25f * (dm * dm + dn * dn)); // not separable
+        }
+    }
+    for (int i = 0; i < 9; i++) {
+        sobel_xy[i] = sobel_x[i] + sobel_x[i % 3 * 3 + i / 3]; // Sobel X + Sobel Y: rank 2
+    }
+    for (int i = 0; i < 25; i++) {
+        random5[i] = (float)(rand() % 513 - 256) / 256.0f;
+    }
+
+    bad |= check("sobel x", sobel_x, 3, 1, 0.0f, CONV_OK, 1);
+    bad |= check("box 3x3", box, 3, 1, 1e-6f, CONV_OK, 1);
+    bad |= check("binomial 5x5", gauss5, 5, 1, 1e-6f, CONV_OK, 1);
+    bad |= check("zero", zero, 3, 1, 0.0f, CONV_OK, 0);
+    bad |= check("sobel x + y", sobel_xy, 3, 3, 1e-5f, CONV_OK, 2);
+    bad |= check("sobel x + y, rank 1", sobel_xy, 3, 1, 1e-5f, CONV_ERANGE, 1);
+    bad |= check("7x7 falloff, 1% of L1", gauss7, 7, 7, 0.2f, CONV_OK, 2);
+    bad |= check("random 5x5, exact", random5, 5, 5, 1e-4f, CONV_OK, 5);
+    bad |= check("random 5x5, rank 2", random5, 5, 2, 0.0f, CONV_ERANGE, 2);
+
+    conv_lowrank lr;
+    if (conv_lowrank_decompose(sobel_x, 4, 1, 0.0f, &lr) != CONV_EINVAL ||
+        conv_lowrank_decompose(sobel_x, 3, 0, 0.0f, &lr) != CONV_EINVAL) {
+        printf("MISMATCH bad arguments accepted\n");
+        bad = 1;
+    }
+    bad |= check_overflow();
+    printf("lowrank: %s\n", bad ? "MISMATCH" : "match");
+
+    bench(gauss5, 5);
+    bench(box, 3);
+    return bad;
+}
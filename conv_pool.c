@@ -0,0 +1,239 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "conv.h"
+#include "conv_tiles.h"
+#include "conv_pool.h"
+
+#define CACHE_LINE 64
+
+// Remaining task range of one worker, packed as begin | end << 32 so that an
+// owner pop and a thief steal are each a single compare-and-swap.
+#define RANGE(b, e) ((uint64_t)(uint32_t)(b) | (uint64_t)(uint32_t)(e) << 32)
+#define RANGE_BEGIN(r) ((int)(uint32_t)(r))
+#define RANGE_END(r) ((int)(uint32_t)((r) >> 32))
+
+typedef struct {
+    _Atomic uint64_t range;
+    struct conv_pool* pool;
+    int id;
+} __attribute__((aligned(CACHE_LINE))) conv_worker;
+
+struct conv_pool {
+    int nthreads;
+    pthread_t* threads;   // nthreads - 1 helpers
+    conv_worker* workers; // nthreads entries; worker 0 is whoever calls run
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    unsigned generation;  // bumped for every run
+    int busy;             // helpers still working on the current run
+    int shutdown;
+    conv_task_fn fn;
+    void* arg;
+};
+
+static int conv_pool_pop(conv_worker* w, int* idx) {
+    uint64_t r = atomic_load(&w->range);
+
+    while (RANGE_BEGIN(r) < RANGE_END(r)) {
+        if (atomic_compare_exchange_weak(&w->range, &r, RANGE(RANGE_BEGIN(r) + 1, RANGE_END(r)))) {
+            *idx = RANGE_BEGIN(r);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Take the back half of the first non-empty range after our own. Only called
+// once our own range is empty, so nobody else writes it meanwhile.
+static int conv_pool_steal(conv_pool* pool, int self) {
+    for (int o = 1; o < pool->nthreads; o++) {
+        conv_worker* victim = &pool->workers[(self + o) % pool->nthreads];
+        uint64_t r = atomic_load(&victim->range);
+
+        while (RANGE_BEGIN(r) < RANGE_END(r)) {
+            int b = RANGE_BEGIN(r);
+            int e = RANGE_END(r);
+            int mid = b + (e - b) / 2;
+            if (atomic_compare_exchange_weak(&victim->range, &r, RANGE(b, mid))) {
+                atomic_store(&pool->workers[self].range, RANGE(mid, e));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void conv_pool_work(conv_pool* pool, int self) {
+    int idx;
+
+    do {
+        while (conv_pool_pop(&pool->workers[self], &idx)) {
+            pool->fn(pool->arg, idx);
+        }
+    } while (conv_pool_steal(pool, self));
+}
+
+static void* conv_pool_helper(void* arg) {
+    conv_worker* w = arg;
+    conv_pool* pool = w->pool;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        conv_pool_work(pool, w->id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+conv_pool* conv_pool_create(int nthreads) {
+    if (nthreads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    conv_pool* pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->nthreads = nthreads;
+    pool->workers = aligned_alloc(CACHE_LINE, sizeof(conv_worker) * nthreads);
+    pool->threads = malloc(sizeof(pthread_t) * nthreads);
+    if (!pool->workers || !pool->threads) {
+        free(pool->workers);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (int i = 0; i < nthreads; i++) {
+        atomic_init(&pool->workers[i].range, RANGE(0, 0));
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+    }
+    for (int i = 1; i < nthreads; i++) {
+        if (pthread_create(&pool->threads[i - 1], NULL, conv_pool_helper, &pool->workers[i]) != 0) {
+            pool->nthreads = i; // only tear down what started
+            conv_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void conv_pool_destroy(conv_pool* pool) {
+    if (!pool) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->nthreads; i++) {
+        pthread_join(pool->threads[i - 1], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->idle);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
+
+int conv_pool_threads(const conv_pool* pool) {
+    return pool->nthreads;
+}
+
+void conv_pool_run(conv_pool* pool, int count, conv_task_fn fn, void* arg) {
+    int n = pool->nthreads;
+
+    if (count <= 0) {
+        return;
+    }
+    if (n == 1) {
+        for (int idx = 0; idx < count; idx++) {
+            fn(arg, idx);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    for (int i = 0; i < n; i++) {
+        int b = (int)((long long)count * i / n);
+        int e = (int)((long long)count * (i + 1) / n);
+        atomic_store(&pool->workers[i].range, RANGE(b, e));
+    }
+    pool->busy = n - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    conv_pool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+typedef struct {
+    const float* in;
+    const float* k;
+    float* out;
+    conv_tiling tiling;
+} conv2d_tiled_job;
+
+static void conv2d_tiled_run(void* arg, int idx) {
+    conv2d_tiled_job* job = arg;
+    conv_tile tile;
+
+    conv_tile_at(&job->tiling, idx, &tile);
+    conv2d_region(job->in, job->tiling.h, job->tiling.w, job->k, job->tiling.ksize, NULL, job->out,
+                  tile.out_row, tile.out_row + tile.out_rows,
+                  tile.out_col, tile.out_col + tile.out_cols);
+}
+
+int conv2d_tiled(const float* in, int h, int w, const float* k, int ksize,
+                 float* out, int tile_size, conv_pool* pool) {
+    conv2d_tiled_job job = { in, k, out, { 0 } };
+
+    if (!in || !k || !out || conv_tiling_init(&job.tiling, h, w, ksize, tile_size) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+
+    int count = conv_tiling_count(&job.tiling);
+    conv_isa(); // pick the vector path once, before the workers look it up
+    if (pool) {
+        conv_pool_run(pool, count, conv2d_tiled_run, &job);
+    } else {
+        for (int idx = 0; idx < count; idx++) {
+            conv2d_tiled_run(&job, idx);
+        }
+    }
+    return CONV_OK;
+}
@@ -0,0 +1,34 @@
+#ifndef CONV_POOL_H
+#define CONV_POOL_H
+
+// Fixed-size thread pool for the host convolution paths.
+//
+// conv_pool_run() hands every worker an equal, contiguous range of task
+// indices. A worker that runs out steals the back half of another worker's
+// remaining range, so uneven tiles (border vs interior, cache misses) still
+// balance without a shared queue.
+
+typedef struct conv_pool conv_pool;
+
+typedef void (*conv_task_fn)(void* arg, int idx);
+
+// nthreads <= 0 uses one thread per online CPU. The calling thread counts as
+// one of them. Returns NULL if the threads cannot be created.
+conv_pool* conv_pool_create(int nthreads);
+void conv_pool_destroy(conv_pool* pool);
+
+int conv_pool_threads(const conv_pool* pool);
+
+// Runs fn(arg, idx) for every idx in [0, count) and returns once all are done.
+// Not reentrant: one run per pool at a time.
+void conv_pool_run(conv_pool* pool, int count, conv_task_fn fn, void* arg);
+
+// conv2d() computed tile by tile using the conv_tiles.h decomposition. The
+// tiles are spread over the pool's threads; every output pixel is still
+// computed by exactly one tile with the same arithmetic, so the result is
+// identical for any thread count and bit-identical to conv2d(). pool may be
+// NULL to run on the calling thread.
+int conv2d_tiled(const float* in, int h, int w, const float* k, int ksize,
+                 float* out, int tile_size, conv_pool* pool);
+
+#endif
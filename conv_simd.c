@@ -0,0 +1,640 @@
+#include <stddef.h>
+#include "conv.h"
+#include "conv_simd.h"
+
+// Float paths use a separate multiply and add (never FMA) and sum each
+// pixel's taps in (m, n) order, so they stay bit-identical to the scalar
+// code. Fixed-point paths reproduce the OurCONV datapath: 32-bit product,
+// arithmetic shift right by 8 per tap, 32-bit sum, clamp to int16.
+//
+// The x86 paths are compiled with per-function target attributes so this
+// file builds without -mavx2 and the choice is made at run time.
+
+#define SIMD_INLINE static inline __attribute__((always_inline))
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+#define TARGET_SSE4 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+// ---------------------------------------------------------------- AVX2 float
+
+SIMD_INLINE TARGET_AVX2 int rows_f32_avx2(const float* in, int w, const float* k, const int K,
+                                          int pad, float* out, int ow,
+                                          int i0, int i1, int j0, int j1) {
+    int cols = (j1 - j0 + 1) / 8 * 8;
+    __m256 kv[25];
+
+    for (int t = 0; t < K * K; t++) {
+        kv[t] = _mm256_set1_ps(k[t]);
+    }
+    for (int i = i0; i <= i1; i++) {
+        const float* base = in + (size_t)(i - pad) * w - pad;
+        float* o = out + (size_t)i * ow;
+        int j = j0;
+
+        // Each pixel's adds form a serial chain, so run four independent
+        // 8-pixel chains side by side to cover the add latency.
+        for (; j + 32 <= j0 + cols; j += 32) {
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            __m256 acc2 = _mm256_setzero_ps();
+            __m256 acc3 = _mm256_setzero_ps();
+            for (int m = 0; m < K; m++) {
+                const float* row = base + (size_t)m * w + j;
+                for (int n = 0; n < K; n++) {
+                    __m256 kt = kv[m * K + n];
+                    acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(kt, _mm256_loadu_ps(row + n)));
+                    acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(kt, _mm256_loadu_ps(row + n + 8)));
+                    acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(kt, _mm256_loadu_ps(row + n + 16)));
+                    acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(kt, _mm256_loadu_ps(row + n + 24)));
+                }
+            }
+            _mm256_storeu_ps(o + j, acc0);
+            _mm256_storeu_ps(o + j + 8, acc1);
+            _mm256_storeu_ps(o + j + 16, acc2);
+            _mm256_storeu_ps(o + j + 24, acc3);
+        }
+        for (; j < j0 + cols; j += 8) {
+            __m256 acc = _mm256_setzero_ps();
+            for (int m = 0; m < K; m++) {
+                const float* row = base + (size_t)m * w + j;
+                for (int n = 0; n < K; n++) {
+                    acc = _mm256_add_ps(acc, _mm256_mul_ps(kv[m * K + n], _mm256_loadu_ps(row + n)));
+                }
+            }
+            _mm256_storeu_ps(o + j, acc);
+        }
+    }
+    return cols;
+}
+
+static TARGET_AVX2 int rows_f32_avx2_k3(const float* in, int w, const float* k, int pad,
+                                        float* out, int ow, int i0, int i1, int j0, int j1) {
+    return rows_f32_avx2(in, w, k, 3, pad, out, ow, i0, i1, j0, j1);
+}
+
+static TARGET_AVX2 int rows_f32_avx2_k5(const float* in, int w, const float* k, int pad,
+                                        float* out, int ow, int i0, int i1, int j0, int j1) {
+    return rows_f32_avx2(in, w, k, 5, pad, out, ow, i0, i1, j0, j1);
+}
+
+// ----------------------------------------------------------------- SSE float
+
+SIMD_INLINE TARGET_SSE4 int rows_f32_sse(const float* in, int w, const float* k, const int K,
+                                         int pad, float* out, int ow,
+                                         int i0, int i1, int j0, int j1) {
+    int cols = (j1 - j0 + 1) / 4 * 4;
+    __m128 kv[25];
+
+    for (int t = 0; t < K * K; t++) {
+        kv[t] = _mm_set1_ps(k[t]);
+    }
+    for (int i = i0; i <= i1; i++) {
+        const float* base = in + (size_t)(i - pad) * w - pad;
+        float* o = out + (size_t)i * ow;
+        int j = j0;
+
+        for (; j + 16 <= j0 + cols; j += 16) {
+            __m128 acc0 = _mm_setzero_ps();
+            __m128 acc1 = _mm_setzero_ps();
+            __m128 acc2 = _mm_setzero_ps();
+            __m128 acc3 = _mm_setzero_ps();
+            for (int m = 0; m < K; m++) {
+                const float* row = base + (size_t)m * w + j;
+                for (int n = 0; n < K; n++) {
+                    __m128 kt = kv[m * K + n];
+                    acc0 = _mm_add_ps(acc0, _mm_mul_ps(kt, _mm_loadu_ps(row + n)));
+                    acc1 = _mm_add_ps(acc1, _mm_mul_ps(kt, _mm_loadu_ps(row + n + 4)));
+                    acc2 = _mm_add_ps(acc2, _mm_mul_ps(kt, _mm_loadu_ps(row + n + 8)));
+                    acc3 = _mm_add_ps(acc3, _mm_mul_ps(kt, _mm_loadu_ps(row + n + 12)));
+                }
+            }
+            _mm_storeu_ps(o + j, acc0);
+            _mm_storeu_ps(o + j + 4, acc1);
+            _mm_storeu_ps(o + j + 8, acc2);
+            _mm_storeu_ps(o + j + 12, acc3);
+        }
+        for (; j < j0 + cols; j += 4) {
+            __m128 acc = _mm_setzero_ps();
+            for (int m = 0; m < K; m++) {
+                const float* row = base + (size_t)m * w + j;
+                for (int n = 0; n < K; n++) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(kv[m * K + n], _mm_loadu_ps(row + n)));
+                }
+            }
+            _mm_storeu_ps(o + j, acc);
+        }
+    }
+    return cols;
+}
+
+static TARGET_SSE4 int rows_f32_sse_k3(const float* in, int w, const float* k, int pad,
+                                       float* out, int ow, int i0, int i1, int j0, int j1) {
+    return rows_f32_sse(in, w, k, 3, pad, out, ow, i0, i1, j0, j1);
+}
+
+static TARGET_SSE4 int rows_f32_sse_k5(const float* in, int w, const float* k, int pad,
+                                       float* out, int ow, int i0, int i1, int j0, int j1) {
+    return rows_f32_sse(in, w, k, 5, pad, out, ow, i0, i1, j0, j1);
+}
+
+// ---------------------------------------------------------- AVX2 fixed point
+
+// 16 pixels per iteration: two 8 x int32 accumulators, packed back to int16
+// with signed saturation, which is exactly the OurCONV clamp.
+SIMD_INLINE TARGET_AVX2 int rows_q88_avx2(const int16_t* in, int w, const int16_t* k, const int K,
+                                          int pad, int16_t* out, uint8_t* overflow, int ow,
+                                          int i0, int i1, int j0, int j1) {
+    int cols = (j1 - j0 + 1) / 16 * 16;
+    const __m256i max = _mm256_set1_epi32(32767);
+    const __m256i min = _mm256_set1_epi32(-32768);
+    __m256i kv[25];
+
+    for (int t = 0; t < K * K; t++) {
+        kv[t] = _mm256_set1_epi32(k[t]);
+    }
+    for (int i = i0; i <= i1; i++) {
+        const int16_t* base = in + (size_t)(i - pad) * w - pad;
+        int16_t* o = out + (size_t)i * ow;
+        for (int j = j0; j < j0 + cols; j += 16) {
+            __m256i lo = _mm256_setzero_si256();
+            __m256i hi = _mm256_setzero_si256();
+            for (int m = 0; m < K; m++) {
+                const int16_t* row = base + (size_t)m * w + j;
+                for (int n = 0; n < K; n++) {
+                    __m256i x = _mm256_loadu_si256((const __m256i*)(row + n));
+                    __m256i xl = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(x));
+                    __m256i xh = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(x, 1));
+                    lo = _mm256_add_epi32(lo, _mm256_srai_epi32(_mm256_mullo_epi32(xl, kv[m * K + n]), 8));
+                    hi = _mm256_add_epi32(hi, _mm256_srai_epi32(_mm256_mullo_epi32(xh, kv[m * K + n]), 8));
+                }
+            }
+            // packs interleaves 128-bit lanes; permute restores pixel order
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+            _mm256_storeu_si256((__m256i*)(o + j), packed);
+
+            if (overflow) {
+                __m256i ovf_lo = _mm256_or_si256(_mm256_cmpgt_epi32(lo, max), _mm256_cmpgt_epi32(min, lo));
+                __m256i ovf_hi = _mm256_or_si256(_mm256_cmpgt_epi32(hi, max), _mm256_cmpgt_epi32(min, hi));
+                unsigned bits = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(ovf_lo)) |
+                                (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(ovf_hi)) << 8;
+                uint8_t* ob = overflow + (size_t)i * ow + j;
+                for (int t = 0; t < 16; t++) {
+                    ob[t] = (bits >> t) & 1;
+                }
+            }
+        }
+    }
+    return cols;
+}
+
+static TARGET_AVX2 int rows_q88_avx2_k3(const int16_t* in, int w, const int16_t* k, int pad,
+                                        int16_t* out, uint8_t* overflow, int ow,
+                                        int i0, int i1, int j0, int j1) {
+    return rows_q88_avx2(in, w, k, 3, pad, out, overflow, ow, i0, i1, j0, j1);
+}
+
+static TARGET_AVX2 int rows_q88_avx2_k5(const int16_t* in, int w, const int16_t* k, int pad,
+                                        int16_t* out, uint8_t* overflow, int ow,
+                                        int i0, int i1, int j0, int j1) {
+    return rows_q88_avx2(in, w, k, 5, pad, out, overflow, ow, i0, i1, j0, j1);
+}
+
+// -------------------------------------------------------- SSE4.1 fixed point
+
+SIMD_INLINE TARGET_SSE4 int rows_q88_sse4(const int16_t* in, int w, const int16_t* k, const int K,
+                                          int pad, int16_t* out, uint8_t* overflow, int ow,
+                                          int i0, int i1, int j0, int j1) {
+    int cols = (j1 - j0 + 1) / 8 * 8;
+    const __m128i max = _mm_set1_epi32(32767);
+    const __m128i min = _mm_set1_epi32(-32768);
+    __m128i kv[25];
+
+    for (int t = 0; t < K * K; t++) {
+        kv[t] = _mm_set1_epi32(k[t]);
+    }
+    for (int i = i0; i <= i1; i++) {
+        const int16_t* base = in + (size_t)(i - pad) * w - pad;
+        int16_t* o = out + (size_t)i * ow;
+        for (int j = j0; j < j0 + cols; j += 8) {
+            __m128i lo = _mm_setzero_si128();
+            __m128i hi = _mm_setzero_si128();
+            for (int m = 0; m < K; m++) {
+                const int16_t* row = base + (size_t)m * w + j;
+                for (int n = 0; n < K; n++) {
+                    __m128i x = _mm_loadu_si128((const __m128i*)(row + n));
+                    __m128i xl = _mm_cvtepi16_epi32(x);
+                    __m128i xh = _mm_cvtepi16_epi32(_mm_srli_si128(x, 8));
+                    lo = _mm_add_epi32(lo, _mm_srai_epi32(_mm_mullo_epi32(xl, kv[m * K + n]), 8));
+                    hi = _mm_add_epi32(hi, _mm_srai_epi32(_mm_mullo_epi32(xh, kv[m * K + n]), 8));
+                }
+            }
+            _mm_storeu_si128((__m128i*)(o + j), _mm_packs_epi32(lo, hi));
+
+            if (overflow) {
+                __m128i ovf_lo = _mm_or_si128(_mm_cmpgt_epi32(lo, max), _mm_cmplt_epi32(lo, min));
+                __m128i ovf_hi = _mm_or_si128(_mm_cmpgt_epi32(hi, max), _mm_cmplt_epi32(hi, min));
+                unsigned bits = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(ovf_lo)) |
+                                (unsigned)_mm_movemask_ps(_mm_castsi128_ps(ovf_hi)) << 4;
+                uint8_t* ob = overflow + (size_t)i * ow + j;
+                for (int t = 0; t < 8; t++) {
+                    ob[t] = (bits >> t) & 1;
+                }
+            }
+        }
+    }
+    return cols;
+}
+
+static TARGET_SSE4 int rows_q88_sse4_k3(const int16_t* in, int w, const int16_t* k, int pad,
+                                        int16_t* out, uint8_t* overflow, int ow,
+                                        int i0, int i1, int j0, int j1) {
+    return rows_q88_sse4(in, w, k, 3, pad, out, overflow, ow, i0, i1, j0, j1);
+}
+
+static TARGET_SSE4 int rows_q88_sse4_k5(const int16_t* in, int w, const int16_t* k, int pad,
+                                        int16_t* out, uint8_t* overflow, int ow,
+                                        int i0, int i1, int j0, int j1) {
+    return rows_q88_sse4(in, w, k, 5, pad, out, overflow, ow, i0, i1, j0, j1);
+}
+
+// ------------------------------------------------------------- 1-D taps
+
+// Four independent 8-wide chains per step, as in rows_f32_avx2
+static TARGET_AVX2 int taps_f32_avx2(const float* src, ptrdiff_t step, const float* k, int K,
+                                     float* dst, int n, int add) {
+    __m256 kv[CONV_TAPS_MAX];
+    int j = 0;
+
+    if (K > CONV_TAPS_MAX) {
+        return 0;
+    }
+    for (int t = 0; t < K; t++) {
+        kv[t] = _mm256_set1_ps(k[t]);
+    }
+    for (; j + 32 <= n; j += 32) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        for (int t = 0; t < K; t++) {
+            const float* s = src + t * step + j;
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(kv[t], _mm256_loadu_ps(s)));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(kv[t], _mm256_loadu_ps(s + 8)));
+            acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(kv[t], _mm256_loadu_ps(s + 16)));
+            acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(kv[t], _mm256_loadu_ps(s + 24)));
+        }
+        if (add) {
+            acc0 = _mm256_add_ps(_mm256_loadu_ps(dst + j), acc0);
+            acc1 = _mm256_add_ps(_mm256_loadu_ps(dst + j + 8), acc1);
+            acc2 = _mm256_add_ps(_mm256_loadu_ps(dst + j + 16), acc2);
+            acc3 = _mm256_add_ps(_mm256_loadu_ps(dst + j + 24), acc3);
+        }
+        _mm256_storeu_ps(dst + j, acc0);
+        _mm256_storeu_ps(dst + j + 8, acc1);
+        _mm256_storeu_ps(dst + j + 16, acc2);
+        _mm256_storeu_ps(dst + j + 24, acc3);
+    }
+    for (; j + 8 <= n; j += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        for (int t = 0; t < K; t++) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(kv[t], _mm256_loadu_ps(src + t * step + j)));
+        }
+        if (add) {
+            acc = _mm256_add_ps(_mm256_loadu_ps(dst + j), acc);
+        }
+        _mm256_storeu_ps(dst + j, acc);
+    }
+    return j;
+}
+
+static TARGET_SSE4 int taps_f32_sse(const float* src, ptrdiff_t step, const float* k, int K,
+                                    float* dst, int n, int add) {
+    __m128 kv[CONV_TAPS_MAX];
+    int j = 0;
+
+    if (K > CONV_TAPS_MAX) {
+        return 0;
+    }
+    for (int t = 0; t < K; t++) {
+        kv[t] = _mm_set1_ps(k[t]);
+    }
+    for (; j + 16 <= n; j += 16) {
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        __m128 acc2 = _mm_setzero_ps();
+        __m128 acc3 = _mm_setzero_ps();
+        for (int t = 0; t < K; t++) {
+            const float* s = src + t * step + j;
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(kv[t], _mm_loadu_ps(s)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(kv[t], _mm_loadu_ps(s + 4)));
+            acc2 = _mm_add_ps(acc2, _mm_mul_ps(kv[t], _mm_loadu_ps(s + 8)));
+            acc3 = _mm_add_ps(acc3, _mm_mul_ps(kv[t], _mm_loadu_ps(s + 12)));
+        }
+        if (add) {
+            acc0 = _mm_add_ps(_mm_loadu_ps(dst + j), acc0);
+            acc1 = _mm_add_ps(_mm_loadu_ps(dst + j + 4), acc1);
+            acc2 = _mm_add_ps(_mm_loadu_ps(dst + j + 8), acc2);
+            acc3 = _mm_add_ps(_mm_loadu_ps(dst + j + 12), acc3);
+        }
+        _mm_storeu_ps(dst + j, acc0);
+        _mm_storeu_ps(dst + j + 4, acc1);
+        _mm_storeu_ps(dst + j + 8, acc2);
+        _mm_storeu_ps(dst + j + 12, acc3);
+    }
+    return j;
+}
+
+// ------------------------------------------------------ float <-> Q8.8 cvt
+
+// Clamp in float before truncating: max(x, lo) returns lo for NaN, like the
+// scalar code. Out-of-range lanes are counted from the unclamped compares.
+static TARGET_AVX2 int cvt_f32_q88_avx2(const float* src, int n, int16_t* dst, int* clamped) {
+    const __m256 scale = _mm256_set1_ps(256.0f);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    const __m256 below = _mm256_set1_ps(-32769.0f);
+    const __m256 above = _mm256_set1_ps(32768.0f);
+    int count = 0;
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m256 x0 = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        __m256 x1 = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale);
+        __m256 bad0 = _mm256_or_ps(_mm256_cmp_ps(x0, below, _CMP_NGT_UQ), _mm256_cmp_ps(x0, above, _CMP_GE_OQ));
+        __m256 bad1 = _mm256_or_ps(_mm256_cmp_ps(x1, below, _CMP_NGT_UQ), _mm256_cmp_ps(x1, above, _CMP_GE_OQ));
+        count += __builtin_popcount((unsigned)_mm256_movemask_ps(bad0)) +
+                 __builtin_popcount((unsigned)_mm256_movemask_ps(bad1));
+        __m256i v0 = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(x0, lo), hi));
+        __m256i v1 = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(x1, lo), hi));
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(v0, v1), 0xD8);
+        _mm256_storeu_si256((__m256i*)(dst + i), packed);
+    }
+    // Tile rows are only 8-12 values long, so do a half step too
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        __m256 bad = _mm256_or_ps(_mm256_cmp_ps(x, below, _CMP_NGT_UQ), _mm256_cmp_ps(x, above, _CMP_GE_OQ));
+        count += __builtin_popcount((unsigned)_mm256_movemask_ps(bad));
+        __m256i v = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(x, lo), hi));
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storeu_si128((__m128i*)(dst + i), packed);
+    }
+    *clamped += count;
+    return i;
+}
+
+static TARGET_AVX2 int cvt_q88_f32_avx2(const int16_t* src, int n, float* dst) {
+    const __m256 scale = _mm256_set1_ps(1.0f / 256.0f);
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    return i;
+}
+
+static TARGET_SSE4 int cvt_f32_q88_sse4(const float* src, int n, int16_t* dst, int* clamped) {
+    const __m128 scale = _mm_set1_ps(256.0f);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    const __m128 below = _mm_set1_ps(-32769.0f);
+    const __m128 above = _mm_set1_ps(32768.0f);
+    int count = 0;
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128 x0 = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        __m128 x1 = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+        __m128 bad0 = _mm_or_ps(_mm_cmpngt_ps(x0, below), _mm_cmpge_ps(x0, above));
+        __m128 bad1 = _mm_or_ps(_mm_cmpngt_ps(x1, below), _mm_cmpge_ps(x1, above));
+        count += __builtin_popcount((unsigned)_mm_movemask_ps(bad0)) +
+                 __builtin_popcount((unsigned)_mm_movemask_ps(bad1));
+        __m128i v0 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(x0, lo), hi));
+        __m128i v1 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(x1, lo), hi));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(v0, v1));
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        __m128 bad = _mm_or_ps(_mm_cmpngt_ps(x, below), _mm_cmpge_ps(x, above));
+        count += __builtin_popcount((unsigned)_mm_movemask_ps(bad));
+        __m128i v = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(x, lo), hi));
+        _mm_storel_epi64((__m128i*)(dst + i), _mm_packs_epi32(v, v));
+    }
+    *clamped += count;
+    return i;
+}
+
+static TARGET_SSE4 int cvt_q88_f32_sse4(const int16_t* src, int n, float* dst) {
+    const __m128 scale = _mm_set1_ps(1.0f / 256.0f);
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    return i;
+}
+
+unsigned conv_simd_supported(void) {
+    unsigned isas = 1u << CONV_ISA_SCALAR;
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) {
+        isas |= 1u << CONV_ISA_SSE;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        isas |= 1u << CONV_ISA_AVX2;
+    }
+    return isas;
+}
+
+conv_rows_f32_fn conv_simd_rows_f32(int isa, int ksize) {
+    if (isa == CONV_ISA_AVX2) {
+        return ksize == 3 ? rows_f32_avx2_k3 : ksize == 5 ? rows_f32_avx2_k5 : NULL;
+    }
+    if (isa == CONV_ISA_SSE) {
+        return ksize == 3 ? rows_f32_sse_k3 : ksize == 5 ? rows_f32_sse_k5 : NULL;
+    }
+    return NULL;
+}
+
+conv_rows_q88_fn conv_simd_rows_q88(int isa, int ksize) {
+    if (isa == CONV_ISA_AVX2) {
+        return ksize == 3 ? rows_q88_avx2_k3 : ksize == 5 ? rows_q88_avx2_k5 : NULL;
+    }
+    if (isa == CONV_ISA_SSE) {
+        return ksize == 3 ? rows_q88_sse4_k3 : ksize == 5 ? rows_q88_sse4_k5 : NULL;
+    }
+    return NULL;
+}
+
+conv_taps_f32_fn conv_simd_taps_f32(int isa) {
+    return isa == CONV_ISA_AVX2 ? taps_f32_avx2 : isa == CONV_ISA_SSE ? taps_f32_sse : NULL;
+}
+
+conv_cvt_f32_q88_fn conv_simd_cvt_f32_q88(int isa) {
+    return isa == CONV_ISA_AVX2 ? cvt_f32_q88_avx2 : isa == CONV_ISA_SSE ? cvt_f32_q88_sse4 : NULL;
+}
+
+conv_cvt_q88_f32_fn conv_simd_cvt_q88_f32(int isa) {
+    return isa == CONV_ISA_AVX2 ? cvt_q88_f32_avx2 : isa == CONV_ISA_SSE ? cvt_q88_f32_sse4 : NULL;
+}
+
+#elif defined(__riscv_v_intrinsic)
+#include <riscv_vector.h>
+
+// ----------------------------------------------------------------- RVV float
+
+// Vector-length agnostic: vsetvl covers the row tail, so every column is done.
+SIMD_INLINE int rows_f32_rvv(const float* in, int w, const float* k, const int K,
+                             int pad, float* out, int ow,
+                             int i0, int i1, int j0, int j1) {
+    for (int i = i0; i <= i1; i++) {
+        const float* base = in + (size_t)(i - pad) * w - pad;
+        float* o = out + (size_t)i * ow;
+        size_t vl;
+        for (int j = j0; j <= j1; j += (int)vl) {
+            vl = __riscv_vsetvl_e32m2((size_t)(j1 - j + 1));
+            vfloat32m2_t acc = __riscv_vfmv_v_f_f32m2(0.0f, vl);
+            for (int m = 0; m < K; m++) {
+                const float* row = base + (size_t)m * w + j;
+                for (int n = 0; n < K; n++) {
+                    vfloat32m2_t x = __riscv_vle32_v_f32m2(row + n, vl);
+                    acc = __riscv_vfadd_vv_f32m2(acc, __riscv_vfmul_vf_f32m2(x, k[m * K + n], vl), vl);
+                }
+            }
+            __riscv_vse32_v_f32m2(o + j, acc, vl);
+        }
+    }
+    return j1 - j0 + 1;
+}
+
+static int rows_f32_rvv_k3(const float* in, int w, const float* k, int pad,
+                           float* out, int ow, int i0, int i1, int j0, int j1) {
+    return rows_f32_rvv(in, w, k, 3, pad, out, ow, i0, i1, j0, j1);
+}
+
+static int rows_f32_rvv_k5(const float* in, int w, const float* k, int pad,
+                           float* out, int ow, int i0, int i1, int j0, int j1) {
+    return rows_f32_rvv(in, w, k, 5, pad, out, ow, i0, i1, j0, j1);
+}
+
+// ------------------------------------------------------------- 1-D taps
+
+static int taps_f32_rvv(const float* src, ptrdiff_t step, const float* k, int K,
+                        float* dst, int n, int add) {
+    size_t vl;
+
+    for (int j = 0; j < n; j += (int)vl) {
+        vl = __riscv_vsetvl_e32m4((size_t)(n - j));
+        vfloat32m4_t acc = __riscv_vfmv_v_f_f32m4(0.0f, vl);
+        for (int t = 0; t < K; t++) {
+            vfloat32m4_t x = __riscv_vle32_v_f32m4(src + t * step + j, vl);
+            acc = __riscv_vfadd_vv_f32m4(acc, __riscv_vfmul_vf_f32m4(x, k[t], vl), vl);
+        }
+        if (add) {
+            acc = __riscv_vfadd_vv_f32m4(__riscv_vle32_v_f32m4(dst + j, vl), acc, vl);
+        }
+        __riscv_vse32_v_f32m4(dst + j, acc, vl);
+    }
+    return n;
+}
+
+// ------------------------------------------------------ float <-> Q8.8 cvt
+
+static int cvt_f32_q88_rvv(const float* src, int n, int16_t* dst, int* clamped) {
+    size_t vl;
+    int count = 0;
+
+    for (int i = 0; i < n; i += (int)vl) {
+        vl = __riscv_vsetvl_e32m4((size_t)(n - i));
+        vfloat32m4_t x = __riscv_vfmul_vf_f32m4(__riscv_vle32_v_f32m4(src + i, vl), 256.0f, vl);
+        // NaN: vmfgt is false (counted), vfmax returns the non-NaN operand
+        vbool8_t ok_lo = __riscv_vmfgt_vf_f32m4_b8(x, -32769.0f, vl);
+        vbool8_t bad_hi = __riscv_vmfge_vf_f32m4_b8(x, 32768.0f, vl);
+        count += (int)__riscv_vcpop_m_b8(__riscv_vmorn_mm_b8(bad_hi, ok_lo, vl), vl);
+        x = __riscv_vfmin_vf_f32m4(__riscv_vfmax_vf_f32m4(x, -32768.0f, vl), 32767.0f, vl);
+        __riscv_vse16_v_i16m2(dst + i, __riscv_vfncvt_rtz_x_f_w_i16m2(x, vl), vl);
+    }
+    *clamped += count;
+    return n;
+}
+
+static int cvt_q88_f32_rvv(const int16_t* src, int n, float* dst) {
+    size_t vl;
+
+    for (int i = 0; i < n; i += (int)vl) {
+        vl = __riscv_vsetvl_e16m2((size_t)(n - i));
+        vfloat32m4_t x = __riscv_vfwcvt_f_x_v_f32m4(__riscv_vle16_v_i16m2(src + i, vl), vl);
+        __riscv_vse32_v_f32m4(dst + i, __riscv_vfmul_vf_f32m4(x, 1.0f / 256.0f, vl), vl);
+    }
+    return n;
+}
+
+unsigned conv_simd_supported(void) {
+    return (1u << CONV_ISA_SCALAR) | (1u << CONV_ISA_RVV);
+}
+
+conv_rows_f32_fn conv_simd_rows_f32(int isa, int ksize) {
+    if (isa == CONV_ISA_RVV) {
+        return ksize == 3 ? rows_f32_rvv_k3 : ksize == 5 ? rows_f32_rvv_k5 : NULL;
+    }
+    return NULL;
+}
+
+// Fixed point on RVV still uses the scalar loop.
+conv_rows_q88_fn conv_simd_rows_q88(int isa, int ksize) {
+    (void)isa;
+    (void)ksize;
+    return NULL;
+}
+
+conv_taps_f32_fn conv_simd_taps_f32(int isa) {
+    return isa == CONV_ISA_RVV ? taps_f32_rvv : NULL;
+}
+
+conv_cvt_f32_q88_fn conv_simd_cvt_f32_q88(int isa) {
+    return isa == CONV_ISA_RVV ? cvt_f32_q88_rvv : NULL;
+}
+
+conv_cvt_q88_f32_fn conv_simd_cvt_q88_f32(int isa) {
+    return isa == CONV_ISA_RVV ? cvt_q88_f32_rvv : NULL;
+}
+
+#else
+
+unsigned conv_simd_supported(void) {
+    return 1u << CONV_ISA_SCALAR;
+}
+
+conv_rows_f32_fn conv_simd_rows_f32(int isa, int ksize) {
+    (void)isa;
+    (void)ksize;
+    return NULL;
+}
+
+conv_rows_q88_fn conv_simd_rows_q88(int isa, int ksize) {
+    (void)isa;
+    (void)ksize;
+    return NULL;
+}
+
+conv_taps_f32_fn conv_simd_taps_f32(int isa) {
+    (void)isa;
+    return NULL;
+}
+
+conv_cvt_f32_q88_fn conv_simd_cvt_f32_q88(int isa) {
+    (void)isa;
+    return NULL;
+}
+
+conv_cvt_q88_f32_fn conv_simd_cvt_q88_f32(int isa) {
+    (void)isa;
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef CONV_SIMD_H
+#define CONV_SIMD_H
+
+// Vector fast paths used by conv.c. Not part of the public API.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Interior rows i0..i1 of a stride-1 convolution, starting at column j0
+// (same arguments as conv2d_rows_k in conv.c). Each function handles as many
+// columns from j0 as its vector width allows and returns how many it did; the
+// caller finishes the remaining columns with the scalar loop.
+typedef int (*conv_rows_f32_fn)(const float* in, int w, const float* k, int pad,
+                                float* out, int ow, int i0, int i1, int j0, int j1);
+typedef int (*conv_rows_q88_fn)(const int16_t* in, int w, const int16_t* k, int pad,
+                                int16_t* out, uint8_t* overflow, int ow,
+                                int i0, int i1, int j0, int j1);
+
+// dst[j] = sum over t < K of k[t] * src[t * step + j] for j in 0..n-1, plus
+// the old dst[j] when add is set: one pass of a separable kernel, across a
+// row (step 1) or down a column (step = row length). Returns how many
+// leading outputs it did; K is at most CONV_TAPS_MAX.
+#define CONV_TAPS_MAX 16
+typedef int (*conv_taps_f32_fn)(const float* src, ptrdiff_t step, const float* k, int K,
+                                float* dst, int n, int add);
+
+// Conversions over n values; each returns how many leading values it did.
+// The float-to-Q8.8 one adds the number of clamped values to *clamped.
+typedef int (*conv_cvt_f32_q88_fn)(const float* src, int n, int16_t* dst, int* clamped);
+typedef int (*conv_cvt_q88_f32_fn)(const int16_t* src, int n, float* dst);
+
+// Bitmask of (1 << CONV_ISA_*) the running CPU supports. Scalar is always set.
+unsigned conv_simd_supported(void);
+
+// Fast path for ksize on isa, or NULL when there is none.
+conv_rows_f32_fn conv_simd_rows_f32(int isa, int ksize);
+conv_rows_q88_fn conv_simd_rows_q88(int isa, int ksize);
+conv_taps_f32_fn conv_simd_taps_f32(int isa);
+conv_cvt_f32_q88_fn conv_simd_cvt_f32_q88(int isa);
+conv_cvt_q88_f32_fn conv_simd_cvt_q88_f32(int isa);
+
+#endif
@@ -0,0 +1,146 @@
+// Build: gcc -O2 -o conv_simd_test conv_simd_test.c conv_bench.c conv.c conv_simd.c
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "conv_bench.h"
+
+#define MAX_SIZE 77
+#define BENCH_SIZE 1024
+#define BENCH_RUNS 5
+
+static int failures = 0;
+
+// Straight OurCONV numerics, one tap at a time, for checking conv2d_q88.
+static void conv_q88_ref(const int16_t* in, int h, int w, const int16_t* k, int ksize,
+                         int16_t* out, uint8_t* overflow) {
+    int pad = ksize / 2;
+
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+            int32_t acc = 0;
+            for (int m = 0; m < ksize; m++) {
+                for (int n = 0; n < ksize; n++) {
+                    int x = i + m - pad;
+                    int y = j + n - pad;
+                    if (x >= 0 && x < h && y >= 0 && y < w) {
+                        acc += ((int32_t)k[m * ksize + n] * in[x * w + y]) >> 8;
+                    }
+                }
+            }
+            overflow[i * w + j] = acc > 32767 || acc < -32768;
+            out[i * w + j] = acc > 32767 ? 32767 : acc < -32768 ? -32768 : (int16_t)acc;
+        }
+    }
+}
+
+// Every ISA against the scalar path on random shapes, including shapes too
+// narrow for a full vector and values that saturate.
+static void check_isa(int isa) {
+    static float fin[MAX_SIZE * MAX_SIZE], fref[MAX_SIZE * MAX_SIZE], fout[MAX_SIZE * MAX_SIZE];
+    static int16_t qin[MAX_SIZE * MAX_SIZE], qref[MAX_SIZE * MAX_SIZE], qout[MAX_SIZE * MAX_SIZE];
+    static uint8_t oref[MAX_SIZE * MAX_SIZE], oout[MAX_SIZE * MAX_SIZE];
+    float fk[25];
+    int16_t qk[25];
+    int bad = 0;
+
+    srand(isa + 1);
+    for (int t = 0; t < 300; t++) {
+        int h = 1 + rand() % MAX_SIZE;
+        int w = 1 + rand() % MAX_SIZE;
+        int ksize = (t % 2) ? 5 : 3;
+        int big = t % 3 == 0; // big values make most pixels saturate
+
+        for (int i = 0; i < h * w; i++) {
+            fin[i] = (float)(rand() % 2000 - 1000) / 64.0f;
+            qin[i] = (int16_t)(big ? rand() % 65536 - 32768 : rand() % 4096 - 2048);
+        }
+        for (int i = 0; i < ksize * ksize; i++) {
+            fk[i] = (float)(rand() % 200 - 100) / 16.0f;
+            qk[i] = (int16_t)(big ? rand() % 65536 - 32768 : rand() % 1024 - 512);
+        }
+
+        conv_set_isa(CONV_ISA_SCALAR);
+        conv2d(fin, h, w, fk, ksize, fref);
+        conv_set_isa(isa);
+        conv2d(fin, h, w, fk, ksize, fout);
+        if (memcmp(fref, fout, sizeof(float) * h * w) != 0) {
+            printf("  float %dx%d k%d differs from scalar\n", h, w, ksize);
+            bad++;
+        }
+
+        conv_q88_ref(qin, h, w, qk, ksize, qref, oref);
+        conv2d_q88(qin, h, w, qk, ksize, qout, oout);
+        if (memcmp(qref, qout, sizeof(int16_t) * h * w) != 0 ||
+            memcmp(oref, oout, h * w) != 0) {
+            printf("  q8.8 %dx%d k%d differs from reference\n", h, w, ksize);
+            bad++;
+        }
+    }
+    printf("%s: %s\n", conv_isa_name(isa), bad ? "FAILED" : "match");
+    failures += bad;
+}
+
+static void bench_isa(int isa, const float* fin, const int16_t* qin, float* fout,
+                      int16_t* qout, uint8_t* ovf) {
+    static const float fk[25] = {1, 5, -1, 0.5f, 1, 2, 0.5f, -2, 0.5f, 2, 3, 0.5f, -3,
+                                 0.5f, 3, 2, 0.5f, -2, 0.5f, 2, 1, 0.5f, -1, 0.5f, 1};
+    int16_t qk[25];
+
+    for (int i = 0; i < 25; i++) {
+        qk[i] = (int16_t)(fk[i] * 256.0f);
+    }
+    conv_set_isa(isa);
+    for (int ksize = 3; ksize <= 5; ksize += 2) {
+        uint64_t best_f = UINT64_MAX, best_q = UINT64_MAX;
+        for (int r = 0; r < BENCH_RUNS; r++) {
+            uint64_t t0 = conv_bench_ns();
+            conv2d(fin, BENCH_SIZE, BENCH_SIZE, fk, ksize, fout);
+            uint64_t t1 = conv_bench_ns();
+            conv2d_q88(qin, BENCH_SIZE, BENCH_SIZE, qk, ksize, qout, ovf);
+            uint64_t t2 = conv_bench_ns();
+            if (t1 - t0 < best_f) best_f = t1 - t0;
+            if (t2 - t1 < best_q) best_q = t2 - t1;
+        }
+        printf("%-7s %dx%d: float %.2f ms, q8.8 %.2f ms (%.0f Mpixel/s)\n", conv_isa_name(isa),
+               ksize, ksize, best_f / 1e6, best_q / 1e6, BENCH_SIZE * BENCH_SIZE * 1e3 / best_q);
+    }
+}
+
+int main() {
+    int best = conv_isa();
+    printf("Best ISA on this CPU: %s\n", conv_isa_name(best));
+
+    for (int isa = CONV_ISA_SCALAR; isa <= CONV_ISA_RVV; isa++) {
+        if (conv_set_isa(isa) == isa) {
+            check_isa(isa);
+        }
+    }
+
+    float* fin = malloc(sizeof(float) * BENCH_SIZE * BENCH_SIZE);
+    float* fout = malloc(sizeof(float) * BENCH_SIZE * BENCH_SIZE);
+    int16_t* qin = malloc(sizeof(int16_t) * BENCH_SIZE * BENCH_SIZE);
+    int16_t* qout = malloc(sizeof(int16_t) * BENCH_SIZE * BENCH_SIZE);
+    uint8_t* ovf = malloc(BENCH_SIZE * BENCH_SIZE);
+    for (int i = 0; i < BENCH_SIZE * BENCH_SIZE; i++) {
+        fin[i] = (float)(i % 16);
+        qin[i] = (int16_t)((i % 16) << 8);
+    }
+    for (int isa = CONV_ISA_SCALAR; isa <= CONV_ISA_RVV; isa++) {
+        if (conv_set_isa(isa) == isa) {
+            bench_isa(isa, fin, qin, fout, qout, ovf);
+        }
+    }
+    free(fin);
+    free(fout);
+    free(qin);
+    free(qout);
+    free(ovf);
+
+    if (failures) {
+        printf("%d mismatches\n", failures);
+        return 1;
+    }
+    return 0;
+}
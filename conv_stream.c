@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <string.h>
+#include "conv_stream.h"
+
+static size_t value_size(const conv_stream* s) {
+    return s->q88 ? sizeof(int16_t) : sizeof(float);
+}
+
+static char* ring_row(const conv_stream* s, int slot) {
+    return (char*)s->ring + (size_t)slot * s->pitch * value_size(s);
+}
+
+static int stream_init(conv_stream* s, int w, const void* k, int ksize, int q88) {
+    memset(s, 0, sizeof(*s));
+    if (!k || w <= 0 || ksize <= 0 || ksize % 2 == 0) {
+        return CONV_EINVAL;
+    }
+    s->w = w;
+    s->ksize = ksize;
+    s->q88 = q88;
+    s->pitch = (size_t)w + ksize - 1;
+
+    size_t taps = (size_t)ksize * ksize * value_size(s);
+    s->k = malloc(taps);
+    s->ring = malloc(2 * (size_t)ksize * s->pitch * value_size(s));
+    if (!s->k || !s->ring) {
+        conv_stream_free(s);
+        return CONV_ENOMEM;
+    }
+    memcpy(s->k, k, taps);
+    conv_stream_reset(s);
+    return CONV_OK;
+}
+
+int conv_stream_init(conv_stream* s, int w, const float* k, int ksize) {
+    return stream_init(s, w, k, ksize, 0);
+}
+
+int conv_stream_init_q88(conv_stream* s, int w, const int16_t* k, int ksize) {
+    return stream_init(s, w, k, ksize, 1);
+}
+
+void conv_stream_free(conv_stream* s) {
+    free(s->ring);
+    free(s->k);
+    s->ring = NULL;
+    s->k = NULL;
+}
+
+void conv_stream_reset(conv_stream* s) {
+    // All zero: the margins stay that way, and the first ksize / 2 rows are
+    // the padding above the frame
+    memset(s->ring, 0, 2 * (size_t)s->ksize * s->pitch * value_size(s));
+    s->rows_in = 0;
+    s->rows_out = 0;
+    s->filled = s->ksize / 2;
+    s->flushing = 0;
+}
+
+// Appends a row (NULL: a zero row) to both of its ring slots. Returns the
+// slot of the first row of the newest complete window, or -1.
+static int ring_push(conv_stream* s, const void* row) {
+    size_t bytes = (size_t)s->w * value_size(s);
+    size_t margin = (size_t)(s->ksize / 2) * value_size(s);
+    int slot = s->filled % s->ksize;
+
+    for (int copy = 0; copy < 2; copy++) {
+        char* dst = ring_row(s, slot + copy * s->ksize) + margin;
+        if (row) {
+            memcpy(dst, row, bytes);
+        } else {
+            memset(dst, 0, bytes);
+        }
+    }
+    s->filled++;
+    return s->filled >= s->ksize ? s->filled % s->ksize : -1;
+}
+
+// Output row of the window starting at ring slot `first`: a valid
+// convolution of ksize rows of pitch values
+static void emit(conv_stream* s, int first, void* out_row, uint8_t* overflow_row) {
+    conv2d_params valid = { 1, 0, 1 };
+
+    if (s->q88) {
+        conv2d_q88_ex((const int16_t*)ring_row(s, first), s->ksize, (int)s->pitch, s->k, s->ksize,
+                      &valid, out_row, overflow_row);
+    } else {
+        conv2d_ex((const float*)ring_row(s, first), s->ksize, (int)s->pitch, s->k, s->ksize, &valid, out_row);
+    }
+    s->rows_out++;
+}
+
+static int stream_push(conv_stream* s, const void* row, void* out_row, uint8_t* overflow_row) {
+    if (!row || !out_row || s->flushing) {
+        return CONV_EINVAL;
+    }
+    s->rows_in++;
+    int first = ring_push(s, row);
+    if (first < 0) {
+        return 0;
+    }
+    emit(s, first, out_row, overflow_row);
+    return 1;
+}
+
+static int stream_flush(conv_stream* s, void* out_row, uint8_t* overflow_row) {
+    if (!out_row) {
+        return CONV_EINVAL;
+    }
+    s->flushing = 1;
+    if (s->rows_out >= s->rows_in) {
+        return 0;
+    }
+    // A short frame may still be filling the window with its own rows
+    int first;
+    do {
+        first = ring_push(s, NULL);
+    } while (first < 0);
+    emit(s, first, out_row, overflow_row);
+    return 1;
+}
+
+int conv_stream_push(conv_stream* s, const float* row, float* out_row) {
+    return !s || s->q88 ? CONV_EINVAL : stream_push(s, row, out_row, NULL);
+}
+
+int conv_stream_push_q88(conv_stream* s, const int16_t* row, int16_t* out_row, uint8_t* overflow_row) {
+    return !s || !s->q88 ? CONV_EINVAL : stream_push(s, row, out_row, overflow_row);
+}
+
+int conv_stream_flush(conv_stream* s, float* out_row) {
+    return !s || s->q88 ? CONV_EINVAL : stream_flush(s, out_row, NULL);
+}
+
+int conv_stream_flush_q88(conv_stream* s, int16_t* out_row, uint8_t* overflow_row) {
+    return !s || !s->q88 ? CONV_EINVAL : stream_flush(s, out_row, overflow_row);
+}
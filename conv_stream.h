@@ -0,0 +1,59 @@
+#ifndef CONV_STREAM_H
+#define CONV_STREAM_H
+
+// Line-buffered "same" convolution for frames that arrive row by row.
+//
+// A stream keeps the last ksize input rows in a ring, each with ksize / 2
+// zero columns on either side, and the ksize / 2 zero rows above the frame
+// are in the ring from the start. Output row r is emitted by the push of
+// input row r + ksize / 2, as soon as its window is complete, so latency is
+// ksize / 2 rows and memory 2 * ksize rows of w + ksize - 1 values: every
+// row is written to two ring slots ksize rows apart, which keeps any ksize
+// consecutive rows contiguous for the row kernels of conv.c (conv2d_ex()
+// with no padding on a ksize-row window). After the last row,
+// conv_stream_flush() supplies the zero rows below the frame and emits the
+// remaining ksize / 2 output rows.
+//
+// The Q8.8 stream is bit-identical to conv2d_q88(). The float one matches
+// conv2d() exactly away from the frame border; on the border it also adds
+// the zero taps, in the order of the interior kernels, so it matches to
+// float rounding.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "conv.h"
+
+typedef struct {
+    int w, ksize;
+    int q88;        // Q8.8 stream
+    int rows_in;    // frame rows pushed
+    int rows_out;   // output rows emitted
+    int filled;     // ring rows written, the top zero rows included
+    int flushing;   // zero rows below the frame are going in
+    size_t pitch;   // values per ring row, w + ksize - 1
+    void* ring;     // 2 * ksize rows
+    void* k;        // copy of the kernel
+} conv_stream;
+
+// Streams of w-wide frames with an odd ksize x ksize kernel, which is
+// copied. Return CONV_OK, CONV_EINVAL or CONV_ENOMEM.
+int conv_stream_init(conv_stream* s, int w, const float* k, int ksize);
+int conv_stream_init_q88(conv_stream* s, int w, const int16_t* k, int ksize);
+void conv_stream_free(conv_stream* s);
+
+// Starts the next frame with the same kernel.
+void conv_stream_reset(conv_stream* s);
+
+// Pushes one input row. Returns 1 with output row s->rows_out - 1 in
+// out_row, 0 while its window is incomplete, or CONV_EINVAL (also after a
+// flush has begun, or for a stream of the other type). overflow_row may be
+// NULL.
+int conv_stream_push(conv_stream* s, const float* row, float* out_row);
+int conv_stream_push_q88(conv_stream* s, const int16_t* row, int16_t* out_row, uint8_t* overflow_row);
+
+// Ends the frame: each call emits the next of the remaining output rows and
+// returns 1, then 0 once all rows_in rows are out.
+int conv_stream_flush(conv_stream* s, float* out_row);
+int conv_stream_flush_q88(conv_stream* s, int16_t* out_row, uint8_t* overflow_row);
+
+#endif
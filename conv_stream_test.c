@@ -0,0 +1,178 @@
+// Build: gcc -O2 -o conv_stream_test conv_stream_test.c conv_stream.c conv_bench.c conv.c conv_simd.c -lm
+//
+// Streams random frames row by row and compares them with conv2d_q88() bit
+// for bit and with conv2d() (exact inside, float rounding on the border),
+// for frames shorter than the kernel too; checks the latency and reuse of a
+// stream across frames. Then streams a 3840x2160 frame and prints its
+// memory and time against conv2d() on the whole frame.
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv.h"
+#include "conv_bench.h"
+#include "conv_stream.h"
+
+// One frame through s; out gets every emitted row, in order. Returns the
+// push that produced output row 0 (1-based), or -1 on an error.
+static int stream_frame(conv_stream* s, const void* in, int h, void* out, uint8_t* overflow) {
+    size_t bytes = s->q88 ? sizeof(int16_t) : sizeof(float);
+    size_t row = (size_t)s->w * bytes;
+    int first = 0, r;
+
+    for (int i = 0; i < h; i++) {
+        char* dst = (char*)out + (size_t)s->rows_out * row;
+        uint8_t* ovf = overflow ? overflow + (size_t)s->rows_out * s->w : NULL;
+        r = s->q88 ? conv_stream_push_q88(s, (const int16_t*)((const char*)in + i * row), (int16_t*)dst, ovf)
+                   : conv_stream_push(s, (const float*)((const char*)in + i * row), (float*)dst);
+        if (r < 0) {
+            return -1;
+        }
+        if (r && !first) {
+            first = i + 1;
+        }
+    }
+    do {
+        char* dst = (char*)out + (size_t)s->rows_out * row;
+        uint8_t* ovf = overflow ? overflow + (size_t)s->rows_out * s->w : NULL;
+        r = s->q88 ? conv_stream_flush_q88(s, (int16_t*)dst, ovf) : conv_stream_flush(s, (float*)dst);
+    } while (r == 1);
+    return r < 0 || s->rows_out != h ? -1 : first;
+}
+
+static int check(int h, int w, int ksize) {
+    size_t plane = (size_t)h * w;
+    float* in = malloc(sizeof(float) * plane);
+    float* ref = malloc(sizeof(float) * plane);
+    float* got = malloc(sizeof(float) * plane);
+    int16_t* in_q = malloc(sizeof(int16_t) * plane);
+    int16_t* ref_q = malloc(sizeof(int16_t) * plane);
+    int16_t* got_q = malloc(sizeof(int16_t) * plane);
+    uint8_t* ref_ovf = malloc(plane);
+    uint8_t* got_ovf = malloc(plane);
+    float k[15 * 15];
+    int16_t k_q[15 * 15];
+    conv_stream s, sq;
+    int pad = ksize / 2, bad = 0;
+
+    for (size_t i = 0; i < plane; i++) {
+        in[i] = (float)(rand() % 2001 - 1000) / 128.0f;
+        in_q[i] = (int16_t)(rand() % 16385 - 8192);
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = (float)(rand() % 201 - 100) / 256.0f;
+        k_q[i] = (int16_t)(rand() % 513 - 256);
+    }
+    conv2d(in, h, w, k, ksize, ref);
+    conv2d_q88(in_q, h, w, k_q, ksize, ref_q, ref_ovf);
+
+    if (conv_stream_init(&s, w, k, ksize) != CONV_OK || conv_stream_init_q88(&sq, w, k_q, ksize) != CONV_OK) {
+        printf("MISMATCH init %dx%d, %dx%d\n", h, w, ksize, ksize);
+        return 1;
+    }
+    // Twice, to check that a reset stream starts clean
+    for (int frame = 0; frame < 2; frame++) {
+        memset(got_q, 0, sizeof(int16_t) * plane);
+        int first = stream_frame(&sq, in_q, h, got_q, got_ovf);
+        if ((h > pad && first != pad + 1) || (h <= pad && first != 0) ||
+            memcmp(ref_q, got_q, sizeof(int16_t) * plane) != 0 || memcmp(ref_ovf, got_ovf, plane) != 0) {
+            printf("MISMATCH q88 %dx%d, %dx%d, frame %d\n", h, w, ksize, ksize, frame);
+            bad = 1;
+        }
+        conv_stream_reset(&sq);
+    }
+    if (stream_frame(&s, in, h, got, NULL) < 0) {
+        bad = 1;
+    }
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+            float r = ref[(size_t)i * w + j], g = got[(size_t)i * w + j];
+            int inside = i >= pad && i < h - pad && j >= pad && j < w - pad;
+            if (inside ? r != g : fabsf(r - g) > 1e-4f * (1.0f + fabsf(r))) {
+                bad = 1;
+            }
+        }
+    }
+    // Pushing after the flush began is an error
+    if (conv_stream_push(&s, in, got) != CONV_EINVAL || conv_stream_push_q88(&s, in_q, got_q, NULL) != CONV_EINVAL) {
+        bad = 1;
+    }
+    if (!bad) {
+        printf("%dx%d, %dx%d: match\n", h, w, ksize, ksize);
+    } else {
+        printf("MISMATCH %dx%d, %dx%d\n", h, w, ksize, ksize);
+    }
+    conv_stream_free(&s);
+    conv_stream_free(&sq);
+    free(in);
+    free(ref);
+    free(got);
+    free(in_q);
+    free(ref_q);
+    free(got_q);
+    free(ref_ovf);
+    free(got_ovf);
+    return bad;
+}
+
+// A 4K frame that arrives row by row: the stream holds 2 * ksize rows, the
+// frame path the whole input and output
+static void bench(int ksize) {
+    enum { H = 2160, W = 3840 };
+    size_t plane = (size_t)H * W;
+    float* in = malloc(sizeof(float) * plane);
+    float* out = malloc(sizeof(float) * plane);
+    float* row = malloc(sizeof(float) * W);
+    float k[25];
+    conv_stream s;
+
+    for (size_t i = 0; i < plane; i++) {
+        in[i] = (float)(i % 251) / 64.0f;
+    }
+    for (int i = 0; i < ksize * ksize; i++) {
+        k[i] = 1.0f / (float)(ksize * ksize);
+    }
+    conv2d(in, H, W, k, ksize, out); // fault the pages in
+    uint64_t t0 = conv_bench_ns();
+    conv2d(in, H, W, k, ksize, out);
+    uint64_t t1 = conv_bench_ns();
+    conv_stream_init(&s, W, k, ksize);
+    for (int i = 0; i < H; i++) {
+        conv_stream_push(&s, in + (size_t)i * W, row);
+    }
+    while (conv_stream_flush(&s, row) == 1) {
+    }
+    uint64_t t2 = conv_bench_ns();
+
+    printf("%dx%d float, %dx%d: frame %.1f MB, %.1f ms; stream %.1f KB, %.1f ms, latency %d rows\n",
+           W, H, ksize, ksize, 2.0 * sizeof(float) * plane / 1e6, (t1 - t0) / 1e6,
+           (2.0 * ksize * s.pitch + W) * sizeof(float) / 1e3, (t2 - t1) / 1e6, ksize / 2);
+    conv_stream_free(&s);
+    free(in);
+    free(out);
+    free(row);
+}
+
+int main() {
+    static const int shapes[][2] = { { 1, 1 }, { 2, 9 }, { 4, 4 }, { 17, 33 }, { 64, 61 }, { 100, 7 } };
+    int failures = 0;
+
+    for (unsigned s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        for (int ksize = 1; ksize <= 7; ksize += 2) {
+            failures += check(shapes[s][0], shapes[s][1], ksize);
+        }
+    }
+    failures += check(40, 50, 15);
+
+    conv_stream bad;
+    float k[4] = { 0 };
+    if (conv_stream_init(&bad, 16, k, 2) != CONV_EINVAL || conv_stream_init(&bad, 0, k, 1) != CONV_EINVAL) {
+        printf("MISMATCH argument checks\n");
+        failures++;
+    }
+
+    bench(3);
+    bench(5);
+    return failures ? 1 : 0;
+}
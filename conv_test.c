@@ -1,5 +1,10 @@
+// Build: gcc -O2 -o conv conv_test.c conv.c conv_simd.c
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "conv.h"
 
 #define N3 3
 #define N5 5
@@ -13,6 +18,31 @@
 #define K3 3
 #define K1 1
 
+// Fixed-size references from the original conv.c / conv_test.c. conv2d() must
+// reproduce every one of them bit-for-bit.
+
+void conv33(float input[N3][N3], float kernel[K3][K3], float output[N3][N3]) {
+    int pad = K3 / 2;
+
+    for (int i = 0; i < N3; i++) {
+        for (int j = 0; j < N3; j++) {
+            float sum = 0.0;
+            for (int m = 0; m < K3; m++) {
+                for (int n = 0; n < K3; n++) {
+                    int x = i + m - pad;
+                    int y = j + n - pad;
+                    if (x >= 0 && x < N3 && y >= 0 && y < N3) {
+                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
+                        sum += kernel[m][n] * input[x][y];
+                    }
+                }
+            }
+            output[i][j] = sum;
+            //printf("Sum = %f\n", sum);
+        }
+    }
+}
+
 void conv81(float input[N8][N8], float kernel[K1][K1], float output[N8][N8]) {
     int pad = K1 / 2;
 
@@ -35,6 +65,28 @@ void conv81(float input[N8][N8], float kernel[K1][K1], float output[N8][N8]) {
     }
 }
 
+void conv83(float input[N8][N8], float kernel[K3][K3], float output[N8][N8]) {
+    int pad = K3 / 2;
+
+    for (int i = 0; i < N8; i++) {
+        for (int j = 0; j < N8; j++) {
+            float sum = 0.0;
+            for (int m = 0; m < K3; m++) {
+                for (int n = 0; n < K3; n++) {
+                    int x = i + m - pad;
+                    int y = j + n - pad;
+                    if (x >= 0 && x < N8 && y >= 0 && y < N8) {
+                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
+                        sum += kernel[m][n] * input[x][y];
+                    }
+                }
+            }
+            output[i][j] = sum;
+            //printf("Sum = %f\n", sum);
+        }
+    }
+}
+
 void conv103(float input[N10][N10], float kernel[K3][K3], float output[N10][N10]) {
     int pad = K3 / 2;
 
@@ -57,7 +109,49 @@ void conv103(float input[N10][N10], float kernel[K3][K3], float output[N10][N10]
     }
 }
 
+void conv55(float input[N5][N5], float kernel[K5][K5], float output[N5][N5]) {
+    int pad = K5 / 2;
 
+    for (int i = 0; i < N5; i++) {
+        for (int j = 0; j < N5; j++) {
+            float sum = 0.0;
+            for (int m = 0; m < K5; m++) {
+                for (int n = 0; n < K5; n++) {
+                    int x = i + m - pad;
+                    int y = j + n - pad;
+                    if (x >= 0 && x < N5 && y >= 0 && y < N5) {
+                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
+                        sum += kernel[m][n] * input[x][y];
+                    }
+                }
+            }
+            output[i][j] = sum;
+            //printf("Sum = %f\n", sum);
+        }
+    }
+}
+
+void conv85(float input[N8][N8], float kernel[K5][K5], float output[N8][N8]) {
+    int pad = K5 / 2;
+
+    for (int i = 0; i < N8; i++) {
+        for (int j = 0; j < N8; j++) {
+            float sum = 0.0;
+            for (int m = 0; m < K5; m++) {
+                for (int n = 0; n < K5; n++) {
+                    int x = i + m - pad;
+                    int y = j + n - pad;
+                    if (x >= 0 && x < N8 && y >= 0 && y < N8) {
+                        //printf("i = %d, j = %d, m = %d, n = %d, x = %d, y = %d | %f * %f\n", i, j, m, n, x, y, kernel[m][n], input[x][y]);
+                        sum += kernel[m][n] * input[x][y];
+                    }
+                }
+            }
+            output[i][j] = sum;
+            //printf("Sum = %f\n", sum);
+        }
+    }
+}
 
 void conv125(float input[N12][N12], float kernel[K5][K5], float output[N12][N12]) {
     int pad = K5 / 2;
@@ -125,8 +219,244 @@ void conv325(float input[N32][N32], float kernel[K5][K5], float output[N32][N32]
     }
 }
 
+#define BENCH_SIZE 1024
+#define BENCH_RUNS 5
+
+static int failures = 0;
+
+// Compare a library result against its fixed-size reference bit-for-bit.
+static void check(const char* name, const float* ref, const float* got, int len) {
+    if (memcmp(ref, got, len * sizeof(float)) != 0) {
+        for (int i = 0; i < len; i++) {
+            if (memcmp(&ref[i], &got[i], sizeof(float)) != 0) {
+                printf("MISMATCH %s at %d: %f != %f\n", name, i, ref[i], got[i]);
+                break;
+            }
+        }
+        failures++;
+    } else {
+        printf("%s: match\n", name);
+    }
+}
+
+// The fixed-size functions above, generalised to runtime sizes. Used as the
+// "before" number for the 1024x1024 benchmark.
+static void conv_naive(const float* input, int n, const float* kernel, int k, float* output) {
+    int pad = k / 2;
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            float sum = 0.0;
+            for (int m = 0; m < k; m++) {
+                for (int l = 0; l < k; l++) {
+                    int x = i + m - pad;
+                    int y = j + l - pad;
+                    if (x >= 0 && x < n && y >= 0 && y < n) {
+                        sum += kernel[m * k + l] * input[x * n + y];
+                    }
+                }
+            }
+            output[i * n + j] = sum;
+        }
+    }
+}
+
+// Strided, dilated reference: every tap tested against the image bounds.
+static void conv_strided_naive(const float* in, const int16_t* in_q, int h, int w,
+                               const float* k, const int16_t* k_q, int ksize,
+                               int stride, int pad, int dil, int oh, int ow,
+                               float* out, int16_t* out_q) {
+    for (int i = 0; i < oh; i++) {
+        for (int j = 0; j < ow; j++) {
+            float sum = 0.0f;
+            int32_t acc = 0;
+            for (int m = 0; m < ksize; m++) {
+                for (int n = 0; n < ksize; n++) {
+                    int x = i * stride - pad + m * dil;
+                    int y = j * stride - pad + n * dil;
+                    if (x >= 0 && x < h && y >= 0 && y < w) {
+                        sum += k[m * ksize + n] * in[x * w + y];
+                        acc += ((int32_t)k_q[m * ksize + n] * in_q[x * w + y]) >> 8;
+                    }
+                }
+            }
+            out[i * ow + j] = sum;
+            out_q[i * ow + j] = (int16_t)(acc > 32767 ? 32767 : acc < -32768 ? -32768 : acc);
+        }
+    }
+}
+
+// conv2d_ex and conv2d_q88_ex over strides 1/2/4 and dilations 1/2
+static void check_strided(int h, int w) {
+    float* in = malloc(sizeof(float) * h * w);
+    int16_t* in_q = malloc(sizeof(int16_t) * h * w);
+    float* ref = malloc(sizeof(float) * h * w);
+    float* got = malloc(sizeof(float) * h * w);
+    int16_t* ref_q = malloc(sizeof(int16_t) * h * w);
+    int16_t* got_q = malloc(sizeof(int16_t) * h * w);
+    float k[25];
+    int16_t k_q[25];
+    int bad = 0;
+
+    for (int i = 0; i < h * w; i++) {
+        in[i] = (float)(rand() % 4001 - 2000) / 256.0f;
+    }
+    for (int i = 0; i < 25; i++) {
+        k[i] = (float)(rand() % 513 - 256) / 256.0f;
+    }
+    conv_f32_to_q88(in, h * w, in_q);
+    conv_f32_to_q88(k, 25, k_q);
+
+    for (int ksize = 1; ksize <= 5; ksize += 2) {
+        for (int stride = 1; stride <= 4; stride *= 2) {
+            for (int dil = 1; dil <= 2; dil++) {
+                int ext = (ksize - 1) * dil + 1;
+                for (int pad = 0; pad <= ext / 2; pad += ext / 2 ? ext / 2 : 1) {
+                    conv2d_params params = { stride, pad, dil };
+                    int oh = conv2d_out_size(h, ext, stride, pad);
+                    int ow = conv2d_out_size(w, ext, stride, pad);
+                    conv_strided_naive(in, in_q, h, w, k, k_q, ksize, stride, pad, dil, oh, ow, ref, ref_q);
+                    if (conv2d_ex(in, h, w, k, ksize, &params, got) != CONV_OK ||
+                        conv2d_q88_ex(in_q, h, w, k_q, ksize, &params, got_q, NULL) != CONV_OK ||
+                        memcmp(ref, got, sizeof(float) * oh * ow) != 0 ||
+                        memcmp(ref_q, got_q, sizeof(int16_t) * oh * ow) != 0) {
+                        printf("MISMATCH strided %dx%d k%d stride %d pad %d dilation %d\n",
+                               h, w, ksize, stride, pad, dil);
+                        bad = 1;
+                    }
+                }
+            }
+        }
+    }
+    conv2d_params no_rows = { 1, 0, 4 };
+    if (conv2d_ex(in, 8, 8, k, 3, &no_rows, got) != CONV_EINVAL) {
+        printf("MISMATCH strided: kernel wider than the image accepted\n");
+        bad = 1;
+    }
+    if (conv2d(in, 8, 8, k, 2, got) != CONV_EINVAL) {
+        printf("MISMATCH strided: even kernel size accepted\n");
+        bad = 1;
+    }
+    if (bad) {
+        failures++;
+    } else {
+        printf("strided %dx%d: match\n", h, w);
+    }
+    free(in);
+    free(in_q);
+    free(ref);
+    free(got);
+    free(ref_q);
+    free(got_q);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench(const float* kernel, int k) {
+    float* input = malloc(sizeof(float) * BENCH_SIZE * BENCH_SIZE);
+    float* ref = malloc(sizeof(float) * BENCH_SIZE * BENCH_SIZE);
+    float* out = malloc(sizeof(float) * BENCH_SIZE * BENCH_SIZE);
+    double best_naive = 1e9, best_lib = 1e9;
+
+    for (int i = 0; i < BENCH_SIZE * BENCH_SIZE; i++) {
+        input[i] = (float)((i * 7) % 23) * 0.25f;
+    }
+
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        double t0 = now_sec();
+        conv_naive(input, BENCH_SIZE, kernel, k, ref);
+        double t1 = now_sec();
+        conv2d(input, BENCH_SIZE, BENCH_SIZE, kernel, k, out);
+        double t2 = now_sec();
+        if (t1 - t0 < best_naive) best_naive = t1 - t0;
+        if (t2 - t1 < best_lib) best_lib = t2 - t1;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "conv%d_%d", BENCH_SIZE, k);
+    check(name, ref, out, BENCH_SIZE * BENCH_SIZE);
+    printf("%dx%d, %dx%d kernel: naive %.2f ms, conv2d %.2f ms (%.1fx)\n",
+           BENCH_SIZE, BENCH_SIZE, k, k, best_naive * 1e3, best_lib * 1e3, best_naive / best_lib);
+
+    free(input);
+    free(ref);
+    free(out);
+}
+
 int main() {
 
+    // Test data from the original conv.c
+    float seq_input3[N3][N3] = {
+        {1, 2, 3},
+        {4, 5, 6},
+        {7, 8, 9}
+    };
+
+    float seq_input5[N5][N5] = {
+        {1, 2, 3, 4, 5},
+        {1, 2, 3, 4, 5},
+        {1, 2, 3, 4, 5},
+        {1, 2, 3, 4, 5},
+        {1, 2, 3, 4, 5}
+    };
+
+    float seq_input8[N8][N8] = {
+        {1, 2, 3, 4, 5, 6, 7, 8},
+        {1, 2, 3, 4, 5, 6, 7, 8},
+        {1, 2, 3, 4, 5, 6, 7, 8},
+        {1, 2, 3, 4, 5, 6, 7, 8},
+        {1, 2, 3, 4, 5, 6, 7, 8},
+        {1, 2, 3, 4, 5, 6, 7, 8},
+        {1, 2, 3, 4, 5, 6, 7, 8},
+        {1, 2, 3, 4, 5, 6, 7, 8}
+    };
+
+    float pad_input10[N10][N10] = {
+        {0,0,0,0,0,0,0,0,0,0},
+        {0,0,0,0,0,0,0,0,0,0},
+        {0,0,1,2,3,4,5,6,7,8},
+        {0,0,1,2,3,4,5,6,7,8},
+        {0,0,1,2,3,4,5,6,7,8},
+        {0,0,1,2,3,4,5,6,7,8},
+        {0,0,1,2,3,4,5,6,7,8},
+        {0,0,1,2,3,4,5,6,7,8},
+        {0,0,1,2,3,4,5,6,7,8},
+        {0,0,1,2,3,4,5,6,7,8}
+    };
+
+    float pad_input12[N12][N12] = {
+        {0,0,0,0,0,0,0,0,0,0,0,0},
+        {0,0,0,0,0,0,0,0,0,0,0,0},
+        {0,0,0,0,0,0,0,0,0,0,0,0},
+        {0,0,0,0,0,0,0,0,0,0,0,0},
+        {0,0,0,0,1,2,3,4,5,6,7,8},
+        {0,0,0,0,1,2,3,4,5,6,7,8},
+        {0,0,0,0,1,2,3,4,5,6,7,8},
+        {0,0,0,0,1,2,3,4,5,6,7,8},
+        {0,0,0,0,1,2,3,4,5,6,7,8},
+        {0,0,0,0,1,2,3,4,5,6,7,8},
+        {0,0,0,0,1,2,3,4,5,6,7,8},
+        {0,0,0,0,1,2,3,4,5,6,7,8}
+    };
+
+    float seq_kernel3[K3][K3] = {
+        {1, 2, 3},
+        {4, 5, 6},
+        {7, 8, 9}
+    };
+
+    float seq_kernel5[K5][K5] = {
+        {1, 2, 3, 4, 5},
+        {6, 7, 8, 9, 10},
+        {11, 12, 13, 14, 15},
+        {16, 17, 18, 19, 20},
+        {21, 22, 23, 24, 25}
+    };
+
     float input8[N8][N8] = {
         {1,2,3,4,5,6,7,8},
         {1,2,3,4,5,6,7,8},
@@ -209,12 +539,53 @@ int main() {
         }
     }
 
-    // Perform 2D convolution
-    conv81(input8, kernel1, output81);
-    conv103(input10, kernel3, output103);
-    conv125(input12, kernel5, output125);
-    conv323(input32, kernel3, output323);
-    conv325(input32, kernel5, output325);
+    // Perform 2D convolution with the library, and with the fixed-size references
+    conv2d(&input8[0][0], N8, N8, &kernel1[0][0], K1, &output81[0][0]);
+    conv2d(&input10[0][0], N10, N10, &kernel3[0][0], K3, &output103[0][0]);
+    conv2d(&input12[0][0], N12, N12, &kernel5[0][0], K5, &output125[0][0]);
+    conv2d(&input32[0][0], N32, N32, &kernel3[0][0], K3, &output323[0][0]);
+    conv2d(&input32[0][0], N32, N32, &kernel5[0][0], K5, &output325[0][0]);
+
+    float ref8[N8][N8], ref10[N10][N10], ref12[N12][N12], ref32[N32][N32];
+    float ref3[N3][N3], out3[N3][N3], ref5[N5][N5], out5[N5][N5];
+    float out8[N8][N8], out10[N10][N10], out12[N12][N12];
+
+    conv81(input8, kernel1, ref8);
+    check("conv81", &ref8[0][0], &output81[0][0], N8 * N8);
+    conv103(input10, kernel3, ref10);
+    check("conv103", &ref10[0][0], &output103[0][0], N10 * N10);
+    conv125(input12, kernel5, ref12);
+    check("conv125", &ref12[0][0], &output125[0][0], N12 * N12);
+    conv323(input32, kernel3, ref32);
+    check("conv323", &ref32[0][0], &output323[0][0], N32 * N32);
+    conv325(input32, kernel5, ref32);
+    check("conv325", &ref32[0][0], &output325[0][0], N32 * N32);
+
+    conv33(seq_input3, seq_kernel3, ref3);
+    conv2d(&seq_input3[0][0], N3, N3, &seq_kernel3[0][0], K3, &out3[0][0]);
+    check("conv33", &ref3[0][0], &out3[0][0], N3 * N3);
+    conv83(seq_input8, seq_kernel3, ref8);
+    conv2d(&seq_input8[0][0], N8, N8, &seq_kernel3[0][0], K3, &out8[0][0]);
+    check("conv83", &ref8[0][0], &out8[0][0], N8 * N8);
+    conv103(pad_input10, seq_kernel3, ref10);
+    conv2d(&pad_input10[0][0], N10, N10, &seq_kernel3[0][0], K3, &out10[0][0]);
+    check("conv103 (padded input)", &ref10[0][0], &out10[0][0], N10 * N10);
+    conv55(seq_input5, seq_kernel5, ref5);
+    conv2d(&seq_input5[0][0], N5, N5, &seq_kernel5[0][0], K5, &out5[0][0]);
+    check("conv55", &ref5[0][0], &out5[0][0], N5 * N5);
+    conv85(seq_input8, seq_kernel5, ref8);
+    conv2d(&seq_input8[0][0], N8, N8, &seq_kernel5[0][0], K5, &out8[0][0]);
+    check("conv85", &ref8[0][0], &out8[0][0], N8 * N8);
+    conv125(pad_input12, seq_kernel5, ref12);
+    conv2d(&pad_input12[0][0], N12, N12, &seq_kernel5[0][0], K5, &out12[0][0]);
+    check("conv125 (padded input)", &ref12[0][0], &out12[0][0], N12 * N12);
+
+    check_strided(23, 17);
+    check_strided(64, 64);
+
+    bench(&kernel1[0][0], K1);
+    bench(&kernel3[0][0], K3);
+    bench(&kernel5[0][0], K5);
 
     // Print output matrix
 
@@ -289,5 +660,9 @@ int main() {
     }
 
 
+    if (failures) {
+        printf("%d mismatches\n", failures);
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,68 @@
+#include <stddef.h>
+#include "conv_tiles.h"
+
+int conv_tiling_init(conv_tiling* t, int h, int w, int ksize, int tile_size) {
+    if (!t || h <= 0 || w <= 0 || ksize <= 0 || ksize % 2 == 0 || tile_size <= 0) {
+        return CONV_EINVAL;
+    }
+    t->h = h;
+    t->w = w;
+    t->ksize = ksize;
+    t->tile_size = tile_size;
+    t->tiles_y = (h + tile_size - 1) / tile_size;
+    t->tiles_x = (w + tile_size - 1) / tile_size;
+    return CONV_OK;
+}
+
+// Input window origin along one axis, matching the tile type: the first
+// tile's window is flush with the top/left edge, the last tile's with the
+// bottom/right edge, and the others are centred on their output tile. On
+// ragged or small images a window can reach past the image on one side;
+// packers fill those pixels with zeros.
+static int conv_tile_in_origin(int idx, int count, int out_start, int n, int in_tile, int pad) {
+    if (idx == 0) {
+        return 0;
+    }
+    if (idx == count - 1) {
+        return n - in_tile;
+    }
+    return out_start - pad;
+}
+
+void conv_tile_at(const conv_tiling* t, int idx, conv_tile* tile) {
+    int i = idx / t->tiles_x;
+    int j = idx % t->tiles_x;
+    int last_i = t->tiles_y - 1;
+    int last_j = t->tiles_x - 1;
+    int pad = t->ksize / 2;
+    int in_tile = t->tile_size + t->ksize - 1;
+
+    if (last_i == 0 && last_j == 0) {
+        tile->type = CONV_TILE_FULL;
+    } else if (i == 0 && j == 0) {
+        tile->type = CONV_TILE_TOP_LEFT;
+    } else if (i == 0 && j == last_j) {
+        tile->type = CONV_TILE_TOP_RIGHT;
+    } else if (i == last_i && j == 0) {
+        tile->type = CONV_TILE_BOTTOM_LEFT;
+    } else if (i == last_i && j == last_j) {
+        tile->type = CONV_TILE_BOTTOM_RIGHT;
+    } else if (i == 0) {
+        tile->type = CONV_TILE_TOP;
+    } else if (j == 0) {
+        tile->type = CONV_TILE_LEFT;
+    } else if (i == last_i) {
+        tile->type = CONV_TILE_BOTTOM;
+    } else if (j == last_j) {
+        tile->type = CONV_TILE_RIGHT;
+    } else {
+        tile->type = CONV_TILE_CENTER;
+    }
+
+    tile->out_row = i * t->tile_size;
+    tile->out_col = j * t->tile_size;
+    tile->out_rows = t->h - tile->out_row < t->tile_size ? t->h - tile->out_row : t->tile_size;
+    tile->out_cols = t->w - tile->out_col < t->tile_size ? t->w - tile->out_col : t->tile_size;
+    tile->in_row = conv_tile_in_origin(i, t->tiles_y, tile->out_row, t->h, in_tile, pad);
+    tile->in_col = conv_tile_in_origin(j, t->tiles_x, tile->out_col, t->w, in_tile, pad);
+}
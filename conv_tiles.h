@@ -0,0 +1,50 @@
+#ifndef CONV_TILES_H
+#define CONV_TILES_H
+
+// Output tile decomposition shared by the host executors and the OurCONV
+// driver. Tile types and input tile placement follow chipyard/convFSM_test.c:
+// edge tiles take their input window flush with the image edge, and the
+// accelerator uses the tile type to know which taps fall in the zero padding.
+// Images need not be square or a multiple of the tile size: the last tile
+// row/column is ragged and says how many output rows/cols are valid.
+
+#include "conv.h"
+
+enum conv_tile_type {
+    CONV_TILE_TOP_LEFT = 0,
+    CONV_TILE_TOP = 1,
+    CONV_TILE_TOP_RIGHT = 2,
+    CONV_TILE_LEFT = 3,
+    CONV_TILE_CENTER = 4,
+    CONV_TILE_RIGHT = 5,
+    CONV_TILE_BOTTOM_LEFT = 6,
+    CONV_TILE_BOTTOM = 7,
+    CONV_TILE_BOTTOM_RIGHT = 8,
+    CONV_TILE_FULL = 9
+};
+
+typedef struct {
+    int h, w;         // image size ("same" convolution, so also the output size)
+    int ksize;        // 1, 3, 5, ...
+    int tile_size;    // output tile edge, 8 for OurCONV
+    int tiles_y, tiles_x;
+} conv_tiling;
+
+typedef struct {
+    int type;                 // enum conv_tile_type
+    int out_row, out_col;     // top-left output pixel
+    int out_rows, out_cols;   // valid output rows/cols (less on ragged edges)
+    int in_row, in_col;       // top-left pixel of the input window, may be
+                              // negative or run past the image when it is small
+} conv_tile;
+
+int conv_tiling_init(conv_tiling* t, int h, int w, int ksize, int tile_size);
+
+static inline int conv_tiling_count(const conv_tiling* t) {
+    return t->tiles_y * t->tiles_x;
+}
+
+// Tile number idx, counted row-major (TOP_LEFT first, BOTTOM_RIGHT last).
+void conv_tile_at(const conv_tiling* t, int idx, conv_tile* tile);
+
+#endif
@@ -0,0 +1,155 @@
+// Build: gcc -O2 -pthread -o conv_tiles_test conv_tiles_test.c conv_bench.c conv_tiles.c conv_pool.c conv.c conv_simd.c
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "conv.h"
+#include "conv_bench.h"
+#include "conv_tiles.h"
+#include "conv_pool.h"
+
+// 4K UHD frame
+#define BENCH_H 2160
+#define BENCH_W 3840
+#define BENCH_TILE 64
+#define BENCH_RUNS 3
+
+static int failures = 0;
+
+// The 32x32 / 8x8 / 5x5 layout hard-coded in chipyard/convFSM_test.c.
+static void check_layout(void) {
+    static const int types[16] = {
+        CONV_TILE_TOP_LEFT, CONV_TILE_TOP, CONV_TILE_TOP, CONV_TILE_TOP_RIGHT,
+        CONV_TILE_LEFT, CONV_TILE_CENTER, CONV_TILE_CENTER, CONV_TILE_RIGHT,
+        CONV_TILE_LEFT, CONV_TILE_CENTER, CONV_TILE_CENTER, CONV_TILE_RIGHT,
+        CONV_TILE_BOTTOM_LEFT, CONV_TILE_BOTTOM, CONV_TILE_BOTTOM, CONV_TILE_BOTTOM_RIGHT
+    };
+    static const int in_origin[4] = {0, 6, 14, 20}; // 0, j*8-2, ..., 32-12
+    conv_tiling t;
+    conv_tile tile;
+    int bad = 0;
+
+    conv_tiling_init(&t, 32, 32, 5, 8);
+    for (int idx = 0; idx < conv_tiling_count(&t); idx++) {
+        conv_tile_at(&t, idx, &tile);
+        if (tile.type != types[idx] || tile.in_row != in_origin[idx / 4] ||
+            tile.in_col != in_origin[idx % 4] || tile.out_row != idx / 4 * 8 ||
+            tile.out_col != idx % 4 * 8 || tile.out_rows != 8 || tile.out_cols != 8) {
+            printf("  tile %d: type %d in (%d, %d) out (%d, %d)\n", idx, tile.type,
+                   tile.in_row, tile.in_col, tile.out_row, tile.out_col);
+            bad++;
+        }
+    }
+    printf("convFSM_test tile layout: %s\n", bad ? "FAILED" : "match");
+    failures += bad;
+}
+
+// Ragged 17x20 / 8x8 / 5x5: the last tile row has 1 valid row, the last
+// tile column 4 valid columns, and their windows stay flush with the edge.
+static void check_ragged(void) {
+    static const int row_origin[3] = {0, 6, 5};  // 17-12
+    static const int col_origin[3] = {0, 6, 8};  // 20-12
+    static const int rows[3] = {8, 8, 1};
+    static const int cols[3] = {8, 8, 4};
+    conv_tiling t;
+    conv_tile tile;
+    int bad = 0;
+
+    conv_tiling_init(&t, 17, 20, 5, 8);
+    for (int idx = 0; idx < conv_tiling_count(&t); idx++) {
+        int i = idx / 3, j = idx % 3;
+        conv_tile_at(&t, idx, &tile);
+        if (conv_tiling_count(&t) != 9 || tile.in_row != row_origin[i] || tile.in_col != col_origin[j] ||
+            tile.out_rows != rows[i] || tile.out_cols != cols[j]) {
+            printf("  tile %d: in (%d, %d) valid %dx%d\n", idx, tile.in_row, tile.in_col,
+                   tile.out_rows, tile.out_cols);
+            bad++;
+        }
+    }
+    printf("ragged tile layout: %s\n", bad ? "FAILED" : "match");
+    failures += bad;
+}
+
+// Tiled output must equal conv2d() for every thread count and tile size.
+static void check_tiled(void) {
+    static const int sizes[][2] = { {32, 32}, {100, 37}, {7, 300}, {257, 129} };
+    static const int tiles[] = {8, 13, 64};
+    static const int threads[] = {1, 2, 3, 8};
+    float k[25];
+    int bad = 0;
+
+    for (int i = 0; i < 25; i++) {
+        k[i] = (float)(i % 7) - 2.5f;
+    }
+    for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int h = sizes[s][0], w = sizes[s][1];
+        float* in = malloc(sizeof(float) * h * w);
+        float* ref = malloc(sizeof(float) * h * w);
+        float* out = malloc(sizeof(float) * h * w);
+        for (int i = 0; i < h * w; i++) {
+            in[i] = (float)((i * 31) % 17) * 0.125f;
+        }
+        for (int ksize = 1; ksize <= 5; ksize += 2) {
+            conv2d(in, h, w, k, ksize, ref);
+            for (unsigned t = 0; t < sizeof(tiles) / sizeof(tiles[0]); t++) {
+                for (unsigned n = 0; n < sizeof(threads) / sizeof(threads[0]); n++) {
+                    conv_pool* pool = conv_pool_create(threads[n]);
+                    memset(out, 0xff, sizeof(float) * h * w);
+                    conv2d_tiled(in, h, w, k, ksize, out, tiles[t], pool);
+                    if (memcmp(ref, out, sizeof(float) * h * w) != 0) {
+                        printf("  %dx%d k%d tile %d threads %d differs\n", h, w, ksize, tiles[t], threads[n]);
+                        bad++;
+                    }
+                    conv_pool_destroy(pool);
+                }
+            }
+        }
+        free(in);
+        free(ref);
+        free(out);
+    }
+    printf("tiled vs conv2d: %s\n", bad ? "FAILED" : "match");
+    failures += bad;
+}
+
+static void bench(void) {
+    static const float k[9] = {1, 5, -1, 2, 0.5f, -2, 3, 0.5f, -3};
+    float* in = malloc(sizeof(float) * BENCH_H * BENCH_W);
+    float* out = malloc(sizeof(float) * BENCH_H * BENCH_W);
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t base = 0;
+
+    for (int i = 0; i < BENCH_H * BENCH_W; i++) {
+        in[i] = (float)(i % 16);
+    }
+    // 1, 2, 4, ... threads, always ending on the full core count
+    for (int n = 1; n <= max_threads; n = (n * 2 > max_threads && n < max_threads) ? max_threads : n * 2) {
+        conv_pool* pool = conv_pool_create(n);
+        uint64_t best = UINT64_MAX;
+        for (int r = 0; r < BENCH_RUNS; r++) {
+            uint64_t t0 = conv_bench_ns();
+            conv2d_tiled(in, BENCH_H, BENCH_W, k, 3, out, BENCH_TILE, pool);
+            uint64_t t1 = conv_bench_ns();
+            if (t1 - t0 < best) best = t1 - t0;
+        }
+        if (n == 1) base = best;
+        printf("%dx%d 3x3, %d threads: %.2f ms (%.2fx)\n", BENCH_W, BENCH_H, n, best / 1e6, (double)base / best);
+        conv_pool_destroy(pool);
+    }
+    free(in);
+    free(out);
+}
+
+int main() {
+    check_layout();
+    check_ragged();
+    check_tiled();
+    bench();
+
+    if (failures) {
+        printf("%d mismatches\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,478 @@
+#include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conv_tiles.h"
+#include "conv_winograd.h"
+
+#define WINO_TILE 8 // the conv_tiles.h output tile, split into m x m sub-tiles
+#define WINO_INLINE static inline __attribute__((always_inline))
+#define WINO_MAX_N 6
+#define WINO_WIN (WINO_TILE + 2) // input window of a tile
+#define WINO_BUF 256 // (m + 2)^2 x (8 / m)^2 floats, largest for m = 2
+
+// G (n x 3), A^T (m x n) and the row sums of |B^T| for m = 2 and 4
+static const double g2[4][3] = {
+    { 1, 0, 0 }, { 0.5, 0.5, 0.5 }, { 0.5, -0.5, 0.5 }, { 0, 0, 1 }
+};
+static const double g4[6][3] = {
+    { 1 / 4.0, 0, 0 },
+    { -1 / 6.0, -1 / 6.0, -1 / 6.0 },
+    { -1 / 6.0, 1 / 6.0, -1 / 6.0 },
+    { 1 / 24.0, 1 / 12.0, 1 / 6.0 },
+    { 1 / 24.0, -1 / 12.0, 1 / 6.0 },
+    { 0, 0, 1 }
+};
+static const int at2[2][4] = { { 1, 1, 1, 0 }, { 0, 1, -1, -1 } };
+static const int at4[4][6] = {
+    { 1, 1, 1, 1, 1, 0 }, { 0, 1, -1, 2, -2, 0 }, { 0, 1, 1, 4, 4, 0 }, { 0, 1, -1, 8, -8, 1 }
+};
+static const int bt_sum2[4] = { 2, 2, 2, 2 };
+static const int bt_sum4[6] = { 10, 10, 10, 6, 6, 10 };
+
+// 1-D B^T and A^T applied lane-wise: element e of every sub-tile of a tile
+// is the L consecutive floats at s + e * ss (written to d + e * ds), so the
+// lane loops vectorize
+WINO_INLINE void bt2_f32(const float* s, int ss, float* d, int ds, int L) {
+    for (int l = 0; l < L; l++) {
+        float s0 = s[l], s1 = s[ss + l], s2 = s[2 * ss + l], s3 = s[3 * ss + l];
+        d[l] = s0 - s2;
+        d[ds + l] = s1 + s2;
+        d[2 * ds + l] = s2 - s1;
+        d[3 * ds + l] = s1 - s3;
+    }
+}
+
+WINO_INLINE void bt4_f32(const float* s, int ss, float* d, int ds, int L) {
+    for (int l = 0; l < L; l++) {
+        float s0 = s[l], s1 = s[ss + l], s2 = s[2 * ss + l], s3 = s[3 * ss + l];
+        float s4 = s[4 * ss + l], s5 = s[5 * ss + l];
+        d[l] = 4 * s0 - 5 * s2 + s4;
+        d[ds + l] = s3 + s4 - 4 * (s1 + s2);
+        d[2 * ds + l] = s4 - s3 + 4 * (s1 - s2);
+        d[3 * ds + l] = s4 - s2 + 2 * (s3 - s1);
+        d[4 * ds + l] = s4 - s2 - 2 * (s3 - s1);
+        d[5 * ds + l] = 4 * s1 - 5 * s3 + s5;
+    }
+}
+
+WINO_INLINE void at2_f32(const float* s, int ss, float* d, int ds, int L) {
+    for (int l = 0; l < L; l++) {
+        d[l] = s[l] + s[ss + l] + s[2 * ss + l];
+        d[ds + l] = s[ss + l] - s[2 * ss + l] - s[3 * ss + l];
+    }
+}
+
+WINO_INLINE void at4_f32(const float* s, int ss, float* d, int ds, int L) {
+    for (int l = 0; l < L; l++) {
+        float p12 = s[ss + l] + s[2 * ss + l], m12 = s[ss + l] - s[2 * ss + l];
+        float p34 = s[3 * ss + l] + s[4 * ss + l], m34 = s[3 * ss + l] - s[4 * ss + l];
+        d[l] = s[l] + p12 + p34;
+        d[ds + l] = m12 + 2 * m34;
+        d[2 * ds + l] = p12 + 4 * p34;
+        d[3 * ds + l] = m12 + 8 * m34 + s[5 * ss + l];
+    }
+}
+
+static inline void bt2_i32(const int32_t* s, int ss, int32_t* d, int ds) {
+    int32_t s0 = s[0], s1 = s[ss], s2 = s[2 * ss], s3 = s[3 * ss];
+    d[0] = s0 - s2;
+    d[ds] = s1 + s2;
+    d[2 * ds] = s2 - s1;
+    d[3 * ds] = s1 - s3;
+}
+
+static inline void bt4_i32(const int32_t* s, int ss, int32_t* d, int ds) {
+    int32_t s0 = s[0], s1 = s[ss], s2 = s[2 * ss], s3 = s[3 * ss], s4 = s[4 * ss], s5 = s[5 * ss];
+    d[0] = 4 * s0 - 5 * s2 + s4;
+    d[ds] = s3 + s4 - 4 * (s1 + s2);
+    d[2 * ds] = s4 - s3 + 4 * (s1 - s2);
+    d[3 * ds] = s4 - s2 + 2 * (s3 - s1);
+    d[4 * ds] = s4 - s2 - 2 * (s3 - s1);
+    d[5 * ds] = 4 * s1 - 5 * s3 + s5;
+}
+
+static inline void at2_i64(const int64_t* s, int ss, int64_t* d, int ds) {
+    d[0] = s[0] + s[ss] + s[2 * ss];
+    d[ds] = s[ss] - s[2 * ss] - s[3 * ss];
+}
+
+static inline void at4_i64(const int64_t* s, int ss, int64_t* d, int ds) {
+    int64_t p12 = s[ss] + s[2 * ss], m12 = s[ss] - s[2 * ss];
+    int64_t p34 = s[3 * ss] + s[4 * ss], m34 = s[3 * ss] - s[4 * ss];
+    d[0] = s[0] + p12 + p34;
+    d[ds] = m12 + 2 * m34;
+    d[2 * ds] = p12 + 4 * p34;
+    d[3 * ds] = m12 + 8 * m34 + s[5 * ss];
+}
+
+// V = B^T d B for every m x m sub-tile of the 8x8 output tile at (r0, c0),
+// lane l being sub-tile (l / S, l % S): v is (m + 2)^2 x L
+WINO_INLINE void tile_input(const float* in, int h, int w, int r0, int c0, int m, float* v) {
+    float win[WINO_WIN * WINO_WIN], d[WINO_BUF], t[WINO_BUF];
+    int n = m + 2, S = WINO_TILE / m, L = S * S;
+
+    // the 10x10 input window, zero outside the image, then one patch per lane
+    r0--;
+    c0--;
+    if (r0 >= 0 && c0 >= 0 && r0 + WINO_WIN <= h && c0 + WINO_WIN <= w) {
+        for (int i = 0; i < WINO_WIN; i++) {
+            memcpy(win + i * WINO_WIN, in + (size_t)(r0 + i) * w + c0, sizeof(win[0]) * WINO_WIN);
+        }
+    } else {
+        for (int i = 0; i < WINO_WIN; i++) {
+            for (int j = 0; j < WINO_WIN; j++) {
+                int r = r0 + i, c = c0 + j;
+                win[i * WINO_WIN + j] = r >= 0 && r < h && c >= 0 && c < w ? in[(size_t)r * w + c] : 0.0f;
+            }
+        }
+    }
+    for (int l = 0; l < L; l++) {
+        const float* p = win + l / S * m * WINO_WIN + l % S * m;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                d[(i * n + j) * L + l] = p[i * WINO_WIN + j];
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        if (m == 2) {
+            bt2_f32(d + i * n * L, L, t + i * n * L, L, L);
+        } else {
+            bt4_f32(d + i * n * L, L, t + i * n * L, L, L);
+        }
+    }
+    for (int j = 0; j < n; j++) {
+        if (m == 2) {
+            bt2_f32(t + j * L, n * L, v + j * L, n * L, L);
+        } else {
+            bt4_f32(t + j * L, n * L, v + j * L, n * L, L);
+        }
+    }
+}
+
+// Y = A^T M A for every sub-tile, storing the outputs that fall in the tile
+WINO_INLINE void tile_output(const float* M, int m, float* out, int w, const conv_tile* tile) {
+    float t[WINO_BUF], y[WINO_BUF];
+    int n = m + 2, S = WINO_TILE / m, L = S * S;
+
+    for (int i = 0; i < n; i++) {
+        if (m == 2) {
+            at2_f32(M + i * n * L, L, t + i * m * L, L, L);
+        } else {
+            at4_f32(M + i * n * L, L, t + i * m * L, L, L);
+        }
+    }
+    for (int j = 0; j < m; j++) {
+        if (m == 2) {
+            at2_f32(t + j * L, m * L, y + j * L, m * L, L);
+        } else {
+            at4_f32(t + j * L, m * L, y + j * L, m * L, L);
+        }
+    }
+    for (int l = 0; l < L; l++) {
+        int sr = l / S * m, sc = l % S * m;
+        for (int i = 0; i < m && sr + i < tile->out_rows; i++) {
+            float* o = out + (size_t)(tile->out_row + sr + i) * w + tile->out_col + sc;
+            for (int j = 0; j < m && sc + j < tile->out_cols; j++) {
+                o[j] = y[(i * m + j) * L + l];
+            }
+        }
+    }
+}
+
+static void gather_i32(const int16_t* in, int h, int w, int r0, int c0, int n, int32_t* d) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int r = r0 + i, c = c0 + j;
+            d[i * n + j] = r >= 0 && r < h && c >= 0 && c < w ? in[(size_t)r * w + c] : 0;
+        }
+    }
+}
+
+// U = G k G^T in double, k in any unit
+static void kernel_transform(const double* k, int m, double* u) {
+    const double(*g)[3] = m == 2 ? g2 : g4;
+    int n = m + 2;
+
+    for (int a = 0; a < n; a++) {
+        for (int b = 0; b < n; b++) {
+            double s = 0.0;
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    s += g[a][i] * k[i * 3 + j] * g[b][j];
+                }
+            }
+            u[a * n + b] = s;
+        }
+    }
+}
+
+// Rounds U of k_q to 16 bits with the most fractional bits that fit and
+// returns the worst output error that rounding can cause, in LSB, or -1 if
+// even the integer part does not fit.
+static double quantize_u(const int16_t* k_q, int m, int max_abs, int16_t* u_q, int* shift) {
+    double k[9], u[WINO_MAX_N * WINO_MAX_N], peak = 0.0;
+    int n = m + 2;
+
+    for (int i = 0; i < 9; i++) {
+        k[i] = k_q[i];
+    }
+    kernel_transform(k, m, u);
+    for (int i = 0; i < n * n; i++) {
+        peak = fabs(u[i]) > peak ? fabs(u[i]) : peak;
+    }
+    int s = 15;
+    while (s >= 0 && ldexp(peak, s) > 32767.0) {
+        s--;
+    }
+    if (s < 0) {
+        return -1.0;
+    }
+
+    // |error of output (i, j)| <= sum_ab |A_ia A_jb| |du_ab| max|V_ab| / 256
+    const int* bt_sum = m == 2 ? bt_sum2 : bt_sum4;
+    double du[WINO_MAX_N * WINO_MAX_N], worst = 0.0;
+    for (int i = 0; i < n * n; i++) {
+        u_q[i] = (int16_t)lround(ldexp(u[i], s));
+        du[i] = fabs(ldexp(u_q[i], -s) - u[i]);
+    }
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < m; j++) {
+            double e = 0.0;
+            for (int a = 0; a < n; a++) {
+                for (int b = 0; b < n; b++) {
+                    int ai = m == 2 ? at2[i][a] : at4[i][a];
+                    int bj = m == 2 ? at2[j][b] : at4[j][b];
+                    e += abs(ai * bj) * du[a * n + b] * bt_sum[a] * bt_sum[b];
+                }
+            }
+            worst = e > worst ? e : worst;
+        }
+    }
+    *shift = s;
+    return worst * max_abs / 256.0;
+}
+
+int conv_winograd_prepare(const float* k, int m, int max_abs, double tol, conv_winograd_kernel* wk) {
+    double kd[9], u[WINO_MAX_N * WINO_MAX_N];
+
+    if (!k || !wk || (m != 2 && m != 4) || max_abs < 0 || !(tol >= 0.0)) {
+        return CONV_EINVAL;
+    }
+    memset(wk, 0, sizeof(*wk));
+    wk->m = m;
+    for (int i = 0; i < 9; i++) {
+        kd[i] = k[i];
+    }
+    kernel_transform(kd, m, u);
+    for (int i = 0; i < (m + 2) * (m + 2); i++) {
+        wk->u[i] = (float)u[i];
+    }
+
+    conv_f32_to_q88(k, 9, wk->k_q);
+    for (int mq = m; mq >= 2; mq -= 2) {
+        double e = quantize_u(wk->k_q, mq, max_abs, wk->u_q, &wk->shift_q88);
+        if (e >= 0.0 && e <= tol) {
+            wk->m_q88 = mq;
+            wk->bound_q88 = e + 9.0; // conv2d_q88() floors each of the 9 products
+            return CONV_OK;
+        }
+    }
+    wk->m_q88 = 0; // conv2d_q88() itself
+    wk->shift_q88 = 0;
+    wk->bound_q88 = 0.0;
+    return CONV_OK;
+}
+
+typedef struct {
+    const float* in;
+    const conv_winograd_kernel* wk;
+    float* out;
+    int c_in, c_out;
+    conv_tiling tiling;
+    _Atomic int failed;
+} wino_job;
+
+WINO_INLINE void plane_tile(wino_job* job, const conv_tile* tile, int m) {
+    float v[WINO_BUF];
+    int nn = (m + 2) * (m + 2), L = (WINO_TILE / m) * (WINO_TILE / m);
+    const float* u = job->wk->u;
+
+    tile_input(job->in, job->tiling.h, job->tiling.w, tile->out_row, tile->out_col, m, v);
+    for (int e = 0; e < nn; e++) {
+        for (int l = 0; l < L; l++) {
+            v[e * L + l] *= u[e];
+        }
+    }
+    tile_output(v, m, job->out, job->tiling.w, tile);
+}
+
+static void plane_run(void* arg, int idx) {
+    wino_job* job = arg;
+    conv_tile tile;
+
+    conv_tile_at(&job->tiling, idx, &tile);
+    if (job->wk->m == 2) {
+        plane_tile(job, &tile, 2);
+    } else {
+        plane_tile(job, &tile, 4);
+    }
+}
+
+// One 8x8 tile of every output channel: the input transforms of all
+// channels are kept for the tile, the products are summed over input
+// channels in the transform domain and each filter's sum is transformed back
+// once.
+WINO_INLINE void layer_tile(wino_job* job, const conv_tile* tile, int m, float* v, float* acc) {
+    int h = job->tiling.h, w = job->tiling.w;
+    int nn = (m + 2) * (m + 2), L = (WINO_TILE / m) * (WINO_TILE / m);
+    size_t plane = (size_t)h * w;
+
+    for (int ci = 0; ci < job->c_in; ci++) {
+        tile_input(job->in + ci * plane, h, w, tile->out_row, tile->out_col, m, v + ci * nn * L);
+    }
+    for (int co = 0; co < job->c_out; co++) {
+        const conv_winograd_kernel* wk = job->wk + (size_t)co * job->c_in;
+        memset(acc, 0, sizeof(float) * nn * L);
+        for (int ci = 0; ci < job->c_in; ci++) {
+            const float* u = wk[ci].u;
+            const float* vc = v + ci * nn * L;
+            for (int e = 0; e < nn; e++) {
+                for (int l = 0; l < L; l++) {
+                    acc[e * L + l] += u[e] * vc[e * L + l];
+                }
+            }
+        }
+        tile_output(acc, m, job->out + co * plane, w, tile);
+    }
+}
+
+static void layer_run(void* arg, int idx) {
+    wino_job* job = arg;
+    float* v = malloc(sizeof(float) * WINO_BUF * job->c_in);
+    float acc[WINO_BUF];
+    conv_tile tile;
+
+    if (!v) {
+        job->failed = 1;
+        return;
+    }
+    conv_tile_at(&job->tiling, idx, &tile);
+    if (job->wk->m == 2) {
+        layer_tile(job, &tile, 2, v, acc);
+    } else {
+        layer_tile(job, &tile, 4, v, acc);
+    }
+    free(v);
+}
+
+static int run(wino_job* job, conv_task_fn fn, conv_pool* pool) {
+    int count = conv_tiling_count(&job->tiling);
+
+    if (pool) {
+        conv_pool_run(pool, count, fn, job);
+    } else {
+        for (int idx = 0; idx < count; idx++) {
+            fn(job, idx);
+        }
+    }
+    return job->failed ? CONV_ENOMEM : CONV_OK;
+}
+
+int conv2d_winograd(const float* in, int h, int w, const conv_winograd_kernel* wk,
+                    float* out, conv_pool* pool) {
+    wino_job job = { in, wk, out, 1, 1, { 0 }, 0 };
+
+    if (!in || !wk || !out || (wk->m != 2 && wk->m != 4) ||
+        conv_tiling_init(&job.tiling, h, w, 3, WINO_TILE) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+    return run(&job, plane_run, pool);
+}
+
+int conv_layer_winograd_f32(const float* in, int c_in, int h, int w,
+                            const conv_winograd_kernel* wk, int c_out, float* out, conv_pool* pool) {
+    wino_job job = { in, wk, out, c_in, c_out, { 0 }, 0 };
+
+    if (!in || !wk || !out || c_in <= 0 || c_out <= 0 ||
+        conv_tiling_init(&job.tiling, h, w, 3, WINO_TILE) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+    for (int i = 0; i < c_in * c_out; i++) {
+        if (wk[i].m != wk[0].m || (wk[i].m != 2 && wk[i].m != 4)) {
+            return CONV_EINVAL;
+        }
+    }
+    return run(&job, layer_run, pool);
+}
+
+int conv2d_winograd_q88(const int16_t* in, int h, int w, const conv_winograd_kernel* wk,
+                        int16_t* out, uint8_t* overflow) {
+    conv_tiling t;
+
+    if (!in || !wk || !out || conv_tiling_init(&t, h, w, 3, WINO_TILE) != CONV_OK) {
+        return CONV_EINVAL;
+    }
+    if (wk->m_q88 == 0) {
+        return conv2d_q88(in, h, w, wk->k_q, 3, out, overflow);
+    }
+
+    int m = wk->m_q88, n = m + 2, shift = 8 + wk->shift_q88;
+    int32_t d[WINO_MAX_N * WINO_MAX_N], v[WINO_MAX_N * WINO_MAX_N];
+    int64_t p[WINO_MAX_N * WINO_MAX_N], q[WINO_MAX_N * 4], y[16];
+    conv_tile tile;
+
+    for (int idx = 0; idx < conv_tiling_count(&t); idx++) {
+        conv_tile_at(&t, idx, &tile);
+        for (int sr = 0; sr < tile.out_rows; sr += m) {
+            for (int sc = 0; sc < tile.out_cols; sc += m) {
+                int r0 = tile.out_row + sr, c0 = tile.out_col + sc;
+                gather_i32(in, h, w, r0 - 1, c0 - 1, n, d);
+                for (int i = 0; i < n; i++) {
+                    if (m == 2) {
+                        bt2_i32(d + i * n, 1, v + i * n, 1);
+                    } else {
+                        bt4_i32(d + i * n, 1, v + i * n, 1);
+                    }
+                }
+                for (int j = 0; j < n; j++) {
+                    if (m == 2) {
+                        bt2_i32(v + j, n, d + j, n);
+                    } else {
+                        bt4_i32(v + j, n, d + j, n);
+                    }
+                }
+                for (int e = 0; e < n * n; e++) {
+                    p[e] = (int64_t)wk->u_q[e] * d[e];
+                }
+                for (int i = 0; i < n; i++) {
+                    if (m == 2) {
+                        at2_i64(p + i * n, 1, q + i * m, 1);
+                    } else {
+                        at4_i64(p + i * n, 1, q + i * m, 1);
+                    }
+                }
+                for (int j = 0; j < m; j++) {
+                    if (m == 2) {
+                        at2_i64(q + j, m, y + j, m);
+                    } else {
+                        at4_i64(q + j, m, y + j, m);
+                    }
+                }
+                for (int i = 0; i < m && sr + i < tile.out_rows; i++) {
+                    for (int j = 0; j < m && sc + j < tile.out_cols; j++) {
+                        int64_t val = y[i * m + j] >> shift; // floor, like the datapath
+                        size_t o = (size_t)(r0 + i) * w + c0 + j;
+                        out[o] = (int16_t)(val > 32767 ? 32767 : val < -32768 ? -32768 : val);
+                        if (overflow) {
+                            overflow[o] = val > 32767 || val < -32768;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return CONV_OK;
+}
@@ -0,0 +1,61 @@
+#ifndef CONV_WINOGRAD_H
+#define CONV_WINOGRAD_H
+
+// Winograd F(2x2, 3x3) and F(4x4, 3x3) convolution for 3x3 kernels.
+//
+// The image is cut into the 8x8 output tiles of conv_tiles.h and every tile
+// into m x m sub-tiles (m = 2 or 4, both divide 8). A sub-tile is
+//   Y = A^T [U * V] A,  V = B^T d B,  U = G k G^T
+// where d is the (m + 2) x (m + 2) input patch and * is elementwise, so it
+// takes (m + 2)^2 multiplies for m^2 outputs: 4 per output for F(2x2)
+// (2.25x fewer than direct) and 2.25 for F(4x4) (4x fewer). The kernel
+// transform U is computed once by conv_winograd_prepare() and reused for
+// every tile and call. In a layer the input transform of a channel is also
+// shared by every filter and the output transform is done once per filter
+// on the sum over input channels, so the multiplies dominate; on a single
+// plane the transforms cost more than the vector conv2d() paths save.
+//
+// Q8.8: B and A have integer entries, so V and the output transform are
+// exact in 32/64-bit integers; only U has to be rounded (G holds 1/2 for
+// F(2x2) and 1/4 .. 1/24 for F(4x4)). U is kept in 16 bits with as many
+// fractional bits as fit, and the rounding error, amplified by B and A, is
+// bounded at prepare time. When the bound exceeds the caller's tolerance
+// F(4x4) drops to F(2x2) and F(2x2) to conv2d_q88().
+
+#include <stdint.h>
+#include "conv.h"
+#include "conv_pool.h"
+
+typedef struct {
+    int m;              // float sub-tile edge, 2 or 4
+    int m_q88;          // Q8.8 sub-tile edge: m, 2, or 0 for conv2d_q88()
+    int shift_q88;      // fractional bits of u_q beyond those of k_q
+    double bound_q88;   // |conv2d_winograd_q88() - conv2d_q88()| bound in LSB
+    float u[36];        // G k G^T, (m + 2) x (m + 2)
+    int16_t u_q[36];    // G k_q G^T * 2^shift_q88, (m_q88 + 2)^2
+    int16_t k_q[9];     // k in Q8.8, for the direct fallback
+} conv_winograd_kernel;
+
+// Transforms a 3x3 kernel for F(m x m, 3x3), m = 2 or 4. For the Q8.8 path
+// the largest m whose transform rounding adds at most tol LSB for images
+// with |pixel| <= max_abs (in LSB) is kept; bound_q88 then also counts the
+// per-product flooring of conv2d_q88(), 9 LSB. Returns CONV_EINVAL or CONV_OK.
+int conv_winograd_prepare(const float* k, int m, int max_abs, double tol, conv_winograd_kernel* wk);
+
+// "Same" 3x3 convolution, out is h x w; matches conv2d() to float rounding.
+// Tiles are spread over pool, which may be NULL.
+int conv2d_winograd(const float* in, int h, int w, const conv_winograd_kernel* wk,
+                    float* out, conv_pool* pool);
+
+// Q8.8 "same" 3x3 convolution with F(m_q88 x m_q88): each output is the
+// exact transform-domain sum floored once and clamped to int16. overflow
+// (may be NULL) gets 1 for every clamped pixel.
+int conv2d_winograd_q88(const int16_t* in, int h, int w, const conv_winograd_kernel* wk,
+                        int16_t* out, uint8_t* overflow);
+
+// conv_layer_f32() for 3x3 kernels: wk holds c_out x c_in prepared kernels,
+// filter-major, all with the same m. Tiles are spread over pool.
+int conv_layer_winograd_f32(const float* in, int c_in, int h, int w,
+                            const conv_winograd_kernel* wk, int c_out, float* out, conv_pool* pool);
+
+#endif
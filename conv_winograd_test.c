@@ -0,0 +1,243 @@
+// Build: gcc -O2 -pthread -o conv_winograd_test conv_winograd_test.c conv_bench.c conv_winograd.c conv_layer.c conv_pool.c conv_tiles.c conv.c conv_simd.c -lm
+//
+// Checks F(2x2, 3x3) and F(4x4, 3x3) against conv2d(), conv2d_q88() and
+// conv_layer_f32(), including the Q8.8 error bound and the fallbacks, then
+// times a 1024x1024 plane and a 3x3, 64 -> 64 channel layer at 56x56.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "conv.h"
+#include "conv_bench.h"
+#include "conv_layer.h"
+#include "conv_pool.h"
+#include "conv_winograd.h"
+
+#define BENCH_SIZE 1024
+#define LAYER_SIZE 56
+#define LAYER_CHANNELS 64
+#define BENCH_RUNS 3
+
+static void fill(float* v, size_t n, int range) {
+    for (size_t i = 0; i < n; i++) {
+        v[i] = (float)(rand() % (2 * range + 1) - range) / 256.0f;
+    }
+}
+
+// Float result within rounding of conv2d(): relative to sum |k| * max |x|
+static int check_f32(int h, int w, int m, conv_pool* pool) {
+    size_t plane = (size_t)h * w;
+    float* in = malloc(sizeof(float) * plane);
+    float* ref = malloc(sizeof(float) * plane);
+    float* got = malloc(sizeof(float) * plane);
+    float k[9];
+    conv_winograd_kernel wk;
+    double worst = 0.0;
+
+    fill(in, plane, 2048);
+    fill(k, 9, 256);
+    conv_winograd_prepare(k, m, 2048, 0.0, &wk);
+    conv2d(in, h, w, k, 3, ref);
+    int status = conv2d_winograd(in, h, w, &wk, got, pool);
+    for (size_t i = 0; i < plane; i++) {
+        double d = fabs((double)ref[i] - got[i]);
+        worst = d > worst ? d : worst;
+    }
+    free(in);
+    free(ref);
+    free(got);
+    // |x| <= 8, |k| <= 1: outputs up to 72
+    if (status != CONV_OK || worst > 72 * 1e-5) {
+        printf("MISMATCH F(%dx%d) f32 %dx%d: error %g\n", m, m, h, w, worst);
+        return 1;
+    }
+    printf("F(%dx%d) f32 %dx%d: error %.2g: match\n", m, m, h, w, worst);
+    return 0;
+}
+
+// Q8.8 result against conv2d_q88() within bound_q88, for the m_q88 the
+// tolerance allows
+static int check_q88(const char* name, const float* k, int m, double tol, int expect_m,
+                     int h, int w, int range) {
+    size_t plane = (size_t)h * w;
+    int16_t* in = malloc(sizeof(int16_t) * plane);
+    int16_t* ref = malloc(sizeof(int16_t) * plane);
+    int16_t* got = malloc(sizeof(int16_t) * plane);
+    conv_winograd_kernel wk;
+    int worst = 0;
+
+    for (size_t i = 0; i < plane; i++) {
+        in[i] = (int16_t)(rand() % (2 * range + 1) - range);
+    }
+    conv_winograd_prepare(k, m, range, tol, &wk);
+    conv2d_q88(in, h, w, wk.k_q, 3, ref, NULL);
+    int status = conv2d_winograd_q88(in, h, w, &wk, got, NULL);
+    for (size_t i = 0; i < plane; i++) {
+        int d = abs(ref[i] - got[i]);
+        worst = d > worst ? d : worst;
+    }
+    free(in);
+    free(ref);
+    free(got);
+    if (status != CONV_OK || wk.m_q88 != expect_m || worst > wk.bound_q88) {
+        printf("MISMATCH %s: m_q88 %d (expected %d), error %d LSB, bound %.1f\n", name, wk.m_q88,
+               expect_m, worst, wk.bound_q88);
+        return 1;
+    }
+    printf("%s: m_q88 %d, %d fractional bits, error %d LSB (bound %.1f): match\n", name, wk.m_q88,
+           wk.shift_q88 + 8, worst, wk.bound_q88);
+    return 0;
+}
+
+static int check_layer(int c_in, int c_out, int h, int w, int m, conv_pool* pool) {
+    size_t plane = (size_t)h * w, n_k = (size_t)c_in * c_out * 9;
+    float* in = malloc(sizeof(float) * c_in * plane);
+    float* k = malloc(sizeof(float) * n_k);
+    float* ref = malloc(sizeof(float) * c_out * plane);
+    float* got = malloc(sizeof(float) * c_out * plane);
+    conv_winograd_kernel* wk = malloc(sizeof(conv_winograd_kernel) * c_in * c_out);
+    double worst = 0.0;
+
+    fill(in, c_in * plane, 2048);
+    fill(k, n_k, 256);
+    for (size_t i = 0; i < (size_t)c_in * c_out; i++) {
+        conv_winograd_prepare(k + i * 9, m, 2048, 0.0, &wk[i]);
+    }
+    conv_layer_f32(in, c_in, h, w, k, c_out, 3, ref, NULL);
+    int status = conv_layer_winograd_f32(in, c_in, h, w, wk, c_out, got, pool);
+    for (size_t i = 0; i < c_out * plane; i++) {
+        double d = fabs((double)ref[i] - got[i]);
+        worst = d > worst ? d : worst;
+    }
+    free(in);
+    free(k);
+    free(ref);
+    free(got);
+    free(wk);
+    if (status != CONV_OK || worst > 72.0 * c_in * 1e-5) {
+        printf("MISMATCH F(%dx%d) layer %d->%d %dx%d: error %g\n", m, m, c_in, c_out, h, w, worst);
+        return 1;
+    }
+    printf("F(%dx%d) layer %d->%d %dx%d: error %.2g: match\n", m, m, c_in, c_out, h, w, worst);
+    return 0;
+}
+
+static void bench_plane(void) {
+    size_t plane = (size_t)BENCH_SIZE * BENCH_SIZE;
+    float* in = malloc(sizeof(float) * plane);
+    float* out = malloc(sizeof(float) * plane);
+    float k[9] = { 1, 2, 1, 2, 4, 2, 1, 2, 1 };
+    conv_winograd_kernel wk2, wk4;
+    uint64_t best[3] = { UINT64_MAX, UINT64_MAX, UINT64_MAX };
+
+    for (size_t i = 0; i < plane; i++) {
+        in[i] = (float)((i * 7) % 23) * 0.25f;
+    }
+    conv_winograd_prepare(k, 2, 32767, 0.0, &wk2);
+    conv_winograd_prepare(k, 4, 32767, 0.0, &wk4);
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        uint64_t t0 = conv_bench_ns();
+        conv2d(in, BENCH_SIZE, BENCH_SIZE, k, 3, out);
+        uint64_t t1 = conv_bench_ns();
+        conv2d_winograd(in, BENCH_SIZE, BENCH_SIZE, &wk2, out, NULL);
+        uint64_t t2 = conv_bench_ns();
+        conv2d_winograd(in, BENCH_SIZE, BENCH_SIZE, &wk4, out, NULL);
+        uint64_t t3 = conv_bench_ns();
+        if (t1 - t0 < best[0]) best[0] = t1 - t0;
+        if (t2 - t1 < best[1]) best[1] = t2 - t1;
+        if (t3 - t2 < best[2]) best[2] = t3 - t2;
+    }
+    printf("%dx%d plane (%s): conv2d %.2f ms (9 mul/px), F(2x2) %.2f ms (4 mul/px), "
+           "F(4x4) %.2f ms (2.25 mul/px)\n",
+           BENCH_SIZE, BENCH_SIZE, conv_isa_name(conv_isa()), best[0] / 1e6, best[1] / 1e6, best[2] / 1e6);
+    free(in);
+    free(out);
+}
+
+static void bench_layer(conv_pool* pool) {
+    size_t plane = LAYER_SIZE * LAYER_SIZE;
+    size_t n_in = LAYER_CHANNELS * plane, n_k = (size_t)LAYER_CHANNELS * LAYER_CHANNELS * 9;
+    float* in = malloc(sizeof(float) * n_in);
+    float* k = malloc(sizeof(float) * n_k);
+    float* out = malloc(sizeof(float) * n_in);
+    conv_winograd_kernel* wk = malloc(sizeof(conv_winograd_kernel) * LAYER_CHANNELS * LAYER_CHANNELS);
+
+    for (size_t i = 0; i < n_in; i++) {
+        in[i] = (float)((i * 7) % 23) * 0.25f;
+    }
+    for (size_t i = 0; i < n_k; i++) {
+        k[i] = (float)((int)(i % 11) - 5) / 64.0f;
+    }
+    for (conv_pool* p = NULL;; p = pool) {
+        uint64_t best[3] = { UINT64_MAX, UINT64_MAX, UINT64_MAX };
+        for (int m = 2; m <= 4; m += 2) {
+            for (int i = 0; i < LAYER_CHANNELS * LAYER_CHANNELS; i++) {
+                conv_winograd_prepare(k + i * 9, m, 32767, 0.0, &wk[i]);
+            }
+            for (int r = 0; r < BENCH_RUNS; r++) {
+                uint64_t t0 = conv_bench_ns();
+                conv_layer_winograd_f32(in, LAYER_CHANNELS, LAYER_SIZE, LAYER_SIZE, wk, LAYER_CHANNELS, out, p);
+                uint64_t t = conv_bench_ns() - t0;
+                if (t < best[m / 2]) best[m / 2] = t;
+            }
+        }
+        for (int r = 0; r < BENCH_RUNS; r++) {
+            uint64_t t0 = conv_bench_ns();
+            conv_layer_f32(in, LAYER_CHANNELS, LAYER_SIZE, LAYER_SIZE, k, LAYER_CHANNELS, 3, out, p);
+            uint64_t t = conv_bench_ns() - t0;
+            if (t < best[0]) best[0] = t;
+        }
+        printf("%dx%d, 3x3, %d->%d layer x%d threads: conv_layer_f32 %.2f ms, F(2x2) %.2f ms (%.2fx), "
+               "F(4x4) %.2f ms (%.2fx)\n",
+               LAYER_SIZE, LAYER_SIZE, LAYER_CHANNELS, LAYER_CHANNELS, p ? conv_pool_threads(p) : 1,
+               best[0] / 1e6, best[1] / 1e6, (double)best[0] / best[1], best[2] / 1e6, (double)best[0] / best[2]);
+        if (p == pool) {
+            break;
+        }
+    }
+    free(in);
+    free(k);
+    free(out);
+    free(wk);
+}
+
+int main() {
+    static const float sobel[9] = { -1, 0, 1, -2, 0, 2, -1, 0, 1 };
+    static const float big[9] = { 100, 100, 100, 100, 100, 100, 100, 100, 100 };
+    conv_pool* pool = conv_pool_create(0);
+    float random3[9];
+    int bad = 0;
+
+    for (int m = 2; m <= 4; m += 2) {
+        bad |= check_f32(64, 64, m, NULL);
+        bad |= check_f32(23, 17, m, pool);
+        bad |= check_f32(1, 1, m, NULL);
+        bad |= check_f32(5, 3, m, NULL);
+        bad |= check_layer(3, 4, 24, 16, m, NULL);
+        bad |= check_layer(5, 2, 9, 13, m, pool);
+    }
+
+    fill(random3, 9, 256);
+    // F(2x2) needs 2 more fractional bits than k_q and is exact
+    bad |= check_q88("sobel F(2x2)", sobel, 2, 0.0, 2, 61, 61, 4096);
+    bad |= check_q88("random F(2x2)", random3, 2, 0.0, 2, 37, 21, 4096);
+    // F(4x4) rounds 1/6 .. 1/24: too much for a tight tolerance, fine for a loose one
+    bad |= check_q88("random F(4x4), tol 0", random3, 4, 0.0, 2, 37, 21, 4096);
+    bad |= check_q88("random F(4x4), tol 4096", random3, 4, 4096.0, 4, 37, 21, 4096);
+    // U of a large kernel does not fit 16 bits: direct
+    bad |= check_q88("large taps", big, 4, 0.0, 0, 16, 16, 64);
+
+    conv_winograd_kernel wk;
+    if (conv_winograd_prepare(sobel, 3, 0, 0.0, &wk) != CONV_EINVAL ||
+        conv_winograd_prepare(sobel, 2, 0, -1.0, &wk) != CONV_EINVAL) {
+        printf("MISMATCH bad arguments accepted\n");
+        bad = 1;
+    }
+    printf("winograd: %s\n", bad ? "MISMATCH" : "match");
+
+    bench_plane();
+    bench_layer(pool);
+    conv_pool_destroy(pool);
+    return bad;
+}
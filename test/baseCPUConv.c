@@ -1,24 +1,37 @@
-#include <stdio.h> 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
-#define INPUT_SIZE 32
 #define KERNEL_SIZE 5
 #define PADDING (KERNEL_SIZE / 2)
-#define OUTPUT_SIZE INPUT_SIZE 
 
-unsigned long read_cycles(void) {
-	unsigned long cycles;
+// Image sizes benchmarked. 4096x4096 needs ~128 MB of heap; drop it when
+// running on the bare-metal simulator.
+static const int bench_sizes[] = {32, 256, 4096};
+#define NUM_BENCH_SIZES (sizeof(bench_sizes) / sizeof(bench_sizes[0]))
+
+static inline uint64_t read_cycles(void) {
+#if defined(__riscv)
+	uint64_t cycles;
 	asm volatile ("rdcycle %0" : "=r" (cycles));
+	return cycles;
+#elif defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+#error "read_cycles: no cycle counter for this target"
+#endif
 }
 
-void convolve2D(int input[INPUT_SIZE][INPUT_SIZE],
-                int kernel[KERNEL_SIZE][KERNEL_SIZE],
-                int output[OUTPUT_SIZE][OUTPUT_SIZE]) {
+// Original reference: bounds check on every MAC.
+void convolve2D_checked(const int* input, int n, const int* kernel, int* output) {
 
     // Iterate over each output element
-    for (int i = 0; i < OUTPUT_SIZE; i++) {
-        for (int j = 0; j < OUTPUT_SIZE; j++) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
             int sum = 0;
 
             // Apply the kernel
@@ -27,48 +40,128 @@ void convolve2D(int input[INPUT_SIZE][INPUT_SIZE],
                     int ii = i + ki - PADDING;
                     int jj = j + kj - PADDING;
 
-                    // Check for padding 
-                    if (ii >= 0 && ii < INPUT_SIZE && jj >= 0 && jj < INPUT_SIZE) {
-                        sum += input[ii][jj] * kernel[ki][kj];
+                    // Check for padding
+                    if (ii >= 0 && ii < n && jj >= 0 && jj < n) {
+                        sum += input[ii * n + jj] * kernel[ki * KERNEL_SIZE + kj];
                     }
                 }
             }
-            output[i][j] = sum;
+            output[i * n + j] = sum;
         }
     }
 }
 
-int main() {
-    int input[INPUT_SIZE][INPUT_SIZE];
-    int kernel[KERNEL_SIZE][KERNEL_SIZE];
-    int output[OUTPUT_SIZE][OUTPUT_SIZE];
-
-    // Initialise input
-    for (int i = 0; i < INPUT_SIZE; i++) {
-        for (int j = 0; j < INPUT_SIZE; j++) {
-            input[i][j] = i;
+// Border pixels: clip the kernel window to the image once per pixel rather
+// than testing every tap.
+static void convolve2D_border(const int* input, int n, const int* kernel, int* output,
+                              int i, int jStart, int jEnd) {
+    int ki0 = i < PADDING ? PADDING - i : 0;
+    int ki1 = i + PADDING >= n ? n - i + PADDING : KERNEL_SIZE;
+
+    for (int j = jStart; j < jEnd; j++) {
+        int kj0 = j < PADDING ? PADDING - j : 0;
+        int kj1 = j + PADDING >= n ? n - j + PADDING : KERNEL_SIZE;
+        int sum = 0;
+
+        for (int ki = ki0; ki < ki1; ki++) {
+            const int* row = &input[(i + ki - PADDING) * n + (j - PADDING)];
+            for (int kj = kj0; kj < kj1; kj++) {
+                sum += row[kj] * kernel[ki * KERNEL_SIZE + kj];
+            }
         }
+        output[i * n + j] = sum;
     }
+}
 
-    // Initialise kernel
-    for (int i = 0; i < KERNEL_SIZE; i++) {
-        for (int j = 0; j < KERNEL_SIZE; j++) {
-            kernel[i][j] = 1;
+// Same result as convolve2D_checked, split like the accelerator's tile types:
+// the interior (CENTER) region runs without any bounds checks, and only the
+// PADDING-wide frame around it goes through the clipped border path.
+void convolve2D(const int* input, int n, const int* kernel, int* output) {
+
+    // Interior: the whole window lies inside the image. Integer sums are
+    // order-independent, so accumulate one kernel tap across the whole row
+    // at a time; that inner loop has no branches and vectorises.
+    for (int i = PADDING; i < n - PADDING; i++) {
+        int* out = &output[i * n];
+        for (int j = PADDING; j < n - PADDING; j++) {
+            out[j] = 0;
         }
+        for (int ki = 0; ki < KERNEL_SIZE; ki++) {
+            const int* row = &input[(i + ki - PADDING) * n - PADDING];
+            for (int kj = 0; kj < KERNEL_SIZE; kj++) {
+                int kv = kernel[ki * KERNEL_SIZE + kj];
+                for (int j = PADDING; j < n - PADDING; j++) {
+                    out[j] += row[j + kj] * kv;
+                }
+            }
+        }
+    }
+
+    // Border: top and bottom rows in full, left and right columns in between
+    int top = PADDING < n ? PADDING : n;
+    int bottom = n - PADDING > top ? n - PADDING : top;
+    for (int i = 0; i < top; i++) {
+        convolve2D_border(input, n, kernel, output, i, 0, n);
+    }
+    for (int i = top; i < bottom; i++) {
+        convolve2D_border(input, n, kernel, output, i, 0, PADDING);
+        convolve2D_border(input, n, kernel, output, i, n - PADDING, n);
     }
-    int start = read_cycles();
-    convolve2D(input, kernel, output);
-    int end = read_cycles();
-
-    // Print output
-    /*for (int i = 0; i < OUTPUT_SIZE; i++) {
-        for (int j = 0; j < OUTPUT_SIZE; j++) {
-            printf("%6d ", output[i][j]);
+    for (int i = bottom; i < n; i++) {
+        convolve2D_border(input, n, kernel, output, i, 0, n);
+    }
+}
+
+int main() {
+    int kernel[KERNEL_SIZE * KERNEL_SIZE];
+
+    // Initialise kernel
+    for (int i = 0; i < KERNEL_SIZE * KERNEL_SIZE; i++) {
+        kernel[i] = 1;
+    }
+
+    printf("size, checked cycles, split cycles, checked MACs/cycle, split MACs/cycle\n");
+    for (unsigned s = 0; s < NUM_BENCH_SIZES; s++) {
+        int n = bench_sizes[s];
+        int* input = malloc(sizeof(int) * n * n);
+        int* ref = malloc(sizeof(int) * n * n);
+        int* output = malloc(sizeof(int) * n * n);
+        if (!input || !ref || !output) {
+            printf("%d: out of memory, skipped\n", n);
+            free(input);
+            free(ref);
+            free(output);
+            continue;
         }
-        printf("\n");
-    }*/
 
-    printf("My convolution took %lu cycles\n", end-start);
+        // Initialise input
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                input[i * n + j] = i;
+            }
+        }
+
+        uint64_t start = read_cycles();
+        convolve2D_checked(input, n, kernel, ref);
+        uint64_t mid = read_cycles();
+        convolve2D(input, n, kernel, output);
+        uint64_t end = read_cycles();
+
+        if (memcmp(ref, output, sizeof(int) * n * n) != 0) {
+            printf("%d: split convolution does not match the reference\n", n);
+            return 1;
+        }
+
+        // Nominal MACs: every output pixel times every kernel tap
+        double macs = (double)n * n * KERNEL_SIZE * KERNEL_SIZE;
+        printf("%d, %llu, %llu, %.3f, %.3f\n", n,
+               (unsigned long long)(mid - start), (unsigned long long)(end - mid),
+               macs / (mid - start), macs / (end - mid));
+
+        free(input);
+        free(ref);
+        free(output);
+    }
 
     return 0;
-}
\ No newline at end of file
+}